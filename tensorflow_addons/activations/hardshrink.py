@@ -13,9 +13,47 @@
 # limitations under the License.
 # ==============================================================================
 
+import numpy as np
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import Number, TensorLike
 
+_activation_so = LazySO("custom_ops/activations/_activation_ops.so")
+
+
+def _hardshrink_custom_op(x, lower, upper):
+    """Computes hardshrink with the custom kernel.
+
+    Returns:
+      The activations, or `None` if the custom kernel can't be used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or x.dtype not in (tf.float32, tf.float64)
+        or tf.is_tensor(lower)
+        or tf.is_tensor(upper)
+    ):
+        return None
+    # The bounds are float attrs, so float64 inputs would be compared against
+    # bounds rounded to float32.
+    if x.dtype == tf.float64 and (
+        np.float32(lower) != lower or np.float32(upper) != upper
+    ):
+        return None
+    try:
+        return _activation_so.ops.addons_hardshrink(x, lower=lower, upper=upper)
+    except tf.errors.NotFoundError:
+        options.warn_fallback("hardshrink")
+        return None
+
+
+@tf.RegisterGradient("Addons>Hardshrink")
+def _hardshrink_grad(op, grad):
+    return _activation_so.ops.addons_hardshrink_grad(
+        grad, op.inputs[0], lower=op.get_attr("lower"), upper=op.get_attr("upper")
+    )
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 def hardshrink(x: TensorLike, lower: Number = -0.5, upper: Number = 0.5) -> tf.Tensor:
@@ -53,6 +91,9 @@ def hardshrink(x: TensorLike, lower: Number = -0.5, upper: Number = 0.5) -> tf.T
             "variable upper, which is {} .".format(lower, upper)
         )
     x = tf.convert_to_tensor(x)
+    output = _hardshrink_custom_op(x, lower, upper)
+    if output is not None:
+        return output
     mask_lower = x < lower
     mask_upper = upper < x
     mask = tf.logical_or(mask_lower, mask_upper)
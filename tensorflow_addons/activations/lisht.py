@@ -15,8 +15,32 @@
 
 import tensorflow as tf
 
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import TensorLike
 
+_activation_so = LazySO("custom_ops/activations/_activation_ops.so")
+
+
+def _lisht_custom_op(x):
+    """Computes lisht with the custom kernel.
+
+    Returns:
+      The activations, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or x.dtype not in (tf.float32, tf.float64):
+        return None
+    try:
+        return _activation_so.ops.addons_lisht(x)
+    except tf.errors.NotFoundError:
+        options.warn_fallback("lisht")
+        return None
+
+
+@tf.RegisterGradient("Addons>Lisht")
+def _lisht_grad(op, grad):
+    return _activation_so.ops.addons_lisht_grad(grad, op.inputs[0])
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 def lisht(x: TensorLike) -> tf.Tensor:
@@ -43,4 +67,7 @@ def lisht(x: TensorLike) -> tf.Tensor:
         A `Tensor`. Has the same type as `x`.
     """
     x = tf.convert_to_tensor(x)
+    output = _lisht_custom_op(x)
+    if output is not None:
+        return output
     return x * tf.math.tanh(x)
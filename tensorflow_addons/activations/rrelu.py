@@ -14,9 +14,34 @@
 # ==============================================================================
 
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import Number, TensorLike
 from typing import Optional
 
+_activation_so = LazySO("custom_ops/activations/_activation_ops.so")
+
+
+def _rrelu_custom_op(x, alpha):
+    """Computes rrelu with the custom kernel.
+
+    Returns:
+      The activations, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or x.dtype not in (tf.float32, tf.float64):
+        return None
+    try:
+        return _activation_so.ops.addons_rrelu(x, alpha)
+    except tf.errors.NotFoundError:
+        options.warn_fallback("rrelu")
+        return None
+
+
+@tf.RegisterGradient("Addons>Rrelu")
+def _rrelu_grad(op, grad):
+    features, alpha = op.inputs
+    return [_activation_so.ops.addons_rrelu_grad(grad, features, alpha), None]
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 def rrelu(
@@ -79,6 +104,8 @@ def rrelu(
         result: A `Tensor`. Has the same type as `x`.
     """
     x = tf.convert_to_tensor(x)
+    # The kernel has no gradient for `a`, so it is only used for constant bounds.
+    constant_bounds = not (tf.is_tensor(lower) or tf.is_tensor(upper))
     lower = tf.cast(lower, x.dtype)
     upper = tf.cast(upper, x.dtype)
 
@@ -96,5 +123,9 @@ def rrelu(
         )
 
     a = tf.keras.backend.in_train_phase(random_a, (lower + upper) / 2, training)
+    if constant_bounds:
+        output = _rrelu_custom_op(x, a)
+        if output is not None:
+            return output
 
     return tf.where(x >= 0, x, a * x)
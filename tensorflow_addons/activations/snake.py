@@ -15,7 +15,35 @@
 
 import tensorflow as tf
 
+from tensorflow_addons import options
 from tensorflow_addons.utils import types
+from tensorflow_addons.utils.resource_loader import LazySO
+
+_activation_so = LazySO("custom_ops/activations/_activation_ops.so")
+
+
+def _snake_custom_op(x, frequency):
+    """Computes snake with the custom kernel.
+
+    Returns:
+      The activations, or `None` if the custom kernel can't be used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or x.dtype not in (tf.float32, tf.float64)
+        or frequency.shape.rank != 0
+    ):
+        return None
+    try:
+        return _activation_so.ops.addons_snake(x, frequency)
+    except tf.errors.NotFoundError:
+        options.warn_fallback("snake")
+        return None
+
+
+@tf.RegisterGradient("Addons>Snake")
+def _snake_grad(op, grad):
+    return _activation_so.ops.addons_snake_grad(grad, op.inputs[0], op.inputs[1])
 
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
@@ -44,5 +72,8 @@ def snake(x: types.TensorLike, frequency: types.Number = 1) -> tf.Tensor:
     """
     x = tf.convert_to_tensor(x)
     frequency = tf.cast(frequency, x.dtype)
+    output = _snake_custom_op(x, frequency)
+    if output is not None:
+        return output
 
     return x + (1 - tf.cos(2 * frequency * x)) / (2 * frequency)
@@ -21,6 +21,7 @@ from tensorflow_addons.activations import lisht
 from tensorflow_addons.utils import test_utils
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.parametrize("dtype", [np.float16, np.float32, np.float64])
 def test_lisht(dtype):
     x = tf.constant([-2.0, -1.0, 0.0, 1.0, 2.0], dtype=dtype)
@@ -28,3 +29,10 @@ def test_lisht(dtype):
         [1.9280552, 0.7615942, 0.0, 0.7615942, 1.9280552], dtype=dtype
     )
     test_utils.assert_allclose_according_to_type(lisht(x), expected_result)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_gradients():
+    x = tf.constant([-30.0, -2.0, -1.0, -0.2, 0.0, 0.3, 1.0, 2.0, 30.0], tf.float64)
+    theoretical, numerical = tf.test.compute_gradient(lisht, [x])
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-5, atol=1e-5)
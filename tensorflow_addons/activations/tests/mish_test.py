@@ -21,6 +21,7 @@ from tensorflow_addons.activations import mish
 from tensorflow_addons.utils import test_utils
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.parametrize("dtype", [np.float16, np.float32, np.float64])
 def test_mish(dtype):
     x = tf.constant([-2.0, -1.0, 0.0, 1.0, 2.0], dtype=dtype)
@@ -28,3 +29,10 @@ def test_mish(dtype):
         [-0.2525015, -0.30340144, 0.0, 0.86509836, 1.943959], dtype=dtype
     )
     test_utils.assert_allclose_according_to_type(mish(x), expected_result)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_gradients():
+    x = tf.constant([-30.0, -2.0, -1.0, -0.2, 0.0, 0.3, 1.0, 2.0, 30.0], tf.float64)
+    theoretical, numerical = tf.test.compute_gradient(mish, [x])
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-5, atol=1e-5)
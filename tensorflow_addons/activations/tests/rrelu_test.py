@@ -50,6 +50,7 @@ def test_rrelu_old(dtype, training):
     test_utils.assert_allclose_according_to_type(result, expect_result)
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.parametrize("dtype", [np.float16, np.float32, np.float64])
 @pytest.mark.parametrize("training", [True, False])
 def test_rrelu(dtype, training):
@@ -74,3 +75,15 @@ def test_rrelu(dtype, training):
     else:
         expect_result = [-0.30000001192092896, -0.15000000596046448, 0, 1, 2]
     test_utils.assert_allclose_according_to_type(result, expect_result)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("training", [True, False])
+def test_gradients(training):
+    x = tf.constant([-2.0, -1.0, 0.0, 1.0, 2.0])
+    rng = tf.random.Generator.from_seed(SEED)
+    with tf.GradientTape() as tape:
+        tape.watch(x)
+        result = rrelu(x, 0.1, 0.2, training=training, rng=rng)
+    grad = tape.gradient(result, x)
+    np.testing.assert_allclose(grad, tf.where(x >= 0, 1.0, result / x), rtol=1e-6)
@@ -16,10 +16,12 @@
 import pytest
 
 import numpy as np
+import tensorflow as tf
 from tensorflow_addons.activations import snake
 from tensorflow_addons.utils import test_utils
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 @pytest.mark.parametrize("dtype", [np.float16, np.float32, np.float64])
 def test_activation(dtype):
@@ -27,3 +29,14 @@ def test_activation(dtype):
     a = dtype(np.random.randn())
     expected_result = x + np.power(np.sin(a * x), 2) / a
     test_utils.assert_allclose_according_to_type(snake(x, a), expected_result)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("frequency", [0.5, -1.5])
+def test_gradients(frequency):
+    x = tf.constant(np.random.uniform(-3, 3, size=(3, 4)))
+    theoretical, numerical = tf.test.compute_gradient(
+        snake, [x, tf.constant(frequency, tf.float64)]
+    )
+    for t, n in zip(theoretical, numerical):
+        np.testing.assert_allclose(t, n, rtol=1e-5, atol=1e-5)
@@ -22,6 +22,7 @@ from tensorflow_addons.activations import softshrink
 from tensorflow_addons.utils import test_utils
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.parametrize("dtype", [np.float16, np.float32, np.float64])
 def test_softshrink(dtype):
     x = tf.constant([-2.0, -1.0, 0.0, 1.0, 2.0], dtype=dtype)
@@ -32,3 +33,24 @@ def test_softshrink(dtype):
     test_utils.assert_allclose_according_to_type(
         softshrink(x, lower=-1.0, upper=1.0), expected_result
     )
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("lower,upper", [(-0.5, 0.5), (-1.5, 0.25)])
+def test_gradients(lower, upper):
+    x = tf.constant([-2.0, -1.0, -0.2, 0.0, 0.3, 1.0, 2.0], tf.float64)
+    theoretical, numerical = tf.test.compute_gradient(
+        lambda x: softshrink(x, lower, upper), [x]
+    )
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-5, atol=1e-5)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_float64_bounds():
+    # 0.1 is not exact in float32, so these values fall on the other side of
+    # the bounds if they are rounded.
+    x = tf.constant([-0.1 - 1e-12, -0.1, 0.1, 0.1 + 1e-12], tf.float64)
+    expected_result = np.array([-1e-12, 0.0, 0.0, 1e-12])
+    np.testing.assert_allclose(
+        softshrink(x, lower=-0.1, upper=0.1), expected_result, rtol=1e-3, atol=0
+    )
@@ -21,8 +21,16 @@ from tensorflow_addons.activations import tanhshrink
 from tensorflow_addons.utils import test_utils
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.parametrize("dtype", [np.float16, np.float32, np.float64])
 def test_tanh(dtype):
     x = tf.constant([-1.0, 0.0, 1.0], dtype=dtype)
     expected_result = tf.constant([-0.23840582, 0.0, 0.238405825], dtype=dtype)
     test_utils.assert_allclose_according_to_type(tanhshrink(x), expected_result)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_gradients():
+    x = tf.constant([-30.0, -2.0, -1.0, -0.2, 0.0, 0.3, 1.0, 2.0, 30.0], tf.float64)
+    theoretical, numerical = tf.test.compute_gradient(tanhshrink, [x])
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-5, atol=1e-5)
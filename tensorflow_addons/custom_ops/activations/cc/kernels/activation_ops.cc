@@ -0,0 +1,618 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+namespace functor {
+
+// Elementwise functors for the activations whose expressions would otherwise
+// evaluate the same exp, tanh or sin several times per element. Each has a
+// scalar and a packet path; Eigen uses the packet path, built on its
+// vectorized polynomial approximations, when the type supports it.
+
+using Eigen::internal::padd;
+using Eigen::internal::pdiv;
+using Eigen::internal::pexp;
+using Eigen::internal::pmin;
+using Eigen::internal::pmul;
+using Eigen::internal::pset1;
+using Eigen::internal::psin;
+using Eigen::internal::psub;
+using Eigen::internal::ptanh;
+
+// tanh(softplus(x)) rounds to one above this input in float and double.
+constexpr double kMishThreshold = 20;
+
+// mish(x) = x * tanh(softplus(x)). With e = exp(x) and n = e * (e + 2),
+// tanh(softplus(x)) = n / (n + 2), which needs a single exp per element.
+template <typename T>
+struct MishFunctor {
+  EIGEN_STRONG_INLINE T operator()(const T &x) const {
+    const T e = std::exp(std::min(x, T(kMishThreshold)));
+    const T n = e * (e + T(2));
+    return x * n / (n + T(2));
+  }
+
+  template <typename Packet>
+  EIGEN_STRONG_INLINE Packet packetOp(const Packet &x) const {
+    const Packet two = pset1<Packet>(T(2));
+    const Packet e = pexp(pmin(x, pset1<Packet>(T(kMishThreshold))));
+    const Packet n = pmul(e, padd(e, two));
+    return pmul(x, pdiv(n, padd(n, two)));
+  }
+};
+
+// mish'(x) = t + x * (1 - t^2) * sigmoid(x) with t = n / (n + 2), which
+// simplifies to (n * (n + 2) + 4 * x * e * (e + 1)) / (n + 2)^2. The second
+// term vanishes past the threshold, so x is clamped together with e.
+template <typename T>
+struct MishGradFunctor {
+  EIGEN_STRONG_INLINE T operator()(const T &g, const T &x) const {
+    const T c = std::min(x, T(kMishThreshold));
+    const T e = std::exp(c);
+    const T n = e * (e + T(2));
+    const T d = n + T(2);
+    return g * (n * d + T(4) * c * e * (e + T(1))) / (d * d);
+  }
+
+  template <typename Packet>
+  EIGEN_STRONG_INLINE Packet packetOp(const Packet &g, const Packet &x) const {
+    const Packet one = pset1<Packet>(T(1));
+    const Packet two = pset1<Packet>(T(2));
+    const Packet c = pmin(x, pset1<Packet>(T(kMishThreshold)));
+    const Packet e = pexp(c);
+    const Packet n = pmul(e, padd(e, two));
+    const Packet d = padd(n, two);
+    const Packet r = pmul(pmul(pset1<Packet>(T(4)), c), pmul(e, padd(e, one)));
+    return pdiv(pmul(g, padd(pmul(n, d), r)), pmul(d, d));
+  }
+};
+
+// lisht'(x) = t + x * (1 - t^2) with t = tanh(x).
+template <typename T>
+struct LishtGradFunctor {
+  EIGEN_STRONG_INLINE T operator()(const T &g, const T &x) const {
+    const T t = std::tanh(x);
+    return g * (t + x * (T(1) - t * t));
+  }
+
+  template <typename Packet>
+  EIGEN_STRONG_INLINE Packet packetOp(const Packet &g, const Packet &x) const {
+    const Packet t = ptanh(x);
+    const Packet one = pset1<Packet>(T(1));
+    return pmul(g, padd(t, pmul(x, psub(one, pmul(t, t)))));
+  }
+};
+
+// snake(x) = x + (1 - cos(2 * f * x)) / (2 * f) = x + sin(f * x)^2 / f.
+template <typename T>
+struct SnakeFunctor {
+  explicit SnakeFunctor(T frequency)
+      : frequency(frequency), inverse(T(1) / frequency) {}
+
+  EIGEN_STRONG_INLINE T operator()(const T &x) const {
+    const T s = std::sin(frequency * x);
+    return x + s * s * inverse;
+  }
+
+  template <typename Packet>
+  EIGEN_STRONG_INLINE Packet packetOp(const Packet &x) const {
+    const Packet s = psin(pmul(pset1<Packet>(frequency), x));
+    return padd(x, pmul(pmul(s, s), pset1<Packet>(inverse)));
+  }
+
+  const T frequency;
+  const T inverse;
+};
+
+// d snake(x) / dx = 1 + sin(2 * f * x).
+template <typename T>
+struct SnakeGradFunctor {
+  explicit SnakeGradFunctor(T frequency) : frequency(frequency) {}
+
+  EIGEN_STRONG_INLINE T operator()(const T &g, const T &x) const {
+    return g * (T(1) + std::sin(T(2) * frequency * x));
+  }
+
+  template <typename Packet>
+  EIGEN_STRONG_INLINE Packet packetOp(const Packet &g, const Packet &x) const {
+    const Packet s = psin(pmul(pset1<Packet>(T(2) * frequency), x));
+    return pmul(g, padd(pset1<Packet>(T(1)), s));
+  }
+
+  const T frequency;
+};
+
+// d snake(x) / df = (x * sin(2 * f * x) - sin(f * x)^2 / f) / f.
+template <typename T>
+struct SnakeFrequencyGradFunctor {
+  explicit SnakeFrequencyGradFunctor(T frequency)
+      : frequency(frequency), inverse(T(1) / frequency) {}
+
+  EIGEN_STRONG_INLINE T operator()(const T &g, const T &x) const {
+    const T s = std::sin(frequency * x);
+    const T s2 = std::sin(T(2) * frequency * x);
+    return g * (x * s2 - s * s * inverse) * inverse;
+  }
+
+  template <typename Packet>
+  EIGEN_STRONG_INLINE Packet packetOp(const Packet &g, const Packet &x) const {
+    const Packet fx = pmul(pset1<Packet>(frequency), x);
+    const Packet s = psin(fx);
+    const Packet s2 = psin(padd(fx, fx));
+    const Packet inv = pset1<Packet>(inverse);
+    return pmul(pmul(g, psub(pmul(x, s2), pmul(pmul(s, s), inv))), inv);
+  }
+
+  const T frequency;
+  const T inverse;
+};
+
+}  // namespace functor
+}  // namespace addons
+}  // namespace tensorflow
+
+namespace Eigen {
+namespace internal {
+
+template <typename T>
+struct functor_traits<tensorflow::addons::functor::MishFunctor<T>> {
+  enum {
+    Cost = functor_traits<scalar_exp_op<T>>::Cost + 4 * NumTraits<T>::MulCost +
+           scalar_div_cost<T, packet_traits<T>::HasDiv>::value,
+    PacketAccess = packet_traits<T>::HasExp && packet_traits<T>::HasDiv &&
+                   packet_traits<T>::HasMin,
+  };
+};
+
+template <typename T>
+struct functor_traits<tensorflow::addons::functor::MishGradFunctor<T>> {
+  enum {
+    Cost = functor_traits<scalar_exp_op<T>>::Cost + 9 * NumTraits<T>::MulCost +
+           scalar_div_cost<T, packet_traits<T>::HasDiv>::value,
+    PacketAccess = packet_traits<T>::HasExp && packet_traits<T>::HasDiv &&
+                   packet_traits<T>::HasMin,
+  };
+};
+
+template <typename T>
+struct functor_traits<tensorflow::addons::functor::LishtGradFunctor<T>> {
+  enum {
+    Cost = functor_traits<scalar_tanh_op<T>>::Cost + 5 * NumTraits<T>::MulCost,
+    PacketAccess = packet_traits<T>::HasTanh,
+  };
+};
+
+template <typename T>
+struct functor_traits<tensorflow::addons::functor::SnakeFunctor<T>> {
+  enum {
+    Cost = functor_traits<scalar_sin_op<T>>::Cost + 4 * NumTraits<T>::MulCost,
+    PacketAccess = packet_traits<T>::HasSin,
+  };
+};
+
+template <typename T>
+struct functor_traits<tensorflow::addons::functor::SnakeGradFunctor<T>> {
+  enum {
+    Cost = functor_traits<scalar_sin_op<T>>::Cost + 4 * NumTraits<T>::MulCost,
+    PacketAccess = packet_traits<T>::HasSin,
+  };
+};
+
+template <typename T>
+struct functor_traits<
+    tensorflow::addons::functor::SnakeFrequencyGradFunctor<T>> {
+  enum {
+    Cost = 2 * functor_traits<scalar_sin_op<T>>::Cost +
+           8 * NumTraits<T>::MulCost,
+    PacketAccess = packet_traits<T>::HasSin,
+  };
+};
+
+}  // namespace internal
+}  // namespace Eigen
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Checks that the first `num_inputs` inputs have the same shape and allocates
+// output 0 with it, forwarding the buffer of input 0 when possible.
+Status AllocateActivationOutput(OpKernelContext *context, int num_inputs,
+                                Tensor **output) {
+  const TensorShape &shape = context->input(0).shape();
+  for (int i = 1; i < num_inputs; ++i) {
+    if (context->input(i).shape() != shape) {
+      return errors::InvalidArgument(
+          "Inputs must have the same shape, got ", shape.DebugString(),
+          " and ", context->input(i).shape().DebugString());
+    }
+  }
+  return context->forward_input_or_allocate_output({0}, 0, shape, output);
+}
+
+// Reads the `lower` and `upper` attrs of the shrink activations.
+Status GetShrinkBounds(OpKernelConstruction *context, float *lower,
+                       float *upper) {
+  TF_RETURN_IF_ERROR(context->GetAttr("lower", lower));
+  TF_RETURN_IF_ERROR(context->GetAttr("upper", upper));
+  if (*lower > *upper) {
+    return errors::InvalidArgument("lower must not be greater than upper, got ",
+                                   *lower, " and ", *upper);
+  }
+  return Status::OK();
+}
+
+// The snake gradient is computed over blocks of this many elements, so that
+// the frequency gradient reduction reads the block from cache and is summed
+// in a fixed order.
+constexpr int64 kSnakeBlockSize = 4096;
+
+}  // namespace
+
+template <typename T>
+class MishOp : public OpKernel {
+ public:
+  explicit MishOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 1, &output));
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        context->input(0).flat<T>().unaryExpr(functor::MishFunctor<T>());
+  }
+};
+
+template <typename T>
+class MishGradOp : public OpKernel {
+ public:
+  explicit MishGradOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 2, &output));
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        context->input(0).flat<T>().binaryExpr(
+            context->input(1).flat<T>(), functor::MishGradFunctor<T>());
+  }
+};
+
+template <typename T>
+class LishtOp : public OpKernel {
+ public:
+  explicit LishtOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 1, &output));
+    const auto features = context->input(0).flat<T>();
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        features * features.tanh();
+  }
+};
+
+template <typename T>
+class LishtGradOp : public OpKernel {
+ public:
+  explicit LishtGradOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 2, &output));
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        context->input(0).flat<T>().binaryExpr(
+            context->input(1).flat<T>(), functor::LishtGradFunctor<T>());
+  }
+};
+
+template <typename T>
+class TanhshrinkOp : public OpKernel {
+ public:
+  explicit TanhshrinkOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 1, &output));
+    const auto features = context->input(0).flat<T>();
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        features - features.tanh();
+  }
+};
+
+template <typename T>
+class TanhshrinkGradOp : public OpKernel {
+ public:
+  explicit TanhshrinkGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 2, &output));
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        context->input(0).flat<T>() *
+        context->input(1).flat<T>().tanh().square();
+  }
+};
+
+template <typename T>
+class SoftshrinkOp : public OpKernel {
+ public:
+  explicit SoftshrinkOp(OpKernelConstruction *context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetShrinkBounds(context, &lower_, &upper_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 1, &output));
+    const auto features = context->input(0).flat<T>();
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        (features - T(upper_)).cwiseMax(T(0)) +
+        (features - T(lower_)).cwiseMin(T(0));
+  }
+
+ private:
+  float lower_;
+  float upper_;
+};
+
+template <typename T>
+class SoftshrinkGradOp : public OpKernel {
+ public:
+  explicit SoftshrinkGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetShrinkBounds(context, &lower_, &upper_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 2, &output));
+    const auto gradients = context->input(0).flat<T>();
+    const auto features = context->input(1).flat<T>();
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        (features < T(lower_) || features > T(upper_))
+            .select(gradients, gradients.constant(T(0)));
+  }
+
+ private:
+  float lower_;
+  float upper_;
+};
+
+template <typename T>
+class HardshrinkOp : public OpKernel {
+ public:
+  explicit HardshrinkOp(OpKernelConstruction *context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetShrinkBounds(context, &lower_, &upper_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 1, &output));
+    const auto features = context->input(0).flat<T>();
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        (features < T(lower_) || features > T(upper_))
+            .select(features, features.constant(T(0)));
+  }
+
+ private:
+  float lower_;
+  float upper_;
+};
+
+template <typename T>
+class HardshrinkGradOp : public OpKernel {
+ public:
+  explicit HardshrinkGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetShrinkBounds(context, &lower_, &upper_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 2, &output));
+    const auto gradients = context->input(0).flat<T>();
+    const auto features = context->input(1).flat<T>();
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        (features < T(lower_) || features > T(upper_))
+            .select(gradients, gradients.constant(T(0)));
+  }
+
+ private:
+  float lower_;
+  float upper_;
+};
+
+template <typename T>
+class SnakeOp : public OpKernel {
+ public:
+  explicit SnakeOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &frequency = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(frequency.shape()),
+                errors::InvalidArgument("frequency must be a scalar, got ",
+                                        frequency.shape().DebugString()));
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 1, &output));
+    output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+        context->input(0).flat<T>().unaryExpr(
+            functor::SnakeFunctor<T>(frequency.scalar<T>()()));
+  }
+};
+
+// Outputs the gradient of the features and of the frequency.
+template <typename T>
+class SnakeGradOp : public OpKernel {
+ public:
+  explicit SnakeGradOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &frequency = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(frequency.shape()),
+                errors::InvalidArgument("frequency must be a scalar, got ",
+                                        frequency.shape().DebugString()));
+    const T f = frequency.scalar<T>()();
+    const int64 size = context->input(0).NumElements();
+    const int64 num_blocks = Eigen::divup(size, kSnakeBlockSize);
+    Tensor partials;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({num_blocks}),
+                                          &partials));
+    // The output may share the buffer of the gradients, so the input pointers
+    // are taken first and every block is reduced before it is overwritten.
+    const T *gradients = context->input(0).flat<T>().data();
+    const T *features = context->input(1).flat<T>().data();
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 2, &output));
+    T *backprops = output->flat<T>().data();
+    auto sums = partials.vec<T>();
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 b = start; b < end; ++b) {
+        const int64 offset = b * kSnakeBlockSize;
+        const int64 length = std::min(kSnakeBlockSize, size - offset);
+        const typename TTypes<T>::UnalignedConstFlat g(gradients + offset,
+                                                       length);
+        const typename TTypes<T>::UnalignedConstFlat x(features + offset,
+                                                       length);
+        const Eigen::Tensor<T, 0, Eigen::RowMajor> sum =
+            g.binaryExpr(x, functor::SnakeFrequencyGradFunctor<T>(f)).sum();
+        sums(b) = sum();
+        typename TTypes<T>::UnalignedFlat(backprops + offset, length) =
+            g.binaryExpr(x, functor::SnakeGradFunctor<T>(f));
+      }
+    };
+    const int64 cost =
+        kSnakeBlockSize *
+        (3 * Eigen::internal::functor_traits<
+                 Eigen::internal::scalar_sin_op<T>>::Cost +
+         12 * Eigen::TensorOpCost::MulCost<T>());
+    context->eigen_device<CPUDevice>().parallelFor(
+        num_blocks,
+        Eigen::TensorOpCost(2 * sizeof(T) * kSnakeBlockSize,
+                            sizeof(T) * kSnakeBlockSize, cost),
+        work);
+
+    Tensor *frequency_backprop = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1, TensorShape({}),
+                                                     &frequency_backprop));
+    T total = T(0);
+    for (int64 b = 0; b < num_blocks; ++b) {
+      total += sums(b);
+    }
+    frequency_backprop->scalar<T>()() = total;
+  }
+};
+
+// `alpha` is either a scalar or has the shape of the features.
+template <typename T>
+class RreluOp : public OpKernel {
+ public:
+  explicit RreluOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &alpha = context->input(1);
+    const bool scalar_alpha = TensorShapeUtils::IsScalar(alpha.shape());
+    OP_REQUIRES(context,
+                scalar_alpha || alpha.shape() == context->input(0).shape(),
+                errors::InvalidArgument(
+                    "alpha must be a scalar or have the shape of features ",
+                    context->input(0).shape().DebugString(), ", got ",
+                    alpha.shape().DebugString()));
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 1, &output));
+    const auto features = context->input(0).flat<T>();
+    const CPUDevice &d = context->eigen_device<CPUDevice>();
+    if (scalar_alpha) {
+      output->flat<T>().device(d) = (features < T(0))
+                                        .select(features * alpha.scalar<T>()(),
+                                                features);
+    } else {
+      output->flat<T>().device(d) =
+          (features < T(0)).select(features * alpha.flat<T>(), features);
+    }
+  }
+};
+
+template <typename T>
+class RreluGradOp : public OpKernel {
+ public:
+  explicit RreluGradOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &alpha = context->input(2);
+    const bool scalar_alpha = TensorShapeUtils::IsScalar(alpha.shape());
+    OP_REQUIRES(context,
+                scalar_alpha || alpha.shape() == context->input(1).shape(),
+                errors::InvalidArgument(
+                    "alpha must be a scalar or have the shape of features ",
+                    context->input(1).shape().DebugString(), ", got ",
+                    alpha.shape().DebugString()));
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, AllocateActivationOutput(context, 2, &output));
+    const auto gradients = context->input(0).flat<T>();
+    const auto features = context->input(1).flat<T>();
+    const CPUDevice &d = context->eigen_device<CPUDevice>();
+    if (scalar_alpha) {
+      output->flat<T>().device(d) =
+          (features < T(0))
+              .select(gradients * alpha.scalar<T>()(), gradients);
+    } else {
+      output->flat<T>().device(d) =
+          (features < T(0)).select(gradients * alpha.flat<T>(), gradients);
+    }
+  }
+};
+
+#define REGISTER_CPU_KERNEL(OP, T)                                  \
+  REGISTER_KERNEL_BUILDER(                                          \
+      Name("Addons>" #OP).Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      OP##Op<T>);
+
+#define REGISTER_CPU_KERNELS(T)            \
+  REGISTER_CPU_KERNEL(Mish, T);            \
+  REGISTER_CPU_KERNEL(MishGrad, T);        \
+  REGISTER_CPU_KERNEL(Lisht, T);           \
+  REGISTER_CPU_KERNEL(LishtGrad, T);       \
+  REGISTER_CPU_KERNEL(Tanhshrink, T);      \
+  REGISTER_CPU_KERNEL(TanhshrinkGrad, T);  \
+  REGISTER_CPU_KERNEL(Softshrink, T);      \
+  REGISTER_CPU_KERNEL(SoftshrinkGrad, T);  \
+  REGISTER_CPU_KERNEL(Hardshrink, T);      \
+  REGISTER_CPU_KERNEL(HardshrinkGrad, T);  \
+  REGISTER_CPU_KERNEL(Snake, T);           \
+  REGISTER_CPU_KERNEL(SnakeGrad, T);       \
+  REGISTER_CPU_KERNEL(Rrelu, T);           \
+  REGISTER_CPU_KERNEL(RreluGrad, T);
+
+REGISTER_CPU_KERNELS(float);
+REGISTER_CPU_KERNELS(double);
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
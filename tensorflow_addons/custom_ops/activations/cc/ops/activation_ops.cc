@@ -0,0 +1,195 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>Mish")
+    .Input("features: T")
+    .Output("activations: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Computes `features * tanh(softplus(features))`.
+)doc");
+
+REGISTER_OP("Addons>MishGrad")
+    .Input("gradients: T")
+    .Input("features: T")
+    .Output("backprops: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn(shape_inference::MergeBothInputsShapeFn)
+    .Doc(R"doc(
+Gradients of Mish with respect to the features.
+)doc");
+
+REGISTER_OP("Addons>Lisht")
+    .Input("features: T")
+    .Output("activations: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Computes `features * tanh(features)`.
+)doc");
+
+REGISTER_OP("Addons>LishtGrad")
+    .Input("gradients: T")
+    .Input("features: T")
+    .Output("backprops: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn(shape_inference::MergeBothInputsShapeFn)
+    .Doc(R"doc(
+Gradients of Lisht with respect to the features.
+)doc");
+
+REGISTER_OP("Addons>Tanhshrink")
+    .Input("features: T")
+    .Output("activations: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Computes `features - tanh(features)`.
+)doc");
+
+REGISTER_OP("Addons>TanhshrinkGrad")
+    .Input("gradients: T")
+    .Input("features: T")
+    .Output("backprops: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn(shape_inference::MergeBothInputsShapeFn)
+    .Doc(R"doc(
+Gradients of Tanhshrink with respect to the features.
+)doc");
+
+REGISTER_OP("Addons>Softshrink")
+    .Input("features: T")
+    .Output("activations: T")
+    .Attr("T: {float, double}")
+    .Attr("lower: float = -0.5")
+    .Attr("upper: float = 0.5")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Computes `features - lower` below `lower`, `features - upper` above `upper`
+and zero in between.
+)doc");
+
+REGISTER_OP("Addons>SoftshrinkGrad")
+    .Input("gradients: T")
+    .Input("features: T")
+    .Output("backprops: T")
+    .Attr("T: {float, double}")
+    .Attr("lower: float = -0.5")
+    .Attr("upper: float = 0.5")
+    .SetShapeFn(shape_inference::MergeBothInputsShapeFn)
+    .Doc(R"doc(
+Gradients of Softshrink with respect to the features.
+)doc");
+
+REGISTER_OP("Addons>Hardshrink")
+    .Input("features: T")
+    .Output("activations: T")
+    .Attr("T: {float, double}")
+    .Attr("lower: float = -0.5")
+    .Attr("upper: float = 0.5")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Computes `features` below `lower` and above `upper` and zero in between.
+)doc");
+
+REGISTER_OP("Addons>HardshrinkGrad")
+    .Input("gradients: T")
+    .Input("features: T")
+    .Output("backprops: T")
+    .Attr("T: {float, double}")
+    .Attr("lower: float = -0.5")
+    .Attr("upper: float = 0.5")
+    .SetShapeFn(shape_inference::MergeBothInputsShapeFn)
+    .Doc(R"doc(
+Gradients of Hardshrink with respect to the features.
+)doc");
+
+REGISTER_OP("Addons>Snake")
+    .Input("features: T")
+    .Input("frequency: T")
+    .Output("activations: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      c->set_output(0, c->input(0));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes `features + sin(frequency * features)^2 / frequency`.
+
+frequency: A scalar.
+)doc");
+
+REGISTER_OP("Addons>SnakeGrad")
+    .Input("gradients: T")
+    .Input("features: T")
+    .Input("frequency: T")
+    .Output("backprops: T")
+    .Output("frequency_backprop: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle features, unused;
+      TF_RETURN_IF_ERROR(c->Merge(c->input(0), c->input(1), &features));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      c->set_output(0, features);
+      c->set_output(1, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of Snake with respect to the features and the frequency.
+)doc");
+
+REGISTER_OP("Addons>Rrelu")
+    .Input("features: T")
+    .Input("alpha: T")
+    .Output("activations: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Computes `features` where it is non-negative and `alpha * features` elsewhere.
+
+alpha: A scalar or a tensor with the shape of `features`.
+)doc");
+
+REGISTER_OP("Addons>RreluGrad")
+    .Input("gradients: T")
+    .Input("features: T")
+    .Input("alpha: T")
+    .Output("backprops: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle features;
+      TF_RETURN_IF_ERROR(c->Merge(c->input(0), c->input(1), &features));
+      c->set_output(0, features);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of Rrelu with respect to the features.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
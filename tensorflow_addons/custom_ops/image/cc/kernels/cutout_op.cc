@@ -0,0 +1,126 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Fills the `mask_size` rectangle centered at `offset` of every image with
+// `constant_values`, clipped to the image. The output forwards the buffer of
+// `images` when possible; only the pixels of the rectangles are written.
+template <typename T>
+class CutoutOp : public OpKernel {
+ public:
+  explicit CutoutOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &images = context->input(0);
+    const Tensor &mask_size = context->input(1);
+    const Tensor &offset = context->input(2);
+    const Tensor &constant_values = context->input(3);
+    OP_REQUIRES(context, images.dims() == 4,
+                errors::InvalidArgument("images must be 4-D, got ",
+                                        images.shape().DebugString()));
+    const int64 batch = images.dim_size(0);
+    const int64 height = images.dim_size(1);
+    const int64 width = images.dim_size(2);
+    const int64 channels = images.dim_size(3);
+    OP_REQUIRES(context, mask_size.shape() == TensorShape({2}),
+                errors::InvalidArgument("mask_size must have shape [2], got ",
+                                        mask_size.shape().DebugString()));
+    OP_REQUIRES(
+        context,
+        TensorShapeUtils::IsMatrix(offset.shape()) &&
+            (offset.dim_size(0) == batch || offset.dim_size(0) == 1) &&
+            offset.dim_size(1) == 2,
+        errors::InvalidArgument("offset must have shape [", batch,
+                                ", 2] or [1, 2], got ",
+                                offset.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsScalar(constant_values.shape()),
+                errors::InvalidArgument(
+                    "constant_values must be a scalar, got ",
+                    constant_values.shape().DebugString()));
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, images.shape(), &output));
+    if (!output->SharesBufferWith(images)) {
+      output->flat<T>().device(context->eigen_device<CPUDevice>()) =
+          images.flat<T>();
+    }
+    if (output->NumElements() == 0) {
+      return;
+    }
+
+    const int64 half_height = mask_size.vec<int32>()(0) / 2;
+    const int64 half_width = mask_size.vec<int32>()(1) / 2;
+    const auto centers = offset.matrix<int32>();
+    const T value = constant_values.scalar<T>()();
+    T *out = output->flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 b = start; b < end; ++b) {
+        const int64 i = offset.dim_size(0) == 1 ? 0 : b;
+        const int64 row_begin =
+            std::min(std::max(centers(i, 0) - half_height, int64{0}), height);
+        const int64 row_end =
+            std::min(std::max(centers(i, 0) + half_height, int64{0}), height);
+        const int64 col_begin =
+            std::min(std::max(centers(i, 1) - half_width, int64{0}), width);
+        const int64 col_end =
+            std::min(std::max(centers(i, 1) + half_width, int64{0}), width);
+        for (int64 r = row_begin; r < row_end; ++r) {
+          T *row = out + ((b * height + r) * width + col_begin) * channels;
+          std::fill(row, row + (col_end - col_begin) * channels, value);
+        }
+      }
+    };
+    const int64 area = std::min(2 * half_height, height) *
+                       std::min(2 * half_width, width) * channels;
+    const Eigen::TensorOpCost cost(0, sizeof(T) * area, area);
+    context->eigen_device<CPUDevice>().parallelFor(batch, cost, work);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("Addons>Cutout").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      CutoutOp<T>);
+
+TF_CALL_int64(REGISTER_CPU_KERNEL);
+TF_CALL_int32(REGISTER_CPU_KERNEL);
+TF_CALL_uint16(REGISTER_CPU_KERNEL);
+TF_CALL_int16(REGISTER_CPU_KERNEL);
+TF_CALL_uint8(REGISTER_CPU_KERNEL);
+TF_CALL_int8(REGISTER_CPU_KERNEL);
+TF_CALL_half(REGISTER_CPU_KERNEL);
+TF_CALL_bfloat16(REGISTER_CPU_KERNEL);
+TF_CALL_float(REGISTER_CPU_KERNEL);
+TF_CALL_double(REGISTER_CPU_KERNEL);
+TF_CALL_bool(REGISTER_CPU_KERNEL);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
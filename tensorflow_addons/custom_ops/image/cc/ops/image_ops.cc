@@ -51,8 +51,39 @@ components: Component ids for each pixel in "image". Same shape as "image". Zero
     the same value are given consecutive ids, starting from 1.
 )doc";
 
+static const char CutoutDoc[] = R"doc(
+Applies cutout to image(s).
+
+Input `images` is a `Tensor` in NHWC format (batch, rows, columns, and
+channels). For every image, the pixels of the `mask_size` rectangle centered
+at the `(row, column)` of `offset`, clipped to the image, are set to
+`constant_values`. `offset` has one row per image, or a single row for all of
+them. The output reuses the buffer of `images` when possible, and the pixels
+outside of the rectangles are not written.
+)doc";
+
 }  // namespace
 
+REGISTER_OP("Addons>Cutout")
+    .Input("images: T")
+    .Input("mask_size: int32")
+    .Input("offset: int32")
+    .Input("constant_values: T")
+    .Output("output: T")
+    .Attr(
+        "T: {int64, int32, uint16, int16, uint8, int8, half, bfloat16, float, "
+        "double, bool}")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      c->set_output(0, c->input(0));
+      return Status::OK();
+    })
+    .Doc(CutoutDoc);
+
 REGISTER_OP("Addons>EuclideanDistanceTransform")
     .Input("images: uint8")
     .Attr("dtype: {float16, float32, float64}")
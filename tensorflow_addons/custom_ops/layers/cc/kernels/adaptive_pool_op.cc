@@ -0,0 +1,388 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Channels of a channels_last input are pooled in blocks of this many, so
+// that the innermost loop reads contiguous memory.
+constexpr int64 kChannelBlock = 64;
+
+// A pooling window, as half-open ranges over depth, height and width.
+struct Bin {
+  int64 start[3];
+  int64 end[3];
+};
+
+// The input viewed as `[batch, channels, depth, height, width]` through
+// strides, with the missing spatial dimensions of 1D and 2D inputs set to 1.
+struct PoolShape {
+  int64 batch;
+  int64 channels;
+  int64 extent[3];
+  int64 batch_stride;
+  int64 channel_stride;
+  int64 spatial_stride;
+  bool channels_last;
+
+  int64 spatial_size() const { return extent[0] * extent[1] * extent[2]; }
+};
+
+Status GetPoolShape(const TensorShape &shape, bool channels_last,
+                    PoolShape *pool) {
+  const int rank = shape.dims();
+  if (rank < 3 || rank > 5) {
+    return errors::InvalidArgument("input must have rank 3, 4 or 5, got ",
+                                   shape.DebugString());
+  }
+  const int spatial_dims = rank - 2;
+  const int first_spatial = channels_last ? 1 : 2;
+  pool->batch = shape.dim_size(0);
+  pool->channels = shape.dim_size(channels_last ? rank - 1 : 1);
+  for (int i = 0; i < 3; ++i) {
+    const int dim = i - (3 - spatial_dims);
+    pool->extent[i] = dim < 0 ? 1 : shape.dim_size(first_spatial + dim);
+    if (pool->extent[i] == 0) {
+      return errors::InvalidArgument(
+          "The spatial dimensions of the input must be nonzero, got ",
+          shape.DebugString());
+    }
+  }
+  const int64 spatial = pool->spatial_size();
+  pool->channels_last = channels_last;
+  pool->batch_stride = spatial * pool->channels;
+  pool->channel_stride = channels_last ? 1 : spatial;
+  pool->spatial_stride = channels_last ? pool->channels : 1;
+  return Status::OK();
+}
+
+// Splits `output_sizes` into pyramid levels of `spatial_dims` sizes each and
+// returns the windows of all their bins in output order. Bin `i` of `n` over
+// an extent `e` covers [floor(i * e / n), ceil((i + 1) * e / n)), so bins
+// cover the whole input for any sizes and overlap when `n` does not divide
+// `e`. With `drop_remainder`, every level instead pools the leading
+// `e - e % n` positions into bins of `e / n`, as when splitting the cropped
+// input.
+Status GetBins(const std::vector<int32> &output_sizes, int spatial_dims,
+               bool drop_remainder, const PoolShape &pool,
+               std::vector<Bin> *bins) {
+  if (output_sizes.empty() || output_sizes.size() % spatial_dims != 0) {
+    return errors::InvalidArgument(
+        "output_sizes must hold ", spatial_dims,
+        " sizes for every pyramid level, got ", output_sizes.size());
+  }
+  bins->clear();
+  for (size_t level = 0; level < output_sizes.size(); level += spatial_dims) {
+    int64 sizes[3] = {1, 1, 1};
+    for (int i = 0; i < spatial_dims; ++i) {
+      sizes[3 - spatial_dims + i] = output_sizes[level + i];
+      if (output_sizes[level + i] <= 0) {
+        return errors::InvalidArgument("output_sizes must be positive, got ",
+                                       output_sizes[level + i]);
+      }
+    }
+    for (int64 d = 0; d < sizes[0]; ++d) {
+      for (int64 h = 0; h < sizes[1]; ++h) {
+        for (int64 w = 0; w < sizes[2]; ++w) {
+          const int64 index[3] = {d, h, w};
+          Bin bin;
+          for (int i = 0; i < 3; ++i) {
+            if (drop_remainder) {
+              const int64 bin_size = pool.extent[i] / sizes[i];
+              bin.start[i] = index[i] * bin_size;
+              bin.end[i] = (index[i] + 1) * bin_size;
+            } else {
+              bin.start[i] = index[i] * pool.extent[i] / sizes[i];
+              bin.end[i] = ((index[i] + 1) * pool.extent[i] + sizes[i] - 1) /
+                           sizes[i];
+            }
+          }
+          bins->push_back(bin);
+        }
+      }
+    }
+  }
+  return Status::OK();
+}
+
+// Calls `fn(offset)` with the spatial offset of every position of `bin`.
+template <typename Fn>
+void ForEachPosition(const Bin &bin, const PoolShape &pool, Fn fn) {
+  for (int64 d = bin.start[0]; d < bin.end[0]; ++d) {
+    for (int64 h = bin.start[1]; h < bin.end[1]; ++h) {
+      const int64 row = (d * pool.extent[1] + h) * pool.extent[2];
+      for (int64 w = bin.start[2]; w < bin.end[2]; ++w) {
+        fn((row + w) * pool.spatial_stride);
+      }
+    }
+  }
+}
+
+int64 BinSize(const Bin &bin) {
+  return (bin.end[0] - bin.start[0]) * (bin.end[1] - bin.start[1]) *
+         (bin.end[2] - bin.start[2]);
+}
+
+// Work is sharded over (batch, channel block) pairs. Every shard reads and
+// writes a disjoint set of channels, so the gradient of overlapping bins can
+// be accumulated without synchronization.
+int64 ChannelBlockSize(const PoolShape &pool) {
+  return pool.channels_last ? std::min(pool.channels, kChannelBlock) : 1;
+}
+
+// The output is `[batch, num_bins, channels]` for channels_last inputs and
+// `[batch, channels, num_bins]` otherwise; returns the offset of bin 0 of
+// channel `c` in example `b`, and the stride between bins.
+void OutputLayout(const PoolShape &pool, int64 num_bins, int64 b, int64 c,
+                  int64 *offset, int64 *bin_stride) {
+  if (pool.channels_last) {
+    *offset = (b * num_bins) * pool.channels + c;
+    *bin_stride = pool.channels;
+  } else {
+    *offset = (b * pool.channels + c) * num_bins;
+    *bin_stride = 1;
+  }
+}
+
+class AdaptivePoolBase : public OpKernel {
+ public:
+  explicit AdaptivePoolBase(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("output_sizes", &output_sizes_));
+    std::string pooling_type, data_format;
+    OP_REQUIRES_OK(context, context->GetAttr("pooling_type", &pooling_type));
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("drop_remainder", &drop_remainder_));
+    max_pooling_ = pooling_type == "max";
+    channels_last_ = data_format == "channels_last";
+  }
+
+ protected:
+  // Reads the shape of `input` and the windows of all bins.
+  Status Prepare(const Tensor &input, PoolShape *pool,
+                 std::vector<Bin> *bins) const {
+    TF_RETURN_IF_ERROR(GetPoolShape(input.shape(), channels_last_, pool));
+    return GetBins(output_sizes_, input.dims() - 2, drop_remainder_, *pool,
+                   bins);
+  }
+
+  TensorShape OutputShape(const PoolShape &pool, int64 num_bins) const {
+    return channels_last_ ? TensorShape({pool.batch, num_bins, pool.channels})
+                          : TensorShape({pool.batch, pool.channels, num_bins});
+  }
+
+  // The cost of pooling one channel block over every bin.
+  Eigen::TensorOpCost ShardCost(const PoolShape &pool,
+                                const std::vector<Bin> &bins,
+                                int64 element_size) const {
+    double window_size = 0.0;
+    for (const Bin &bin : bins) {
+      window_size += static_cast<double>(BinSize(bin));
+    }
+    const double block = static_cast<double>(ChannelBlockSize(pool));
+    return Eigen::TensorOpCost(window_size * block * element_size,
+                               bins.size() * block * element_size,
+                               window_size * block);
+  }
+
+  std::vector<int32> output_sizes_;
+  bool max_pooling_;
+  bool channels_last_;
+  bool drop_remainder_;
+};
+
+}  // namespace
+
+// Max or average pools an input with 1, 2 or 3 spatial dimensions into every
+// level of a pyramid of output sizes in one pass. The bin boundaries are
+// computed on the fly, so the output sizes need not divide the input.
+template <typename T>
+class AdaptivePoolOp : public AdaptivePoolBase {
+ public:
+  explicit AdaptivePoolOp(OpKernelConstruction *context)
+      : AdaptivePoolBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &input = context->input(0);
+    PoolShape pool;
+    std::vector<Bin> bins;
+    OP_REQUIRES_OK(context, Prepare(input, &pool, &bins));
+    const int64 num_bins = bins.size();
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, OutputShape(pool, num_bins), &output));
+    if (output->NumElements() == 0) {
+      return;
+    }
+
+    const T *x = input.flat<T>().data();
+    T *y = output->flat<T>().data();
+    const int64 block = ChannelBlockSize(pool);
+    const int64 num_blocks = (pool.channels + block - 1) / block;
+    const bool max_pooling = max_pooling_;
+    const auto work = [&](int64 start, int64 end) {
+      std::vector<T> acc(block);
+      for (int64 shard = start; shard < end; ++shard) {
+        const int64 b = shard / num_blocks;
+        const int64 c0 = (shard % num_blocks) * block;
+        const int64 channels = std::min(block, pool.channels - c0);
+        const T *x_block =
+            x + b * pool.batch_stride + c0 * pool.channel_stride;
+        int64 y_offset, bin_stride;
+        OutputLayout(pool, num_bins, b, c0, &y_offset, &bin_stride);
+        const int64 y_channel_stride = pool.channels_last ? 1 : num_bins;
+        for (int64 k = 0; k < num_bins; ++k) {
+          const Bin &bin = bins[k];
+          std::fill(acc.begin(), acc.end(),
+                    max_pooling ? std::numeric_limits<T>::lowest() : T(0));
+          ForEachPosition(bin, pool, [&](int64 offset) {
+            const T *values = x_block + offset;
+            for (int64 c = 0; c < channels; ++c) {
+              const T value = values[c * pool.channel_stride];
+              acc[c] = max_pooling ? std::max(acc[c], value) : acc[c] + value;
+            }
+          });
+          const T scale =
+              max_pooling ? T(1) : T(1) / static_cast<T>(BinSize(bin));
+          T *y_bin = y + y_offset + k * bin_stride;
+          for (int64 c = 0; c < channels; ++c) {
+            y_bin[c * y_channel_stride] = acc[c] * scale;
+          }
+        }
+      }
+    };
+    context->eigen_device<CPUDevice>().parallelFor(
+        pool.batch * num_blocks, ShardCost(pool, bins, sizeof(T)), work);
+  }
+};
+
+// Backpropagates through AdaptivePool. Average pooling spreads the gradient
+// of a bin evenly over its window, and max pooling routes it to the first
+// maximum of the window, which is found again from the input.
+template <typename T>
+class AdaptivePoolGradOp : public AdaptivePoolBase {
+ public:
+  explicit AdaptivePoolGradOp(OpKernelConstruction *context)
+      : AdaptivePoolBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &input = context->input(0);
+    const Tensor &grad = context->input(1);
+    PoolShape pool;
+    std::vector<Bin> bins;
+    OP_REQUIRES_OK(context, Prepare(input, &pool, &bins));
+    const int64 num_bins = bins.size();
+    const TensorShape output_shape = OutputShape(pool, num_bins);
+    OP_REQUIRES(context, grad.shape() == output_shape,
+                errors::InvalidArgument("grad should have shape ",
+                                        output_shape.DebugString(), ", got ",
+                                        grad.shape().DebugString()));
+    Tensor *input_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, input.shape(),
+                                                     &input_grad));
+    input_grad->flat<T>().setZero();
+    if (grad.NumElements() == 0) {
+      return;
+    }
+
+    const T *x = input.flat<T>().data();
+    const T *dy = grad.flat<T>().data();
+    T *dx = input_grad->flat<T>().data();
+    const int64 block = ChannelBlockSize(pool);
+    const int64 num_blocks = (pool.channels + block - 1) / block;
+    const bool max_pooling = max_pooling_;
+    const auto work = [&](int64 start, int64 end) {
+      std::vector<T> best(block);
+      std::vector<int64> argmax(block);
+      for (int64 shard = start; shard < end; ++shard) {
+        const int64 b = shard / num_blocks;
+        const int64 c0 = (shard % num_blocks) * block;
+        const int64 channels = std::min(block, pool.channels - c0);
+        const int64 x_offset =
+            b * pool.batch_stride + c0 * pool.channel_stride;
+        const T *x_block = x + x_offset;
+        T *dx_block = dx + x_offset;
+        int64 dy_offset, bin_stride;
+        OutputLayout(pool, num_bins, b, c0, &dy_offset, &bin_stride);
+        const int64 dy_channel_stride = pool.channels_last ? 1 : num_bins;
+        for (int64 k = 0; k < num_bins; ++k) {
+          const Bin &bin = bins[k];
+          const T *dy_bin = dy + dy_offset + k * bin_stride;
+          if (max_pooling) {
+            std::fill(best.begin(), best.end(),
+                      std::numeric_limits<T>::lowest());
+            std::fill(argmax.begin(), argmax.end(), -1);
+            ForEachPosition(bin, pool, [&](int64 offset) {
+              for (int64 c = 0; c < channels; ++c) {
+                const int64 index = offset + c * pool.channel_stride;
+                if (argmax[c] < 0 || x_block[index] > best[c]) {
+                  best[c] = x_block[index];
+                  argmax[c] = index;
+                }
+              }
+            });
+            // Bins are empty when drop_remainder crops the whole extent.
+            for (int64 c = 0; c < channels && argmax[c] >= 0; ++c) {
+              dx_block[argmax[c]] += dy_bin[c * dy_channel_stride];
+            }
+          } else {
+            const T scale = T(1) / static_cast<T>(BinSize(bin));
+            ForEachPosition(bin, pool, [&](int64 offset) {
+              for (int64 c = 0; c < channels; ++c) {
+                dx_block[offset + c * pool.channel_stride] +=
+                    dy_bin[c * dy_channel_stride] * scale;
+              }
+            });
+          }
+        }
+      }
+    };
+    context->eigen_device<CPUDevice>().parallelFor(
+        pool.batch * num_blocks, ShardCost(pool, bins, sizeof(T)), work);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                  \
+  REGISTER_KERNEL_BUILDER(Name("Addons>AdaptivePool")           \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          AdaptivePoolOp<T>);                   \
+  REGISTER_KERNEL_BUILDER(Name("Addons>AdaptivePoolGrad")       \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          AdaptivePoolGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
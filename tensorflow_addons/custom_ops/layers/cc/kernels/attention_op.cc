@@ -0,0 +1,509 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+template <typename T>
+using RowMajorMatrix =
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+template <typename T>
+using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+// A block of rows of one head of a `[..., elements, heads, depth]` tensor.
+template <typename T>
+using ConstHeadMap =
+    Eigen::Map<const RowMajorMatrix<T>, 0, Eigen::OuterStride<>>;
+
+template <typename T>
+using HeadMap = Eigen::Map<RowMajorMatrix<T>, 0, Eigen::OuterStride<>>;
+
+// The attention is computed for blocks of this many queries against blocks of
+// this many keys, so that the scores of a block fit in cache.
+constexpr int64 kQueryBlock = 32;
+constexpr int64 kKeyBlock = 64;
+
+// Added to the logits of the masked keys, like the Python implementation.
+constexpr double kMaskPenalty = -10e9;
+
+// The inputs of the attention of all heads, with the sizes and strides needed
+// to read the tiles of one (example, head) pair.
+template <typename T>
+class AttentionInputs {
+ public:
+  AttentionInputs(const Tensor &query, const Tensor &key, const Tensor &value,
+                  const Tensor &mask, const Tensor &seed, float dropout_rate)
+      : batch_(query.dim_size(0)),
+        queries_(query.dim_size(1)),
+        heads_(query.dim_size(2)),
+        depth_(query.dim_size(3)),
+        keys_(key.dim_size(1)),
+        value_depth_(value.dim_size(3)),
+        query_(query.flat<T>().data()),
+        key_(key.flat<T>().data()),
+        value_(value.flat<T>().data()),
+        mask_(mask.NumElements() > 0 ? mask.flat<T>().data() : nullptr),
+        mask_batch_(mask.NumElements() > 0 ? mask.dim_size(0) : 0),
+        mask_heads_(mask.NumElements() > 0 ? mask.dim_size(1) : 0),
+        dropout_rate_(dropout_rate),
+        seed_lo_(seed.flat<int64>()(0)),
+        seed_hi_(seed.flat<int64>()(1)) {}
+
+  int64 batch() const { return batch_; }
+  int64 queries() const { return queries_; }
+  int64 heads() const { return heads_; }
+  int64 depth() const { return depth_; }
+  int64 keys() const { return keys_; }
+  int64 value_depth() const { return value_depth_; }
+  bool has_dropout() const { return dropout_rate_ > 0.0f; }
+
+  // The offset of row `n` of head `bh` in a `[batch, n, heads, depth]`
+  // tensor with `n` rows per example.
+  int64 RowOffset(int64 bh, int64 n, int64 rows, int64 depth) const {
+    const int64 b = bh / heads_, h = bh % heads_;
+    return ((b * rows + n) * heads_ + h) * depth;
+  }
+
+  ConstHeadMap<T> Queries(int64 bh, int64 n0, int64 rows) const {
+    return ConstHeadMap<T>(query_ + RowOffset(bh, n0, queries_, depth_), rows,
+                           depth_, Eigen::OuterStride<>(heads_ * depth_));
+  }
+
+  ConstHeadMap<T> Keys(int64 bh, int64 m0, int64 cols) const {
+    return ConstHeadMap<T>(key_ + RowOffset(bh, m0, keys_, depth_), cols,
+                           depth_, Eigen::OuterStride<>(heads_ * depth_));
+  }
+
+  ConstHeadMap<T> Values(int64 bh, int64 m0, int64 cols) const {
+    return ConstHeadMap<T>(value_ + RowOffset(bh, m0, keys_, value_depth_),
+                           cols, value_depth_,
+                           Eigen::OuterStride<>(heads_ * value_depth_));
+  }
+
+  // Computes the masked logits of queries [n0, n0 + rows) against keys
+  // [m0, m0 + cols) of head `bh` into `scores`.
+  template <typename Scores>
+  void Logits(int64 bh, int64 n0, int64 rows, int64 m0, int64 cols,
+              Scores &&scores) const {
+    scores.noalias() = Queries(bh, n0, rows) * Keys(bh, m0, cols).transpose();
+    if (mask_ != nullptr) {
+      const int64 b = mask_batch_ == 1 ? 0 : bh / heads_;
+      const int64 h = mask_heads_ == 1 ? 0 : bh % heads_;
+      const ConstHeadMap<T> mask(
+          mask_ + ((b * mask_heads_ + h) * queries_ + n0) * keys_ + m0, rows,
+          cols, Eigen::OuterStride<>(keys_));
+      scores.array() +=
+          static_cast<T>(kMaskPenalty) * (T(1) - mask.array());
+    }
+  }
+
+  // Multiplies the attention of queries [n0, n0 + rows) to keys
+  // [m0, m0 + cols) of head `bh` by the dropout scale. The keep decision of
+  // every element is a counter-based draw from the seed, so the backward
+  // pass recomputes the same mask without storing it.
+  template <typename Weights>
+  void ApplyDropout(int64 bh, int64 n0, int64 rows, int64 m0, int64 cols,
+                    Weights &&weights) const {
+    const int64 draws_per_row = (keys_ + 3) / 4;
+    const T keep_scale = static_cast<T>(1.0f / (1.0f - dropout_rate_));
+    for (int64 i = 0; i < rows; ++i) {
+      random::PhiloxRandom generator(seed_lo_, seed_hi_);
+      generator.Skip((bh * queries_ + n0 + i) * draws_per_row + m0 / 4);
+      random::PhiloxRandom::ResultType bits = generator();
+      for (int64 j = 0; j < cols; ++j) {
+        const int64 m = m0 + j;
+        if (j > 0 && m % 4 == 0) {
+          bits = generator();
+        }
+        const float uniform =
+            static_cast<float>(bits[m % 4] >> 8) * (1.0f / (1 << 24));
+        weights(i, j) *= uniform < dropout_rate_ ? T(0) : keep_scale;
+      }
+    }
+  }
+
+  // The cost of computing the attention between a block of queries and all
+  // keys.
+  Eigen::TensorOpCost BlockCost(int64 rows, int64 cols) const {
+    const double size = static_cast<double>(rows * cols);
+    return Eigen::TensorOpCost(
+        sizeof(T) * cols * (depth_ + value_depth_),
+        sizeof(T) * rows * value_depth_,
+        size * 2 * (depth_ + value_depth_ + (has_dropout() ? 16 : 4)));
+  }
+
+ private:
+  const int64 batch_, queries_, heads_, depth_, keys_, value_depth_;
+  const T *query_;
+  const T *key_;
+  const T *value_;
+  const T *mask_;
+  const int64 mask_batch_, mask_heads_;
+  const float dropout_rate_;
+  const uint64 seed_lo_, seed_hi_;
+};
+
+Status CheckInputs(const Tensor &query, const Tensor &key, const Tensor &value,
+                   const Tensor &mask, const Tensor &seed) {
+  if (query.dims() != 4 || key.dims() != 4 || value.dims() != 4) {
+    return errors::InvalidArgument(
+        "query, key and value must have rank 4, got ",
+        query.shape().DebugString(), ", ", key.shape().DebugString(), " and ",
+        value.shape().DebugString());
+  }
+  if (key.dim_size(0) != query.dim_size(0) ||
+      key.dim_size(2) != query.dim_size(2) ||
+      key.dim_size(3) != query.dim_size(3)) {
+    return errors::InvalidArgument(
+        "key should have shape [", query.dim_size(0), ", key_elements, ",
+        query.dim_size(2), ", ", query.dim_size(3), "], got ",
+        key.shape().DebugString());
+  }
+  if (value.dim_size(0) != key.dim_size(0) ||
+      value.dim_size(1) != key.dim_size(1) ||
+      value.dim_size(2) != key.dim_size(2)) {
+    return errors::InvalidArgument(
+        "value should have shape [", key.dim_size(0), ", ", key.dim_size(1),
+        ", ", key.dim_size(2), ", value_depth], got ",
+        value.shape().DebugString());
+  }
+  if (mask.NumElements() > 0) {
+    if (mask.dims() != 4 ||
+        (mask.dim_size(0) != 1 && mask.dim_size(0) != query.dim_size(0)) ||
+        (mask.dim_size(1) != 1 && mask.dim_size(1) != query.dim_size(2)) ||
+        mask.dim_size(2) != query.dim_size(1) ||
+        mask.dim_size(3) != key.dim_size(1)) {
+      return errors::InvalidArgument(
+          "mask should be empty or have shape [1 or ", query.dim_size(0),
+          ", 1 or ", query.dim_size(2), ", ", query.dim_size(1), ", ",
+          key.dim_size(1), "], got ", mask.shape().DebugString());
+    }
+  }
+  if (seed.NumElements() != 2) {
+    return errors::InvalidArgument("seed must have 2 elements, got ",
+                                   seed.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// Computes the attention of every head in blocks of queries. The keys are
+// visited in blocks, and a running maximum and sum of the exponentiated
+// logits of every query rescale the partial outputs, so that only one block
+// of logits is held at a time. The log-sum-exp of the logits of every query
+// is returned for the backward pass.
+template <typename T>
+class DotProductAttentionOp : public OpKernel {
+ public:
+  explicit DotProductAttentionOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("dropout_rate", &dropout_rate_));
+    OP_REQUIRES(context, dropout_rate_ >= 0.0f && dropout_rate_ < 1.0f,
+                errors::InvalidArgument("dropout_rate must be in [0, 1), got ",
+                                        dropout_rate_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &query = context->input(0);
+    const Tensor &key = context->input(1);
+    const Tensor &value = context->input(2);
+    const Tensor &mask = context->input(3);
+    const Tensor &seed = context->input(4);
+    OP_REQUIRES_OK(context, CheckInputs(query, key, value, mask, seed));
+    const AttentionInputs<T> inputs(query, key, value, mask, seed,
+                                    dropout_rate_);
+    const int64 bh_size = inputs.batch() * inputs.heads();
+    const int64 queries = inputs.queries();
+    const int64 keys = inputs.keys();
+    const int64 value_depth = inputs.value_depth();
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0,
+                                TensorShape({inputs.batch(), queries,
+                                             inputs.heads(), value_depth}),
+                                &output));
+    Tensor *logsumexp = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1,
+                                TensorShape({inputs.batch(), inputs.heads(),
+                                             queries}),
+                                &logsumexp));
+    if (keys == 0) {
+      output->flat<T>().setZero();
+      logsumexp->flat<T>().setConstant(-std::numeric_limits<T>::infinity());
+      return;
+    }
+
+    T *y = output->flat<T>().data();
+    T *lse = logsumexp->flat<T>().data();
+    const int64 num_blocks = (queries + kQueryBlock - 1) / kQueryBlock;
+    const auto work = [&](int64 start, int64 end) {
+      RowMajorMatrix<T> scores(kQueryBlock, kKeyBlock);
+      RowMajorMatrix<T> acc(kQueryBlock, value_depth);
+      Vector<T> row_max(kQueryBlock), row_sum(kQueryBlock);
+      for (int64 shard = start; shard < end; ++shard) {
+        const int64 bh = shard / num_blocks;
+        const int64 n0 = (shard % num_blocks) * kQueryBlock;
+        const int64 rows = std::min(kQueryBlock, queries - n0);
+        acc.setZero();
+        row_max.setConstant(-std::numeric_limits<T>::infinity());
+        row_sum.setZero();
+        for (int64 m0 = 0; m0 < keys; m0 += kKeyBlock) {
+          const int64 cols = std::min(kKeyBlock, keys - m0);
+          auto s = scores.topLeftCorner(rows, cols);
+          inputs.Logits(bh, n0, rows, m0, cols, s);
+          for (int64 i = 0; i < rows; ++i) {
+            const T new_max = std::max(row_max(i), s.row(i).maxCoeff());
+            const T correction = std::exp(row_max(i) - new_max);
+            s.row(i) = (s.row(i).array() - new_max).exp();
+            row_sum(i) = row_sum(i) * correction + s.row(i).sum();
+            acc.row(i) *= correction;
+            row_max(i) = new_max;
+          }
+          // The softmax is normalized before dropout, so the sums above use
+          // the attention that is not dropped.
+          if (inputs.has_dropout()) {
+            inputs.ApplyDropout(bh, n0, rows, m0, cols, s);
+          }
+          acc.topRows(rows).noalias() += s * inputs.Values(bh, m0, cols);
+        }
+        HeadMap<T> out(y + inputs.RowOffset(bh, n0, queries, value_depth),
+                       rows, value_depth,
+                       Eigen::OuterStride<>(inputs.heads() * value_depth));
+        out = row_sum.head(rows).cwiseInverse().asDiagonal() *
+              acc.topRows(rows);
+        for (int64 i = 0; i < rows; ++i) {
+          lse[bh * queries + n0 + i] = row_max(i) + std::log(row_sum(i));
+        }
+      }
+    };
+    context->eigen_device<CPUDevice>().parallelFor(
+        bh_size * num_blocks, inputs.BlockCost(kQueryBlock, keys), work);
+  }
+
+ private:
+  float dropout_rate_;
+};
+
+// Backpropagates through DotProductAttention by recomputing the attention one
+// tile at a time from the saved log-sum-exp. A first pass over blocks of
+// queries computes the query gradients, and a second pass over blocks of keys
+// the key and value gradients, so that every shard owns the gradients it
+// accumulates.
+template <typename T>
+class DotProductAttentionGradOp : public OpKernel {
+ public:
+  explicit DotProductAttentionGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("dropout_rate", &dropout_rate_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &query = context->input(0);
+    const Tensor &key = context->input(1);
+    const Tensor &value = context->input(2);
+    const Tensor &mask = context->input(3);
+    const Tensor &seed = context->input(4);
+    const Tensor &output = context->input(5);
+    const Tensor &logsumexp = context->input(6);
+    const Tensor &grad = context->input(7);
+    OP_REQUIRES_OK(context, CheckInputs(query, key, value, mask, seed));
+    const AttentionInputs<T> inputs(query, key, value, mask, seed,
+                                    dropout_rate_);
+    const int64 bh_size = inputs.batch() * inputs.heads();
+    const int64 queries = inputs.queries();
+    const int64 keys = inputs.keys();
+    const int64 heads = inputs.heads();
+    const int64 depth = inputs.depth();
+    const int64 value_depth = inputs.value_depth();
+    const TensorShape output_shape(
+        {inputs.batch(), queries, heads, value_depth});
+    OP_REQUIRES(context, output.shape() == output_shape &&
+                             grad.shape() == output_shape &&
+                             logsumexp.NumElements() == bh_size * queries,
+                errors::InvalidArgument(
+                    "output and grad should have shape ",
+                    output_shape.DebugString(), ", got ",
+                    output.shape().DebugString(), " and ",
+                    grad.shape().DebugString()));
+
+    Tensor *query_grad = nullptr;
+    Tensor *key_grad = nullptr;
+    Tensor *value_grad = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, query.shape(), &query_grad));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, key.shape(), &key_grad));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(2, value.shape(), &value_grad));
+    if (keys == 0 || queries == 0) {
+      query_grad->flat<T>().setZero();
+      key_grad->flat<T>().setZero();
+      value_grad->flat<T>().setZero();
+      return;
+    }
+
+    const T *y = output.flat<T>().data();
+    const T *dy = grad.flat<T>().data();
+    const T *lse = logsumexp.flat<T>().data();
+    T *dq = query_grad->flat<T>().data();
+    T *dk = key_grad->flat<T>().data();
+    T *dv = value_grad->flat<T>().data();
+    const auto heads_map = [&](const T *data, int64 offset, int64 rows,
+                               int64 cols) {
+      return ConstHeadMap<T>(data + offset, rows, cols,
+                             Eigen::OuterStride<>(heads * cols));
+    };
+    // The dot product of the output and output gradient of every query,
+    // which is the softmax gradient term shared by all its keys.
+    std::vector<T> delta(bh_size * queries);
+
+    // Computes the probabilities of a tile, the gradient of their dropout
+    // and the gradient of the logits into `probs` and `dlogits`, and returns
+    // whether `probs` was multiplied by the dropout scale.
+    const auto tile_grads = [&](int64 bh, int64 n0, int64 rows, int64 m0,
+                                int64 cols, RowMajorMatrix<T> *probs,
+                                RowMajorMatrix<T> *dlogits) {
+      auto p = probs->topLeftCorner(rows, cols);
+      auto ds = dlogits->topLeftCorner(rows, cols);
+      inputs.Logits(bh, n0, rows, m0, cols, p);
+      for (int64 i = 0; i < rows; ++i) {
+        p.row(i) = (p.row(i).array() - lse[bh * queries + n0 + i]).exp();
+      }
+      ds.noalias() =
+          heads_map(dy, inputs.RowOffset(bh, n0, queries, value_depth), rows,
+                    value_depth) *
+          inputs.Values(bh, m0, cols).transpose();
+      if (inputs.has_dropout()) {
+        inputs.ApplyDropout(bh, n0, rows, m0, cols, ds);
+      }
+      for (int64 i = 0; i < rows; ++i) {
+        ds.row(i) = p.row(i).cwiseProduct(
+            (ds.row(i).array() - delta[bh * queries + n0 + i]).matrix());
+      }
+    };
+
+    const int64 num_query_blocks = (queries + kQueryBlock - 1) / kQueryBlock;
+    const auto query_work = [&](int64 start, int64 end) {
+      RowMajorMatrix<T> probs(kQueryBlock, kKeyBlock);
+      RowMajorMatrix<T> dlogits(kQueryBlock, kKeyBlock);
+      RowMajorMatrix<T> acc(kQueryBlock, depth);
+      for (int64 shard = start; shard < end; ++shard) {
+        const int64 bh = shard / num_query_blocks;
+        const int64 n0 = (shard % num_query_blocks) * kQueryBlock;
+        const int64 rows = std::min(kQueryBlock, queries - n0);
+        const int64 offset = inputs.RowOffset(bh, n0, queries, value_depth);
+        const auto d = heads_map(y, offset, rows, value_depth)
+                           .cwiseProduct(heads_map(dy, offset, rows,
+                                                   value_depth))
+                           .rowwise()
+                           .sum();
+        for (int64 i = 0; i < rows; ++i) {
+          delta[bh * queries + n0 + i] = d(i);
+        }
+        acc.setZero();
+        for (int64 m0 = 0; m0 < keys; m0 += kKeyBlock) {
+          const int64 cols = std::min(kKeyBlock, keys - m0);
+          tile_grads(bh, n0, rows, m0, cols, &probs, &dlogits);
+          acc.topRows(rows).noalias() +=
+              dlogits.topLeftCorner(rows, cols) * inputs.Keys(bh, m0, cols);
+        }
+        HeadMap<T>(dq + inputs.RowOffset(bh, n0, queries, depth), rows, depth,
+                   Eigen::OuterStride<>(heads * depth)) = acc.topRows(rows);
+      }
+    };
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(bh_size * num_query_blocks,
+                       inputs.BlockCost(kQueryBlock, keys), query_work);
+
+    const int64 num_key_blocks = (keys + kKeyBlock - 1) / kKeyBlock;
+    const auto key_work = [&](int64 start, int64 end) {
+      RowMajorMatrix<T> probs(kQueryBlock, kKeyBlock);
+      RowMajorMatrix<T> dlogits(kQueryBlock, kKeyBlock);
+      RowMajorMatrix<T> key_acc(kKeyBlock, depth);
+      RowMajorMatrix<T> value_acc(kKeyBlock, value_depth);
+      for (int64 shard = start; shard < end; ++shard) {
+        const int64 bh = shard / num_key_blocks;
+        const int64 m0 = (shard % num_key_blocks) * kKeyBlock;
+        const int64 cols = std::min(kKeyBlock, keys - m0);
+        key_acc.setZero();
+        value_acc.setZero();
+        for (int64 n0 = 0; n0 < queries; n0 += kQueryBlock) {
+          const int64 rows = std::min(kQueryBlock, queries - n0);
+          tile_grads(bh, n0, rows, m0, cols, &probs, &dlogits);
+          auto p = probs.topLeftCorner(rows, cols);
+          if (inputs.has_dropout()) {
+            inputs.ApplyDropout(bh, n0, rows, m0, cols, p);
+          }
+          value_acc.topRows(cols).noalias() +=
+              p.transpose() *
+              heads_map(dy, inputs.RowOffset(bh, n0, queries, value_depth),
+                        rows, value_depth);
+          key_acc.topRows(cols).noalias() +=
+              dlogits.topLeftCorner(rows, cols).transpose() *
+              inputs.Queries(bh, n0, rows);
+        }
+        HeadMap<T>(dk + inputs.RowOffset(bh, m0, keys, depth), cols, depth,
+                   Eigen::OuterStride<>(heads * depth)) =
+            key_acc.topRows(cols);
+        HeadMap<T>(dv + inputs.RowOffset(bh, m0, keys, value_depth), cols,
+                   value_depth, Eigen::OuterStride<>(heads * value_depth)) =
+            value_acc.topRows(cols);
+      }
+    };
+    device.parallelFor(bh_size * num_key_blocks,
+                       inputs.BlockCost(kKeyBlock, queries), key_work);
+  }
+
+ private:
+  float dropout_rate_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>DotProductAttention")       \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          DotProductAttentionOp<T>);               \
+  REGISTER_KERNEL_BUILDER(Name("Addons>DotProductAttentionGrad")   \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          DotProductAttentionGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
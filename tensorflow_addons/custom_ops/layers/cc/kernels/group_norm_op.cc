@@ -0,0 +1,350 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// The input viewed as [batch, spatial, channels] (NHWC) or [batch, channels,
+// spatial] (NCHW), with the channels split into `groups` groups.
+struct GroupNormShape {
+  int64 batch;
+  int64 channels;
+  int64 spatial;
+  int64 groups;
+  int64 group_channels;
+  bool channels_last;
+
+  int64 group_size() const { return group_channels * spatial; }
+
+  // Calls `fn(offset, channel, length, channel_step)` for every contiguous run
+  // of elements of group `g` in batch `n`: the run starts at `offset`, and its
+  // k-th element is in channel `channel + k * channel_step`.
+  template <typename Fn>
+  void ForEachRun(int64 n, int64 g, Fn fn) const {
+    const int64 first_channel = g * group_channels;
+    if (channels_last) {
+      for (int64 s = 0; s < spatial; ++s) {
+        fn((n * spatial + s) * channels + first_channel, first_channel,
+           group_channels, 1);
+      }
+    } else {
+      for (int64 c = first_channel; c < first_channel + group_channels; ++c) {
+        fn((n * channels + c) * spatial, c, spatial, 0);
+      }
+    }
+  }
+};
+
+Status GetGroupNormShape(const TensorShape &shape, int groups,
+                         const std::string &data_format,
+                         GroupNormShape *group_shape) {
+  if (shape.dims() < 2) {
+    return errors::InvalidArgument("x must have at least 2 dimensions, got ",
+                                   shape.DebugString());
+  }
+  group_shape->channels_last = data_format == "NHWC";
+  const int channel_axis = group_shape->channels_last ? shape.dims() - 1 : 1;
+  group_shape->batch = shape.dim_size(0);
+  group_shape->channels = shape.dim_size(channel_axis);
+  group_shape->spatial = 1;
+  for (int i = 1; i < shape.dims(); ++i) {
+    if (i != channel_axis) {
+      group_shape->spatial *= shape.dim_size(i);
+    }
+  }
+  if (groups <= 0 || group_shape->channels % groups != 0) {
+    return errors::InvalidArgument("The number of channels (",
+                                   group_shape->channels,
+                                   ") must be a multiple of groups (", groups,
+                                   ").");
+  }
+  group_shape->groups = groups;
+  group_shape->group_channels = group_shape->channels / groups;
+  return Status::OK();
+}
+
+// Running count, mean and sum of squared deviations, merged run by run with
+// the parallel form of Welford's update.
+struct Moments {
+  double count = 0.0;
+  double mean = 0.0;
+  double m2 = 0.0;
+
+  template <typename T>
+  void AddRun(const T *data, int64 length) {
+    double run_mean = 0.0;
+    for (int64 k = 0; k < length; ++k) {
+      run_mean += static_cast<double>(data[k]);
+    }
+    run_mean /= length;
+    double run_m2 = 0.0;
+    for (int64 k = 0; k < length; ++k) {
+      const double delta = static_cast<double>(data[k]) - run_mean;
+      run_m2 += delta * delta;
+    }
+    const double total = count + length;
+    const double delta = run_mean - mean;
+    mean += delta * length / total;
+    m2 += run_m2 + delta * delta * count * length / total;
+    count = total;
+  }
+};
+
+}  // namespace
+
+// Normalizes every group of channels of every example with the mean and
+// variance of the group, and applies the per-channel `gamma` and `beta`. Each
+// (example, group) pair is one task: its moments are reduced in a single
+// pass over the group, merging the moments of each contiguous run, and the
+// normalization and affine transform are applied right after while the group
+// is still in cache. The mean and inverse standard deviation of each group
+// are returned for the gradient.
+template <typename T>
+class GroupNormOp : public OpKernel {
+ public:
+  explicit GroupNormOp(OpKernelConstruction *context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("groups", &groups_));
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &x = context->input(0);
+    const Tensor &gamma = context->input(1);
+    const Tensor &beta = context->input(2);
+    GroupNormShape shape;
+    OP_REQUIRES_OK(context,
+                   GetGroupNormShape(x.shape(), groups_, data_format_, &shape));
+    OP_REQUIRES(context,
+                gamma.shape() == TensorShape({shape.channels}) &&
+                    beta.shape() == TensorShape({shape.channels}),
+                errors::InvalidArgument(
+                    "gamma and beta should have shape [", shape.channels,
+                    "], got ", gamma.shape().DebugString(), " and ",
+                    beta.shape().DebugString()));
+
+    Tensor *y = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, x.shape(), &y));
+    const TensorShape stats_shape({shape.batch, shape.groups});
+    Tensor *mean = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1, stats_shape, &mean));
+    Tensor *inv_std = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(2, stats_shape, &inv_std));
+    if (shape.group_size() == 0) {
+      return;
+    }
+
+    const T *x_data = x.flat<T>().data();
+    const T *gamma_data = gamma.flat<T>().data();
+    const T *beta_data = beta.flat<T>().data();
+    T *y_data = y->flat<T>().data();
+    T *mean_data = mean->flat<T>().data();
+    T *inv_std_data = inv_std->flat<T>().data();
+    const double epsilon = epsilon_;
+
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 task = start; task < end; ++task) {
+        const int64 n = task / shape.groups;
+        const int64 g = task % shape.groups;
+        Moments moments;
+        shape.ForEachRun(n, g,
+                         [&](int64 offset, int64, int64 length, int64) {
+                           moments.AddRun(x_data + offset, length);
+                         });
+        const double group_inv_std =
+            1.0 / std::sqrt(moments.m2 / moments.count + epsilon);
+        mean_data[task] = static_cast<T>(moments.mean);
+        inv_std_data[task] = static_cast<T>(group_inv_std);
+
+        const T group_mean = static_cast<T>(moments.mean);
+        const T scale = static_cast<T>(group_inv_std);
+        shape.ForEachRun(
+            n, g, [&](int64 offset, int64 channel, int64 length, int64 step) {
+              for (int64 k = 0; k < length; ++k) {
+                const int64 c = channel + k * step;
+                y_data[offset + k] = (x_data[offset + k] - group_mean) *
+                                         (scale * gamma_data[c]) +
+                                     beta_data[c];
+              }
+            });
+      }
+    };
+    const double group_size = static_cast<double>(shape.group_size());
+    const Eigen::TensorOpCost cost(
+        2 * sizeof(T) * group_size, sizeof(T) * group_size,
+        8 * Eigen::TensorOpCost::AddCost<T>() * group_size);
+    context->eigen_device<CPUDevice>().parallelFor(shape.batch * shape.groups,
+                                                   cost, work);
+  }
+
+ private:
+  int groups_;
+  float epsilon_;
+  std::string data_format_;
+};
+
+// Computes the gradients of GroupNorm with respect to `x`, `gamma` and `beta`
+// in two passes over each group. The first reduces the sums of the gradient of
+// the normalized input and of its product with the normalized input, along
+// with per-example partial sums for `gamma` and `beta`; the second writes
+//
+//   dx = inv_std * (dx_hat - mean(dx_hat) - x_hat * mean(dx_hat * x_hat))
+//
+// The partial sums are then reduced over the batch in order.
+template <typename T>
+class GroupNormGradOp : public OpKernel {
+ public:
+  explicit GroupNormGradOp(OpKernelConstruction *context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("groups", &groups_));
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &dy = context->input(0);
+    const Tensor &x = context->input(1);
+    const Tensor &gamma = context->input(2);
+    const Tensor &mean = context->input(3);
+    const Tensor &inv_std = context->input(4);
+    GroupNormShape shape;
+    OP_REQUIRES_OK(context,
+                   GetGroupNormShape(x.shape(), groups_, data_format_, &shape));
+    const TensorShape stats_shape({shape.batch, shape.groups});
+    OP_REQUIRES(context,
+                dy.shape() == x.shape() &&
+                    gamma.shape() == TensorShape({shape.channels}) &&
+                    mean.shape() == stats_shape &&
+                    inv_std.shape() == stats_shape,
+                errors::InvalidArgument(
+                    "Incompatible shapes for dy, x, gamma, mean and inv_std: ",
+                    dy.shape().DebugString(), ", ", x.shape().DebugString(),
+                    ", ", gamma.shape().DebugString(), ", ",
+                    mean.shape().DebugString(), " and ",
+                    inv_std.shape().DebugString()));
+
+    Tensor *dx = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, x.shape(), &dx));
+    Tensor *dgamma = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, gamma.shape(), &dgamma));
+    Tensor *dbeta = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(2, gamma.shape(), &dbeta));
+
+    const int64 channels = shape.channels;
+    // Per-example partial sums for gamma and beta.
+    std::vector<double> dgamma_partials(shape.batch * channels, 0.0);
+    std::vector<double> dbeta_partials(shape.batch * channels, 0.0);
+    const T *dy_data = dy.flat<T>().data();
+    const T *x_data = x.flat<T>().data();
+    const T *gamma_data = gamma.flat<T>().data();
+    const T *mean_data = mean.flat<T>().data();
+    const T *inv_std_data = inv_std.flat<T>().data();
+    T *dx_data = dx->flat<T>().data();
+
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 task = start; task < end; ++task) {
+        const int64 n = task / shape.groups;
+        const int64 g = task % shape.groups;
+        const T group_mean = mean_data[task];
+        const T group_inv_std = inv_std_data[task];
+        double *dgamma_row = dgamma_partials.data() + n * channels;
+        double *dbeta_row = dbeta_partials.data() + n * channels;
+        double sum_dx_hat = 0.0, sum_dx_hat_x_hat = 0.0;
+        shape.ForEachRun(
+            n, g, [&](int64 offset, int64 channel, int64 length, int64 step) {
+              for (int64 k = 0; k < length; ++k) {
+                const int64 c = channel + k * step;
+                const double x_hat = static_cast<double>(
+                    (x_data[offset + k] - group_mean) * group_inv_std);
+                const double grad = static_cast<double>(dy_data[offset + k]);
+                const double dx_hat = grad * static_cast<double>(gamma_data[c]);
+                dgamma_row[c] += grad * x_hat;
+                dbeta_row[c] += grad;
+                sum_dx_hat += dx_hat;
+                sum_dx_hat_x_hat += dx_hat * x_hat;
+              }
+            });
+
+        const double group_size = static_cast<double>(shape.group_size());
+        const T mean_dx_hat = static_cast<T>(sum_dx_hat / group_size);
+        const T mean_dx_hat_x_hat =
+            static_cast<T>(sum_dx_hat_x_hat / group_size);
+        shape.ForEachRun(
+            n, g, [&](int64 offset, int64 channel, int64 length, int64 step) {
+              for (int64 k = 0; k < length; ++k) {
+                const int64 c = channel + k * step;
+                const T x_hat =
+                    (x_data[offset + k] - group_mean) * group_inv_std;
+                dx_data[offset + k] =
+                    group_inv_std * (dy_data[offset + k] * gamma_data[c] -
+                                     mean_dx_hat - x_hat * mean_dx_hat_x_hat);
+              }
+            });
+      }
+    };
+    const double group_size = static_cast<double>(shape.group_size());
+    const Eigen::TensorOpCost cost(
+        4 * sizeof(T) * group_size, sizeof(T) * group_size,
+        16 * Eigen::TensorOpCost::AddCost<T>() * group_size);
+    context->eigen_device<CPUDevice>().parallelFor(shape.batch * shape.groups,
+                                                   cost, work);
+
+    auto dgamma_flat = dgamma->flat<T>();
+    auto dbeta_flat = dbeta->flat<T>();
+    for (int64 c = 0; c < channels; ++c) {
+      double dgamma_sum = 0.0, dbeta_sum = 0.0;
+      for (int64 n = 0; n < shape.batch; ++n) {
+        dgamma_sum += dgamma_partials[n * channels + c];
+        dbeta_sum += dbeta_partials[n * channels + c];
+      }
+      dgamma_flat(c) = static_cast<T>(dgamma_sum);
+      dbeta_flat(c) = static_cast<T>(dbeta_sum);
+    }
+  }
+
+ private:
+  int groups_;
+  std::string data_format_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>GroupNorm")                 \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          GroupNormOp<T>);                         \
+  REGISTER_KERNEL_BUILDER(Name("Addons>GroupNormGrad")             \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          GroupNormGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,263 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Channels are unpooled in blocks of this many, so that the innermost loop
+// reads contiguous memory.
+constexpr int64 kChannelBlock = 64;
+
+// The sizes of an unpooling: `updates` and `mask` are
+// `[batch, height, width, channels]`, and the output is
+// `[batch, output_height, output_width, channels]`.
+struct UnpoolShape {
+  int64 batch;
+  int64 height;
+  int64 width;
+  int64 channels;
+  int64 output_height;
+  int64 output_width;
+
+  int64 input_size() const { return height * width * channels; }
+  int64 output_size() const { return output_height * output_width * channels; }
+};
+
+class MaxUnpooling2DBase : public OpKernel {
+ public:
+  explicit MaxUnpooling2DBase(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("pool_size", &pool_size_));
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
+    std::string padding;
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding));
+    OP_REQUIRES(context, pool_size_.size() == 2 && strides_.size() == 2,
+                errors::InvalidArgument(
+                    "pool_size and strides must have 2 elements."));
+    valid_padding_ = padding == "VALID";
+  }
+
+ protected:
+  // Checks `updates` and `mask` and computes the shape of the output, which
+  // is the shape of the input of the max pooling.
+  Status GetShape(const Tensor &updates, const Tensor &mask,
+                  UnpoolShape *shape) const {
+    if (updates.dims() != 4) {
+      return errors::InvalidArgument("updates must have rank 4, got ",
+                                     updates.shape().DebugString());
+    }
+    if (updates.shape() != mask.shape()) {
+      return errors::InvalidArgument(
+          "updates and mask should have the same shape, got ",
+          updates.shape().DebugString(), " and ",
+          mask.shape().DebugString());
+    }
+    shape->batch = updates.dim_size(0);
+    shape->height = updates.dim_size(1);
+    shape->width = updates.dim_size(2);
+    shape->channels = updates.dim_size(3);
+    if (valid_padding_) {
+      shape->output_height = (shape->height - 1) * strides_[0] + pool_size_[0];
+      shape->output_width = (shape->width - 1) * strides_[1] + pool_size_[1];
+    } else {
+      shape->output_height = shape->height * strides_[0];
+      shape->output_width = shape->width * strides_[1];
+    }
+    return Status::OK();
+  }
+
+  TensorShape OutputShape(const UnpoolShape &shape) const {
+    return TensorShape({shape.batch, shape.output_height, shape.output_width,
+                        shape.channels});
+  }
+
+  std::vector<int32> pool_size_;
+  std::vector<int32> strides_;
+  bool valid_padding_;
+};
+
+// Returns the offset in its example of the output element that receives an
+// update at `channel`, or -1 if `index` points outside of the output. Like
+// `tf.nn.max_pool_with_argmax` without `include_batch_in_index`, a mask value
+// is a flat `(y * output_width + x) * channels + c` index into one example;
+// the channel of the update is used in place of `c`.
+template <typename Tmask>
+int64 OutputOffset(Tmask index, int64 channel, const UnpoolShape &shape) {
+  const int64 position = static_cast<int64>(index) / shape.channels;
+  if (index < 0 || position >= shape.output_height * shape.output_width) {
+    return -1;
+  }
+  return position * shape.channels + channel;
+}
+
+Status InvalidIndex(int64 index, const UnpoolShape &shape) {
+  return errors::InvalidArgument("mask value ", index,
+                                 " is outside of the output of shape [",
+                                 shape.output_height, ", ", shape.output_width,
+                                 ", ", shape.channels, "]");
+}
+
+}  // namespace
+
+// Writes `updates` into a zero-initialized output at the positions of
+// `mask`. Work is sharded over (batch, channel block) pairs; an update only
+// moves within its example and channel, so the shards write disjoint outputs
+// and duplicate positions are summed without synchronization.
+template <typename T, typename Tmask>
+class MaxUnpooling2DOp : public MaxUnpooling2DBase {
+ public:
+  explicit MaxUnpooling2DOp(OpKernelConstruction *context)
+      : MaxUnpooling2DBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &updates = context->input(0);
+    const Tensor &mask = context->input(1);
+    UnpoolShape shape;
+    OP_REQUIRES_OK(context, GetShape(updates, mask, &shape));
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, OutputShape(shape),
+                                                     &output));
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    output->flat<T>().device(device) = output->flat<T>().constant(T(0));
+    if (updates.NumElements() == 0) {
+      return;
+    }
+
+    const T *values = updates.flat<T>().data();
+    const Tmask *indices = mask.flat<Tmask>().data();
+    T *y = output->flat<T>().data();
+    const int64 block = std::min(shape.channels, kChannelBlock);
+    const int64 num_blocks = (shape.channels + block - 1) / block;
+    const int64 positions = shape.height * shape.width;
+    std::atomic<bool> valid(true);
+    std::atomic<int64> invalid_index(0);
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 shard = start; shard < end; ++shard) {
+        const int64 b = shard / num_blocks;
+        const int64 c0 = (shard % num_blocks) * block;
+        const int64 c1 = std::min(shape.channels, c0 + block);
+        const int64 input_offset = b * shape.input_size();
+        T *y_example = y + b * shape.output_size();
+        for (int64 p = 0; p < positions; ++p) {
+          const int64 row = input_offset + p * shape.channels;
+          for (int64 c = c0; c < c1; ++c) {
+            const int64 offset = OutputOffset(indices[row + c], c, shape);
+            if (offset < 0) {
+              invalid_index = static_cast<int64>(indices[row + c]);
+              valid = false;
+              return;
+            }
+            y_example[offset] += values[row + c];
+          }
+        }
+      }
+    };
+    const double block_size = static_cast<double>(positions * block);
+    const Eigen::TensorOpCost cost((sizeof(T) + sizeof(Tmask)) * block_size,
+                                   sizeof(T) * block_size, 4 * block_size);
+    device.parallelFor(shape.batch * num_blocks, cost, work);
+    OP_REQUIRES(context, valid, InvalidIndex(invalid_index, shape));
+  }
+};
+
+// Gathers the gradient of every update from its position in the output.
+template <typename T, typename Tmask>
+class MaxUnpooling2DGradOp : public MaxUnpooling2DBase {
+ public:
+  explicit MaxUnpooling2DGradOp(OpKernelConstruction *context)
+      : MaxUnpooling2DBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &updates = context->input(0);
+    const Tensor &mask = context->input(1);
+    const Tensor &grad = context->input(2);
+    UnpoolShape shape;
+    OP_REQUIRES_OK(context, GetShape(updates, mask, &shape));
+    OP_REQUIRES(context, grad.shape() == OutputShape(shape),
+                errors::InvalidArgument(
+                    "grad should have shape ",
+                    OutputShape(shape).DebugString(), ", got ",
+                    grad.shape().DebugString()));
+    Tensor *updates_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, updates.shape(),
+                                                     &updates_grad));
+    if (updates.NumElements() == 0) {
+      return;
+    }
+
+    const Tmask *indices = mask.flat<Tmask>().data();
+    const T *dy = grad.flat<T>().data();
+    T *dx = updates_grad->flat<T>().data();
+    std::atomic<bool> valid(true);
+    std::atomic<int64> invalid_index(0);
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 k = start; k < end; ++k) {
+        const int64 b = k / shape.input_size();
+        const int64 offset =
+            OutputOffset(indices[k], k % shape.channels, shape);
+        if (offset < 0) {
+          invalid_index = static_cast<int64>(indices[k]);
+          valid = false;
+          return;
+        }
+        dx[k] = dy[b * shape.output_size() + offset];
+      }
+    };
+    const Eigen::TensorOpCost cost(sizeof(T) + sizeof(Tmask), sizeof(T), 4);
+    context->eigen_device<CPUDevice>().parallelFor(updates.NumElements(), cost,
+                                                   work);
+    OP_REQUIRES(context, valid, InvalidIndex(invalid_index, shape));
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T, Tmask)                                  \
+  REGISTER_KERNEL_BUILDER(Name("Addons>MaxUnpooling2D")                \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<T>("T")                  \
+                              .TypeConstraint<Tmask>("Tmask"),         \
+                          MaxUnpooling2DOp<T, Tmask>);                 \
+  REGISTER_KERNEL_BUILDER(Name("Addons>MaxUnpooling2DGrad")            \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<T>("T")                  \
+                              .TypeConstraint<Tmask>("Tmask"),         \
+                          MaxUnpooling2DGradOp<T, Tmask>);
+
+#define REGISTER_CPU_KERNELS(T) \
+  REGISTER_CPU_KERNEL(T, int32); \
+  REGISTER_CPU_KERNEL(T, int64);
+
+REGISTER_CPU_KERNELS(Eigen::half);
+REGISTER_CPU_KERNELS(float);
+REGISTER_CPU_KERNELS(double);
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
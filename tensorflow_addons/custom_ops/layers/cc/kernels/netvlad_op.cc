@@ -0,0 +1,288 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Same lower bound on squared norms as `tf.nn.l2_normalize`.
+constexpr double kNormEpsilon = 1e-12;
+
+template <typename T>
+using RowMajorMatrix =
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+template <typename T>
+using MatrixMap = Eigen::Map<RowMajorMatrix<T>>;
+template <typename T>
+using ConstMatrixMap = Eigen::Map<const RowMajorMatrix<T>>;
+
+// Computes the `[feature_dim, num_clusters]` residuals of one example,
+//
+//   residuals[d, k] = sum_t a[t, k] * (frames[t, d] - centers[d, k])
+//
+// with a single product over the frames, and the soft count of every cluster.
+template <typename T>
+void ComputeResiduals(const ConstMatrixMap<T> &frames,
+                      const ConstMatrixMap<T> &assignments,
+                      const ConstMatrixMap<T> &centers,
+                      MatrixMap<T> *residuals,
+                      Eigen::Matrix<T, 1, Eigen::Dynamic> *counts) {
+  residuals->noalias() = frames.transpose() * assignments;
+  *counts = assignments.colwise().sum();
+  *residuals -= centers * counts->asDiagonal();
+}
+
+// Returns rsqrt(max(squared_norm, epsilon)) as in `tf.nn.l2_normalize`, and
+// whether the norm was clipped, in which case the normalization is constant.
+template <typename T>
+T InverseNorm(T squared_norm, bool *clipped) {
+  *clipped = squared_norm < static_cast<T>(kNormEpsilon);
+  return T(1) / std::sqrt(std::max(squared_norm, static_cast<T>(kNormEpsilon)));
+}
+
+Status ValidateNetVLADInputs(const Tensor &frames, const Tensor &assignments,
+                             const Tensor &centers) {
+  if (frames.dims() != 3 || assignments.dims() != 3 ||
+      centers.dims() != 2 || frames.dim_size(0) != assignments.dim_size(0) ||
+      frames.dim_size(1) != assignments.dim_size(1) ||
+      frames.dim_size(2) != centers.dim_size(0) ||
+      assignments.dim_size(2) != centers.dim_size(1)) {
+    return errors::InvalidArgument(
+        "frames, assignments and centers should have shapes [batch, time, "
+        "feature_dim], [batch, time, num_clusters] and [feature_dim, "
+        "num_clusters], got ",
+        frames.shape().DebugString(), ", ", assignments.shape().DebugString(),
+        " and ", centers.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// Aggregates frames into a NetVLAD descriptor. For every example the residuals
+// of all clusters are accumulated in one pass over the frames, directly into
+// the output, which is then normalized in place: first every cluster over the
+// feature dimension, then the whole descriptor. Examples are sharded over the
+// CPU thread pool.
+template <typename T>
+class NetVLADAggregateOp : public OpKernel {
+ public:
+  explicit NetVLADAggregateOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &frames = context->input(0);
+    const Tensor &assignments = context->input(1);
+    const Tensor &centers = context->input(2);
+    OP_REQUIRES_OK(context,
+                   ValidateNetVLADInputs(frames, assignments, centers));
+    const int64 batch_size = frames.dim_size(0);
+    const int64 time = frames.dim_size(1);
+    const int64 feature_dim = frames.dim_size(2);
+    const int64 num_clusters = centers.dim_size(1);
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({batch_size,
+                                                feature_dim * num_clusters}),
+                                &output));
+    const ConstMatrixMap<T> centers_matrix(centers.flat<T>().data(),
+                                           feature_dim, num_clusters);
+
+    const auto work = [&](int64 start, int64 end) {
+      Eigen::Matrix<T, 1, Eigen::Dynamic> counts;
+      for (int64 b = start; b < end; ++b) {
+        const ConstMatrixMap<T> frames_matrix(
+            frames.flat<T>().data() + b * time * feature_dim, time,
+            feature_dim);
+        const ConstMatrixMap<T> assignments_matrix(
+            assignments.flat<T>().data() + b * time * num_clusters, time,
+            num_clusters);
+        MatrixMap<T> vlad(output->flat<T>().data() +
+                              b * feature_dim * num_clusters,
+                          feature_dim, num_clusters);
+        ComputeResiduals(frames_matrix, assignments_matrix, centers_matrix,
+                         &vlad, &counts);
+        bool clipped;
+        for (int64 k = 0; k < num_clusters; ++k) {
+          vlad.col(k) *= InverseNorm(vlad.col(k).squaredNorm(), &clipped);
+        }
+        vlad *= InverseNorm(vlad.squaredNorm(), &clipped);
+      }
+    };
+    const double size = static_cast<double>(time * feature_dim * num_clusters);
+    const Eigen::TensorOpCost cost(
+        sizeof(T) * time * (feature_dim + num_clusters),
+        sizeof(T) * feature_dim * num_clusters,
+        size * (Eigen::TensorOpCost::AddCost<T>() +
+                Eigen::TensorOpCost::MulCost<T>()));
+    context->eigen_device<CPUDevice>().parallelFor(batch_size, cost, work);
+  }
+};
+
+// Gradients of NetVLADAggregate with respect to the frames, the assignments
+// and the centers. The residuals are recomputed per example and the gradient
+// is propagated back through both normalizations in place. The gradients of
+// the centers are summed per example and then reduced over the batch in
+// order.
+template <typename T>
+class NetVLADAggregateGradOp : public OpKernel {
+ public:
+  explicit NetVLADAggregateGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &frames = context->input(0);
+    const Tensor &assignments = context->input(1);
+    const Tensor &centers = context->input(2);
+    const Tensor &grad = context->input(3);
+    OP_REQUIRES_OK(context,
+                   ValidateNetVLADInputs(frames, assignments, centers));
+    const int64 batch_size = frames.dim_size(0);
+    const int64 time = frames.dim_size(1);
+    const int64 feature_dim = frames.dim_size(2);
+    const int64 num_clusters = centers.dim_size(1);
+    const int64 vlad_size = feature_dim * num_clusters;
+    OP_REQUIRES(context,
+                grad.shape() == TensorShape({batch_size, vlad_size}),
+                errors::InvalidArgument("grad should have shape [", batch_size,
+                                        ", ", vlad_size, "], got ",
+                                        grad.shape().DebugString()));
+
+    Tensor *frames_grad = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, frames.shape(), &frames_grad));
+    Tensor *assignments_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1, assignments.shape(),
+                                                     &assignments_grad));
+    Tensor *centers_grad = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(2, centers.shape(), &centers_grad));
+    // Per-example gradients of the centers.
+    std::vector<T> centers_partials(batch_size * vlad_size);
+    const ConstMatrixMap<T> centers_matrix(centers.flat<T>().data(),
+                                           feature_dim, num_clusters);
+
+    const auto work = [&](int64 start, int64 end) {
+      RowMajorMatrix<T> vlad_buffer(feature_dim, num_clusters);
+      Eigen::Matrix<T, 1, Eigen::Dynamic> counts, inverse_norms;
+      for (int64 b = start; b < end; ++b) {
+        const ConstMatrixMap<T> frames_matrix(
+            frames.flat<T>().data() + b * time * feature_dim, time,
+            feature_dim);
+        const ConstMatrixMap<T> assignments_matrix(
+            assignments.flat<T>().data() + b * time * num_clusters, time,
+            num_clusters);
+        MatrixMap<T> vlad(vlad_buffer.data(), feature_dim, num_clusters);
+        ComputeResiduals(frames_matrix, assignments_matrix, centers_matrix,
+                         &vlad, &counts);
+
+        // Forward normalizations, keeping the inverse norms.
+        std::vector<bool> cluster_clipped(num_clusters);
+        inverse_norms.resize(num_clusters);
+        for (int64 k = 0; k < num_clusters; ++k) {
+          bool clipped;
+          inverse_norms(k) = InverseNorm(vlad.col(k).squaredNorm(), &clipped);
+          cluster_clipped[k] = clipped;
+          vlad.col(k) *= inverse_norms(k);
+        }
+        bool global_clipped;
+        const T global_inverse_norm =
+            InverseNorm(vlad.squaredNorm(), &global_clipped);
+
+        // Back through the global normalization: the output is
+        // vlad * global_inverse_norm.
+        RowMajorMatrix<T> d_vlad =
+            ConstMatrixMap<T>(grad.flat<T>().data() + b * vlad_size,
+                              feature_dim, num_clusters) *
+            global_inverse_norm;
+        if (!global_clipped) {
+          const T projection = (d_vlad.array() * vlad.array()).sum();
+          d_vlad -= vlad * (projection * global_inverse_norm *
+                            global_inverse_norm);
+        }
+        // Back through the normalization of every cluster, which leaves the
+        // gradient of the residuals in d_vlad.
+        for (int64 k = 0; k < num_clusters; ++k) {
+          d_vlad.col(k) *= inverse_norms(k);
+          if (!cluster_clipped[k]) {
+            d_vlad.col(k) -= vlad.col(k) * vlad.col(k).dot(d_vlad.col(k));
+          }
+        }
+
+        MatrixMap<T> d_frames(frames_grad->flat<T>().data() +
+                                  b * time * feature_dim,
+                              time, feature_dim);
+        d_frames.noalias() = assignments_matrix * d_vlad.transpose();
+        MatrixMap<T> d_assignments(assignments_grad->flat<T>().data() +
+                                       b * time * num_clusters,
+                                   time, num_clusters);
+        d_assignments.noalias() = frames_matrix * d_vlad;
+        d_assignments.rowwise() -=
+            (d_vlad.array() * centers_matrix.array()).colwise().sum().matrix();
+        MatrixMap<T> d_centers(centers_partials.data() + b * vlad_size,
+                               feature_dim, num_clusters);
+        d_centers.noalias() = -(d_vlad * counts.asDiagonal());
+      }
+    };
+    const double size = static_cast<double>(time * vlad_size);
+    const Eigen::TensorOpCost cost(
+        sizeof(T) * (time * (feature_dim + num_clusters) + vlad_size),
+        sizeof(T) * (time * (feature_dim + num_clusters) + vlad_size),
+        3 * size *
+            (Eigen::TensorOpCost::AddCost<T>() +
+             Eigen::TensorOpCost::MulCost<T>()));
+    context->eigen_device<CPUDevice>().parallelFor(batch_size, cost, work);
+
+    auto centers_grad_flat = centers_grad->flat<T>();
+    centers_grad_flat.setZero();
+    for (int64 b = 0; b < batch_size; ++b) {
+      for (int64 i = 0; i < vlad_size; ++i) {
+        centers_grad_flat(i) += centers_partials[b * vlad_size + i];
+      }
+    }
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>NetVLADAggregate")          \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          NetVLADAggregateOp<T>);                  \
+  REGISTER_KERNEL_BUILDER(Name("Addons>NetVLADAggregateGrad")      \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          NetVLADAggregateGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,190 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Lower bound of the squared norms, as in tf.nn.l2_normalize.
+constexpr double kSquaredNormEpsilon = 1e-12;
+
+// Minimum number of kernel elements reduced by one task of the power
+// iteration, and maximum number of tasks. The partition only depends on the
+// kernel shape, so the partial sums are added in the same order whatever the
+// size of the thread pool.
+constexpr int64 kSpectralNormBlockSize = 16384;
+constexpr int64 kMaxSpectralNormBlocks = 64;
+
+// Runs one step of the power iteration on `w`, a [rows, channels] matrix:
+// returns `||w u||^2` in `squared_norm` and `w^T w u` in `wtwu`. Every row
+// is loaded once; its product with `u` is accumulated into the partial
+// `w^T w u` of its block while the row is still in cache.
+template <typename T>
+void PowerIterationStep(const CPUDevice &device, const T *w, int64 rows,
+                        int64 channels, const std::vector<double> &u,
+                        double *squared_norm, std::vector<double> *wtwu) {
+  const int64 block_rows =
+      std::max(Eigen::divup(rows, kMaxSpectralNormBlocks),
+               Eigen::divup(kSpectralNormBlockSize, channels));
+  const int64 num_blocks = Eigen::divup(rows, block_rows);
+  std::vector<double> partial_wtwu(num_blocks * channels, 0.0);
+  std::vector<double> partial_norms(num_blocks, 0.0);
+  const auto work = [&](int64 start, int64 end) {
+    for (int64 b = start; b < end; ++b) {
+      double *out = partial_wtwu.data() + b * channels;
+      const int64 row_end = std::min(rows, (b + 1) * block_rows);
+      for (int64 r = b * block_rows; r < row_end; ++r) {
+        const T *row = w + r * channels;
+        double wu = 0.0;
+        for (int64 c = 0; c < channels; ++c) {
+          wu += static_cast<double>(row[c]) * u[c];
+        }
+        partial_norms[b] += wu * wu;
+        for (int64 c = 0; c < channels; ++c) {
+          out[c] += wu * static_cast<double>(row[c]);
+        }
+      }
+    }
+  };
+  const int64 block_size = block_rows * channels;
+  const Eigen::TensorOpCost cost(
+      sizeof(T) * block_size, 0,
+      4 * Eigen::TensorOpCost::MulCost<double>() * block_size);
+  device.parallelFor(num_blocks, cost, work);
+
+  *squared_norm = 0.0;
+  std::fill(wtwu->begin(), wtwu->end(), 0.0);
+  for (int64 b = 0; b < num_blocks; ++b) {
+    *squared_norm += partial_norms[b];
+    const double *partial = partial_wtwu.data() + b * channels;
+    for (int64 c = 0; c < channels; ++c) {
+      (*wtwu)[c] += partial[c];
+    }
+  }
+}
+
+}  // namespace
+
+// Spectral normalization of the kernel `w` with the persistent vector `u`.
+// With `w` viewed as a [rows, channels] matrix, every power iteration computes
+//
+//   v = l2_normalize(w u)
+//   u = l2_normalize(w^T v)
+//
+// and `w` is then divided in place by `sigma = (w^T v) . u`. Since `v` is
+// `w u` up to a scale, both products come out of a single sweep over the rows
+// of `w`, which yields `||w u||^2` and `w^T w u`; the two normalizations are
+// then applied to these sums with the epsilon of tf.nn.l2_normalize.
+template <typename T>
+class ResourceSpectralNormalizeOp : public OpKernel {
+ public:
+  explicit ResourceSpectralNormalizeOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("power_iterations", &power_iterations_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, use_locking_, false, {0, 1});
+
+    Tensor w, u;
+    OP_REQUIRES_OK(context, GetInputTensorFromVariable<CPUDevice, T>(
+                                context, 0, use_locking_, false, &w));
+    OP_REQUIRES_OK(context, GetInputTensorFromVariable<CPUDevice, T>(
+                                context, 1, use_locking_, false, &u));
+    OP_REQUIRES(context, w.IsInitialized() && u.IsInitialized(),
+                errors::FailedPrecondition(
+                    "Attempting to use uninitialized variables w and u."));
+    OP_REQUIRES(context, w.dims() >= 1,
+                errors::InvalidArgument(
+                    "w must have at least 1 dimension, got ",
+                    w.shape().DebugString()));
+    const int64 channels = w.dim_size(w.dims() - 1);
+    OP_REQUIRES(context, u.NumElements() == channels,
+                errors::InvalidArgument("u should have ", channels,
+                                        " elements, got shape ",
+                                        u.shape().DebugString()));
+    if (channels == 0) {
+      return;
+    }
+    const int64 rows = w.NumElements() / channels;
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    auto u_flat = u.flat<T>();
+    std::vector<double> u_values(channels);
+    for (int64 c = 0; c < channels; ++c) {
+      u_values[c] = static_cast<double>(u_flat(c));
+    }
+    std::vector<double> wtwu(channels);
+    double sigma = 0.0;
+    for (int i = 0; i < power_iterations_; ++i) {
+      double squared_norm;
+      PowerIterationStep(device, w.flat<T>().data(), rows, channels, u_values,
+                         &squared_norm, &wtwu);
+      // `w^T v` is `w^T w u / ||w u||`, and `u` is its normalization.
+      const double v_scale =
+          1.0 / std::sqrt(std::max(squared_norm, kSquaredNormEpsilon));
+      double wtv_squared_norm = 0.0;
+      for (int64 c = 0; c < channels; ++c) {
+        wtwu[c] *= v_scale;
+        wtv_squared_norm += wtwu[c] * wtwu[c];
+      }
+      const double u_scale =
+          1.0 / std::sqrt(std::max(wtv_squared_norm, kSquaredNormEpsilon));
+      for (int64 c = 0; c < channels; ++c) {
+        u_values[c] = wtwu[c] * u_scale;
+      }
+      sigma = wtv_squared_norm * u_scale;
+    }
+
+    for (int64 c = 0; c < channels; ++c) {
+      u_flat(c) = static_cast<T>(u_values[c]);
+    }
+    w.flat<T>().device(device) = w.flat<T>() / static_cast<T>(sigma);
+  }
+
+ private:
+  int power_iterations_;
+  bool use_locking_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                          \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceSpectralNormalize")      \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          ResourceSpectralNormalizeOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
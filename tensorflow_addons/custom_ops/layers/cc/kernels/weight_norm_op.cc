@@ -0,0 +1,209 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Lower bound of the squared norms, as in tf.nn.l2_normalize.
+constexpr double kSquaredNormEpsilon = 1e-12;
+
+// Checks that `v` has at least one dimension and that `g` is a vector over
+// its last one, and returns `v` viewed as a [rows, channels] matrix.
+Status GetWeightNormShape(const Tensor &v, const Tensor &g, int64 *rows,
+                          int64 *channels) {
+  if (v.dims() < 1) {
+    return errors::InvalidArgument("v must have at least 1 dimension, got ",
+                                   v.shape().DebugString());
+  }
+  *channels = v.dim_size(v.dims() - 1);
+  if (g.shape() != TensorShape({*channels})) {
+    return errors::InvalidArgument("g should have shape [", *channels,
+                                   "], got ", g.shape().DebugString());
+  }
+  *rows = *channels == 0 ? 0 : v.NumElements() / *channels;
+  return Status::OK();
+}
+
+}  // namespace
+
+// Computes `kernel = g * v / ||v||`, where the norms are taken over all but
+// the last dimension of `v`, as with tf.nn.l2_normalize. Every task owns a
+// range of channels: it reduces their squared norms over the rows and then
+// writes the scaled rows of the range while they are still in cache.
+template <typename T>
+class WeightNormOp : public OpKernel {
+ public:
+  explicit WeightNormOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &v = context->input(0);
+    const Tensor &g = context->input(1);
+    int64 rows, channels;
+    OP_REQUIRES_OK(context, GetWeightNormShape(v, g, &rows, &channels));
+
+    Tensor *kernel = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, v.shape(), &kernel));
+    if (kernel->NumElements() == 0) {
+      return;
+    }
+
+    const T *v_data = v.flat<T>().data();
+    const T *g_data = g.flat<T>().data();
+    T *kernel_data = kernel->flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      std::vector<double> squared_norms(end - start, 0.0);
+      for (int64 r = 0; r < rows; ++r) {
+        const T *row = v_data + r * channels;
+        for (int64 c = start; c < end; ++c) {
+          const double value = static_cast<double>(row[c]);
+          squared_norms[c - start] += value * value;
+        }
+      }
+      std::vector<T> scales(end - start);
+      for (int64 c = start; c < end; ++c) {
+        scales[c - start] = static_cast<T>(
+            static_cast<double>(g_data[c]) /
+            std::sqrt(std::max(squared_norms[c - start], kSquaredNormEpsilon)));
+      }
+      for (int64 r = 0; r < rows; ++r) {
+        const T *row = v_data + r * channels;
+        T *out = kernel_data + r * channels;
+        for (int64 c = start; c < end; ++c) {
+          out[c] = row[c] * scales[c - start];
+        }
+      }
+    };
+    const Eigen::TensorOpCost cost(
+        2 * sizeof(T) * rows, sizeof(T) * rows,
+        3 * Eigen::TensorOpCost::MulCost<T>() * rows);
+    context->eigen_device<CPUDevice>().parallelFor(channels, cost, work);
+  }
+};
+
+// Computes the gradients of WeightNorm with respect to `v` and `g`. With
+// `s = 1 / ||v||` and `dot = sum(grad * v)` over the rows of a channel,
+//
+//   dg = s * dot
+//   dv = g * s * (grad - s^2 * dot * v)
+//
+// where the second term is dropped for channels whose squared norm is below
+// the epsilon of tf.nn.l2_normalize. The squared norms are recomputed in the
+// same pass that reduces `dot`, and `dv` is written in a second pass over the
+// channel range of the task.
+template <typename T>
+class WeightNormGradOp : public OpKernel {
+ public:
+  explicit WeightNormGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &grad = context->input(0);
+    const Tensor &v = context->input(1);
+    const Tensor &g = context->input(2);
+    int64 rows, channels;
+    OP_REQUIRES_OK(context, GetWeightNormShape(v, g, &rows, &channels));
+    OP_REQUIRES(context, grad.shape() == v.shape(),
+                errors::InvalidArgument(
+                    "grad and v must have the same shape, got ",
+                    grad.shape().DebugString(), " and ",
+                    v.shape().DebugString()));
+
+    Tensor *v_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, v.shape(), &v_grad));
+    Tensor *g_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1, g.shape(), &g_grad));
+    if (channels == 0) {
+      return;
+    }
+
+    const T *grad_data = grad.flat<T>().data();
+    const T *v_data = v.flat<T>().data();
+    const T *g_data = g.flat<T>().data();
+    T *v_grad_data = v_grad->flat<T>().data();
+    T *g_grad_data = g_grad->flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      std::vector<double> squared_norms(end - start, 0.0);
+      std::vector<double> dots(end - start, 0.0);
+      for (int64 r = 0; r < rows; ++r) {
+        const T *v_row = v_data + r * channels;
+        const T *grad_row = grad_data + r * channels;
+        for (int64 c = start; c < end; ++c) {
+          const double value = static_cast<double>(v_row[c]);
+          squared_norms[c - start] += value * value;
+          dots[c - start] += static_cast<double>(grad_row[c]) * value;
+        }
+      }
+      std::vector<T> grad_scales(end - start);
+      std::vector<T> v_scales(end - start);
+      for (int64 c = start; c < end; ++c) {
+        const double squared_norm = squared_norms[c - start];
+        const double inv_norm =
+            1.0 / std::sqrt(std::max(squared_norm, kSquaredNormEpsilon));
+        const double dot = dots[c - start];
+        const double scale = static_cast<double>(g_data[c]) * inv_norm;
+        g_grad_data[c] = static_cast<T>(dot * inv_norm);
+        grad_scales[c - start] = static_cast<T>(scale);
+        v_scales[c - start] =
+            squared_norm < kSquaredNormEpsilon
+                ? T(0)
+                : static_cast<T>(-scale * inv_norm * inv_norm * dot);
+      }
+      for (int64 r = 0; r < rows; ++r) {
+        const T *v_row = v_data + r * channels;
+        const T *grad_row = grad_data + r * channels;
+        T *out = v_grad_data + r * channels;
+        for (int64 c = start; c < end; ++c) {
+          out[c] = grad_row[c] * grad_scales[c - start] +
+                   v_row[c] * v_scales[c - start];
+        }
+      }
+    };
+    const Eigen::TensorOpCost cost(
+        4 * sizeof(T) * rows, sizeof(T) * rows,
+        6 * Eigen::TensorOpCost::MulCost<T>() * rows);
+    context->eigen_device<CPUDevice>().parallelFor(channels, cost, work);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>WeightNorm")                \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          WeightNormOp<T>);                        \
+  REGISTER_KERNEL_BUILDER(Name("Addons>WeightNormGrad")            \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          WeightNormGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,105 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::DimensionHandle;
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>AdaptivePool")
+    .Input("input: T")
+    .Output("output: T")
+    .Attr("output_sizes: list(int) >= 1")
+    .Attr("pooling_type: {'max', 'avg'}")
+    .Attr("data_format: {'channels_last', 'channels_first'} = 'channels_last'")
+    .Attr("drop_remainder: bool = false")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 3, &input));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(input, 5, &input));
+      std::vector<int32> output_sizes;
+      std::string data_format;
+      TF_RETURN_IF_ERROR(c->GetAttr("output_sizes", &output_sizes));
+      TF_RETURN_IF_ERROR(c->GetAttr("data_format", &data_format));
+      if (!c->RankKnown(input)) {
+        c->set_output(0, c->UnknownShapeOfRank(3));
+        return Status::OK();
+      }
+      const int spatial_dims = c->Rank(input) - 2;
+      if (output_sizes.size() % spatial_dims != 0) {
+        return errors::InvalidArgument(
+            "output_sizes must hold ", spatial_dims,
+            " sizes for every pyramid level, got ", output_sizes.size());
+      }
+      int64 num_bins = 0;
+      for (size_t level = 0; level < output_sizes.size();
+           level += spatial_dims) {
+        int64 level_bins = 1;
+        for (int i = 0; i < spatial_dims; ++i) {
+          level_bins *= output_sizes[level + i];
+        }
+        num_bins += level_bins;
+      }
+      const DimensionHandle batch = c->Dim(input, 0);
+      if (data_format == "channels_last") {
+        c->set_output(0, c->MakeShape({batch, c->MakeDim(num_bins),
+                                       c->Dim(input, -1)}));
+      } else {
+        c->set_output(0, c->MakeShape({batch, c->Dim(input, 1),
+                                       c->MakeDim(num_bins)}));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Adaptive max or average pooling over a pyramid of output sizes.
+
+Pools an input with 1, 2 or 3 spatial dimensions into every level of
+`output_sizes`, which holds the sizes of all levels one after the other, in
+one pass over the input. Bin `i` of `n` over a spatial extent `e` covers
+`[floor(i * e / n), ceil((i + 1) * e / n))`, so the output sizes need not
+divide the input. With `drop_remainder`, every level pools the leading
+`e - e % n` positions into bins of `e / n` instead. The bins of all levels are
+flattened in order into the output, of shape `[batch, num_bins, channels]` for
+channels_last inputs and `[batch, channels, num_bins]` otherwise.
+)doc");
+
+REGISTER_OP("Addons>AdaptivePoolGrad")
+    .Input("input: T")
+    .Input("grad: T")
+    .Output("input_grad: T")
+    .Attr("output_sizes: list(int) >= 1")
+    .Attr("pooling_type: {'max', 'avg'}")
+    .Attr("data_format: {'channels_last', 'channels_first'} = 'channels_last'")
+    .Attr("drop_remainder: bool = false")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradient of AdaptivePool with respect to its input.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
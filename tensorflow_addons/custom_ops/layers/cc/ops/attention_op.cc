@@ -0,0 +1,89 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>DotProductAttention")
+    .Input("query: T")
+    .Input("key: T")
+    .Input("value: T")
+    .Input("mask: T")
+    .Input("seed: int64")
+    .Output("output: T")
+    .Output("logsumexp: T")
+    .Attr("dropout_rate: float = 0.0")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle query, key, value;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &query));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 4, &key));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 4, &value));
+      c->set_output(0, c->MakeShape({c->Dim(query, 0), c->Dim(query, 1),
+                                     c->Dim(query, 2), c->Dim(value, 3)}));
+      c->set_output(1, c->MakeShape({c->Dim(query, 0), c->Dim(query, 2),
+                                     c->Dim(query, 1)}));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Dot-product attention of every head without materializing the attention.
+
+For `[batch, query_elements, heads, depth]` queries,
+`[batch, key_elements, heads, depth]` keys and
+`[batch, key_elements, heads, value_depth]` values, returns
+`softmax(query . key + mask_penalty)` applied to the values, of shape
+`[batch, query_elements, heads, value_depth]`, and the log-sum-exp of the
+logits of every query, of shape `[batch, heads, query_elements]`. The keys
+are visited in blocks with a running softmax, so memory does not grow with
+the number of keys.
+
+mask: Empty, or `[batch or 1, heads or 1, query_elements, key_elements]`;
+  `-10e9 * (1 - mask)` is added to the logits.
+seed: Two integers seeding the dropout of the attention, which is applied
+  with rate `dropout_rate` after the softmax.
+)doc");
+
+REGISTER_OP("Addons>DotProductAttentionGrad")
+    .Input("query: T")
+    .Input("key: T")
+    .Input("value: T")
+    .Input("mask: T")
+    .Input("seed: int64")
+    .Input("output: T")
+    .Input("logsumexp: T")
+    .Input("grad: T")
+    .Output("query_grad: T")
+    .Output("key_grad: T")
+    .Output("value_grad: T")
+    .Attr("dropout_rate: float = 0.0")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(1));
+      c->set_output(2, c->input(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of DotProductAttention with respect to its query, key and value.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,104 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::DimensionHandle;
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+namespace {
+
+// Computes the spatial size of the input of the max pooling from the size
+// `dim` of its output.
+Status UnpooledDim(InferenceContext* c, DimensionHandle dim, int32 pool_size,
+                   int32 stride, bool valid_padding, DimensionHandle* out) {
+  if (valid_padding) {
+    TF_RETURN_IF_ERROR(c->Subtract(dim, 1, &dim));
+    TF_RETURN_IF_ERROR(c->Multiply(dim, stride, &dim));
+    return c->Add(dim, pool_size, out);
+  }
+  return c->Multiply(dim, stride, out);
+}
+
+}  // namespace
+
+REGISTER_OP("Addons>MaxUnpooling2D")
+    .Input("updates: T")
+    .Input("mask: Tmask")
+    .Output("output: T")
+    .Attr("pool_size: list(int) = [2, 2]")
+    .Attr("strides: list(int) = [2, 2]")
+    .Attr("padding: {'SAME', 'VALID'} = 'SAME'")
+    .Attr("T: {half, float, double}")
+    .Attr("Tmask: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle updates;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &updates));
+      TF_RETURN_IF_ERROR(c->Merge(updates, c->input(1), &updates));
+      std::vector<int32> pool_size, strides;
+      std::string padding;
+      TF_RETURN_IF_ERROR(c->GetAttr("pool_size", &pool_size));
+      TF_RETURN_IF_ERROR(c->GetAttr("strides", &strides));
+      TF_RETURN_IF_ERROR(c->GetAttr("padding", &padding));
+      if (pool_size.size() != 2 || strides.size() != 2) {
+        return errors::InvalidArgument(
+            "pool_size and strides must have 2 elements.");
+      }
+      DimensionHandle height, width;
+      TF_RETURN_IF_ERROR(UnpooledDim(c, c->Dim(updates, 1), pool_size[0],
+                                     strides[0], padding == "VALID", &height));
+      TF_RETURN_IF_ERROR(UnpooledDim(c, c->Dim(updates, 2), pool_size[1],
+                                     strides[1], padding == "VALID", &width));
+      c->set_output(0, c->MakeShape({c->Dim(updates, 0), height, width,
+                                     c->Dim(updates, 3)}));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Unpools the outputs of a maximum pooling operation.
+
+Writes every update into a zero-initialized tensor with the shape of the
+input of the max pooling, at the position given by `mask` as returned by
+`tf.nn.max_pool_with_argmax` without `include_batch_in_index`. Updates
+unpooled to the same position are summed.
+)doc");
+
+REGISTER_OP("Addons>MaxUnpooling2DGrad")
+    .Input("updates: T")
+    .Input("mask: Tmask")
+    .Input("grad: T")
+    .Output("updates_grad: T")
+    .Attr("pool_size: list(int) = [2, 2]")
+    .Attr("strides: list(int) = [2, 2]")
+    .Attr("padding: {'SAME', 'VALID'} = 'SAME'")
+    .Attr("T: {half, float, double}")
+    .Attr("Tmask: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradient of MaxUnpooling2D with respect to its updates.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
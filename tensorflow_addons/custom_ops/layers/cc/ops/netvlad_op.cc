@@ -0,0 +1,74 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::DimensionHandle;
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>NetVLADAggregate")
+    .Input("frames: T")
+    .Input("assignments: T")
+    .Input("centers: T")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle frames, assignments, centers;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 3, &frames));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 3, &assignments));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &centers));
+      DimensionHandle size;
+      TF_RETURN_IF_ERROR(
+          c->Multiply(c->Dim(centers, 0), c->Dim(centers, 1), &size));
+      c->set_output(0, c->Matrix(c->Dim(frames, 0), size));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Aggregates soft-assigned frames into NetVLAD descriptors.
+
+For `[batch, time, feature_dim]` frames, `[batch, time, num_clusters]`
+assignments and `[feature_dim, num_clusters]` centers, accumulates the
+residuals `sum_t a[t, k] * (frames[t, d] - centers[d, k])` in one pass over
+the frames, L2-normalizes every cluster over the feature dimension and then
+the whole descriptor, and returns it flattened to
+`[batch, feature_dim * num_clusters]`.
+)doc");
+
+REGISTER_OP("Addons>NetVLADAggregateGrad")
+    .Input("frames: T")
+    .Input("assignments: T")
+    .Input("centers: T")
+    .Input("grad: T")
+    .Output("frames_grad: T")
+    .Output("assignments_grad: T")
+    .Output("centers_grad: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(1));
+      c->set_output(2, c->input(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of NetVLADAggregate with respect to its three inputs.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
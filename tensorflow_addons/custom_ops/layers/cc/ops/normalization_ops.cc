@@ -0,0 +1,155 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::DimensionHandle;
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+namespace {
+
+// Returns the [batch, groups] shape of the group statistics of `x`.
+Status GroupStatsShape(InferenceContext* c, ShapeHandle x, ShapeHandle* out) {
+  int groups;
+  TF_RETURN_IF_ERROR(c->GetAttr("groups", &groups));
+  *out = c->Matrix(c->Dim(x, 0), c->MakeDim(groups));
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("Addons>GroupNorm")
+    .Input("x: T")
+    .Input("gamma: T")
+    .Input("beta: T")
+    .Output("y: T")
+    .Output("mean: T")
+    .Output("inv_std: T")
+    .Attr("T: {float, double}")
+    .Attr("groups: int >= 1")
+    .Attr("epsilon: float = 0.001")
+    .Attr("data_format: {'NHWC', 'NCHW'} = 'NHWC'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x, stats, unused;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 2, &x));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(GroupStatsShape(c, x, &stats));
+      c->set_output(0, x);
+      c->set_output(1, stats);
+      c->set_output(2, stats);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Group normalization of `x` with a per-channel affine transform.
+
+The channels are the last dimension of `x` for NHWC and the second one for
+NCHW, and are split into `groups` groups. The mean and variance of each group
+of each example are reduced in one Welford pass, and the group is normalized
+and scaled right after. Also returns the `[batch, groups]` mean and inverse
+standard deviation used by the gradient.
+)doc");
+
+REGISTER_OP("Addons>GroupNormGrad")
+    .Input("dy: T")
+    .Input("x: T")
+    .Input("gamma: T")
+    .Input("mean: T")
+    .Input("inv_std: T")
+    .Output("dx: T")
+    .Output("dgamma: T")
+    .Output("dbeta: T")
+    .Attr("T: {float, double}")
+    .Attr("groups: int >= 1")
+    .Attr("data_format: {'NHWC', 'NCHW'} = 'NHWC'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->Merge(c->input(0), c->input(1), &x));
+      c->set_output(0, x);
+      c->set_output(1, c->input(2));
+      c->set_output(2, c->input(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of GroupNorm with respect to `x`, `gamma` and `beta`.
+)doc");
+
+REGISTER_OP("Addons>WeightNorm")
+    .Input("v: T")
+    .Input("g: T")
+    .Output("kernel: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle v, g;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &v));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &g));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(v, -1), c->Dim(g, 0), &unused));
+      c->set_output(0, v);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Weight normalization of a kernel, `kernel = g * v / ||v||`.
+
+The norms are taken over all but the last dimension of `v`, as with
+`tf.nn.l2_normalize`, and `g` has one scale per slice of the last dimension.
+The squared norms and the scaled kernel of a range of channels are computed
+in one task, while the range is in cache.
+)doc");
+
+REGISTER_OP("Addons>WeightNormGrad")
+    .Input("grad: T")
+    .Input("v: T")
+    .Input("g: T")
+    .Output("v_grad: T")
+    .Output("g_grad: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle v;
+      TF_RETURN_IF_ERROR(c->Merge(c->input(0), c->input(1), &v));
+      c->set_output(0, v);
+      c->set_output(1, c->input(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of WeightNorm with respect to `v` and `g`.
+)doc");
+
+REGISTER_OP("Addons>ResourceSpectralNormalize")
+    .Input("w: resource")
+    .Input("u: resource")
+    .Attr("T: {float, double}")
+    .Attr("power_iterations: int >= 1")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Spectral normalization of `w`, updating `w` and `u` in place.
+
+With `w` viewed as a [rows, channels] matrix and `u` holding `channels`
+elements, every power iteration computes `v = l2_normalize(w u)` and
+`u = l2_normalize(w^T v)`, then `w` is divided by `(w^T v) . u`. Each
+iteration is a single sweep over `w`.
+
+power_iterations: The number of power iterations.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
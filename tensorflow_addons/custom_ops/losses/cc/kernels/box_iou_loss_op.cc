@@ -0,0 +1,399 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+enum class IoUMode {
+  kIoU,
+  kGIoU,
+  kDIoU,
+  kCIoU,
+};
+
+// `4 / pi^2`, the scale of the aspect ratio term of CIoU.
+constexpr double kAspectRatioScale = 0.40528473456935108578;
+
+// A box encoded as `[y_min, x_min, y_max, x_max]`.
+template <typename T>
+struct Box {
+  explicit Box(const T *coordinates)
+      : ymin(coordinates[0]),
+        xmin(coordinates[1]),
+        ymax(coordinates[2]),
+        xmax(coordinates[3]) {}
+
+  T ymin, xmin, ymax, xmax;
+};
+
+// The gradient of a box, in the same encoding.
+template <typename T>
+struct BoxGrad {
+  T ymin = T(0), xmin = T(0), ymax = T(0), xmax = T(0);
+};
+
+// The intermediate values of the metric of one pair of boxes, computed like
+// `_calculate_giou`: sizes are clipped at zero and ratios with a zero
+// denominator are zero.
+template <typename T>
+struct IoUTerms {
+  IoUTerms(const Box<T> &b1, const Box<T> &b2, IoUMode mode) {
+    width1 = std::max(T(0), b1.xmax - b1.xmin);
+    height1 = std::max(T(0), b1.ymax - b1.ymin);
+    width2 = std::max(T(0), b2.xmax - b2.xmin);
+    height2 = std::max(T(0), b2.ymax - b2.ymin);
+    intersect_width = std::max(
+        T(0), std::min(b1.xmax, b2.xmax) - std::max(b1.xmin, b2.xmin));
+    intersect_height = std::max(
+        T(0), std::min(b1.ymax, b2.ymax) - std::max(b1.ymin, b2.ymin));
+    intersect_area = intersect_width * intersect_height;
+    union_area = width1 * height1 + width2 * height2 - intersect_area;
+    metric = union_area == T(0) ? T(0) : intersect_area / union_area;
+    iou = metric;
+    if (mode == IoUMode::kIoU) {
+      return;
+    }
+
+    enclose_width = std::max(
+        T(0), std::max(b1.xmax, b2.xmax) - std::min(b1.xmin, b2.xmin));
+    enclose_height = std::max(
+        T(0), std::max(b1.ymax, b2.ymax) - std::min(b1.ymin, b2.ymin));
+    if (mode == IoUMode::kGIoU) {
+      enclose_area = enclose_width * enclose_height;
+      if (enclose_area != T(0)) {
+        metric -= (enclose_area - union_area) / enclose_area;
+      }
+      return;
+    }
+
+    center_dy = (b1.ymin + b1.ymax - b2.ymin - b2.ymax) / T(2);
+    center_dx = (b1.xmin + b1.xmax - b2.xmin - b2.xmax) / T(2);
+    center_distance = center_dy * center_dy + center_dx * center_dx;
+    diagonal =
+        enclose_width * enclose_width + enclose_height * enclose_height;
+    if (diagonal != T(0)) {
+      metric -= center_distance / diagonal;
+    }
+    if (mode == IoUMode::kCIoU) {
+      angle_diff = std::atan2(width2, height2) - std::atan2(width1, height1);
+      aspect_ratio = static_cast<T>(kAspectRatioScale) * angle_diff *
+                     angle_diff;
+      const T denominator = T(1) - iou + aspect_ratio;
+      alpha = denominator == T(0) ? T(0) : aspect_ratio / denominator;
+      metric -= alpha * aspect_ratio;
+    }
+  }
+
+  T width1, height1, width2, height2;
+  T intersect_width, intersect_height, intersect_area, union_area, iou;
+  T enclose_width = T(0), enclose_height = T(0), enclose_area = T(0);
+  T center_dy = T(0), center_dx = T(0), center_distance = T(0);
+  T diagonal = T(0), angle_diff = T(0), aspect_ratio = T(0), alpha = T(0);
+  T metric;
+};
+
+// Backpropagates `grad` through `max(0, end - begin)`.
+template <typename T>
+void ClippedDifferenceGrad(T begin, T end, T grad, T *begin_grad,
+                           T *end_grad) {
+  if (end - begin > T(0)) {
+    *end_grad += grad;
+    *begin_grad -= grad;
+  }
+}
+
+// Backpropagates `grad` through `std::max(a, b)`, which like `tf.maximum`
+// passes it to `a` on ties, or through `std::min(a, b)` when `min` is true.
+template <typename T>
+void SelectGrad(bool min, T a, T b, T grad, T *a_grad, T *b_grad) {
+  if (min ? a <= b : a >= b) {
+    *a_grad += grad;
+  } else {
+    *b_grad += grad;
+  }
+}
+
+// Backpropagates `grad` through `atan2(width, height)`.
+template <typename T>
+void AngleGrad(T width, T height, T grad, T *width_grad, T *height_grad) {
+  const T norm = width * width + height * height;
+  if (norm != T(0)) {
+    *width_grad += grad * height / norm;
+    *height_grad -= grad * width / norm;
+  }
+}
+
+// Computes the gradients of both boxes of a pair from the gradient of its
+// metric. Like the `tf.stop_gradient` of the Python implementation, the
+// `alpha` of CIoU is a constant.
+template <typename T>
+void IoUGrad(const Box<T> &b1, const Box<T> &b2, const IoUTerms<T> &terms,
+             IoUMode mode, T grad, BoxGrad<T> *g1, BoxGrad<T> *g2) {
+  T union_grad(0);
+  T enclose_width_grad(0), enclose_height_grad(0);
+  T width1_grad(0), height1_grad(0), width2_grad(0), height2_grad(0);
+  if (mode == IoUMode::kGIoU && terms.enclose_area != T(0)) {
+    // The metric is `iou - 1 + union_area / enclose_area`.
+    union_grad += grad / terms.enclose_area;
+    const T enclose_grad = -grad * terms.union_area /
+                           (terms.enclose_area * terms.enclose_area);
+    enclose_width_grad += enclose_grad * terms.enclose_height;
+    enclose_height_grad += enclose_grad * terms.enclose_width;
+  }
+  if ((mode == IoUMode::kDIoU || mode == IoUMode::kCIoU) &&
+      terms.diagonal != T(0)) {
+    const T distance_grad = -grad / terms.diagonal;
+    const T diagonal_grad = grad * terms.center_distance /
+                            (terms.diagonal * terms.diagonal);
+    enclose_width_grad += T(2) * terms.enclose_width * diagonal_grad;
+    enclose_height_grad += T(2) * terms.enclose_height * diagonal_grad;
+    const T dy_grad = distance_grad * terms.center_dy;
+    const T dx_grad = distance_grad * terms.center_dx;
+    g1->ymin += dy_grad;
+    g1->ymax += dy_grad;
+    g2->ymin -= dy_grad;
+    g2->ymax -= dy_grad;
+    g1->xmin += dx_grad;
+    g1->xmax += dx_grad;
+    g2->xmin -= dx_grad;
+    g2->xmax -= dx_grad;
+  }
+  if (mode == IoUMode::kCIoU) {
+    const T angle_grad = -grad * terms.alpha *
+                         static_cast<T>(2 * kAspectRatioScale) *
+                         terms.angle_diff;
+    AngleGrad(terms.width2, terms.height2, angle_grad, &width2_grad,
+              &height2_grad);
+    AngleGrad(terms.width1, terms.height1, -angle_grad, &width1_grad,
+              &height1_grad);
+  }
+
+  T intersect_grad(0);
+  if (terms.union_area != T(0)) {
+    intersect_grad += grad / terms.union_area;
+    union_grad -= grad * terms.intersect_area /
+                  (terms.union_area * terms.union_area);
+  }
+  intersect_grad -= union_grad;
+  width1_grad += union_grad * terms.height1;
+  height1_grad += union_grad * terms.width1;
+  width2_grad += union_grad * terms.height2;
+  height2_grad += union_grad * terms.width2;
+  ClippedDifferenceGrad(b1.xmin, b1.xmax, width1_grad, &g1->xmin, &g1->xmax);
+  ClippedDifferenceGrad(b1.ymin, b1.ymax, height1_grad, &g1->ymin,
+                        &g1->ymax);
+  ClippedDifferenceGrad(b2.xmin, b2.xmax, width2_grad, &g2->xmin, &g2->xmax);
+  ClippedDifferenceGrad(b2.ymin, b2.ymax, height2_grad, &g2->ymin,
+                        &g2->ymax);
+
+  // The intersection spans from the larger minimum to the smaller maximum.
+  T begin_grad(0), end_grad(0);
+  ClippedDifferenceGrad(std::max(b1.xmin, b2.xmin),
+                        std::min(b1.xmax, b2.xmax),
+                        intersect_grad * terms.intersect_height, &begin_grad,
+                        &end_grad);
+  SelectGrad(false, b1.xmin, b2.xmin, begin_grad, &g1->xmin, &g2->xmin);
+  SelectGrad(true, b1.xmax, b2.xmax, end_grad, &g1->xmax, &g2->xmax);
+  begin_grad = end_grad = T(0);
+  ClippedDifferenceGrad(std::max(b1.ymin, b2.ymin),
+                        std::min(b1.ymax, b2.ymax),
+                        intersect_grad * terms.intersect_width, &begin_grad,
+                        &end_grad);
+  SelectGrad(false, b1.ymin, b2.ymin, begin_grad, &g1->ymin, &g2->ymin);
+  SelectGrad(true, b1.ymax, b2.ymax, end_grad, &g1->ymax, &g2->ymax);
+  if (mode == IoUMode::kIoU) {
+    return;
+  }
+
+  // The enclosing box spans from the smaller minimum to the larger maximum.
+  begin_grad = end_grad = T(0);
+  ClippedDifferenceGrad(std::min(b1.xmin, b2.xmin),
+                        std::max(b1.xmax, b2.xmax), enclose_width_grad,
+                        &begin_grad, &end_grad);
+  SelectGrad(true, b1.xmin, b2.xmin, begin_grad, &g1->xmin, &g2->xmin);
+  SelectGrad(false, b1.xmax, b2.xmax, end_grad, &g1->xmax, &g2->xmax);
+  begin_grad = end_grad = T(0);
+  ClippedDifferenceGrad(std::min(b1.ymin, b2.ymin),
+                        std::max(b1.ymax, b2.ymax), enclose_height_grad,
+                        &begin_grad, &end_grad);
+  SelectGrad(true, b1.ymin, b2.ymin, begin_grad, &g1->ymin, &g2->ymin);
+  SelectGrad(false, b1.ymax, b2.ymax, end_grad, &g1->ymax, &g2->ymax);
+}
+
+class BoxIoULossBase : public OpKernel {
+ public:
+  explicit BoxIoULossBase(OpKernelConstruction *context) : OpKernel(context) {
+    std::string mode;
+    OP_REQUIRES_OK(context, context->GetAttr("mode", &mode));
+    if (mode == "iou") {
+      mode_ = IoUMode::kIoU;
+    } else if (mode == "giou") {
+      mode_ = IoUMode::kGIoU;
+    } else if (mode == "diou") {
+      mode_ = IoUMode::kDIoU;
+    } else if (mode == "ciou") {
+      mode_ = IoUMode::kCIoU;
+    } else {
+      context->CtxFailure(errors::InvalidArgument(
+          "mode must be 'iou', 'giou', 'diou' or 'ciou', got ", mode));
+    }
+  }
+
+ protected:
+  Status CheckInputs(const Tensor &boxes1, const Tensor &boxes2) const {
+    if (boxes1.dims() < 1 || boxes1.dim_size(boxes1.dims() - 1) != 4) {
+      return errors::InvalidArgument(
+          "boxes1 must have a last dimension of size 4, got ",
+          boxes1.shape().DebugString());
+    }
+    if (boxes1.shape() != boxes2.shape()) {
+      return errors::InvalidArgument(
+          "boxes1 and boxes2 should have the same shape, got ",
+          boxes1.shape().DebugString(), " and ",
+          boxes2.shape().DebugString());
+    }
+    return Status::OK();
+  }
+
+  static TensorShape PairShape(const Tensor &boxes) {
+    TensorShape shape = boxes.shape();
+    shape.RemoveLastDims(1);
+    return shape;
+  }
+
+  IoUMode mode_;
+};
+
+}  // namespace
+
+// Computes `1 - metric` of every pair of boxes in registers, sharded over
+// the pairs, reading each box and writing each loss once.
+template <typename T>
+class BoxIoULossOp : public BoxIoULossBase {
+ public:
+  explicit BoxIoULossOp(OpKernelConstruction *context)
+      : BoxIoULossBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &boxes1 = context->input(0);
+    const Tensor &boxes2 = context->input(1);
+    OP_REQUIRES_OK(context, CheckInputs(boxes1, boxes2));
+    Tensor *loss = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, PairShape(boxes1), &loss));
+    const T *b1 = boxes1.flat<T>().data();
+    const T *b2 = boxes2.flat<T>().data();
+    T *l = loss->flat<T>().data();
+    const IoUMode mode = mode_;
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 i = start; i < end; ++i) {
+        l[i] = T(1) -
+               IoUTerms<T>(Box<T>(b1 + 4 * i), Box<T>(b2 + 4 * i), mode)
+                   .metric;
+      }
+    };
+    const Eigen::TensorOpCost cost(8 * sizeof(T), sizeof(T),
+                                   mode_ == IoUMode::kCIoU ? 120 : 40);
+    context->eigen_device<CPUDevice>().parallelFor(loss->NumElements(), cost,
+                                                   work);
+  }
+};
+
+// Recomputes the metric of every pair of boxes and backpropagates the
+// gradient of its loss to both boxes.
+template <typename T>
+class BoxIoULossGradOp : public BoxIoULossBase {
+ public:
+  explicit BoxIoULossGradOp(OpKernelConstruction *context)
+      : BoxIoULossBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &boxes1 = context->input(0);
+    const Tensor &boxes2 = context->input(1);
+    const Tensor &grad = context->input(2);
+    OP_REQUIRES_OK(context, CheckInputs(boxes1, boxes2));
+    OP_REQUIRES(context, grad.shape() == PairShape(boxes1),
+                errors::InvalidArgument(
+                    "grad should have shape ",
+                    PairShape(boxes1).DebugString(), ", got ",
+                    grad.shape().DebugString()));
+    Tensor *boxes1_grad = nullptr;
+    Tensor *boxes2_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, boxes1.shape(),
+                                                     &boxes1_grad));
+    OP_REQUIRES_OK(context, context->allocate_output(1, boxes2.shape(),
+                                                     &boxes2_grad));
+    const T *b1 = boxes1.flat<T>().data();
+    const T *b2 = boxes2.flat<T>().data();
+    const T *g = grad.flat<T>().data();
+    T *d1 = boxes1_grad->flat<T>().data();
+    T *d2 = boxes2_grad->flat<T>().data();
+    const IoUMode mode = mode_;
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 i = start; i < end; ++i) {
+        const Box<T> box1(b1 + 4 * i);
+        const Box<T> box2(b2 + 4 * i);
+        BoxGrad<T> grad1, grad2;
+        IoUGrad(box1, box2, IoUTerms<T>(box1, box2, mode), mode, -g[i],
+                &grad1, &grad2);
+        T *out1 = d1 + 4 * i;
+        T *out2 = d2 + 4 * i;
+        out1[0] = grad1.ymin;
+        out1[1] = grad1.xmin;
+        out1[2] = grad1.ymax;
+        out1[3] = grad1.xmax;
+        out2[0] = grad2.ymin;
+        out2[1] = grad2.xmin;
+        out2[2] = grad2.ymax;
+        out2[3] = grad2.xmax;
+      }
+    };
+    const Eigen::TensorOpCost cost(9 * sizeof(T), 8 * sizeof(T),
+                                   mode_ == IoUMode::kCIoU ? 240 : 100);
+    context->eigen_device<CPUDevice>().parallelFor(grad.NumElements(), cost,
+                                                   work);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                          \
+  REGISTER_KERNEL_BUILDER(Name("Addons>BoxIoULoss")                     \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          BoxIoULossOp<T>);                             \
+  REGISTER_KERNEL_BUILDER(Name("Addons>BoxIoULossGrad")                 \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          BoxIoULossGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
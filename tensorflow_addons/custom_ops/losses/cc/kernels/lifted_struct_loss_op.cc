@@ -0,0 +1,372 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow_addons/custom_ops/losses/cc/kernels/pairwise_distance_op.h"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+template <typename T>
+T LogAddExp(T a, T b) {
+  const T maximum = std::max(a, b);
+  if (maximum == -std::numeric_limits<T>::infinity()) {
+    return maximum;
+  }
+  return maximum + std::log1p(std::exp(-std::abs(a - b)));
+}
+
+// The lifted structured loss of a positive pair (i, j) is
+//
+//   J_ij = log(sum_{k in neg(i)} exp(margin - d_ik) +
+//              sum_{k in neg(j)} exp(margin - d_jk)) + d_ij
+//        = logaddexp(L_i, L_j) + d_ij,
+//
+// where L_i is the log-sum-exp over the negatives of row i. `L` only has one
+// entry per row, so the kernels below sweep the distance matrix tile by tile
+// and never hold more than a tile of it, instead of the `[batch^2, batch]`
+// tiled differences of `lifted.lifted_struct_loss`.
+template <typename T, typename Tlabels>
+class LiftedStructSweeper {
+ public:
+  LiftedStructSweeper(OpKernelContext *context,
+                      const PairwiseDistanceTiler<T> &tiler,
+                      const Tlabels *labels, T margin)
+      : context_(context), tiler_(tiler), labels_(labels), margin_(margin) {}
+
+  // Computes L_i for every row with an online max, rescaling the running sum
+  // whenever a larger term is found. Rows without negatives get -inf.
+  void NegativeLogSumExp(T *lse) const {
+    const Eigen::Index num_rows = tiler_.num_rows();
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      RowMajorMatrix<T> gram, tile;
+      for (Eigen::Index row_tile = start; row_tile < end; ++row_tile) {
+        const Eigen::Index row_begin = row_tile * kPairwiseDistanceTileSize;
+        const Eigen::Index rows =
+            std::min(kPairwiseDistanceTileSize, num_rows - row_begin);
+        Eigen::Matrix<T, Eigen::Dynamic, 1> maximums, sums;
+        maximums.setConstant(rows, -std::numeric_limits<T>::infinity());
+        sums.setZero(rows);
+        for (Eigen::Index col_begin = 0; col_begin < num_rows;
+             col_begin += kPairwiseDistanceTileSize) {
+          const Eigen::Index cols =
+              std::min(kPairwiseDistanceTileSize, num_rows - col_begin);
+          tiler_.ComputeTile(row_begin, rows, col_begin, cols, &gram, &tile);
+          for (Eigen::Index r = 0; r < rows; ++r) {
+            const Tlabels label = labels_[row_begin + r];
+            for (Eigen::Index c = 0; c < cols; ++c) {
+              if (labels_[col_begin + c] == label) {
+                continue;
+              }
+              const T value = margin_ - tile(r, c);
+              if (value > maximums(r)) {
+                sums(r) = sums(r) * std::exp(maximums(r) - value) + T(1);
+                maximums(r) = value;
+              } else {
+                sums(r) += std::exp(value - maximums(r));
+              }
+            }
+          }
+        }
+        for (Eigen::Index r = 0; r < rows; ++r) {
+          lse[row_begin + r] = sums(r) > T(0)
+                                   ? maximums(r) + std::log(sums(r))
+                                   : -std::numeric_limits<T>::infinity();
+        }
+      }
+    };
+    Sweep(std::move(work));
+  }
+
+  // For every row i, sums max(J_ij, 0)^2 over its positives j into
+  // `losses[i]` and, if `lse_weights` is not null,
+  // max(J_ij, 0) * dJ_ij/dL_i into `lse_weights[i]`.
+  void PositiveTerms(const T *lse, T *losses, T *lse_weights) const {
+    const Eigen::Index num_rows = tiler_.num_rows();
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      RowMajorMatrix<T> gram, tile;
+      for (Eigen::Index row_tile = start; row_tile < end; ++row_tile) {
+        const Eigen::Index row_begin = row_tile * kPairwiseDistanceTileSize;
+        const Eigen::Index rows =
+            std::min(kPairwiseDistanceTileSize, num_rows - row_begin);
+        for (Eigen::Index r = 0; r < rows; ++r) {
+          losses[row_begin + r] = T(0);
+          if (lse_weights != nullptr) {
+            lse_weights[row_begin + r] = T(0);
+          }
+        }
+        for (Eigen::Index col_begin = 0; col_begin < num_rows;
+             col_begin += kPairwiseDistanceTileSize) {
+          const Eigen::Index cols =
+              std::min(kPairwiseDistanceTileSize, num_rows - col_begin);
+          tiler_.ComputeTile(row_begin, rows, col_begin, cols, &gram, &tile);
+          for (Eigen::Index r = 0; r < rows; ++r) {
+            const Eigen::Index i = row_begin + r;
+            for (Eigen::Index c = 0; c < cols; ++c) {
+              const Eigen::Index j = col_begin + c;
+              if (j == i || labels_[j] != labels_[i]) {
+                continue;
+              }
+              const T soft_maximum = LogAddExp(lse[i], lse[j]);
+              const T loss = std::max(soft_maximum + tile(r, c), T(0));
+              if (!(loss > T(0))) {
+                continue;
+              }
+              losses[i] += loss * loss;
+              if (lse_weights != nullptr) {
+                lse_weights[i] += loss * std::exp(lse[i] - soft_maximum);
+              }
+            }
+          }
+        }
+      }
+    };
+    Sweep(std::move(work));
+  }
+
+  // Writes the gradient of `scale * sum_ij max(J_ij, 0)^2 / 2` with respect
+  // to the embeddings, given L and `lse_weights` from `PositiveTerms`.
+  void Gradient(const T *lse, const T *lse_weights, T scale,
+                Eigen::Map<RowMajorMatrix<T>> *embeddings_grads) const {
+    const Eigen::Index num_rows = tiler_.num_rows();
+    const Eigen::Index depth = tiler_.depth();
+    const auto operands = tiler_.operands();
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      RowMajorMatrix<T> gram, tile, weights, accumulated;
+      Eigen::Matrix<T, Eigen::Dynamic, 1> row_sums;
+      for (Eigen::Index row_tile = start; row_tile < end; ++row_tile) {
+        const Eigen::Index row_begin = row_tile * kPairwiseDistanceTileSize;
+        const Eigen::Index rows =
+            std::min(kPairwiseDistanceTileSize, num_rows - row_begin);
+        accumulated.setZero(rows, depth);
+        row_sums.setZero(rows);
+        for (Eigen::Index col_begin = 0; col_begin < num_rows;
+             col_begin += kPairwiseDistanceTileSize) {
+          const Eigen::Index cols =
+              std::min(kPairwiseDistanceTileSize, num_rows - col_begin);
+          tiler_.ComputeTile(row_begin, rows, col_begin, cols, &gram, &tile);
+          weights.resize(rows, cols);
+          for (Eigen::Index r = 0; r < rows; ++r) {
+            const Eigen::Index i = row_begin + r;
+            for (Eigen::Index c = 0; c < cols; ++c) {
+              const Eigen::Index j = col_begin + c;
+              const T distance = tile(r, c);
+              // d_ii is constant, and d_ij is not differentiable at 0.
+              if (j == i || !(distance > T(0))) {
+                weights(r, c) = T(0);
+                continue;
+              }
+              T weight;
+              if (labels_[j] == labels_[i]) {
+                // d_ij enters both J_ij and J_ji.
+                weight = T(2) * std::max(
+                                    LogAddExp(lse[i], lse[j]) + distance, T(0));
+              } else {
+                // d_ij enters both L_i and L_j.
+                const T value = margin_ - distance;
+                weight = -T(2) * (lse_weights[i] * std::exp(value - lse[i]) +
+                                  lse_weights[j] * std::exp(value - lse[j]));
+              }
+              // d(d_ij)/dx_i = (x_i - x_j) / d_ij
+              weights(r, c) = weight / distance;
+            }
+          }
+          accumulated.noalias() +=
+              weights * operands.middleRows(col_begin, cols);
+          row_sums += weights.rowwise().sum();
+        }
+        for (Eigen::Index r = 0; r < rows; ++r) {
+          const Eigen::Index i = row_begin + r;
+          embeddings_grads->row(i) =
+              scale * (row_sums(r) * operands.row(i) - accumulated.row(r));
+        }
+      }
+    };
+    Sweep(std::move(work), 3.0);
+  }
+
+ private:
+  template <typename Work>
+  void Sweep(Work &&work, double cost_scale = 1.0) const {
+    const CPUDevice &device = context_->eigen_device<CPUDevice>();
+    device.parallelFor(
+        tiler_.num_tiles(),
+        TileRowCost<T>(tiler_.num_rows(), tiler_.depth()) * cost_scale,
+        std::forward<Work>(work));
+  }
+
+  OpKernelContext *context_;
+  const PairwiseDistanceTiler<T> &tiler_;
+  const Tlabels *labels_;
+  const T margin_;
+};
+
+// Returns the number of ordered (i, j) pairs with i != j and the same label.
+template <typename Tlabels>
+int64 NumPositivePairs(const Tlabels *labels, int64 num_rows) {
+  std::unordered_map<Tlabels, int64> counts;
+  for (int64 i = 0; i < num_rows; ++i) {
+    ++counts[labels[i]];
+  }
+  int64 num_positives = 0;
+  for (const auto &count : counts) {
+    num_positives += count.second * (count.second - 1);
+  }
+  return num_positives;
+}
+
+Status ValidateLiftedStructInputs(OpKernelContext *context) {
+  const Tensor &labels = context->input(0);
+  const Tensor &embeddings = context->input(1);
+  if (!TensorShapeUtils::IsVector(labels.shape())) {
+    return errors::InvalidArgument("labels shape should be 1-D.");
+  }
+  if (!TensorShapeUtils::IsMatrix(embeddings.shape())) {
+    return errors::InvalidArgument("embeddings shape should be 2-D.");
+  }
+  if (labels.dim_size(0) != embeddings.dim_size(0)) {
+    return errors::InvalidArgument(
+        "labels and embeddings should have the same batch size.");
+  }
+  if (!TensorShapeUtils::IsScalar(context->input(2).shape())) {
+    return errors::InvalidArgument("margin should be a scalar.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename T, typename Tlabels>
+class LiftedStructLossOp : public OpKernel {
+ public:
+  explicit LiftedStructLossOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    OP_REQUIRES_OK(context, ValidateLiftedStructInputs(context));
+    const Tensor &labels = context->input(0);
+    const Tensor &embeddings = context->input(1);
+    const T margin = context->input(2).scalar<T>()();
+
+    PairwiseDistanceTiler<T> tiler(DistanceMetric::kL2);
+    OP_REQUIRES_OK(context, tiler.Init(context, embeddings));
+    const Eigen::Index num_rows = tiler.num_rows();
+    const Tlabels *labels_data = labels.flat<Tlabels>().data();
+
+    Tensor lse, losses;
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::value,
+                                                   TensorShape({num_rows}),
+                                                   &lse));
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::value,
+                                                   TensorShape({num_rows}),
+                                                   &losses));
+    LiftedStructSweeper<T, Tlabels> sweeper(context, tiler, labels_data,
+                                            margin);
+    sweeper.NegativeLogSumExp(lse.flat<T>().data());
+    sweeper.PositiveTerms(lse.flat<T>().data(), losses.flat<T>().data(),
+                          nullptr);
+
+    T total = T(0);
+    for (Eigen::Index i = 0; i < num_rows; ++i) {
+      total += losses.flat<T>()(i);
+    }
+    const int64 num_positives = NumPositivePairs(labels_data, num_rows);
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({}), &output));
+    // Each unordered pair is counted twice, so this is the mean of
+    // max(J_ij, 0)^2 / 2 over the unordered positive pairs.
+    output->scalar<T>()() = total / static_cast<T>(2 * num_positives);
+  }
+};
+
+template <typename T, typename Tlabels>
+class LiftedStructLossGradOp : public OpKernel {
+ public:
+  explicit LiftedStructLossGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    OP_REQUIRES_OK(context, ValidateLiftedStructInputs(context));
+    const Tensor &labels = context->input(0);
+    const Tensor &embeddings = context->input(1);
+    const T margin = context->input(2).scalar<T>()();
+    const Tensor &grad = context->input(3);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(grad.shape()),
+                errors::InvalidArgument("grad should be a scalar."));
+
+    PairwiseDistanceTiler<T> tiler(DistanceMetric::kL2);
+    OP_REQUIRES_OK(context, tiler.Init(context, embeddings));
+    const Eigen::Index num_rows = tiler.num_rows();
+    const Tlabels *labels_data = labels.flat<Tlabels>().data();
+
+    Tensor lse, losses, lse_weights;
+    for (Tensor *temp : {&lse, &losses, &lse_weights}) {
+      OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::value,
+                                                     TensorShape({num_rows}),
+                                                     temp));
+    }
+    LiftedStructSweeper<T, Tlabels> sweeper(context, tiler, labels_data,
+                                            margin);
+    sweeper.NegativeLogSumExp(lse.flat<T>().data());
+    sweeper.PositiveTerms(lse.flat<T>().data(), losses.flat<T>().data(),
+                          lse_weights.flat<T>().data());
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, embeddings.shape(), &output));
+    Eigen::Map<RowMajorMatrix<T>> embeddings_grads(output->flat<T>().data(),
+                                                   num_rows, tiler.depth());
+    const T scale =
+        grad.scalar<T>()() /
+        static_cast<T>(NumPositivePairs(labels_data, num_rows));
+    sweeper.Gradient(lse.flat<T>().data(), lse_weights.flat<T>().data(), scale,
+                     &embeddings_grads);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T, Tlabels)                                        \
+  REGISTER_KERNEL_BUILDER(Name("Addons>LiftedStructLoss")                      \
+                              .Device(DEVICE_CPU)                              \
+                              .TypeConstraint<T>("T")                          \
+                              .TypeConstraint<Tlabels>("Tlabels"),             \
+                          LiftedStructLossOp<T, Tlabels>);                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>LiftedStructLossGrad")                  \
+                              .Device(DEVICE_CPU)                              \
+                              .TypeConstraint<T>("T")                          \
+                              .TypeConstraint<Tlabels>("Tlabels"),             \
+                          LiftedStructLossGradOp<T, Tlabels>);
+
+REGISTER_CPU_KERNEL(float, int32);
+REGISTER_CPU_KERNEL(float, int64);
+REGISTER_CPU_KERNEL(double, int32);
+REGISTER_CPU_KERNEL(double, int64);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,203 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow_addons/custom_ops/losses/cc/kernels/pairwise_distance_op.h"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// The per-row statistics of `npairs.npairs_loss`: the log-sum-exp of the
+// logits of a row, and the mean logit over the columns sharing its label.
+template <typename T>
+struct NpairsRow {
+  T lse;
+  T positive_mean;
+  int64 num_positives;
+};
+
+// Reduces row i of `logits` in column tiles, rescaling the running sum of
+// exponentials whenever a tile has a larger maximum, so the soft labels
+// `y_true / reduce_sum(y_true, 1)` are never built.
+template <typename T, typename Tlabels>
+NpairsRow<T> ReduceNpairsRow(const T *logits, const Tlabels *labels,
+                             Eigen::Index num_cols, Eigen::Index i) {
+  const T *row = logits + i * num_cols;
+  T maximum = -std::numeric_limits<T>::infinity();
+  T sum = T(0);
+  T positive_sum = T(0);
+  int64 num_positives = 0;
+  for (Eigen::Index begin = 0; begin < num_cols;
+       begin += kPairwiseDistanceTileSize) {
+    const Eigen::Index end =
+        std::min(begin + kPairwiseDistanceTileSize, num_cols);
+    const T tile_maximum = *std::max_element(row + begin, row + end);
+    if (tile_maximum > maximum) {
+      sum *= std::exp(maximum - tile_maximum);
+      maximum = tile_maximum;
+    }
+    for (Eigen::Index j = begin; j < end; ++j) {
+      sum += std::exp(row[j] - maximum);
+      if (labels[j] == labels[i]) {
+        positive_sum += row[j];
+        ++num_positives;
+      }
+    }
+  }
+  NpairsRow<T> result;
+  result.lse = maximum + std::log(sum);
+  result.positive_mean = positive_sum / static_cast<T>(num_positives);
+  result.num_positives = num_positives;
+  return result;
+}
+
+Status ValidateNpairsInputs(OpKernelContext *context) {
+  const Tensor &labels = context->input(0);
+  const Tensor &logits = context->input(1);
+  if (!TensorShapeUtils::IsVector(labels.shape())) {
+    return errors::InvalidArgument("labels shape should be 1-D.");
+  }
+  const int64 batch_size = labels.dim_size(0);
+  if (logits.shape() != TensorShape({batch_size, batch_size})) {
+    return errors::InvalidArgument("logits shape should be [", batch_size,
+                                   ", ", batch_size, "], got ",
+                                   logits.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+template <typename T>
+Eigen::TensorOpCost NpairsRowCost(Eigen::Index num_cols) {
+  return Eigen::TensorOpCost(
+      num_cols * sizeof(T), num_cols * sizeof(T),
+      num_cols * (Eigen::TensorOpCost::AddCost<T>() +
+                  Eigen::TensorOpCost::MulCost<T>() +
+                  Eigen::internal::functor_traits<
+                      Eigen::internal::scalar_exp_op<T>>::Cost));
+}
+
+}  // namespace
+
+template <typename T, typename Tlabels>
+class NpairsLossOp : public OpKernel {
+ public:
+  explicit NpairsLossOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    OP_REQUIRES_OK(context, ValidateNpairsInputs(context));
+    const Tlabels *labels = context->input(0).flat<Tlabels>().data();
+    const T *logits = context->input(1).flat<T>().data();
+    const Eigen::Index batch_size = context->input(0).dim_size(0);
+
+    Tensor row_losses;
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::value,
+                                                   TensorShape({batch_size}),
+                                                   &row_losses));
+    auto losses = row_losses.vec<T>();
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      for (Eigen::Index i = start; i < end; ++i) {
+        const NpairsRow<T> row = ReduceNpairsRow(logits, labels, batch_size, i);
+        losses(i) = row.lse - row.positive_mean;
+      }
+    };
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(batch_size, NpairsRowCost<T>(batch_size),
+                       std::move(work));
+
+    T total = T(0);
+    for (Eigen::Index i = 0; i < batch_size; ++i) {
+      total += losses(i);
+    }
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({}), &output));
+    output->scalar<T>()() = total / static_cast<T>(batch_size);
+  }
+};
+
+template <typename T, typename Tlabels>
+class NpairsLossGradOp : public OpKernel {
+ public:
+  explicit NpairsLossGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    OP_REQUIRES_OK(context, ValidateNpairsInputs(context));
+    const Tensor &grad = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(grad.shape()),
+                errors::InvalidArgument("grad should be a scalar."));
+    const Tlabels *labels = context->input(0).flat<Tlabels>().data();
+    const T *logits = context->input(1).flat<T>().data();
+    const Eigen::Index batch_size = context->input(0).dim_size(0);
+    const T scale = grad.scalar<T>()() / static_cast<T>(batch_size);
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, context->input(1).shape(), &output));
+    T *logits_grads = output->flat<T>().data();
+
+    // softmax(logits) - y_true, written straight into the output row.
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      for (Eigen::Index i = start; i < end; ++i) {
+        const NpairsRow<T> row = ReduceNpairsRow(logits, labels, batch_size, i);
+        const T positive_weight = T(1) / static_cast<T>(row.num_positives);
+        const T *logits_row = logits + i * batch_size;
+        T *grads_row = logits_grads + i * batch_size;
+        for (Eigen::Index j = 0; j < batch_size; ++j) {
+          T value = std::exp(logits_row[j] - row.lse);
+          if (labels[j] == labels[i]) {
+            value -= positive_weight;
+          }
+          grads_row[j] = scale * value;
+        }
+      }
+    };
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(batch_size, NpairsRowCost<T>(batch_size) * 2.0,
+                       std::move(work));
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T, Tlabels)                            \
+  REGISTER_KERNEL_BUILDER(Name("Addons>NpairsLoss")                \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T")              \
+                              .TypeConstraint<Tlabels>("Tlabels"), \
+                          NpairsLossOp<T, Tlabels>);               \
+  REGISTER_KERNEL_BUILDER(Name("Addons>NpairsLossGrad")            \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T")              \
+                              .TypeConstraint<Tlabels>("Tlabels"), \
+                          NpairsLossGradOp<T, Tlabels>);
+
+REGISTER_CPU_KERNEL(float, int32);
+REGISTER_CPU_KERNEL(float, int64);
+REGISTER_CPU_KERNEL(double, int32);
+REGISTER_CPU_KERNEL(double, int64);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,311 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow_addons/custom_ops/losses/cc/kernels/pairwise_distance_op.h"
+
+#include <limits>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+Status GetDistanceMetric(OpKernelConstruction *context,
+                         DistanceMetric *metric) {
+  std::string metric_string;
+  TF_RETURN_IF_ERROR(context->GetAttr("metric", &metric_string));
+  if (!DistanceMetricFromString(metric_string, metric)) {
+    return errors::InvalidArgument(
+        "Only support 'L2', 'squared-L2' and 'angular' metric.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename T>
+class PairwiseDistanceOp : public OpKernel {
+ public:
+  explicit PairwiseDistanceOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetDistanceMetric(context, &metric_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &features = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(features.shape()),
+                errors::InvalidArgument("features shape should be 2-D."));
+
+    PairwiseDistanceTiler<T> tiler(metric_);
+    OP_REQUIRES_OK(context, tiler.Init(context, features));
+    const Eigen::Index num_rows = tiler.num_rows();
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({num_rows, num_rows}), &output));
+    auto distances = output->matrix<T>();
+
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      RowMajorMatrix<T> gram, tile;
+      for (Eigen::Index row_tile = start; row_tile < end; ++row_tile) {
+        const Eigen::Index row_begin = row_tile * kPairwiseDistanceTileSize;
+        const Eigen::Index rows =
+            std::min(kPairwiseDistanceTileSize, num_rows - row_begin);
+        for (Eigen::Index col_begin = 0; col_begin < num_rows;
+             col_begin += kPairwiseDistanceTileSize) {
+          const Eigen::Index cols =
+              std::min(kPairwiseDistanceTileSize, num_rows - col_begin);
+          tiler.ComputeTile(row_begin, rows, col_begin, cols, &gram, &tile);
+          for (Eigen::Index r = 0; r < rows; ++r) {
+            std::copy_n(&tile(r, 0), cols,
+                        &distances(row_begin + r, col_begin));
+          }
+        }
+      }
+    };
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(tiler.num_tiles(),
+                       TileRowCost<T>(num_rows, tiler.depth()),
+                       std::move(work));
+  }
+
+ private:
+  DistanceMetric metric_;
+};
+
+template <typename T>
+class PairwiseDistanceGradOp : public OpKernel {
+ public:
+  explicit PairwiseDistanceGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetDistanceMetric(context, &metric_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &features = context->input(0);
+    const Tensor &grads_tensor = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(features.shape()),
+                errors::InvalidArgument("features shape should be 2-D."));
+    const int64 num_rows = features.dim_size(0);
+    OP_REQUIRES(context,
+                grads_tensor.shape() == TensorShape({num_rows, num_rows}),
+                errors::InvalidArgument("grads shape should be [",
+                                        num_rows, ", ", num_rows, "], got ",
+                                        grads_tensor.shape().DebugString()));
+
+    PairwiseDistanceTiler<T> tiler(metric_);
+    OP_REQUIRES_OK(context, tiler.Init(context, features));
+    const Eigen::Index depth = tiler.depth();
+    const auto grads = grads_tensor.matrix<T>();
+    const auto operands = tiler.operands();
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, features.shape(), &output));
+    typename PairwiseDistanceTiler<T>::ConstMatrixMap inputs(
+        features.flat<T>().data(), num_rows, depth);
+    Eigen::Map<RowMajorMatrix<T>> features_grads(output->flat<T>().data(),
+                                                 num_rows, depth);
+
+    // Every distance is a function of the dot product of its two operands, so
+    // the gradient of a tile row is `h * operands[cols]` for a tile `h` of
+    // per-pair weights, accumulated while the tile is still in cache.
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      RowMajorMatrix<T> gram, tile, weights, accumulated;
+      Eigen::Matrix<T, Eigen::Dynamic, 1> row_sums;
+      for (Eigen::Index row_tile = start; row_tile < end; ++row_tile) {
+        const Eigen::Index row_begin = row_tile * kPairwiseDistanceTileSize;
+        const Eigen::Index rows =
+            std::min(kPairwiseDistanceTileSize, num_rows - row_begin);
+        accumulated.setZero(rows, depth);
+        row_sums.setZero(rows);
+        for (Eigen::Index col_begin = 0; col_begin < num_rows;
+             col_begin += kPairwiseDistanceTileSize) {
+          const Eigen::Index cols =
+              std::min(kPairwiseDistanceTileSize, num_rows - col_begin);
+          tiler.ComputeTile(row_begin, rows, col_begin, cols, &gram, &tile);
+          weights.resize(rows, cols);
+          for (Eigen::Index r = 0; r < rows; ++r) {
+            const Eigen::Index i = row_begin + r;
+            for (Eigen::Index c = 0; c < cols; ++c) {
+              const Eigen::Index j = col_begin + c;
+              const T grad = grads(i, j) + grads(j, i);
+              weights(r, c) = PairWeight(grad, gram(r, c), tile(r, c));
+            }
+          }
+          accumulated.noalias() +=
+              weights * operands.middleRows(col_begin, cols);
+          row_sums += weights.rowwise().sum();
+        }
+
+        for (Eigen::Index r = 0; r < rows; ++r) {
+          const Eigen::Index i = row_begin + r;
+          if (metric_ == DistanceMetric::kAngular) {
+            // Backpropagate through `tf.math.l2_normalize`.
+            const T scale = tiler.inverse_norm(i);
+            if (tiler.squared_norm(i) > static_cast<T>(tiler.kNormEpsilon)) {
+              const T projection = operands.row(i).dot(accumulated.row(r));
+              features_grads.row(i) =
+                  scale * (accumulated.row(r) - projection * operands.row(i));
+            } else {
+              features_grads.row(i) = scale * accumulated.row(r);
+            }
+          } else {
+            features_grads.row(i) =
+                T(2) * (row_sums(r) * inputs.row(i) - accumulated.row(r));
+          }
+        }
+      }
+    };
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(tiler.num_tiles(),
+                       TileRowCost<T>(num_rows, depth) * 3.0, std::move(work));
+  }
+
+ private:
+  // Returns the derivative of the loss with respect to the dot product of a
+  // pair (negated for the L2 metrics, where it enters as `-2 * dot`), given
+  // the symmetrized incoming gradient of that pair.
+  T PairWeight(T grad, T dot, T distance) const {
+    switch (metric_) {
+      case DistanceMetric::kAngular:
+        // d = max(1 - dot, 0)
+        return T(1) - dot >= T(0) ? -grad : T(0);
+      case DistanceMetric::kSquaredL2:
+        return distance > T(0) ? grad : T(0);
+      case DistanceMetric::kL2:
+        return distance > T(0) ? grad / (T(2) * distance) : T(0);
+    }
+    return T(0);
+  }
+
+  DistanceMetric metric_;
+};
+
+template <typename T>
+class PairwiseDistanceReduceOp : public OpKernel {
+ public:
+  explicit PairwiseDistanceReduceOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetDistanceMetric(context, &metric_));
+    std::string reduction;
+    OP_REQUIRES_OK(context, context->GetAttr("reduction", &reduction));
+    OP_REQUIRES(context, reduction == "min" || reduction == "max",
+                errors::InvalidArgument("Only support 'min' and 'max' "
+                                        "reduction."));
+    maximum_ = reduction == "max";
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &features = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(features.shape()),
+                errors::InvalidArgument("features shape should be 2-D."));
+
+    PairwiseDistanceTiler<T> tiler(metric_);
+    OP_REQUIRES_OK(context, tiler.Init(context, features));
+    const Eigen::Index num_rows = tiler.num_rows();
+
+    Tensor *values_tensor = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({num_rows}), &values_tensor));
+    Tensor *indices_tensor = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, TensorShape({num_rows}), &indices_tensor));
+    auto values = values_tensor->vec<T>();
+    auto indices = indices_tensor->vec<int32>();
+    const bool maximum = maximum_;
+
+    // Only one tile per thread is ever alive: the reduction is folded into
+    // the tile epilogue instead of reading back a [batch, batch] matrix.
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      RowMajorMatrix<T> gram, tile;
+      for (Eigen::Index row_tile = start; row_tile < end; ++row_tile) {
+        const Eigen::Index row_begin = row_tile * kPairwiseDistanceTileSize;
+        const Eigen::Index rows =
+            std::min(kPairwiseDistanceTileSize, num_rows - row_begin);
+        for (Eigen::Index r = 0; r < rows; ++r) {
+          values(row_begin + r) = maximum ? -std::numeric_limits<T>::infinity()
+                                          : std::numeric_limits<T>::infinity();
+          indices(row_begin + r) = -1;
+        }
+        for (Eigen::Index col_begin = 0; col_begin < num_rows;
+             col_begin += kPairwiseDistanceTileSize) {
+          const Eigen::Index cols =
+              std::min(kPairwiseDistanceTileSize, num_rows - col_begin);
+          tiler.ComputeTile(row_begin, rows, col_begin, cols, &gram, &tile);
+          for (Eigen::Index r = 0; r < rows; ++r) {
+            const Eigen::Index i = row_begin + r;
+            for (Eigen::Index c = 0; c < cols; ++c) {
+              const Eigen::Index j = col_begin + c;
+              const T value = tile(r, c);
+              if (j != i && (maximum ? value > values(i) : value < values(i))) {
+                values(i) = value;
+                indices(i) = static_cast<int32>(j);
+              }
+            }
+          }
+        }
+        // A single row has no other row to be reduced against.
+        for (Eigen::Index r = 0; r < rows; ++r) {
+          const Eigen::Index i = row_begin + r;
+          if (indices(i) < 0) {
+            indices(i) = static_cast<int32>(i);
+            values(i) =
+                tiler.Distance(i, i, tiler.operands().row(i).squaredNorm());
+          }
+        }
+      }
+    };
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(tiler.num_tiles(),
+                       TileRowCost<T>(num_rows, tiler.depth()),
+                       std::move(work));
+  }
+
+ private:
+  DistanceMetric metric_;
+  bool maximum_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                  \
+  REGISTER_KERNEL_BUILDER(Name("Addons>PairwiseDistance")       \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          PairwiseDistanceOp<T>);               \
+  REGISTER_KERNEL_BUILDER(Name("Addons>PairwiseDistanceGrad")   \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          PairwiseDistanceGradOp<T>);           \
+  REGISTER_KERNEL_BUILDER(Name("Addons>PairwiseDistanceReduce") \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          PairwiseDistanceReduceOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,187 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_ADDONS_LOSSES_KERNELS_PAIRWISE_DISTANCE_OP_H_
+#define TENSORFLOW_ADDONS_LOSSES_KERNELS_PAIRWISE_DISTANCE_OP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+enum class DistanceMetric {
+  kL2,
+  kSquaredL2,
+  kAngular,
+};
+
+inline bool DistanceMetricFromString(const std::string &metric_string,
+                                     DistanceMetric *metric) {
+  if (metric_string == "L2") {
+    *metric = DistanceMetric::kL2;
+  } else if (metric_string == "squared-L2") {
+    *metric = DistanceMetric::kSquaredL2;
+  } else if (metric_string == "angular") {
+    *metric = DistanceMetric::kAngular;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// The distance matrix is produced in square tiles of this size, so that the
+// operands of a tile and the tile itself stay resident in L2 cache.
+constexpr Eigen::Index kPairwiseDistanceTileSize = 128;
+
+template <typename T>
+using RowMajorMatrix =
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// Cost of producing one tile row, used to shard work over tile rows.
+template <typename T>
+Eigen::TensorOpCost TileRowCost(Eigen::Index num_rows, Eigen::Index depth) {
+  const double bytes_loaded = (num_rows + kPairwiseDistanceTileSize) * depth *
+                              sizeof(T) / kPairwiseDistanceTileSize;
+  const double bytes_stored = num_rows * sizeof(T);
+  const double compute_cycles =
+      num_rows * depth *
+      (Eigen::TensorOpCost::AddCost<T>() + Eigen::TensorOpCost::MulCost<T>());
+  return Eigen::TensorOpCost(bytes_loaded, bytes_stored, compute_cycles) *
+         static_cast<double>(kPairwiseDistanceTileSize);
+}
+
+// Computes tiles of the pairwise distance matrix of a `[batch, depth]`
+// feature matrix, matching `metric_learning.pairwise_distance` and
+// `metric_learning.angular_distance`. The dot products of a tile are a small
+// Eigen GEMM, so they run on Eigen's vectorized micro-kernel; the distance
+// epilogue is applied to the tile while it is still in cache.
+template <typename T>
+class PairwiseDistanceTiler {
+ public:
+  using ConstMatrixMap = Eigen::Map<const RowMajorMatrix<T>>;
+  using VectorMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>;
+  using ConstVectorMap = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>>;
+
+  // Same epsilon as `tf.math.l2_normalize`.
+  static constexpr double kNormEpsilon = 1e-12;
+
+  explicit PairwiseDistanceTiler(DistanceMetric metric) : metric_(metric) {}
+
+  // Computes the squared norm of every row and, for the angular metric, the
+  // l2-normalized rows the tiles are computed from.
+  Status Init(OpKernelContext *context, const Tensor &features) {
+    num_rows_ = features.dim_size(0);
+    depth_ = features.dim_size(1);
+    TF_RETURN_IF_ERROR(context->allocate_temp(
+        DataTypeToEnum<T>::value, TensorShape({num_rows_}), &squared_norms_));
+    const T *input = features.flat<T>().data();
+    T *squared_norms = squared_norms_.flat<T>().data();
+    for (Eigen::Index i = 0; i < num_rows_; ++i) {
+      squared_norms[i] =
+          ConstVectorMap(input + i * depth_, depth_).squaredNorm();
+    }
+
+    operands_ = input;
+    if (metric_ == DistanceMetric::kAngular) {
+      TF_RETURN_IF_ERROR(context->allocate_temp(
+          DataTypeToEnum<T>::value, TensorShape({num_rows_, depth_}),
+          &normalized_));
+      T *normalized = normalized_.flat<T>().data();
+      for (Eigen::Index i = 0; i < num_rows_; ++i) {
+        VectorMap(normalized + i * depth_, depth_) =
+            ConstVectorMap(input + i * depth_, depth_) * inverse_norm(i);
+      }
+      operands_ = normalized;
+    }
+    return Status::OK();
+  }
+
+  Eigen::Index num_rows() const { return num_rows_; }
+  Eigen::Index depth() const { return depth_; }
+  Eigen::Index num_tiles() const {
+    return (num_rows_ + kPairwiseDistanceTileSize - 1) /
+           kPairwiseDistanceTileSize;
+  }
+  DistanceMetric metric() const { return metric_; }
+
+  // The rows the dot products are taken over: the features themselves, or
+  // their l2-normalized version for the angular metric.
+  ConstMatrixMap operands() const {
+    return ConstMatrixMap(operands_, num_rows_, depth_);
+  }
+
+  T squared_norm(Eigen::Index i) const {
+    return squared_norms_.flat<T>().data()[i];
+  }
+
+  // `1 / sqrt(max(||x_i||^2, epsilon))`, the scale used to normalize row i.
+  T inverse_norm(Eigen::Index i) const {
+    return T(1) /
+           std::sqrt(std::max(squared_norm(i), static_cast<T>(kNormEpsilon)));
+  }
+
+  // Fills `gram` with the dot products and `distances` with the distances
+  // between rows [row_begin, row_begin + rows) and rows
+  // [col_begin, col_begin + cols).
+  void ComputeTile(Eigen::Index row_begin, Eigen::Index rows,
+                   Eigen::Index col_begin, Eigen::Index cols,
+                   RowMajorMatrix<T> *gram,
+                   RowMajorMatrix<T> *distances) const {
+    const ConstMatrixMap x = operands();
+    gram->resize(rows, cols);
+    gram->noalias() = x.middleRows(row_begin, rows) *
+                      x.middleRows(col_begin, cols).transpose();
+    distances->resize(rows, cols);
+    for (Eigen::Index r = 0; r < rows; ++r) {
+      const Eigen::Index i = row_begin + r;
+      for (Eigen::Index c = 0; c < cols; ++c) {
+        (*distances)(r, c) = Distance(i, col_begin + c, (*gram)(r, c));
+      }
+    }
+  }
+
+  T Distance(Eigen::Index i, Eigen::Index j, T dot) const {
+    if (metric_ == DistanceMetric::kAngular) {
+      return std::max(T(1) - dot, T(0));
+    }
+    if (i == j) {
+      return T(0);
+    }
+    const T squared =
+        std::max(squared_norm(i) + squared_norm(j) - T(2) * dot, T(0));
+    return metric_ == DistanceMetric::kL2 ? std::sqrt(squared) : squared;
+  }
+
+ private:
+  const DistanceMetric metric_;
+  Eigen::Index num_rows_ = 0;
+  Eigen::Index depth_ = 0;
+  const T *operands_ = nullptr;
+  Tensor squared_norms_;
+  Tensor normalized_;
+};
+
+}  // namespace addons
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_ADDONS_LOSSES_KERNELS_PAIRWISE_DISTANCE_OP_H_
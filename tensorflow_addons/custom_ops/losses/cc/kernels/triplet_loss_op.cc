@@ -0,0 +1,461 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow_addons/custom_ops/losses/cc/kernels/pairwise_distance_op.h"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Anchors are mined in blocks of this many rows. The distances of a block to
+// every candidate are the only per-thread state, so it is O(batch).
+constexpr Eigen::Index kAnchorBlockSize = 16;
+
+enum class TripletMining {
+  kSemihard,
+  kHard,
+};
+
+// A distance d(anchor, candidate) the loss of an anchor depends on, with the
+// derivative of that loss with respect to it.
+template <typename T>
+struct MinedPair {
+  Eigen::Index candidate;
+  T weight;
+};
+
+// Mines the triplets of `triplet.triplet_semihard_loss` and
+// `triplet.triplet_hard_loss` one anchor row at a time, with the same
+// fallbacks as `_masked_minimum` and `_masked_maximum` when an anchor has no
+// negative or no positive.
+template <typename T, typename Tlabels>
+class TripletMiner {
+ public:
+  TripletMiner(const PairwiseDistanceTiler<T> &tiler, const Tlabels *labels,
+               T margin, TripletMining mining, bool soft)
+      : tiler_(tiler),
+        labels_(labels),
+        margin_(margin),
+        mining_(mining),
+        soft_(soft) {}
+
+  // Computes the distances of anchors [begin, begin + rows) to all rows.
+  void LoadAnchorBlock(Eigen::Index begin, Eigen::Index rows) {
+    block_begin_ = begin;
+    tiler_.ComputeTile(begin, rows, 0, tiler_.num_rows(), &gram_, &distances_);
+  }
+
+  // Dot product of the operands of anchor row `r` of the block and `j`.
+  T gram(Eigen::Index r, Eigen::Index j) const { return gram_(r, j); }
+  T distance(Eigen::Index r, Eigen::Index j) const { return distances_(r, j); }
+
+  // Returns the loss of anchor row `r` of the block (before normalization)
+  // and appends the pairs it depends on to `pairs`.
+  T MineAnchor(Eigen::Index r, std::vector<MinedPair<T>> *pairs) {
+    return mining_ == TripletMining::kSemihard ? MineSemihard(r, pairs)
+                                               : MineHard(r, pairs);
+  }
+
+ private:
+  T MineSemihard(Eigen::Index r, std::vector<MinedPair<T>> *pairs) {
+    const Eigen::Index num_rows = tiler_.num_rows();
+    const Eigen::Index anchor = block_begin_ + r;
+    const Tlabels label = labels_[anchor];
+
+    negatives_.clear();
+    Eigen::Index closest = anchor;
+    for (Eigen::Index k = 0; k < num_rows; ++k) {
+      if (distances_(r, k) < distances_(r, closest)) {
+        closest = k;
+      }
+      if (labels_[k] != label) {
+        negatives_.emplace_back(distances_(r, k), k);
+      }
+    }
+    std::sort(negatives_.begin(), negatives_.end());
+    // The largest negative distance is used when no negative is farther than
+    // the positive; the smallest distance overall if there is no negative.
+    const Eigen::Index inside =
+        negatives_.empty() ? closest : negatives_.back().second;
+
+    T loss = T(0);
+    for (Eigen::Index p = 0; p < num_rows; ++p) {
+      if (p == anchor || labels_[p] != label) {
+        continue;
+      }
+      const T positive_distance = distances_(r, p);
+      // The smallest negative distance larger than the positive distance.
+      const auto outside = std::upper_bound(
+          negatives_.begin(), negatives_.end(),
+          std::make_pair(positive_distance,
+                         std::numeric_limits<Eigen::Index>::max()));
+      const Eigen::Index negative =
+          outside == negatives_.end() ? inside : outside->second;
+      const T triplet_loss =
+          margin_ + positive_distance - distances_(r, negative);
+      if (triplet_loss >= T(0)) {
+        loss += triplet_loss;
+        pairs->push_back({p, T(1)});
+        pairs->push_back({negative, T(-1)});
+      }
+    }
+    return loss;
+  }
+
+  T MineHard(Eigen::Index r, std::vector<MinedPair<T>> *pairs) {
+    const Eigen::Index num_rows = tiler_.num_rows();
+    const Eigen::Index anchor = block_begin_ + r;
+    const Tlabels label = labels_[anchor];
+
+    Eigen::Index closest = anchor, farthest = anchor;
+    Eigen::Index positive = -1, negative = -1;
+    for (Eigen::Index k = 0; k < num_rows; ++k) {
+      const T distance = distances_(r, k);
+      if (distance < distances_(r, closest)) closest = k;
+      if (distance > distances_(r, farthest)) farthest = k;
+      if (labels_[k] != label) {
+        if (negative < 0 || distance < distances_(r, negative)) negative = k;
+      } else if (k != anchor) {
+        if (positive < 0 || distance > distances_(r, positive)) positive = k;
+      }
+    }
+    if (positive < 0) positive = closest;
+    if (negative < 0) negative = farthest;
+
+    const T difference = distances_(r, positive) - distances_(r, negative);
+    T loss, derivative;
+    if (soft_) {
+      loss = std::log1p(std::exp(difference));
+      derivative = T(1) / (T(1) + std::exp(-difference));
+    } else {
+      loss = std::max(difference + margin_, T(0));
+      derivative = difference + margin_ >= T(0) ? T(1) : T(0);
+    }
+    if (derivative != T(0)) {
+      pairs->push_back({positive, derivative});
+      pairs->push_back({negative, -derivative});
+    }
+    return loss;
+  }
+
+  const PairwiseDistanceTiler<T> &tiler_;
+  const Tlabels *labels_;
+  const T margin_;
+  const TripletMining mining_;
+  const bool soft_;
+
+  Eigen::Index block_begin_ = 0;
+  RowMajorMatrix<T> gram_;
+  RowMajorMatrix<T> distances_;
+  std::vector<std::pair<T, Eigen::Index>> negatives_;
+};
+
+// Returns the number of (anchor, positive) pairs of the semi-hard loss, or
+// the number of anchors of the hard loss.
+template <typename Tlabels>
+int64 TripletNormalizer(const Tlabels *labels, int64 num_rows,
+                        TripletMining mining) {
+  if (mining == TripletMining::kHard) {
+    return num_rows;
+  }
+  std::unordered_map<Tlabels, int64> counts;
+  for (int64 i = 0; i < num_rows; ++i) {
+    ++counts[labels[i]];
+  }
+  int64 num_positives = 0;
+  for (const auto &count : counts) {
+    num_positives += count.second * (count.second - 1);
+  }
+  return num_positives;
+}
+
+Eigen::Index NumAnchorBlocks(Eigen::Index num_rows) {
+  return (num_rows + kAnchorBlockSize - 1) / kAnchorBlockSize;
+}
+
+}  // namespace
+
+template <typename T, typename Tlabels>
+class TripletLossOpBase : public OpKernel {
+ public:
+  explicit TripletLossOpBase(OpKernelConstruction *context)
+      : OpKernel(context) {
+    std::string metric_string, mining_string;
+    OP_REQUIRES_OK(context, context->GetAttr("metric", &metric_string));
+    OP_REQUIRES(context, DistanceMetricFromString(metric_string, &metric_),
+                errors::InvalidArgument(
+                    "Only support 'L2', 'squared-L2' and 'angular' metric."));
+    OP_REQUIRES_OK(context, context->GetAttr("mining", &mining_string));
+    if (mining_string == "semihard") {
+      mining_ = TripletMining::kSemihard;
+    } else if (mining_string == "hard") {
+      mining_ = TripletMining::kHard;
+    } else {
+      OP_REQUIRES(context, false,
+                  errors::InvalidArgument(
+                      "Only support 'semihard' and 'hard' mining."));
+    }
+    OP_REQUIRES_OK(context, context->GetAttr("soft", &soft_));
+  }
+
+ protected:
+  Status ValidateInputs(OpKernelContext *context) {
+    const Tensor &labels = context->input(0);
+    const Tensor &embeddings = context->input(1);
+    const Tensor &margin = context->input(2);
+    if (!TensorShapeUtils::IsVector(labels.shape())) {
+      return errors::InvalidArgument("labels shape should be 1-D.");
+    }
+    if (!TensorShapeUtils::IsMatrix(embeddings.shape())) {
+      return errors::InvalidArgument("embeddings shape should be 2-D.");
+    }
+    if (labels.dim_size(0) != embeddings.dim_size(0)) {
+      return errors::InvalidArgument(
+          "labels and embeddings should have the same batch size.");
+    }
+    if (!TensorShapeUtils::IsScalar(margin.shape())) {
+      return errors::InvalidArgument("margin should be a scalar.");
+    }
+    return Status::OK();
+  }
+
+  DistanceMetric metric_;
+  TripletMining mining_;
+  bool soft_;
+};
+
+template <typename T, typename Tlabels>
+class TripletLossOp : public TripletLossOpBase<T, Tlabels> {
+ public:
+  explicit TripletLossOp(OpKernelConstruction *context)
+      : TripletLossOpBase<T, Tlabels>(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    OP_REQUIRES_OK(context, this->ValidateInputs(context));
+    const Tensor &labels = context->input(0);
+    const Tensor &embeddings = context->input(1);
+    const T margin = context->input(2).scalar<T>()();
+
+    PairwiseDistanceTiler<T> tiler(this->metric_);
+    OP_REQUIRES_OK(context, tiler.Init(context, embeddings));
+    const Eigen::Index num_rows = tiler.num_rows();
+    const Tlabels *labels_data = labels.flat<Tlabels>().data();
+
+    Tensor anchor_losses;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({num_rows}),
+                                          &anchor_losses));
+    auto losses = anchor_losses.vec<T>();
+
+    const TripletMining mining = this->mining_;
+    const bool soft = this->soft_;
+    const auto work = [&](Eigen::Index start, Eigen::Index end) {
+      TripletMiner<T, Tlabels> miner(tiler, labels_data, margin, mining, soft);
+      std::vector<MinedPair<T>> pairs;
+      for (Eigen::Index block = start; block < end; ++block) {
+        const Eigen::Index begin = block * kAnchorBlockSize;
+        const Eigen::Index rows = std::min(kAnchorBlockSize, num_rows - begin);
+        miner.LoadAnchorBlock(begin, rows);
+        for (Eigen::Index r = 0; r < rows; ++r) {
+          pairs.clear();
+          losses(begin + r) = miner.MineAnchor(r, &pairs);
+        }
+      }
+    };
+
+    // The distances of an anchor block are priced like a tile row of the
+    // pairwise distance kernels, plus sorting the negatives of every anchor.
+    const double mining_cycles = kAnchorBlockSize * num_rows *
+                                 std::log2(num_rows + 1) *
+                                 Eigen::TensorOpCost::AddCost<T>();
+    const Eigen::TensorOpCost cost =
+        TileRowCost<T>(num_rows, tiler.depth()) *
+            (static_cast<double>(kAnchorBlockSize) /
+             kPairwiseDistanceTileSize) +
+        Eigen::TensorOpCost(0, 0, mining_cycles);
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(NumAnchorBlocks(num_rows), cost, std::move(work));
+
+    T total = T(0);
+    for (Eigen::Index i = 0; i < num_rows; ++i) {
+      total += losses(i);
+    }
+    const int64 normalizer = TripletNormalizer(labels_data, num_rows, mining);
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({}), &output));
+    output->scalar<T>()() = total / static_cast<T>(normalizer);
+  }
+};
+
+template <typename T, typename Tlabels>
+class TripletLossGradOp : public TripletLossOpBase<T, Tlabels> {
+ public:
+  explicit TripletLossGradOp(OpKernelConstruction *context)
+      : TripletLossOpBase<T, Tlabels>(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    OP_REQUIRES_OK(context, this->ValidateInputs(context));
+    const Tensor &labels = context->input(0);
+    const Tensor &embeddings = context->input(1);
+    const T margin = context->input(2).scalar<T>()();
+    const Tensor &grad = context->input(3);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(grad.shape()),
+                errors::InvalidArgument("grad should be a scalar."));
+
+    PairwiseDistanceTiler<T> tiler(this->metric_);
+    OP_REQUIRES_OK(context, tiler.Init(context, embeddings));
+    const Eigen::Index num_rows = tiler.num_rows();
+    const Eigen::Index depth = tiler.depth();
+    const Tlabels *labels_data = labels.flat<Tlabels>().data();
+    const TripletMining mining = this->mining_;
+    const DistanceMetric metric = this->metric_;
+    const bool soft = this->soft_;
+    const T scale =
+        grad.scalar<T>()() /
+        static_cast<T>(TripletNormalizer(labels_data, num_rows, mining));
+
+    // A mined pair contributes to the gradient of both of its rows, so each
+    // shard accumulates into its own partial gradient; they are summed below.
+    auto *thread_pool =
+        context->device()->tensorflow_cpu_worker_threads()->workers;
+    const Eigen::Index num_blocks = NumAnchorBlocks(num_rows);
+    const Eigen::Index num_shards = std::max<Eigen::Index>(
+        1, std::min<Eigen::Index>(thread_pool->NumThreads(), num_blocks));
+    Tensor partials_tensor;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({num_shards, num_rows, depth}),
+                                &partials_tensor));
+    T *partials = partials_tensor.flat<T>().data();
+    const auto operands = tiler.operands();
+
+    const auto work = [&](int64 start, int64 end) {
+      TripletMiner<T, Tlabels> miner(tiler, labels_data, margin, mining, soft);
+      std::vector<MinedPair<T>> pairs;
+      for (int64 shard = start; shard < end; ++shard) {
+        Eigen::Map<RowMajorMatrix<T>> partial(
+            partials + shard * num_rows * depth, num_rows, depth);
+        partial.setZero();
+        const Eigen::Index first_block = num_blocks * shard / num_shards;
+        const Eigen::Index last_block = num_blocks * (shard + 1) / num_shards;
+        for (Eigen::Index block = first_block; block < last_block; ++block) {
+          const Eigen::Index begin = block * kAnchorBlockSize;
+          const Eigen::Index rows =
+              std::min(kAnchorBlockSize, num_rows - begin);
+          miner.LoadAnchorBlock(begin, rows);
+          for (Eigen::Index r = 0; r < rows; ++r) {
+            const Eigen::Index a = begin + r;
+            pairs.clear();
+            miner.MineAnchor(r, &pairs);
+            for (const MinedPair<T> &pair : pairs) {
+              const Eigen::Index b = pair.candidate;
+              const T weight = pair.weight * scale;
+              if (metric == DistanceMetric::kAngular) {
+                // d = max(1 - n_a . n_b, 0), taken w.r.t. the normalized rows.
+                if (T(1) - miner.gram(r, b) >= T(0)) {
+                  partial.row(a) -= weight * operands.row(b);
+                  partial.row(b) -= weight * operands.row(a);
+                }
+                continue;
+              }
+              const T distance = miner.distance(r, b);
+              if (!(distance > T(0))) {
+                continue;
+              }
+              const T coefficient = metric == DistanceMetric::kL2
+                                        ? weight / distance
+                                        : T(2) * weight;
+              partial.row(a) +=
+                  coefficient * (operands.row(a) - operands.row(b));
+              partial.row(b) -=
+                  coefficient * (operands.row(a) - operands.row(b));
+            }
+          }
+        }
+      }
+    };
+    const int64 cost_per_shard = std::numeric_limits<int32>::max();
+    thread_pool->ParallelFor(num_shards, cost_per_shard, work);
+
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, embeddings.shape(), &output));
+    Eigen::Map<RowMajorMatrix<T>> embeddings_grads(output->flat<T>().data(),
+                                                   num_rows, depth);
+    const auto reduce = [&](Eigen::Index start, Eigen::Index end) {
+      for (Eigen::Index i = start; i < end; ++i) {
+        embeddings_grads.row(i).setZero();
+        for (Eigen::Index shard = 0; shard < num_shards; ++shard) {
+          embeddings_grads.row(i) +=
+              Eigen::Map<const Eigen::Matrix<T, 1, Eigen::Dynamic>>(
+                  partials + (shard * num_rows + i) * depth, depth);
+        }
+        if (metric == DistanceMetric::kAngular) {
+          // Backpropagate through `tf.math.l2_normalize`.
+          const T inverse_norm = tiler.inverse_norm(i);
+          if (tiler.squared_norm(i) >
+              static_cast<T>(PairwiseDistanceTiler<T>::kNormEpsilon)) {
+            const T projection = operands.row(i).dot(embeddings_grads.row(i));
+            embeddings_grads.row(i) -= projection * operands.row(i);
+          }
+          embeddings_grads.row(i) *= inverse_norm;
+        }
+      }
+    };
+    const Eigen::TensorOpCost reduce_cost(
+        num_shards * depth * sizeof(T), depth * sizeof(T),
+        num_shards * depth * Eigen::TensorOpCost::AddCost<T>());
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(num_rows, reduce_cost, std::move(reduce));
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T, Tlabels)                             \
+  REGISTER_KERNEL_BUILDER(Name("Addons>TripletLoss")                \
+                              .Device(DEVICE_CPU)                   \
+                              .TypeConstraint<T>("T")               \
+                              .TypeConstraint<Tlabels>("Tlabels"),  \
+                          TripletLossOp<T, Tlabels>);               \
+  REGISTER_KERNEL_BUILDER(Name("Addons>TripletLossGrad")            \
+                              .Device(DEVICE_CPU)                   \
+                              .TypeConstraint<T>("T")               \
+                              .TypeConstraint<Tlabels>("Tlabels"),  \
+                          TripletLossGradOp<T, Tlabels>);
+
+REGISTER_CPU_KERNEL(float, int32);
+REGISTER_CPU_KERNEL(float, int64);
+REGISTER_CPU_KERNEL(double, int32);
+REGISTER_CPU_KERNEL(double, int64);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,71 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::DimensionHandle;
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>BoxIoULoss")
+    .Input("boxes1: T")
+    .Input("boxes2: T")
+    .Output("loss: T")
+    .Attr("T: {float, double}")
+    .Attr("mode: {'iou', 'giou', 'diou', 'ciou'} = 'giou'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle boxes, pairs;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &boxes));
+      TF_RETURN_IF_ERROR(c->Merge(boxes, c->input(1), &boxes));
+      DimensionHandle coordinates;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(boxes, -1), 4, &coordinates));
+      TF_RETURN_IF_ERROR(c->Subshape(boxes, 0, -1, &pairs));
+      c->set_output(0, pairs);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes `1 - metric` of pairs of boxes.
+
+The boxes are encoded as `[y_min, x_min, y_max, x_max]`. The metric is the
+IoU, the GIoU, the DIoU, which subtracts the squared distance of the box
+centers divided by the squared diagonal of the enclosing box from the IoU, or
+the CIoU, which also subtracts `alpha * v` with the aspect ratio consistency
+`v = 4 / pi^2 * (atan(w2 / h2) - atan(w1 / h1))^2` and
+`alpha = v / (1 - iou + v)`. Ratios with a zero denominator are zero.
+)doc");
+
+REGISTER_OP("Addons>BoxIoULossGrad")
+    .Input("boxes1: T")
+    .Input("boxes2: T")
+    .Input("grad: T")
+    .Output("boxes1_grad: T")
+    .Output("boxes2_grad: T")
+    .Attr("T: {float, double}")
+    .Attr("mode: {'iou', 'giou', 'diou', 'ciou'} = 'giou'")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(1));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of BoxIoULoss with respect to both boxes, with a constant `alpha`.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,206 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::DimensionHandle;
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>PairwiseDistance")
+    .Input("features: T")
+    .Output("distances: T")
+    .Attr("T: {float, double}")
+    .Attr("metric: {'L2', 'squared-L2', 'angular'} = 'L2'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle features;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &features));
+      DimensionHandle batch_size = c->Dim(features, 0);
+      c->set_output(0, c->Matrix(batch_size, batch_size));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the pairwise distance matrix of the rows of `features`.
+
+The matrix is computed in cache-sized tiles, so no `[batch, batch]`
+temporary other than the output itself is created.
+)doc");
+
+REGISTER_OP("Addons>PairwiseDistanceGrad")
+    .Input("features: T")
+    .Input("grads: T")
+    .Output("features_grads: T")
+    .Attr("T: {float, double}")
+    .Attr("metric: {'L2', 'squared-L2', 'angular'} = 'L2'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle features, grads;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &features));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &grads));
+      c->set_output(0, features);
+      return Status::OK();
+    });
+
+REGISTER_OP("Addons>PairwiseDistanceReduce")
+    .Input("features: T")
+    .Output("values: T")
+    .Output("indices: int32")
+    .Attr("T: {float, double}")
+    .Attr("metric: {'L2', 'squared-L2', 'angular'} = 'L2'")
+    .Attr("reduction: {'min', 'max'} = 'min'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle features;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &features));
+      DimensionHandle batch_size = c->Dim(features, 0);
+      c->set_output(0, c->Vector(batch_size));
+      c->set_output(1, c->Vector(batch_size));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Reduces every row of the pairwise distance matrix, excluding the diagonal,
+without materializing the matrix.
+
+values: The minimum or maximum distance of every row.
+indices: The column the reduced distance of every row was found at.
+)doc");
+
+REGISTER_OP("Addons>TripletLoss")
+    .Input("labels: Tlabels")
+    .Input("embeddings: T")
+    .Input("margin: T")
+    .Output("loss: T")
+    .Attr("T: {float, double}")
+    .Attr("Tlabels: {int32, int64}")
+    .Attr("metric: {'L2', 'squared-L2', 'angular'} = 'L2'")
+    .Attr("mining: {'semihard', 'hard'} = 'semihard'")
+    .Attr("soft: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle labels, embeddings, margin;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &labels));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &embeddings));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &margin));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(labels, 0), c->Dim(embeddings, 0), &unused));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the triplet loss with semi-hard or hard negative mining.
+
+Anchors are mined one row at a time against all candidates, so no more than
+O(batch) distances are kept per thread.
+)doc");
+
+REGISTER_OP("Addons>TripletLossGrad")
+    .Input("labels: Tlabels")
+    .Input("embeddings: T")
+    .Input("margin: T")
+    .Input("grad: T")
+    .Output("embeddings_grads: T")
+    .Attr("T: {float, double}")
+    .Attr("Tlabels: {int32, int64}")
+    .Attr("metric: {'L2', 'squared-L2', 'angular'} = 'L2'")
+    .Attr("mining: {'semihard', 'hard'} = 'semihard'")
+    .Attr("soft: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle embeddings, grad;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &embeddings));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &grad));
+      c->set_output(0, embeddings);
+      return Status::OK();
+    });
+
+REGISTER_OP("Addons>LiftedStructLoss")
+    .Input("labels: Tlabels")
+    .Input("embeddings: T")
+    .Input("margin: T")
+    .Output("loss: T")
+    .Attr("T: {float, double}")
+    .Attr("Tlabels: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle labels, embeddings, margin;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &labels));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &embeddings));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &margin));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(labels, 0), c->Dim(embeddings, 0), &unused));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the lifted structured loss over the L2 distances of `embeddings`.
+
+The log-sum-exp over the negatives of every row is accumulated tile by tile
+with an online maximum, so no more than one distance tile is kept per thread.
+)doc");
+
+REGISTER_OP("Addons>LiftedStructLossGrad")
+    .Input("labels: Tlabels")
+    .Input("embeddings: T")
+    .Input("margin: T")
+    .Input("grad: T")
+    .Output("embeddings_grads: T")
+    .Attr("T: {float, double}")
+    .Attr("Tlabels: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle embeddings, grad;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &embeddings));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &grad));
+      c->set_output(0, embeddings);
+      return Status::OK();
+    });
+
+REGISTER_OP("Addons>NpairsLoss")
+    .Input("labels: Tlabels")
+    .Input("logits: T")
+    .Output("loss: T")
+    .Attr("T: {float, double}")
+    .Attr("Tlabels: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle labels, logits;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &labels));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &logits));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the npairs loss of a `[batch, batch]` similarity matrix.
+
+Every row is reduced with an online log-sum-exp, without building the
+`[batch, batch]` soft label matrix.
+)doc");
+
+REGISTER_OP("Addons>NpairsLossGrad")
+    .Input("labels: Tlabels")
+    .Input("logits: T")
+    .Input("grad: T")
+    .Output("logits_grads: T")
+    .Attr("T: {float, double}")
+    .Attr("Tlabels: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle logits, grad;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &logits));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &grad));
+      c->set_output(0, logits);
+      return Status::OK();
+    });
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,185 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Returns the number of cut points strictly below `value`, like the default
+// side of `tf.searchsorted`.
+int64 FindBin(const float *cuts, int64 num_cuts, float value) {
+  return std::lower_bound(cuts, cuts + num_cuts, value) - cuts;
+}
+
+}  // namespace
+
+// Adds a batch of (y_true, y_pred) pairs to the dense `[actual_cutpoints,
+// preds_cutpoints]` matrix of joint bin counts. The bins of all elements are
+// found in parallel with a binary search over the cut points, then added to
+// the counts in one sequential pass.
+class KendallsTauUpdateOp : public OpKernel {
+ public:
+  explicit KendallsTauUpdateOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &y_true = context->input(1);
+    const Tensor &y_pred = context->input(2);
+    const Tensor &actual_cuts = context->input(3);
+    const Tensor &preds_cuts = context->input(4);
+    OP_REQUIRES(context, y_true.NumElements() == y_pred.NumElements(),
+                errors::InvalidArgument(
+                    "y_true and y_pred should have the same size, got ",
+                    y_true.shape().DebugString(), " and ",
+                    y_pred.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(actual_cuts.shape()) &&
+                    TensorShapeUtils::IsVector(preds_cuts.shape()),
+                errors::InvalidArgument("The cut points should be vectors."));
+
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, int64>(
+        context, use_locking_, false, {0});
+    Tensor counts;
+    OP_REQUIRES_OK(context, GetInputTensorFromVariable<CPUDevice, int64>(
+                                context, 0, use_locking_, false, &counts));
+    const int64 num_actual_cuts = actual_cuts.NumElements();
+    const int64 num_preds_cuts = preds_cuts.NumElements();
+    const TensorShape counts_shape({num_actual_cuts + 1, num_preds_cuts + 1});
+    OP_REQUIRES(context,
+                counts.IsInitialized() && counts.shape() == counts_shape,
+                errors::InvalidArgument(
+                    "counts should be initialized with shape ",
+                    counts_shape.DebugString(), ", got ",
+                    counts.shape().DebugString()));
+
+    const int64 size = y_true.NumElements();
+    const float *actual = y_true.flat<float>().data();
+    const float *preds = y_pred.flat<float>().data();
+    const float *actual_cut_data = actual_cuts.flat<float>().data();
+    const float *preds_cut_data = preds_cuts.flat<float>().data();
+    std::vector<int64> cells(size);
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 k = start; k < end; ++k) {
+        cells[k] = FindBin(actual_cut_data, num_actual_cuts, actual[k]) *
+                       (num_preds_cuts + 1) +
+                   FindBin(preds_cut_data, num_preds_cuts, preds[k]);
+      }
+    };
+    const double search_cost =
+        std::log2(static_cast<double>(num_actual_cuts + 1)) +
+        std::log2(static_cast<double>(num_preds_cuts + 1));
+    const Eigen::TensorOpCost cost(2 * sizeof(float), sizeof(int64),
+                                   2 * search_cost);
+    context->eigen_device<CPUDevice>().parallelFor(size, cost, work);
+
+    int64 *count_data = counts.flat<int64>().data();
+    for (int64 k = 0; k < size; ++k) {
+      ++count_data[cells[k]];
+    }
+  }
+
+ private:
+  bool use_locking_;
+};
+
+// Computes Kendall's tau-b from a matrix of joint bin counts. A single sweep
+// over the rows keeps the column counts of the rows above, so that the pairs
+// concordant and discordant with every cell are read from a running prefix
+// sum in O(actual_cutpoints * preds_cutpoints).
+template <typename T>
+class KendallsTauOp : public OpKernel {
+ public:
+  explicit KendallsTauOp(OpKernelConstruction *context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &counts = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(counts.shape()),
+                errors::InvalidArgument("counts must be a matrix, got ",
+                                        counts.shape().DebugString()));
+    const int64 rows = counts.dim_size(0);
+    const int64 cols = counts.dim_size(1);
+    const auto m = counts.matrix<int64>();
+
+    // Column counts of the rows above the current one, and of all rows once
+    // the sweep is done.
+    std::vector<double> above(cols, 0.0);
+    double concordant = 0.0, discordant = 0.0;
+    double sum_squares = 0.0, row_ties = 0.0;
+    double total_above = 0.0;
+    for (int64 i = 0; i < rows; ++i) {
+      double left = 0.0, row_sum = 0.0;
+      for (int64 j = 0; j < cols; ++j) {
+        const double cell = static_cast<double>(m(i, j));
+        if (cell != 0.0) {
+          concordant += cell * left;
+          discordant += cell * (total_above - left - above[j]);
+          row_sum += cell;
+          sum_squares += cell * cell;
+        }
+        left += above[j];
+      }
+      for (int64 j = 0; j < cols; ++j) {
+        above[j] += static_cast<double>(m(i, j));
+      }
+      total_above += row_sum;
+      row_ties += row_sum * row_sum;
+    }
+    double col_ties = 0.0;
+    for (int64 j = 0; j < cols; ++j) {
+      col_ties += above[j] * above[j];
+    }
+    // Pairs tied in y_true only, and in y_pred only.
+    const double t = (row_ties - sum_squares) / 2.0;
+    const double u = (col_ties - sum_squares) / 2.0;
+    const double p_plus_q = concordant + discordant;
+
+    Tensor *tau = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, TensorShape({}), &tau));
+    tau->scalar<T>()() = static_cast<T>(
+        (concordant - discordant) / std::sqrt((p_plus_q + t) * (p_plus_q + u)));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("Addons>KendallsTauUpdate").Device(DEVICE_CPU),
+                        KendallsTauUpdateOp);
+
+#define REGISTER_CPU_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>KendallsTau")               \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          KendallsTauOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
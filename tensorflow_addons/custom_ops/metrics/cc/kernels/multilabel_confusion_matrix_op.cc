@@ -0,0 +1,203 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// The batch is sharded in blocks of about this many labels.
+constexpr int64 kConfusionBlockSize = 1 << 14;
+
+// Bound on the number of row blocks times the number of classes, which is
+// the size of the per block counts. Wide label sets get fewer row blocks and
+// are sharded over their columns instead.
+constexpr int64 kMaxPartialCounts = 1 << 18;
+
+// The counts are indexed by 2 * label + prediction, that is true negatives,
+// false positives, false negatives and true positives; these are the
+// variable inputs in that order.
+constexpr int kCountInputs[4] = {3, 1, 2, 0};
+
+}  // namespace
+
+// Adds the counts of a `[batch_size, num_classes]` batch of multilabel
+// predictions to the per-class true positive, false positive, false negative
+// and true negative variables. As in the Python metric, true positives, false
+// positives and false negatives compare the labels and predictions to zero,
+// while the true negatives are the entries where neither is 1. Each block of
+// rows and columns accumulates its own counts in a single scan of `y_true`
+// and `y_pred`; the row blocks are then summed in order, and the partition
+// only depends on the shapes, so the result does not depend on the thread
+// pool.
+template <typename T, typename Tlabel>
+class MultiLabelConfusionMatrixUpdateOp : public OpKernel {
+ public:
+  explicit MultiLabelConfusionMatrixUpdateOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &y_true = context->input(4);
+    const Tensor &y_pred = context->input(5);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(y_true.shape()),
+                errors::InvalidArgument("y_true must be a matrix, got ",
+                                        y_true.shape().DebugString()));
+    OP_REQUIRES(context, y_true.shape() == y_pred.shape(),
+                errors::InvalidArgument(
+                    "y_true and y_pred should have the same shape, got ",
+                    y_true.shape().DebugString(), " and ",
+                    y_pred.shape().DebugString()));
+    const int64 batch_size = y_true.dim_size(0);
+    const int64 num_classes = y_true.dim_size(1);
+
+    // The weight of element (i, j) is weights[i * row_stride + j * stride].
+    const Tensor &sample_weight = context->input(6);
+    const T *weights = sample_weight.flat<T>().data();
+    const int64 num_weights = sample_weight.NumElements();
+    int64 row_stride = 0, stride = 0;
+    if (num_weights == batch_size * num_classes && sample_weight.dims() == 2) {
+      row_stride = num_classes;
+      stride = 1;
+    } else if (num_weights == batch_size && sample_weight.dims() == 1) {
+      row_stride = 1;
+    } else {
+      OP_REQUIRES(context, TensorShapeUtils::IsScalar(sample_weight.shape()),
+                  errors::InvalidArgument(
+                      "sample_weight should be a scalar, or have shape [",
+                      batch_size, "] or [", batch_size, ", ", num_classes,
+                      "], got ", sample_weight.shape().DebugString()));
+    }
+
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, use_locking_, false, {0, 1, 2, 3});
+    Tensor counts[4];
+    for (int cell = 0; cell < 4; ++cell) {
+      OP_REQUIRES_OK(context, GetInputTensorFromVariable<CPUDevice, T>(
+                                  context, kCountInputs[cell], use_locking_,
+                                  false, &counts[cell]));
+      OP_REQUIRES(
+          context,
+          counts[cell].IsInitialized() &&
+              counts[cell].shape() == TensorShape({num_classes}),
+          errors::InvalidArgument("The confusion matrix variables should "
+                                  "be initialized with shape [",
+                                  num_classes, "], got ",
+                                  counts[cell].shape().DebugString()));
+    }
+    if (batch_size == 0 || num_classes == 0) {
+      return;
+    }
+
+    const int64 num_row_blocks = std::min(
+        Eigen::divup(batch_size,
+                     std::max<int64>(1, kConfusionBlockSize / num_classes)),
+        std::max<int64>(1, kMaxPartialCounts / num_classes));
+    const int64 rows_per_block = Eigen::divup(batch_size, num_row_blocks);
+    const int64 columns_per_block = std::min(
+        num_classes, std::max<int64>(1, kConfusionBlockSize / rows_per_block));
+    const int64 num_column_blocks =
+        Eigen::divup(num_classes, columns_per_block);
+    std::vector<double> partials(num_row_blocks * 4 * num_classes, 0.0);
+    const Tlabel *labels = y_true.flat<Tlabel>().data();
+    const Tlabel *predictions = y_pred.flat<Tlabel>().data();
+
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 block = start; block < end; ++block) {
+        const int64 b = block / num_column_blocks;
+        const int64 first_column =
+            (block % num_column_blocks) * columns_per_block;
+        const int64 last_column =
+            std::min(num_classes, first_column + columns_per_block);
+        double *block_counts = partials.data() + b * 4 * num_classes;
+        const int64 last_row = std::min(batch_size, (b + 1) * rows_per_block);
+        for (int64 i = b * rows_per_block; i < last_row; ++i) {
+          const Tlabel *row_labels = labels + i * num_classes;
+          const Tlabel *row_predictions = predictions + i * num_classes;
+          for (int64 j = first_column; j < last_column; ++j) {
+            const double weight =
+                static_cast<double>(weights[i * row_stride + j * stride]);
+            const int cell = 2 * (row_labels[j] != Tlabel(0)) +
+                             (row_predictions[j] != Tlabel(0));
+            if (cell != 0) {
+              block_counts[cell * num_classes + j] += weight;
+            }
+            if (row_labels[j] != Tlabel(1) && row_predictions[j] != Tlabel(1)) {
+              block_counts[j] += weight;
+            }
+          }
+        }
+      }
+    };
+    const double block_size =
+        static_cast<double>(rows_per_block * columns_per_block);
+    const Eigen::TensorOpCost cost(
+        (2 * sizeof(Tlabel) + sizeof(T)) * block_size, 0, 6 * block_size);
+    context->eigen_device<CPUDevice>().parallelFor(
+        num_row_blocks * num_column_blocks, cost, work);
+
+    for (int cell = 0; cell < 4; ++cell) {
+      auto cell_counts = counts[cell].vec<T>();
+      for (int64 j = 0; j < num_classes; ++j) {
+        double total = 0.0;
+        for (int64 b = 0; b < num_row_blocks; ++b) {
+          total += partials[(b * 4 + cell) * num_classes + j];
+        }
+        cell_counts(j) += static_cast<T>(total);
+      }
+    }
+  }
+
+ private:
+  bool use_locking_;
+};
+
+#define REGISTER_CPU_KERNEL(T, Tlabel)                                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>MultiLabelConfusionMatrixUpdate")   \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<T>("T")                      \
+                              .TypeConstraint<Tlabel>("Tlabels"),          \
+                          MultiLabelConfusionMatrixUpdateOp<T, Tlabel>);
+
+#define REGISTER_CPU_KERNELS(T) \
+  REGISTER_CPU_KERNEL(T, bool); \
+  REGISTER_CPU_KERNEL(T, int8); \
+  REGISTER_CPU_KERNEL(T, int16); \
+  REGISTER_CPU_KERNEL(T, int32); \
+  REGISTER_CPU_KERNEL(T, int64); \
+  REGISTER_CPU_KERNEL(T, uint8);
+
+REGISTER_CPU_KERNELS(float);
+REGISTER_CPU_KERNELS(double);
+REGISTER_CPU_KERNELS(int32);
+REGISTER_CPU_KERNELS(int64);
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,93 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>KendallsTauUpdate")
+    .Input("counts: resource")
+    .Input("y_true: float")
+    .Input("y_pred: float")
+    .Input("actual_cuts: float")
+    .Input("preds_cuts: float")
+    .Attr("use_locking: bool = true")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+      return c->WithRank(c->input(4), 1, &unused);
+    })
+    .Doc(R"doc(
+Adds a batch of pairs to the joint bin counts of Kendall's tau.
+
+`y_true` and `y_pred` have the same number of elements. Each value is put in
+the bin given by the number of cut points below it, and the
+`[len(actual_cuts) + 1, len(preds_cuts) + 1]` int64 `counts` variable is
+incremented in place at every pair of bins.
+)doc");
+
+REGISTER_OP("Addons>KendallsTau")
+    .Input("counts: int64")
+    .Output("tau: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &unused));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes Kendall's tau-b from a matrix of joint bin counts.
+
+The concordant and discordant pairs are counted in one sweep over the rows of
+`counts`, with pairs in the same row or column treated as ties.
+)doc");
+
+REGISTER_OP("Addons>MultiLabelConfusionMatrixUpdate")
+    .Input("true_positives: resource")
+    .Input("false_positives: resource")
+    .Input("false_negatives: resource")
+    .Input("true_negatives: resource")
+    .Input("y_true: Tlabels")
+    .Input("y_pred: Tlabels")
+    .Input("sample_weight: T")
+    .Attr("T: {float, double, int32, int64}")
+    .Attr("Tlabels: {bool, int8, int16, int32, int64, uint8}")
+    .Attr("use_locking: bool = true")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle labels;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 2, &labels));
+      TF_RETURN_IF_ERROR(c->Merge(labels, c->input(5), &labels));
+      ShapeHandle unused;
+      return c->WithRankAtMost(c->input(6), 2, &unused);
+    })
+    .Doc(R"doc(
+Adds a batch of multilabel predictions to per-class confusion counts.
+
+`y_true` and `y_pred` are `[batch_size, num_classes]`. True positives, false
+positives and false negatives compare the entries to zero, and true negatives
+are the entries where neither is 1, as in the Python metric. `sample_weight`
+is a scalar, a `[batch_size]` vector or a `[batch_size, num_classes]` matrix.
+Both inputs are scanned once, with per-block partial counts that are summed in
+order and added in place to the four `[num_classes]` variables.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,225 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "tensorflow_addons/custom_ops/optimizers/cc/kernels/optimizer_op_helpers.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Every tensor is split into blocks of this many elements.
+constexpr int64 kLambBlockSize = 1 << 14;
+
+}  // namespace
+
+// Applies a LAMB step to a list of variables:
+//
+//   m_t = beta_1 * m + (1 - beta_1) * g
+//   v_t = beta_2 * v + (1 - beta_2) * g^2
+//   update = m_t / (1 - beta_1^t) / (sqrt(v_t / (1 - beta_2^t)) + epsilon)
+//            + weight_decay_rate * var
+//   var -= lr * (||var|| / ||update||) * update
+//
+// The first pass over a tensor updates the slots and accumulates both norms,
+// the second recomputes `update` from the new slots and applies it, so no
+// temporary of the size of the variable is created.
+template <typename T>
+class ResourceApplyLambMultiOp : public OpKernel {
+ public:
+  using ArrayMap = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+  using ConstArrayMap = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+  explicit ResourceApplyLambMultiOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("N", &num_tensors_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("use_weight_decay", &use_weight_decay_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_layer_adaptation",
+                                             &use_layer_adaptation_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+    OP_REQUIRES(context,
+                static_cast<int>(use_weight_decay_.size()) == num_tensors_ &&
+                    static_cast<int>(use_layer_adaptation_.size()) ==
+                        num_tensors_,
+                errors::InvalidArgument(
+                    "use_weight_decay and use_layer_adaptation should have N "
+                    "elements."));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const int n = num_tensors_;
+    std::vector<int> variable_inputs(3 * n);
+    for (int i = 0; i < 3 * n; ++i) {
+      variable_inputs[i] = i;
+    }
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, use_locking_, false, variable_inputs);
+
+    std::vector<Tensor> vars(n), ms(n), vs(n);
+    for (int i = 0; i < n; ++i) {
+      OP_REQUIRES_OK(context, GetInputTensorFromVariable<CPUDevice, T>(
+                                  context, i, use_locking_, false, &vars[i]));
+      OP_REQUIRES_OK(context,
+                     GetInputTensorFromVariable<CPUDevice, T>(
+                         context, n + i, use_locking_, false, &ms[i]));
+      OP_REQUIRES_OK(context,
+                     GetInputTensorFromVariable<CPUDevice, T>(
+                         context, 2 * n + i, use_locking_, false, &vs[i]));
+      const Tensor &grad = context->input(3 * n + i);
+      OP_REQUIRES(context,
+                  vars[i].IsInitialized() && ms[i].IsInitialized() &&
+                      vs[i].IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to use uninitialized variables: ", i));
+      OP_REQUIRES(context,
+                  vars[i].shape() == ms[i].shape() &&
+                      vars[i].shape() == vs[i].shape() &&
+                      vars[i].shape() == grad.shape(),
+                  errors::InvalidArgument(
+                      "var, m, v and grad ", i,
+                      " should have the same shape, got ",
+                      vars[i].shape().DebugString(), ", ",
+                      ms[i].shape().DebugString(), ", ",
+                      vs[i].shape().DebugString(), " and ",
+                      grad.shape().DebugString()));
+    }
+
+    T lr, beta_1, beta_2, epsilon, weight_decay_rate, beta_1_power,
+        beta_2_power;
+    const int first_scalar = 4 * n;
+    OP_REQUIRES_OK(context, GetScalarInput(context, first_scalar, "lr", &lr));
+    OP_REQUIRES_OK(context, GetScalarInput(context, first_scalar + 1,
+                                           "beta_1", &beta_1));
+    OP_REQUIRES_OK(context, GetScalarInput(context, first_scalar + 2,
+                                           "beta_2", &beta_2));
+    OP_REQUIRES_OK(context, GetScalarInput(context, first_scalar + 3,
+                                           "epsilon", &epsilon));
+    OP_REQUIRES_OK(context,
+                   GetScalarInput(context, first_scalar + 4,
+                                  "weight_decay_rate", &weight_decay_rate));
+    OP_REQUIRES_OK(context, GetScalarInput(context, first_scalar + 5,
+                                           "beta_1_power", &beta_1_power));
+    OP_REQUIRES_OK(context, GetScalarInput(context, first_scalar + 6,
+                                           "beta_2_power", &beta_2_power));
+    const T m_scale = T(1) / (T(1) - beta_1_power);
+    const T v_scale = T(1) / (T(1) - beta_2_power);
+
+    std::vector<int64> sizes(n);
+    for (int i = 0; i < n; ++i) {
+      sizes[i] = vars[i].NumElements();
+    }
+    const std::vector<TensorBlock> blocks =
+        SplitIntoBlocks(sizes, kLambBlockSize);
+    const int64 num_blocks = blocks.size();
+    // Squared norms of the variable and of the update, per block.
+    std::vector<T> var_norms(num_blocks), update_norms(num_blocks);
+    std::vector<T> decays(n), ratios(n);
+    for (int i = 0; i < n; ++i) {
+      decays[i] = use_weight_decay_[i] ? weight_decay_rate : T(0);
+    }
+
+    const auto slot_pass = [&](int64 start, int64 end) {
+      for (int64 b = start; b < end; ++b) {
+        const TensorBlock &block = blocks[b];
+        const int64 size = block.end - block.begin;
+        const int i = block.tensor;
+        ConstArrayMap grad(context->input(3 * n + i).flat<T>().data() +
+                               block.begin,
+                           size);
+        ArrayMap var(vars[i].flat<T>().data() + block.begin, size);
+        ArrayMap m(ms[i].flat<T>().data() + block.begin, size);
+        ArrayMap v(vs[i].flat<T>().data() + block.begin, size);
+        m = beta_1 * m + (T(1) - beta_1) * grad;
+        v = beta_2 * v + (T(1) - beta_2) * grad.square();
+        var_norms[b] = var.square().sum();
+        update_norms[b] = ((m * m_scale) / ((v * v_scale).sqrt() + epsilon) +
+                           decays[i] * var)
+                              .square()
+                              .sum();
+      }
+    };
+
+    const auto var_pass = [&](int64 start, int64 end) {
+      for (int64 b = start; b < end; ++b) {
+        const TensorBlock &block = blocks[b];
+        const int64 size = block.end - block.begin;
+        const int i = block.tensor;
+        ArrayMap var(vars[i].flat<T>().data() + block.begin, size);
+        ConstArrayMap m(ms[i].flat<T>().data() + block.begin, size);
+        ConstArrayMap v(vs[i].flat<T>().data() + block.begin, size);
+        var -= (ratios[i] * lr) *
+               ((m * m_scale) / ((v * v_scale).sqrt() + epsilon) +
+                decays[i] * var);
+      }
+    };
+
+    const double block_size = static_cast<double>(kLambBlockSize);
+    const Eigen::TensorOpCost slot_cost(
+        4 * sizeof(T) * block_size, 2 * sizeof(T) * block_size,
+        16 * Eigen::TensorOpCost::AddCost<T>() * block_size);
+    const Eigen::TensorOpCost var_cost(
+        3 * sizeof(T) * block_size, sizeof(T) * block_size,
+        10 * Eigen::TensorOpCost::AddCost<T>() * block_size);
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+
+    device.parallelFor(num_blocks, slot_cost, slot_pass);
+
+    std::vector<T> var_norm(n, T(0)), update_norm(n, T(0));
+    for (int64 b = 0; b < num_blocks; ++b) {
+      var_norm[blocks[b].tensor] += var_norms[b];
+      update_norm[blocks[b].tensor] += update_norms[b];
+    }
+    for (int i = 0; i < n; ++i) {
+      ratios[i] = T(1);
+      if (use_layer_adaptation_[i] && var_norm[i] > T(0) &&
+          update_norm[i] > T(0)) {
+        ratios[i] = std::sqrt(var_norm[i]) / std::sqrt(update_norm[i]);
+      }
+    }
+
+    device.parallelFor(num_blocks, var_cost, var_pass);
+  }
+
+ private:
+  int num_tensors_;
+  std::vector<bool> use_weight_decay_;
+  std::vector<bool> use_layer_adaptation_;
+  bool use_locking_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceApplyLambMulti")    \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          ResourceApplyLambMultiOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,186 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "tensorflow_addons/custom_ops/optimizers/cc/kernels/optimizer_op_helpers.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Applies a LazyAdam step to the rows of `var`, `m` and `v` selected by
+// `indices`:
+//
+//   m_t = beta_1 * m + (1 - beta_1) * g
+//   v_t = beta_2 * v + (1 - beta_2) * g^2
+//   var -= lr * sqrt(1 - beta_2^t) / (1 - beta_1^t) * m_t / (sqrt(v_t) + eps)
+//
+// Gradients of repeated indices are summed first, so every row is read and
+// written once, by a single thread.
+template <typename T, typename Tindex>
+class ResourceSparseApplyLazyAdamOp : public OpKernel {
+ public:
+  using ArrayMap = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+  using ConstArrayMap = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+  explicit ResourceSparseApplyLazyAdamOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, use_locking_, true, {0, 1, 2});
+    Tensor var, m, v;
+    OP_REQUIRES_OK(context, GetInputTensorFromVariable<CPUDevice, T>(
+                                context, 0, use_locking_, true, &var));
+    OP_REQUIRES_OK(context, GetInputTensorFromVariable<CPUDevice, T>(
+                                context, 1, use_locking_, true, &m));
+    OP_REQUIRES_OK(context, GetInputTensorFromVariable<CPUDevice, T>(
+                                context, 2, use_locking_, true, &v));
+    OP_REQUIRES(context,
+                var.IsInitialized() && m.IsInitialized() && v.IsInitialized(),
+                errors::FailedPrecondition(
+                    "Attempting to use uninitialized variables"));
+    OP_REQUIRES(context,
+                var.shape() == m.shape() && var.shape() == v.shape(),
+                errors::InvalidArgument(
+                    "var, m and v should have the same shape, got ",
+                    var.shape().DebugString(), ", ", m.shape().DebugString(),
+                    " and ", v.shape().DebugString()));
+
+    T beta_1_power, beta_2_power, lr, beta_1, beta_2, epsilon;
+    OP_REQUIRES_OK(context,
+                   GetScalarInput(context, 3, "beta_1_power", &beta_1_power));
+    OP_REQUIRES_OK(context,
+                   GetScalarInput(context, 4, "beta_2_power", &beta_2_power));
+    OP_REQUIRES_OK(context, GetScalarInput(context, 5, "lr", &lr));
+    OP_REQUIRES_OK(context, GetScalarInput(context, 6, "beta_1", &beta_1));
+    OP_REQUIRES_OK(context, GetScalarInput(context, 7, "beta_2", &beta_2));
+    OP_REQUIRES_OK(context, GetScalarInput(context, 8, "epsilon", &epsilon));
+
+    const Tensor &grad = context->input(9);
+    const Tensor &indices = context->input(10);
+    int64 row_size;
+    OP_REQUIRES_OK(context, ValidateSparseUpdate<Tindex>(var, grad, indices,
+                                                         &row_size));
+    const int64 num_indices = indices.dim_size(0);
+    const auto indices_vec = indices.vec<Tindex>();
+    if (num_indices == 0 || row_size == 0) {
+      return;
+    }
+
+    // Group the positions of every distinct index, in order of first
+    // appearance, into `positions[offsets[u]:offsets[u + 1]]`.
+    std::vector<Tindex> unique_rows;
+    std::vector<int64> offsets, positions(num_indices);
+    {
+      std::unordered_map<Tindex, int64> unique_ids;
+      unique_ids.reserve(num_indices);
+      std::vector<int64> ids(num_indices);
+      for (int64 i = 0; i < num_indices; ++i) {
+        const auto inserted =
+            unique_ids.emplace(indices_vec(i), unique_rows.size());
+        if (inserted.second) {
+          unique_rows.push_back(indices_vec(i));
+          offsets.push_back(0);
+        }
+        ids[i] = inserted.first->second;
+        ++offsets[ids[i]];
+      }
+      int64 total = 0;
+      for (int64 &offset : offsets) {
+        const int64 count = offset;
+        offset = total;
+        total += count;
+      }
+      offsets.push_back(total);
+      std::vector<int64> next(offsets.begin(), offsets.end() - 1);
+      for (int64 i = 0; i < num_indices; ++i) {
+        positions[next[ids[i]]++] = i;
+      }
+    }
+    const int64 num_unique = unique_rows.size();
+
+    const T alpha =
+        lr * std::sqrt(T(1) - beta_2_power) / (T(1) - beta_1_power);
+    const T *grad_data = grad.flat<T>().data();
+    T *var_data = var.flat<T>().data();
+    T *m_data = m.flat<T>().data();
+    T *v_data = v.flat<T>().data();
+
+    const auto work = [&](int64 start, int64 end) {
+      Eigen::Array<T, Eigen::Dynamic, 1> summed;
+      for (int64 u = start; u < end; ++u) {
+        const int64 offset = static_cast<int64>(unique_rows[u]) * row_size;
+        const int64 first = offsets[u];
+        const int64 last = offsets[u + 1];
+        const T *row_grad = grad_data + positions[first] * row_size;
+        if (last - first > 1) {
+          summed = ConstArrayMap(row_grad, row_size);
+          for (int64 k = first + 1; k < last; ++k) {
+            summed += ConstArrayMap(grad_data + positions[k] * row_size,
+                                    row_size);
+          }
+          row_grad = summed.data();
+        }
+        ConstArrayMap g(row_grad, row_size);
+        ArrayMap var_row(var_data + offset, row_size);
+        ArrayMap m_row(m_data + offset, row_size);
+        ArrayMap v_row(v_data + offset, row_size);
+        m_row = beta_1 * m_row + (T(1) - beta_1) * g;
+        v_row = beta_2 * v_row + (T(1) - beta_2) * g.square();
+        var_row -= alpha * m_row / (v_row.sqrt() + epsilon);
+      }
+    };
+
+    const double row_bytes = static_cast<double>(row_size * sizeof(T));
+    const Eigen::TensorOpCost cost(
+        (3 + static_cast<double>(num_indices) / num_unique) * row_bytes,
+        3 * row_bytes,
+        10 * Eigen::TensorOpCost::AddCost<T>() * row_size);
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(num_unique, cost, work);
+  }
+
+ private:
+  bool use_locking_;
+};
+
+#define REGISTER_CPU_KERNEL(T, Tindex)                                 \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceSparseApplyLazyAdam")   \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<T>("T")                  \
+                              .TypeConstraint<Tindex>("Tindices"),     \
+                          ResourceSparseApplyLazyAdamOp<T, Tindex>);
+
+REGISTER_CPU_KERNEL(float, int32);
+REGISTER_CPU_KERNEL(float, int64);
+REGISTER_CPU_KERNEL(double, int32);
+REGISTER_CPU_KERNEL(double, int64);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
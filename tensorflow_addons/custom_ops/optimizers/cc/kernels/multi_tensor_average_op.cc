@@ -0,0 +1,190 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "tensorflow_addons/custom_ops/optimizers/cc/kernels/optimizer_op_helpers.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Every tensor is split into blocks of this many elements.
+constexpr int64 kAverageBlockSize = 1 << 14;
+
+// Locks and reads the `2 * num_tensors` variables `a` and `b`, and checks that
+// every pair has the same shape.
+template <typename T>
+Status ReadVariablePairs(OpKernelContext *context, int num_tensors,
+                         bool use_locking, std::vector<Tensor> *a,
+                         std::vector<Tensor> *b) {
+  a->resize(num_tensors);
+  b->resize(num_tensors);
+  for (int i = 0; i < num_tensors; ++i) {
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        context, i, use_locking, false, &(*a)[i]));
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        context, num_tensors + i, use_locking, false, &(*b)[i]));
+    if (!(*a)[i].IsInitialized() || !(*b)[i].IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables: ", i);
+    }
+    if ((*a)[i].shape() != (*b)[i].shape()) {
+      return errors::InvalidArgument(
+          "Variables ", i, " should have the same shape, got ",
+          (*a)[i].shape().DebugString(), " and ",
+          (*b)[i].shape().DebugString());
+    }
+  }
+  return Status::OK();
+}
+
+std::vector<int> AllInputs(int count) {
+  std::vector<int> inputs(count);
+  for (int i = 0; i < count; ++i) {
+    inputs[i] = i;
+  }
+  return inputs;
+}
+
+std::vector<TensorBlock> SplitVariables(const std::vector<Tensor> &vars) {
+  std::vector<int64> sizes(vars.size());
+  for (size_t i = 0; i < vars.size(); ++i) {
+    sizes[i] = vars[i].NumElements();
+  }
+  return SplitIntoBlocks(sizes, kAverageBlockSize);
+}
+
+}  // namespace
+
+// Updates the averages of `N` variables in place:
+//
+//   average = decay * average + (1 - decay) * var
+//
+// which is an exponential moving average for a fixed decay, and a running
+// mean over n snapshots for decay = n / (n + 1). Nothing is written when
+// decay is 1.
+template <typename T>
+class MultiTensorAverageOp : public OpKernel {
+ public:
+  explicit MultiTensorAverageOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("N", &num_tensors_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const int n = num_tensors_;
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, use_locking_, false, AllInputs(2 * n));
+    std::vector<Tensor> vars, averages;
+    OP_REQUIRES_OK(context, ReadVariablePairs<T>(context, n, use_locking_,
+                                                 &vars, &averages));
+    T decay;
+    OP_REQUIRES_OK(context, GetScalarInput(context, 2 * n, "decay", &decay));
+    if (decay == T(1)) {
+      return;
+    }
+
+    const std::vector<TensorBlock> blocks = SplitVariables(vars);
+    const T weight = T(1) - decay;
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 b = start; b < end; ++b) {
+        const TensorBlock &block = blocks[b];
+        const int64 size = block.end - block.begin;
+        Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> var(
+            vars[block.tensor].flat<T>().data() + block.begin, size);
+        Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> average(
+            averages[block.tensor].flat<T>().data() + block.begin, size);
+        average -= weight * (average - var);
+      }
+    };
+    const double block_size = static_cast<double>(kAverageBlockSize);
+    const Eigen::TensorOpCost cost(
+        2 * sizeof(T) * block_size, sizeof(T) * block_size,
+        3 * Eigen::TensorOpCost::AddCost<T>() * block_size);
+    context->eigen_device<CPUDevice>().parallelFor(blocks.size(), cost, work);
+  }
+
+ private:
+  int num_tensors_;
+  bool use_locking_;
+};
+
+// Swaps the values of `N` pairs of variables in place.
+template <typename T>
+class MultiTensorSwapOp : public OpKernel {
+ public:
+  explicit MultiTensorSwapOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("N", &num_tensors_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const int n = num_tensors_;
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, use_locking_, false, AllInputs(2 * n));
+    std::vector<Tensor> a, b;
+    OP_REQUIRES_OK(context,
+                   ReadVariablePairs<T>(context, n, use_locking_, &a, &b));
+
+    const std::vector<TensorBlock> blocks = SplitVariables(a);
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 k = start; k < end; ++k) {
+        const TensorBlock &block = blocks[k];
+        T *a_data = a[block.tensor].flat<T>().data();
+        T *b_data = b[block.tensor].flat<T>().data();
+        std::swap_ranges(a_data + block.begin, a_data + block.end,
+                         b_data + block.begin);
+      }
+    };
+    const double block_bytes =
+        sizeof(T) * static_cast<double>(kAverageBlockSize);
+    const Eigen::TensorOpCost cost(2 * block_bytes, 2 * block_bytes, 0);
+    context->eigen_device<CPUDevice>().parallelFor(blocks.size(), cost, work);
+  }
+
+ private:
+  int num_tensors_;
+  bool use_locking_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>MultiTensorAverage")        \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("T"),             \
+                          MultiTensorAverageOp<T>);                \
+  REGISTER_KERNEL_BUILDER(Name("Addons>MultiTensorSwap")           \
+                              .Device(DEVICE_CPU)                  \
+                              .TypeConstraint<T>("dtype"),         \
+                          MultiTensorSwapOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,336 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "tensorflow_addons/custom_ops/optimizers/cc/kernels/optimizer_op_helpers.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+template <typename T>
+struct NovoGradCoefficients {
+  T lr;
+  T beta_1;
+  T beta_2;
+  T epsilon;
+  T weight_decay;
+  bool first_step;
+  bool grad_averaging;
+};
+
+}  // namespace
+
+// Applies a NovoGrad step, with a single second moment `v` per variable:
+//
+//   v_t = ||g||^2 on the first step, beta_2 * v + (1 - beta_2) * ||g||^2
+//         afterwards (and vhat_t = max(vhat, v_t) with amsgrad)
+//   g' = g / (sqrt(v_t) + epsilon) + weight_decay * var
+//   g' *= 1 - beta_1 with grad averaging, after the first step
+//   m_t = beta_1 * m - lr * g'
+//   var += m_t
+//
+// The squared norm of the gradient is one parallel reduction; everything
+// else is done in a single pass over the variable.
+template <typename T>
+class NovoGradOpBase : public OpKernel {
+ public:
+  explicit NovoGradOpBase(OpKernelConstruction *context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_vhat", &num_vhat_));
+    OP_REQUIRES(context, num_vhat_ <= 1,
+                errors::InvalidArgument("num_vhat should be 0 or 1."));
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+  }
+
+ protected:
+  // Index of the first input after the variables.
+  int first_hyperparameter() const { return 3 + num_vhat_; }
+  bool amsgrad() const { return num_vhat_ == 1; }
+
+  std::vector<int> VariableInputs() const {
+    std::vector<int> inputs = {0, 1, 2};
+    if (amsgrad()) {
+      inputs.push_back(3);
+    }
+    return inputs;
+  }
+
+  // Reads `var`, `m`, `v`, `vhat` and the hyperparameters, and checks that the
+  // gradient has `expected_grad_shape`, or var's shape if it is null.
+  Status ReadInputs(OpKernelContext *context, bool sparse, Tensor *var,
+                    Tensor *m, Tensor *v, Tensor *vhat,
+                    NovoGradCoefficients<T> *coefficients) {
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        context, 0, use_locking_, sparse, var));
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        context, 1, use_locking_, sparse, m));
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        context, 2, use_locking_, sparse, v));
+    if (!var->IsInitialized() || !m->IsInitialized() || !v->IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables");
+    }
+    if (var->shape() != m->shape()) {
+      return errors::InvalidArgument(
+          "var and m should have the same shape, got ",
+          var->shape().DebugString(), " and ", m->shape().DebugString());
+    }
+    if (!TensorShapeUtils::IsScalar(v->shape())) {
+      return errors::InvalidArgument("v should be a scalar, got ",
+                                     v->shape().DebugString());
+    }
+    if (amsgrad()) {
+      TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+          context, 3, use_locking_, sparse, vhat));
+      if (!vhat->IsInitialized()) {
+        return errors::FailedPrecondition(
+            "Attempting to use uninitialized variables");
+      }
+      if (var->shape() != vhat->shape()) {
+        return errors::InvalidArgument(
+            "var and vhat should have the same shape, got ",
+            var->shape().DebugString(), " and ", vhat->shape().DebugString());
+      }
+    }
+
+    const int first = first_hyperparameter();
+    int64 step;
+    TF_RETURN_IF_ERROR(GetScalarInput(context, first, "step", &step));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 1, "lr", &coefficients->lr));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 2, "beta_1", &coefficients->beta_1));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 3, "beta_2", &coefficients->beta_2));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 4, "epsilon", &coefficients->epsilon));
+    TF_RETURN_IF_ERROR(GetScalarInput(context, first + 5, "weight_decay",
+                                      &coefficients->weight_decay));
+    TF_RETURN_IF_ERROR(GetScalarInput(context, first + 6, "grad_averaging",
+                                      &coefficients->grad_averaging));
+    coefficients->first_step = step == 0;
+    return Status::OK();
+  }
+
+  // Updates the second moment with the squared norm of `grad`.
+  static T UpdateSecondMoment(const CPUDevice &device, const Tensor &grad,
+                              const NovoGradCoefficients<T> &coefficients,
+                              Tensor *v) {
+    const T squared_norm = ParallelSquaredNorm(device, grad);
+    T &v_scalar = v->scalar<T>()();
+    v_scalar = coefficients.first_step
+                   ? squared_norm
+                   : coefficients.beta_2 * v_scalar +
+                         (T(1) - coefficients.beta_2) * squared_norm;
+    return v_scalar;
+  }
+
+  // Applies the update to `size` contiguous elements, given the gradient
+  // normalizer `sqrt(v_t) + epsilon`, or per-element normalizers `vhat` with
+  // amsgrad.
+  static void ApplyElements(const NovoGradCoefficients<T> &coefficients,
+                            T v_t, const T *grad, T *var, T *m, T *vhat,
+                            int64 size) {
+    using ArrayMap = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+    using ConstArrayMap =
+        Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+    ConstArrayMap g(grad, size);
+    ArrayMap var_array(var, size);
+    ArrayMap m_array(m, size);
+    const T scale = coefficients.grad_averaging && !coefficients.first_step
+                        ? T(1) - coefficients.beta_1
+                        : T(1);
+    const T weight_decay = coefficients.weight_decay > T(0)
+                               ? coefficients.weight_decay
+                               : T(0);
+    if (vhat != nullptr) {
+      ArrayMap vhat_array(vhat, size);
+      vhat_array = vhat_array.max(v_t);
+      m_array = coefficients.beta_1 * m_array -
+                (coefficients.lr * scale) *
+                    (g / (vhat_array.sqrt() + coefficients.epsilon) +
+                     weight_decay * var_array);
+    } else {
+      const T normalizer = std::sqrt(v_t) + coefficients.epsilon;
+      m_array = coefficients.beta_1 * m_array -
+                (coefficients.lr * scale) *
+                    (g / normalizer + weight_decay * var_array);
+    }
+    var_array += m_array;
+  }
+
+  static Eigen::TensorOpCost ElementCost() {
+    return Eigen::TensorOpCost(4 * sizeof(T), 2 * sizeof(T),
+                               8 * Eigen::TensorOpCost::AddCost<T>());
+  }
+
+  bool use_locking_;
+
+ private:
+  static T ParallelSquaredNorm(const CPUDevice &device, const Tensor &grad) {
+    constexpr int64 kBlockSize = 1 << 14;
+    const int64 size = grad.NumElements();
+    const T *data = grad.flat<T>().data();
+    const int64 num_blocks = (size + kBlockSize - 1) / kBlockSize;
+    // Summed in block order afterwards, so the result does not depend on
+    // the sharding.
+    std::vector<T> partials(num_blocks);
+    device.parallelFor(
+        num_blocks,
+        Eigen::TensorOpCost(kBlockSize * sizeof(T), 0,
+                            2 * kBlockSize * Eigen::TensorOpCost::AddCost<T>()),
+        [&](int64 start, int64 end) {
+          for (int64 b = start; b < end; ++b) {
+            const int64 begin = b * kBlockSize;
+            const int64 length = std::min(kBlockSize, size - begin);
+            partials[b] = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>(
+                              data + begin, length)
+                              .square()
+                              .sum();
+          }
+        });
+    T total = T(0);
+    for (const T partial : partials) {
+      total += partial;
+    }
+    return total;
+  }
+
+  int num_vhat_;
+};
+
+template <typename T>
+class ResourceApplyNovoGradOp : public NovoGradOpBase<T> {
+ public:
+  explicit ResourceApplyNovoGradOp(OpKernelConstruction *context)
+      : NovoGradOpBase<T>(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, this->use_locking_, false, this->VariableInputs());
+    Tensor var, m, v, vhat;
+    NovoGradCoefficients<T> coefficients;
+    OP_REQUIRES_OK(context, this->ReadInputs(context, false, &var, &m, &v,
+                                             &vhat, &coefficients));
+    const Tensor &grad = context->input(this->first_hyperparameter() + 7);
+    OP_REQUIRES(context, grad.shape() == var.shape(),
+                errors::InvalidArgument(
+                    "var and grad should have the same shape, got ",
+                    var.shape().DebugString(), " and ",
+                    grad.shape().DebugString()));
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    const T v_t = this->UpdateSecondMoment(device, grad, coefficients, &v);
+    const T *grad_data = grad.flat<T>().data();
+    T *var_data = var.flat<T>().data();
+    T *m_data = m.flat<T>().data();
+    T *vhat_data = this->amsgrad() ? vhat.flat<T>().data() : nullptr;
+    device.parallelFor(
+        var.NumElements(), this->ElementCost(), [&](int64 start, int64 end) {
+          this->ApplyElements(coefficients, v_t, grad_data + start,
+                              var_data + start, m_data + start,
+                              vhat_data ? vhat_data + start : nullptr,
+                              end - start);
+        });
+  }
+};
+
+template <typename T, typename Tindex>
+class ResourceSparseApplyNovoGradOp : public NovoGradOpBase<T> {
+ public:
+  explicit ResourceSparseApplyNovoGradOp(OpKernelConstruction *context)
+      : NovoGradOpBase<T>(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, this->use_locking_, true, this->VariableInputs());
+    Tensor var, m, v, vhat;
+    NovoGradCoefficients<T> coefficients;
+    OP_REQUIRES_OK(context, this->ReadInputs(context, true, &var, &m, &v,
+                                             &vhat, &coefficients));
+    const Tensor &grad = context->input(this->first_hyperparameter() + 7);
+    const Tensor &indices = context->input(this->first_hyperparameter() + 8);
+    int64 row_size;
+    OP_REQUIRES_OK(context, ValidateSparseUpdate<Tindex>(var, grad, indices,
+                                                         &row_size));
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    const T v_t = this->UpdateSecondMoment(device, grad, coefficients, &v);
+    T *vhat_data = nullptr;
+    if (this->amsgrad()) {
+      // vhat is a running maximum over every element, not only the rows
+      // being updated.
+      vhat_data = vhat.flat<T>().data();
+      device.parallelFor(vhat.NumElements(),
+                         Eigen::TensorOpCost(sizeof(T), sizeof(T), 1),
+                         [&](int64 start, int64 end) {
+                           for (int64 k = start; k < end; ++k) {
+                             vhat_data[k] = std::max(vhat_data[k], v_t);
+                           }
+                         });
+    }
+
+    const auto indices_vec = indices.vec<Tindex>();
+    const T *grad_data = grad.flat<T>().data();
+    T *var_data = var.flat<T>().data();
+    T *m_data = m.flat<T>().data();
+    device.parallelFor(
+        indices.NumElements(), this->ElementCost() * row_size,
+        [&](int64 start, int64 end) {
+          for (int64 i = start; i < end; ++i) {
+            const int64 offset = static_cast<int64>(indices_vec(i)) * row_size;
+            this->ApplyElements(coefficients, v_t, grad_data + i * row_size,
+                                var_data + offset, m_data + offset,
+                                vhat_data ? vhat_data + offset : nullptr,
+                                row_size);
+          }
+        });
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                          \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceApplyNovoGrad")          \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          ResourceApplyNovoGradOp<T>);                  \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceSparseApplyNovoGrad")    \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T")                   \
+                              .TypeConstraint<int32>("Tindices"),       \
+                          ResourceSparseApplyNovoGradOp<T, int32>);     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceSparseApplyNovoGrad")    \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T")                   \
+                              .TypeConstraint<int64>("Tindices"),       \
+                          ResourceSparseApplyNovoGradOp<T, int64>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
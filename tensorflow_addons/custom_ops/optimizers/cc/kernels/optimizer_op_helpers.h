@@ -0,0 +1,97 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_ADDONS_OPTIMIZERS_KERNELS_OPTIMIZER_OP_HELPERS_H_
+#define TENSORFLOW_ADDONS_OPTIMIZERS_KERNELS_OPTIMIZER_OP_HELPERS_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+
+namespace tensorflow {
+namespace addons {
+
+// A contiguous range of elements of one of the tensors of a multi-tensor op.
+struct TensorBlock {
+  int tensor;
+  int64 begin;
+  int64 end;
+};
+
+// Splits tensors of the given sizes into blocks of at most `block_size`
+// elements. The blocks of all tensors are then sharded together, so large
+// tensors are updated by several threads and small ones are batched on one.
+inline std::vector<TensorBlock> SplitIntoBlocks(
+    const std::vector<int64> &sizes, int64 block_size) {
+  std::vector<TensorBlock> blocks;
+  for (int i = 0; i < static_cast<int>(sizes.size()); ++i) {
+    for (int64 begin = 0; begin < sizes[i]; begin += block_size) {
+      blocks.push_back({i, begin, std::min(begin + block_size, sizes[i])});
+    }
+  }
+  return blocks;
+}
+
+// Reads the scalar hyperparameter at input `index`.
+template <typename T>
+Status GetScalarInput(OpKernelContext *context, int index, const char *name,
+                      T *value) {
+  const Tensor &tensor = context->input(index);
+  if (!TensorShapeUtils::IsScalar(tensor.shape())) {
+    return errors::InvalidArgument(name, " is not a scalar: ",
+                                   tensor.shape().DebugString());
+  }
+  *value = tensor.scalar<T>()();
+  return Status::OK();
+}
+
+// Checks that `indices` is a vector of rows of `var` and that `grad` holds
+// one row per index, and sets `row_size` to the number of elements in a row.
+template <typename Tindex>
+Status ValidateSparseUpdate(const Tensor &var, const Tensor &grad,
+                            const Tensor &indices, int64 *row_size) {
+  if (!TensorShapeUtils::IsVectorOrHigher(var.shape())) {
+    return errors::InvalidArgument("var must be at least 1 dimensional");
+  }
+  if (!TensorShapeUtils::IsVector(indices.shape())) {
+    return errors::InvalidArgument("indices must be one-dimensional");
+  }
+  const int64 num_indices = indices.dim_size(0);
+  TensorShape expected_grad_shape = var.shape();
+  expected_grad_shape.set_dim(0, num_indices);
+  if (grad.shape() != expected_grad_shape) {
+    return errors::InvalidArgument("grad shape should be ",
+                                   expected_grad_shape.DebugString(), ", got ",
+                                   grad.shape().DebugString());
+  }
+  const int64 num_rows = var.dim_size(0);
+  const auto indices_vec = indices.vec<Tindex>();
+  for (int64 i = 0; i < num_indices; ++i) {
+    const Tindex index = indices_vec(i);
+    if (index < 0 || index >= num_rows) {
+      return errors::InvalidArgument("indices[", i, "] = ", index,
+                                     " is not in [0, ", num_rows, ")");
+    }
+  }
+  *row_size = num_rows > 0 ? var.NumElements() / num_rows : 0;
+  return Status::OK();
+}
+
+}  // namespace addons
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_ADDONS_OPTIMIZERS_KERNELS_OPTIMIZER_OP_HELPERS_H_
@@ -0,0 +1,296 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "tensorflow_addons/custom_ops/optimizers/cc/kernels/optimizer_op_helpers.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+template <typename T>
+struct YogiCoefficients {
+  T lr;
+  T beta_1;
+  T beta_2;
+  T epsilon;
+  T l1;
+  T l2;
+  bool tanh_activation;
+};
+
+// Applies the Yogi update to `size` contiguous elements. `m` is null when
+// the optimizer has no first moment (beta_1 == 0); with a first moment,
+// `m` has already been decayed by beta_1 if `m_decayed` is set.
+template <typename T>
+void YogiUpdate(const YogiCoefficients<T> &c, bool m_decayed, const T *grad,
+                T *var, T *m, T *v, int64 size) {
+  for (int64 k = 0; k < size; ++k) {
+    const T g = grad[k];
+    T update = g;
+    if (m != nullptr) {
+      m[k] = (m_decayed ? m[k] : c.beta_1 * m[k]) + (T(1) - c.beta_1) * g;
+      update = m[k];
+    }
+    const T g2 = g * g;
+    const T diff = g2 - v[k];
+    const T sign = c.tanh_activation
+                       ? std::tanh(T(10) * diff)
+                       : T((diff > T(0)) - (diff < T(0)));
+    v[k] += (T(1) - c.beta_2) * sign * g2;
+    const T per_coord_lr = c.lr / (std::sqrt(v[k]) + c.epsilon);
+    T new_var = var[k] - per_coord_lr * update;
+    if (c.l1 > T(0)) {
+      // Minimizes (a/2) w^2 + b w + c |w|, as in FTRL.
+      const T a = T(1) + c.l2 * per_coord_lr;
+      const T b = -new_var;
+      const T threshold = c.l1 * per_coord_lr;
+      new_var = std::abs(b) > threshold
+                    ? (threshold * T((b > T(0)) - (b < T(0))) - b) / a
+                    : T(0);
+    } else if (c.l2 > T(0)) {
+      new_var /= T(1) + c.l2 * per_coord_lr;
+    }
+    var[k] = new_var;
+  }
+}
+
+}  // namespace
+
+// Applies a Yogi step:
+//
+//   m_t = beta_1 * m + (1 - beta_1) * g            (when there is an `m`)
+//   v_t = v + (1 - beta_2) * sign(g^2 - v) * g^2   (or tanh(10 (g^2 - v)))
+//   lr_t = lr * sqrt(1 - beta_2^t) / (1 - beta_1^t) / (sqrt(v_t) + epsilon)
+//   var -= lr_t * m_t
+//
+// followed by the L1 proximal step or the L2 shrinkage, in one pass.
+template <typename T>
+class YogiOpBase : public OpKernel {
+ public:
+  explicit YogiOpBase(OpKernelConstruction *context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_m", &num_m_));
+    OP_REQUIRES(context, num_m_ <= 1,
+                errors::InvalidArgument("num_m should be 0 or 1."));
+    string activation;
+    OP_REQUIRES_OK(context, context->GetAttr("activation", &activation));
+    tanh_activation_ = activation == "tanh";
+    OP_REQUIRES_OK(context, context->GetAttr("use_locking", &use_locking_));
+  }
+
+ protected:
+  bool has_m() const { return num_m_ == 1; }
+
+  std::vector<int> VariableInputs() const {
+    std::vector<int> inputs = {0};
+    if (has_m()) {
+      inputs.push_back(1);
+    }
+    inputs.push_back(1 + num_m_);
+    return inputs;
+  }
+
+  // Reads `var`, `m`, `v` and the hyperparameters, and returns the index of
+  // the gradient in `grad_index`.
+  Status ReadInputs(OpKernelContext *context, bool sparse, Tensor *var,
+                    Tensor *m, Tensor *v, YogiCoefficients<T> *coefficients,
+                    int *grad_index) {
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        context, 0, use_locking_, sparse, var));
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        context, 1 + num_m_, use_locking_, sparse, v));
+    if (!var->IsInitialized() || !v->IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables");
+    }
+    if (var->shape() != v->shape()) {
+      return errors::InvalidArgument(
+          "var and v should have the same shape, got ",
+          var->shape().DebugString(), " and ", v->shape().DebugString());
+    }
+    if (has_m()) {
+      TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+          context, 1, use_locking_, sparse, m));
+      if (!m->IsInitialized()) {
+        return errors::FailedPrecondition(
+            "Attempting to use uninitialized variables");
+      }
+      if (var->shape() != m->shape()) {
+        return errors::InvalidArgument(
+            "var and m should have the same shape, got ",
+            var->shape().DebugString(), " and ", m->shape().DebugString());
+      }
+    }
+
+    const int first = 2 + num_m_;
+    T beta_1_power, beta_2_power;
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first, "beta_1_power", &beta_1_power));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 1, "beta_2_power", &beta_2_power));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 2, "lr", &coefficients->lr));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 3, "beta_1", &coefficients->beta_1));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 4, "beta_2", &coefficients->beta_2));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 5, "epsilon", &coefficients->epsilon));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 6, "l1", &coefficients->l1));
+    TF_RETURN_IF_ERROR(
+        GetScalarInput(context, first + 7, "l2", &coefficients->l2));
+    coefficients->lr *=
+        std::sqrt(T(1) - beta_2_power) / (T(1) - beta_1_power);
+    coefficients->tanh_activation = tanh_activation_;
+    *grad_index = first + 8;
+    return Status::OK();
+  }
+
+  static Eigen::TensorOpCost ElementCost() {
+    return Eigen::TensorOpCost(4 * sizeof(T), 3 * sizeof(T),
+                               20 * Eigen::TensorOpCost::AddCost<T>());
+  }
+
+  bool use_locking_;
+
+ private:
+  int num_m_;
+  bool tanh_activation_;
+};
+
+template <typename T>
+class ResourceApplyYogiOp : public YogiOpBase<T> {
+ public:
+  explicit ResourceApplyYogiOp(OpKernelConstruction *context)
+      : YogiOpBase<T>(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, this->use_locking_, false, this->VariableInputs());
+    Tensor var, m, v;
+    YogiCoefficients<T> coefficients;
+    int grad_index;
+    OP_REQUIRES_OK(context, this->ReadInputs(context, false, &var, &m, &v,
+                                             &coefficients, &grad_index));
+    const Tensor &grad = context->input(grad_index);
+    OP_REQUIRES(context, grad.shape() == var.shape(),
+                errors::InvalidArgument(
+                    "var and grad should have the same shape, got ",
+                    var.shape().DebugString(), " and ",
+                    grad.shape().DebugString()));
+
+    const T *grad_data = grad.flat<T>().data();
+    T *var_data = var.flat<T>().data();
+    T *m_data = this->has_m() ? m.flat<T>().data() : nullptr;
+    T *v_data = v.flat<T>().data();
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    device.parallelFor(
+        var.NumElements(), this->ElementCost(), [&](int64 start, int64 end) {
+          YogiUpdate(coefficients, false, grad_data + start, var_data + start,
+                     m_data ? m_data + start : nullptr, v_data + start,
+                     end - start);
+        });
+  }
+};
+
+// Only the rows in `indices` of `var` and `v` are updated, but all of `m` is
+// decayed, as the Python implementation does. Indices must be unique.
+template <typename T, typename Tindex>
+class ResourceSparseApplyYogiOp : public YogiOpBase<T> {
+ public:
+  explicit ResourceSparseApplyYogiOp(OpKernelConstruction *context)
+      : YogiOpBase<T>(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        context, this->use_locking_, true, this->VariableInputs());
+    Tensor var, m, v;
+    YogiCoefficients<T> coefficients;
+    int grad_index;
+    OP_REQUIRES_OK(context, this->ReadInputs(context, true, &var, &m, &v,
+                                             &coefficients, &grad_index));
+    const Tensor &grad = context->input(grad_index);
+    const Tensor &indices = context->input(grad_index + 1);
+    int64 row_size;
+    OP_REQUIRES_OK(context, ValidateSparseUpdate<Tindex>(var, grad, indices,
+                                                         &row_size));
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    T *m_data = nullptr;
+    if (this->has_m()) {
+      m_data = m.flat<T>().data();
+      const T beta_1 = coefficients.beta_1;
+      device.parallelFor(m.NumElements(),
+                         Eigen::TensorOpCost(sizeof(T), sizeof(T),
+                                             Eigen::TensorOpCost::MulCost<T>()),
+                         [&](int64 start, int64 end) {
+                           for (int64 k = start; k < end; ++k) {
+                             m_data[k] *= beta_1;
+                           }
+                         });
+    }
+
+    const auto indices_vec = indices.vec<Tindex>();
+    const T *grad_data = grad.flat<T>().data();
+    T *var_data = var.flat<T>().data();
+    T *v_data = v.flat<T>().data();
+    device.parallelFor(
+        indices.NumElements(), this->ElementCost() * row_size,
+        [&](int64 start, int64 end) {
+          for (int64 i = start; i < end; ++i) {
+            const int64 offset = static_cast<int64>(indices_vec(i)) * row_size;
+            YogiUpdate(coefficients, true, grad_data + i * row_size,
+                       var_data + offset, m_data ? m_data + offset : nullptr,
+                       v_data + offset, row_size);
+          }
+        });
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                        \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceApplyYogi")            \
+                              .Device(DEVICE_CPU)                     \
+                              .TypeConstraint<T>("T"),                \
+                          ResourceApplyYogiOp<T>);                    \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceSparseApplyYogi")      \
+                              .Device(DEVICE_CPU)                     \
+                              .TypeConstraint<T>("T")                 \
+                              .TypeConstraint<int32>("Tindices"),     \
+                          ResourceSparseApplyYogiOp<T, int32>);       \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ResourceSparseApplyYogi")      \
+                              .Device(DEVICE_CPU)                     \
+                              .TypeConstraint<T>("T")                 \
+                              .TypeConstraint<int64>("Tindices"),     \
+                          ResourceSparseApplyYogiOp<T, int64>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
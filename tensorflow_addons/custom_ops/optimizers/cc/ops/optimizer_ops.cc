@@ -0,0 +1,285 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+namespace {
+
+// Checks that the inputs [first, num_inputs) are scalars.
+Status TrailingScalarsShapeFn(InferenceContext* c, int first) {
+  ShapeHandle unused;
+  for (int i = first; i < c->num_inputs(); ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+  }
+  return Status::OK();
+}
+
+// Checks that the `count` inputs starting at `first` are scalars, and, if
+// `sparse`, that they are followed by a gradient with at least one dimension
+// and a vector of indices.
+Status ScalarsThenGradShapeFn(InferenceContext* c, int first, int count,
+                              bool sparse) {
+  ShapeHandle unused;
+  for (int i = first; i < first + count; ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+  }
+  if (sparse) {
+    TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(first + count), 1, &unused));
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(first + count + 1), 1, &unused));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("Addons>ResourceApplyLambMulti")
+    .Input("var: N * resource")
+    .Input("m: N * resource")
+    .Input("v: N * resource")
+    .Input("grad: N * T")
+    .Input("lr: T")
+    .Input("beta_1: T")
+    .Input("beta_2: T")
+    .Input("epsilon: T")
+    .Input("weight_decay_rate: T")
+    .Input("beta_1_power: T")
+    .Input("beta_2_power: T")
+    .Attr("N: int >= 1")
+    .Attr("T: {float, double}")
+    .Attr("use_weight_decay: list(bool)")
+    .Attr("use_layer_adaptation: list(bool)")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int n;
+      TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+      return TrailingScalarsShapeFn(c, 4 * n);
+    })
+    .Doc(R"doc(
+Applies one LAMB step to `N` variables and their `m` and `v` slots.
+
+Each tensor is read twice: once to update the slots and accumulate the norms
+of the variable and of its update, and once to apply the trust ratio scaled
+update. Blocks of all tensors are sharded over the same thread pool.
+
+use_weight_decay: Whether weight decay applies to each variable.
+use_layer_adaptation: Whether the trust ratio applies to each variable.
+)doc");
+
+REGISTER_OP("Addons>ResourceSparseApplyLazyAdam")
+    .Input("var: resource")
+    .Input("m: resource")
+    .Input("v: resource")
+    .Input("beta_1_power: T")
+    .Input("beta_2_power: T")
+    .Input("lr: T")
+    .Input("beta_1: T")
+    .Input("beta_2: T")
+    .Input("epsilon: T")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      for (int i = 3; i < 9; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(9), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(10), 1, &unused));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Applies one LazyAdam step to the rows of `var`, `m` and `v` in `indices`.
+
+Gradients of repeated indices are summed, then every distinct row is loaded
+and written back once. Rows are sharded over the CPU thread pool.
+)doc");
+
+REGISTER_OP("Addons>ResourceApplyNovoGrad")
+    .Input("var: resource")
+    .Input("m: resource")
+    .Input("v: resource")
+    .Input("vhat: num_vhat * resource")
+    .Input("step: int64")
+    .Input("lr: T")
+    .Input("beta_1: T")
+    .Input("beta_2: T")
+    .Input("epsilon: T")
+    .Input("weight_decay: T")
+    .Input("grad_averaging: bool")
+    .Input("grad: T")
+    .Attr("T: {float, double}")
+    .Attr("num_vhat: int >= 0")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int num_vhat;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_vhat", &num_vhat));
+      return ScalarsThenGradShapeFn(c, 3 + num_vhat, 7, false);
+    })
+    .Doc(R"doc(
+Applies one NovoGrad step to `var`, its `m` slot and its scalar `v` slot.
+
+The squared norm of `grad` is reduced over the CPU thread pool, then the
+normalized, decayed and averaged gradient is folded into `m` and `var` in one
+pass, without temporaries of the size of the variable.
+
+vhat: One `vhat` slot with amsgrad, none otherwise.
+step: The number of steps already taken; `v` is reset to the squared norm of
+  `grad` on step 0.
+)doc");
+
+REGISTER_OP("Addons>ResourceSparseApplyNovoGrad")
+    .Input("var: resource")
+    .Input("m: resource")
+    .Input("v: resource")
+    .Input("vhat: num_vhat * resource")
+    .Input("step: int64")
+    .Input("lr: T")
+    .Input("beta_1: T")
+    .Input("beta_2: T")
+    .Input("epsilon: T")
+    .Input("weight_decay: T")
+    .Input("grad_averaging: bool")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("num_vhat: int >= 0")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int num_vhat;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_vhat", &num_vhat));
+      return ScalarsThenGradShapeFn(c, 3 + num_vhat, 7, true);
+    })
+    .Doc(R"doc(
+Applies one NovoGrad step to the rows of `var` and `m` in `indices`.
+
+`v` is updated from the squared norm of the sparse gradient. With amsgrad,
+`vhat` is a running maximum over the whole tensor. Indices must be unique.
+
+vhat: One `vhat` slot with amsgrad, none otherwise.
+step: The number of steps already taken; `v` is reset to the squared norm of
+  `grad` on step 0.
+)doc");
+
+REGISTER_OP("Addons>ResourceApplyYogi")
+    .Input("var: resource")
+    .Input("m: num_m * resource")
+    .Input("v: resource")
+    .Input("beta_1_power: T")
+    .Input("beta_2_power: T")
+    .Input("lr: T")
+    .Input("beta_1: T")
+    .Input("beta_2: T")
+    .Input("epsilon: T")
+    .Input("l1: T")
+    .Input("l2: T")
+    .Input("grad: T")
+    .Attr("T: {float, double}")
+    .Attr("num_m: int >= 0")
+    .Attr("activation: {'sign', 'tanh'} = 'sign'")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int num_m;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_m", &num_m));
+      return ScalarsThenGradShapeFn(c, 2 + num_m, 8, false);
+    })
+    .Doc(R"doc(
+Applies one Yogi step to `var` and its `m` and `v` slots.
+
+The moments, the variable and its L1 proximal step or L2 shrinkage are
+updated element by element in a single pass.
+
+m: One `m` slot when beta_1 > 0, none otherwise.
+activation: Whether `v` moves by the sign of `g^2 - v` or by
+  `tanh(10 (g^2 - v))`.
+)doc");
+
+REGISTER_OP("Addons>ResourceSparseApplyYogi")
+    .Input("var: resource")
+    .Input("m: num_m * resource")
+    .Input("v: resource")
+    .Input("beta_1_power: T")
+    .Input("beta_2_power: T")
+    .Input("lr: T")
+    .Input("beta_1: T")
+    .Input("beta_2: T")
+    .Input("epsilon: T")
+    .Input("l1: T")
+    .Input("l2: T")
+    .Input("grad: T")
+    .Input("indices: Tindices")
+    .Attr("T: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("num_m: int >= 0")
+    .Attr("activation: {'sign', 'tanh'} = 'sign'")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int num_m;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_m", &num_m));
+      return ScalarsThenGradShapeFn(c, 2 + num_m, 8, true);
+    })
+    .Doc(R"doc(
+Applies one Yogi step to the rows of `var` and `v` in `indices`.
+
+All of `m` is decayed by `beta_1` before the rows in `indices` are updated,
+as in the dense step. Indices must be unique.
+
+m: One `m` slot when beta_1 > 0, none otherwise.
+activation: Whether `v` moves by the sign of `g^2 - v` or by
+  `tanh(10 (g^2 - v))`.
+)doc");
+
+REGISTER_OP("Addons>MultiTensorAverage")
+    .Input("var: N * resource")
+    .Input("average: N * resource")
+    .Input("decay: T")
+    .Attr("N: int >= 1")
+    .Attr("T: {float, double}")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int n;
+      TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+      return TrailingScalarsShapeFn(c, 2 * n);
+    })
+    .Doc(R"doc(
+Sets `average = decay * average + (1 - decay) * var` for `N` variables.
+
+A fixed decay gives an exponential moving average, and decay = n / (n + 1) a
+running mean over n snapshots. Blocks of all tensors are sharded over the CPU
+thread pool; nothing is written when decay is 1.
+)doc");
+
+REGISTER_OP("Addons>MultiTensorSwap")
+    .Input("a: N * resource")
+    .Input("b: N * resource")
+    .Attr("N: int >= 1")
+    .Attr("dtype: {float, double}")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Swaps the values of `N` pairs of variables in place.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
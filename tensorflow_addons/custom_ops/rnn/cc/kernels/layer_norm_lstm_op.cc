@@ -0,0 +1,425 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <cmath>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+template <typename T>
+using Array = Eigen::Array<T, Eigen::Dynamic, 1>;
+
+template <typename T>
+using ConstArrayMap = Eigen::Map<const Array<T>>;
+
+template <typename T>
+using ArrayMap = Eigen::Map<Array<T>>;
+
+// The inputs shared by the step and its gradient, in order.
+enum Input {
+  kX,
+  kHPrev,
+  kCPrev,
+  kKernel,
+  kRecurrentKernel,
+  kBias,
+  kKernelGamma,
+  kKernelBeta,
+  kRecurrentGamma,
+  kRecurrentBeta,
+  kStateGamma,
+  kStateBeta,
+  kNumInputs
+};
+
+// Computes `out = a * b` on the thread pool, transposing `a` or `b` first
+// when requested.
+template <typename T>
+void MatMul(const CPUDevice &device, typename TTypes<T>::ConstMatrix a,
+            bool transpose_a, typename TTypes<T>::ConstMatrix b,
+            bool transpose_b, typename TTypes<T>::Matrix out) {
+  Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dims;
+  dims[0] = Eigen::IndexPair<Eigen::DenseIndex>(transpose_a ? 0 : 1,
+                                                transpose_b ? 1 : 0);
+  out.device(device) = a.contract(b, dims);
+}
+
+// Normalizes `x` to zero mean and unit variance, like
+// `tf.keras.layers.LayerNormalization` before the gain and offset, and
+// returns the inverse standard deviation.
+template <typename T>
+T Normalize(const ConstArrayMap<T> &x, T epsilon, Array<T> *x_hat) {
+  const T mean = x.mean();
+  const T variance = (x - mean).square().mean();
+  const T inv_std = T(1) / std::sqrt(variance + epsilon);
+  *x_hat = (x - mean) * inv_std;
+  return inv_std;
+}
+
+// Backpropagates the gradient `dx_hat` of the normalized `x_hat` to `x`.
+template <typename T>
+Array<T> NormalizeGrad(const Array<T> &x_hat, T inv_std,
+                       const Array<T> &dx_hat) {
+  return inv_std *
+         (dx_hat - dx_hat.mean() - x_hat * (dx_hat * x_hat).mean());
+}
+
+template <typename T>
+Array<T> Sigmoid(const Array<T> &x) {
+  return T(1) / (T(1) + (-x).exp());
+}
+
+// The sizes and the bias and layer normalization parameters of a step.
+template <typename T>
+struct LSTMParams {
+  int64 batch_size;
+  int64 input_size;
+  int64 units;
+  T epsilon;
+  const T *bias;
+  const T *kernel_gamma;
+  const T *kernel_beta;
+  const T *recurrent_gamma;
+  const T *recurrent_beta;
+  const T *state_gamma;
+  const T *state_beta;
+
+  ConstArrayMap<T> Gates(const T *data) const {
+    return ConstArrayMap<T>(data, 4 * units);
+  }
+  ConstArrayMap<T> Units(const T *data) const {
+    return ConstArrayMap<T>(data, units);
+  }
+};
+
+// Checks the shapes of the inputs of a step and collects its parameters.
+template <typename T>
+Status GetParams(OpKernelContext *context, float epsilon,
+                 LSTMParams<T> *params) {
+  const Tensor &x = context->input(kX);
+  const Tensor &kernel = context->input(kKernel);
+  const Tensor &recurrent_kernel = context->input(kRecurrentKernel);
+  if (!TensorShapeUtils::IsMatrix(x.shape()) ||
+      !TensorShapeUtils::IsMatrix(kernel.shape()) ||
+      !TensorShapeUtils::IsMatrix(recurrent_kernel.shape())) {
+    return errors::InvalidArgument(
+        "x, kernel and recurrent_kernel must be matrices, got ",
+        x.shape().DebugString(), ", ", kernel.shape().DebugString(), " and ",
+        recurrent_kernel.shape().DebugString());
+  }
+  const int64 batch_size = x.dim_size(0);
+  const int64 input_size = x.dim_size(1);
+  const int64 units = recurrent_kernel.dim_size(0);
+  const TensorShape state_shape({batch_size, units});
+  const TensorShape gates_shape({4 * units});
+  const TensorShape expected[kNumInputs] = {
+      x.shape(),   state_shape, state_shape, {input_size, 4 * units},
+      {units, 4 * units},       gates_shape, gates_shape, gates_shape,
+      gates_shape, gates_shape, {units},     {units}};
+  for (int i = 0; i < kNumInputs; ++i) {
+    if (context->input(i).shape() != expected[i]) {
+      return errors::InvalidArgument(
+          "Input ", i, " should have shape ", expected[i].DebugString(),
+          ", got ", context->input(i).shape().DebugString());
+    }
+  }
+  params->batch_size = batch_size;
+  params->input_size = input_size;
+  params->units = units;
+  params->epsilon = static_cast<T>(epsilon);
+  params->bias = context->input(kBias).flat<T>().data();
+  params->kernel_gamma = context->input(kKernelGamma).flat<T>().data();
+  params->kernel_beta = context->input(kKernelBeta).flat<T>().data();
+  params->recurrent_gamma = context->input(kRecurrentGamma).flat<T>().data();
+  params->recurrent_beta = context->input(kRecurrentBeta).flat<T>().data();
+  params->state_gamma = context->input(kStateGamma).flat<T>().data();
+  params->state_beta = context->input(kStateBeta).flat<T>().data();
+  return Status::OK();
+}
+
+// The intermediate values of one example of a step. The backward pass
+// recomputes them from the projections saved by the forward pass.
+template <typename T>
+struct LSTMRow {
+  Array<T> kernel_hat, recurrent_hat;
+  T kernel_inv_std, recurrent_inv_std;
+  // The input, forget, candidate and output gates after their activations.
+  Array<T> gates;
+  Array<T> state_hat;
+  T state_inv_std;
+  Array<T> c;
+  Array<T> c_tanh;
+
+  void Compute(const LSTMParams<T> &p, const T *kernel_projection,
+               const T *recurrent_projection, const T *c_prev) {
+    const int64 units = p.units;
+    kernel_inv_std =
+        Normalize(p.Gates(kernel_projection), p.epsilon, &kernel_hat);
+    recurrent_inv_std =
+        Normalize(p.Gates(recurrent_projection), p.epsilon, &recurrent_hat);
+    gates = kernel_hat * p.Gates(p.kernel_gamma) + p.Gates(p.kernel_beta) +
+            recurrent_hat * p.Gates(p.recurrent_gamma) +
+            p.Gates(p.recurrent_beta) + p.Gates(p.bias);
+    gates.head(2 * units) = Sigmoid<T>(gates.head(2 * units));
+    gates.segment(2 * units, units) = gates.segment(2 * units, units).tanh();
+    gates.tail(units) = Sigmoid<T>(gates.tail(units));
+    const Array<T> state =
+        gates.segment(units, units) * p.Units(c_prev) +
+        gates.head(units) * gates.segment(2 * units, units);
+    state_inv_std = Normalize(ConstArrayMap<T>(state.data(), units),
+                              p.epsilon, &state_hat);
+    c = state_hat * p.Units(p.state_gamma) + p.Units(p.state_beta);
+    c_tanh = c.tanh();
+  }
+};
+
+}  // namespace
+
+// Runs one step of a layer normalized LSTM. After the input and recurrent
+// projections, which are computed as two GEMMs on the thread pool, the
+// layer normalization of both projections, the gate activations, the state
+// update and the layer normalization of the new state are fused into one
+// pass over every example. The projections are also returned, so that the
+// gradient recomputes the rest without repeating the GEMMs.
+template <typename T>
+class LayerNormLSTMBlockCellOp : public OpKernel {
+ public:
+  explicit LayerNormLSTMBlockCellOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    LSTMParams<T> p;
+    OP_REQUIRES_OK(context, GetParams(context, epsilon_, &p));
+    const int64 units = p.units;
+    Tensor *h = nullptr;
+    Tensor *c = nullptr;
+    Tensor *kernel_projection = nullptr;
+    Tensor *recurrent_projection = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({p.batch_size, units}), &h));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, TensorShape({p.batch_size, units}), &c));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                2, TensorShape({p.batch_size, 4 * units}),
+                                &kernel_projection));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                3, TensorShape({p.batch_size, 4 * units}),
+                                &recurrent_projection));
+    if (p.batch_size == 0 || units == 0) {
+      return;
+    }
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    MatMul<T>(device, context->input(kX).matrix<T>(), false,
+              context->input(kKernel).matrix<T>(), false,
+              kernel_projection->matrix<T>());
+    MatMul<T>(device, context->input(kHPrev).matrix<T>(), false,
+              context->input(kRecurrentKernel).matrix<T>(), false,
+              recurrent_projection->matrix<T>());
+
+    const T *kernel_data = kernel_projection->flat<T>().data();
+    const T *recurrent_data = recurrent_projection->flat<T>().data();
+    const T *c_prev = context->input(kCPrev).flat<T>().data();
+    T *h_data = h->flat<T>().data();
+    T *c_data = c->flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      LSTMRow<T> row;
+      for (int64 b = start; b < end; ++b) {
+        row.Compute(p, kernel_data + b * 4 * units,
+                    recurrent_data + b * 4 * units, c_prev + b * units);
+        ArrayMap<T>(c_data + b * units, units) = row.c;
+        ArrayMap<T>(h_data + b * units, units) =
+            row.gates.tail(units) * row.c_tanh;
+      }
+    };
+    const Eigen::TensorOpCost cost(10 * units * sizeof(T),
+                                   2 * units * sizeof(T), 80 * units);
+    device.parallelFor(p.batch_size, cost, work);
+  }
+
+ private:
+  float epsilon_;
+};
+
+// Backpropagates the gradients of `h` and `c` through a step. The elementwise
+// part runs over the examples in parallel and keeps the per-example terms of
+// the parameter gradients, which are then summed in order; the gradients of
+// the inputs and weights are four GEMMs on the thread pool.
+template <typename T>
+class LayerNormLSTMBlockCellGradOp : public OpKernel {
+ public:
+  explicit LayerNormLSTMBlockCellGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    LSTMParams<T> p;
+    OP_REQUIRES_OK(context, GetParams(context, epsilon_, &p));
+    const int64 batch_size = p.batch_size;
+    const int64 units = p.units;
+    const TensorShape projection_shape({batch_size, 4 * units});
+    const TensorShape state_shape({batch_size, units});
+    const Tensor &kernel_projection = context->input(kNumInputs);
+    const Tensor &recurrent_projection = context->input(kNumInputs + 1);
+    const Tensor &h_grad = context->input(kNumInputs + 2);
+    const Tensor &c_grad = context->input(kNumInputs + 3);
+    OP_REQUIRES(context,
+                kernel_projection.shape() == projection_shape &&
+                    recurrent_projection.shape() == projection_shape,
+                errors::InvalidArgument("The projections should have shape ",
+                                        projection_shape.DebugString()));
+    OP_REQUIRES(context,
+                h_grad.shape() == state_shape && c_grad.shape() == state_shape,
+                errors::InvalidArgument("h_grad and c_grad should have shape ",
+                                        state_shape.DebugString()));
+
+    Tensor *grads[kNumInputs];
+    for (int i = 0; i < kNumInputs; ++i) {
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  i, context->input(i).shape(), &grads[i]));
+    }
+    Tensor kernel_grad, recurrent_grad, partials;
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::value,
+                                                   projection_shape,
+                                                   &kernel_grad));
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::value,
+                                                   projection_shape,
+                                                   &recurrent_grad));
+    // For every example, the terms of the gradients of the bias, the gains
+    // of the two projections, the gain of the state and the offset of the
+    // state. The offsets of the projections have the same gradient as the
+    // bias.
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({batch_size, 14 * units}),
+                                          &partials));
+
+    const T *kernel_data = kernel_projection.flat<T>().data();
+    const T *recurrent_data = recurrent_projection.flat<T>().data();
+    const T *c_prev = context->input(kCPrev).flat<T>().data();
+    const T *dh_data = h_grad.flat<T>().data();
+    const T *dc_data = c_grad.flat<T>().data();
+    T *dkernel = kernel_grad.flat<T>().data();
+    T *drecurrent = recurrent_grad.flat<T>().data();
+    T *dc_prev = grads[kCPrev]->flat<T>().data();
+    T *partial_data = partials.flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      LSTMRow<T> row;
+      for (int64 b = start; b < end; ++b) {
+        row.Compute(p, kernel_data + b * 4 * units,
+                    recurrent_data + b * 4 * units, c_prev + b * units);
+        const auto i = row.gates.head(units);
+        const auto f = row.gates.segment(units, units);
+        const auto g = row.gates.segment(2 * units, units);
+        const auto o = row.gates.tail(units);
+        const ConstArrayMap<T> dh(dh_data + b * units, units);
+        const Array<T> dc = ConstArrayMap<T>(dc_data + b * units, units) +
+                            dh * o * (T(1) - row.c_tanh.square());
+        const Array<T> ds = NormalizeGrad<T>(
+            row.state_hat, row.state_inv_std, dc * p.Units(p.state_gamma));
+        ArrayMap<T>(dc_prev + b * units, units) = ds * f;
+
+        ArrayMap<T> partial(partial_data + b * 14 * units, 14 * units);
+        auto dz = partial.head(4 * units);
+        dz.head(units) = ds * g * i * (T(1) - i);
+        dz.segment(units, units) =
+            ds * p.Units(c_prev + b * units) * f * (T(1) - f);
+        dz.segment(2 * units, units) = ds * i * (T(1) - g.square());
+        dz.tail(units) = dh * row.c_tanh * o * (T(1) - o);
+        partial.segment(4 * units, 4 * units) = dz * row.kernel_hat;
+        partial.segment(8 * units, 4 * units) = dz * row.recurrent_hat;
+        partial.segment(12 * units, units) = dc * row.state_hat;
+        partial.tail(units) = dc;
+
+        ArrayMap<T>(dkernel + b * 4 * units, 4 * units) = NormalizeGrad<T>(
+            row.kernel_hat, row.kernel_inv_std, dz * p.Gates(p.kernel_gamma));
+        ArrayMap<T>(drecurrent + b * 4 * units, 4 * units) = NormalizeGrad<T>(
+            row.recurrent_hat, row.recurrent_inv_std,
+            dz * p.Gates(p.recurrent_gamma));
+      }
+    };
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    const Eigen::TensorOpCost cost(14 * units * sizeof(T),
+                                   23 * units * sizeof(T), 160 * units);
+    device.parallelFor(batch_size, cost, work);
+
+    const auto partial_sums = partials.matrix<T>();
+    const auto sum = [&](int64 offset, int64 size, Tensor *out) {
+      auto out_vec = out->flat<T>();
+      for (int64 j = 0; j < size; ++j) {
+        T total(0);
+        for (int64 b = 0; b < batch_size; ++b) {
+          total += partial_sums(b, offset + j);
+        }
+        out_vec(j) = total;
+      }
+    };
+    sum(0, 4 * units, grads[kBias]);
+    sum(0, 4 * units, grads[kKernelBeta]);
+    sum(0, 4 * units, grads[kRecurrentBeta]);
+    sum(4 * units, 4 * units, grads[kKernelGamma]);
+    sum(8 * units, 4 * units, grads[kRecurrentGamma]);
+    sum(12 * units, units, grads[kStateGamma]);
+    sum(13 * units, units, grads[kStateBeta]);
+
+    const Tensor &kernel_grad_ref = kernel_grad;
+    const Tensor &recurrent_grad_ref = recurrent_grad;
+    MatMul<T>(device, kernel_grad_ref.matrix<T>(), false,
+              context->input(kKernel).matrix<T>(), true,
+              grads[kX]->matrix<T>());
+    MatMul<T>(device, context->input(kX).matrix<T>(), true,
+              kernel_grad_ref.matrix<T>(), false, grads[kKernel]->matrix<T>());
+    MatMul<T>(device, recurrent_grad_ref.matrix<T>(), false,
+              context->input(kRecurrentKernel).matrix<T>(), true,
+              grads[kHPrev]->matrix<T>());
+    MatMul<T>(device, context->input(kHPrev).matrix<T>(), true,
+              recurrent_grad_ref.matrix<T>(), false,
+              grads[kRecurrentKernel]->matrix<T>());
+  }
+
+ private:
+  float epsilon_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                          \
+  REGISTER_KERNEL_BUILDER(Name("Addons>LayerNormLSTMBlockCell")         \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          LayerNormLSTMBlockCellOp<T>);                 \
+  REGISTER_KERNEL_BUILDER(Name("Addons>LayerNormLSTMBlockCellGrad")     \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          LayerNormLSTMBlockCellGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,472 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/Eigen/Eigenvalues"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+template <typename T>
+using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+template <typename T>
+using ConstVectorMap = Eigen::Map<const Vector<T>>;
+
+template <typename T>
+using VectorMap = Eigen::Map<Vector<T>>;
+
+// The sizes of a product of a dense `[batch, input_units]` state with a
+// reservoir of `output_units` rows of `row_size` entries each.
+struct ReservoirShape {
+  int64 batch;
+  int64 input_units;
+  int64 output_units;
+  int64 row_size;
+};
+
+// Checks the state and the reservoir, where `indices` and `values` are both
+// `[output_units, row_size]`: row `j` of the reservoir connects the input
+// units `indices[j, :]` to the output unit `j` with weights `values[j, :]`.
+Status GetShape(const Tensor &state, const Tensor &indices,
+                const Tensor &values, ReservoirShape *shape) {
+  if (!TensorShapeUtils::IsMatrix(state.shape())) {
+    return errors::InvalidArgument("state must be a matrix, got ",
+                                   state.shape().DebugString());
+  }
+  if (!TensorShapeUtils::IsMatrix(indices.shape()) ||
+      indices.shape() != values.shape()) {
+    return errors::InvalidArgument(
+        "indices and values must be matrices of the same shape, got ",
+        indices.shape().DebugString(), " and ", values.shape().DebugString());
+  }
+  shape->batch = state.dim_size(0);
+  shape->input_units = state.dim_size(1);
+  shape->output_units = indices.dim_size(0);
+  shape->row_size = indices.dim_size(1);
+  return Status::OK();
+}
+
+Status InvalidIndex(int64 index, const ReservoirShape &shape) {
+  return errors::InvalidArgument("reservoir index ", index,
+                                 " is outside of [0, ", shape.input_units,
+                                 ")");
+}
+
+// Transposes a matrix on the thread pool.
+template <typename T>
+void Transpose(const CPUDevice &device, typename TTypes<T>::ConstMatrix in,
+               typename TTypes<T>::Matrix out) {
+  out.device(device) = in.shuffle(Eigen::array<int, 2>({1, 0}));
+}
+
+}  // namespace
+
+// Multiplies a dense state by a sparse reservoir stored row by row, like a
+// CSR matrix whose rows all have `row_size` entries, so that the row offsets
+// are implicit. The state is transposed first so that every entry of the
+// reservoir scales one contiguous column of the batch; the output units are
+// then computed in parallel, each reading its row of the reservoir once for
+// the whole batch.
+template <typename T, typename Tindices>
+class SparseReservoirMatMulOp : public OpKernel {
+ public:
+  explicit SparseReservoirMatMulOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &state = context->input(0);
+    const Tensor &indices = context->input(1);
+    const Tensor &values = context->input(2);
+    ReservoirShape shape;
+    OP_REQUIRES_OK(context, GetShape(state, indices, values, &shape));
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({shape.batch, shape.output_units}),
+                       &output));
+    if (output->NumElements() == 0) {
+      return;
+    }
+
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    Tensor state_t, output_t;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DataTypeToEnum<T>::value,
+                       TensorShape({shape.input_units, shape.batch}),
+                       &state_t));
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DataTypeToEnum<T>::value,
+                       TensorShape({shape.output_units, shape.batch}),
+                       &output_t));
+    Transpose<T>(device, state.matrix<T>(), state_t.matrix<T>());
+
+    const T *x = state_t.flat<T>().data();
+    const Tindices *index_data = indices.flat<Tindices>().data();
+    const T *value_data = values.flat<T>().data();
+    T *y = output_t.flat<T>().data();
+    std::atomic<bool> valid(true);
+    std::atomic<int64> invalid_index(0);
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 j = start; j < end; ++j) {
+        VectorMap<T> y_row(y + j * shape.batch, shape.batch);
+        y_row.setZero();
+        for (int64 k = j * shape.row_size; k < (j + 1) * shape.row_size; ++k) {
+          const int64 i = static_cast<int64>(index_data[k]);
+          if (i < 0 || i >= shape.input_units) {
+            invalid_index = i;
+            valid = false;
+            return;
+          }
+          y_row += value_data[k] *
+                   ConstVectorMap<T>(x + i * shape.batch, shape.batch);
+        }
+      }
+    };
+    const double row_cost = static_cast<double>(shape.row_size * shape.batch);
+    const Eigen::TensorOpCost cost(sizeof(T) * row_cost,
+                                   sizeof(T) * shape.batch, 2 * row_cost);
+    device.parallelFor(shape.output_units, cost, work);
+    OP_REQUIRES(context, valid, InvalidIndex(invalid_index, shape));
+
+    const Tensor &output_t_ref = output_t;
+    Transpose<T>(device, output_t_ref.matrix<T>(), output->matrix<T>());
+  }
+};
+
+// Computes the gradients of SparseReservoirMatMul with respect to the state
+// and the values of the reservoir. The state gradient scatters into the row
+// of its example, so it is sharded over examples; the gradient of every
+// value is a dot product over the batch, so it is sharded over the rows of
+// the reservoir. Both are deterministic.
+template <typename T, typename Tindices>
+class SparseReservoirMatMulGradOp : public OpKernel {
+ public:
+  explicit SparseReservoirMatMulGradOp(OpKernelConstruction *context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &state = context->input(0);
+    const Tensor &indices = context->input(1);
+    const Tensor &values = context->input(2);
+    const Tensor &grad = context->input(3);
+    ReservoirShape shape;
+    OP_REQUIRES_OK(context, GetShape(state, indices, values, &shape));
+    const TensorShape output_shape({shape.batch, shape.output_units});
+    OP_REQUIRES(context, grad.shape() == output_shape,
+                errors::InvalidArgument("grad should have shape ",
+                                        output_shape.DebugString(), ", got ",
+                                        grad.shape().DebugString()));
+    Tensor *state_grad = nullptr;
+    Tensor *values_grad = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, state.shape(), &state_grad));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, values.shape(), &values_grad));
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    state_grad->flat<T>().device(device) =
+        state_grad->flat<T>().constant(T(0));
+    values_grad->flat<T>().device(device) =
+        values_grad->flat<T>().constant(T(0));
+    if (grad.NumElements() == 0 || values.NumElements() == 0) {
+      return;
+    }
+
+    const Tindices *index_data = indices.flat<Tindices>().data();
+    const T *value_data = values.flat<T>().data();
+    const int64 num_entries = values.NumElements();
+    std::atomic<bool> valid(true);
+    std::atomic<int64> invalid_index(0);
+    {
+      const T *dy = grad.flat<T>().data();
+      T *dx = state_grad->flat<T>().data();
+      const auto work = [&](int64 start, int64 end) {
+        for (int64 b = start; b < end; ++b) {
+          const T *dy_row = dy + b * shape.output_units;
+          T *dx_row = dx + b * shape.input_units;
+          for (int64 k = 0; k < num_entries; ++k) {
+            const int64 i = static_cast<int64>(index_data[k]);
+            if (i < 0 || i >= shape.input_units) {
+              invalid_index = i;
+              valid = false;
+              return;
+            }
+            dx_row[i] += value_data[k] * dy_row[k / shape.row_size];
+          }
+        }
+      };
+      const Eigen::TensorOpCost cost(
+          (sizeof(T) + sizeof(Tindices)) * num_entries,
+          sizeof(T) * num_entries, 2 * num_entries);
+      device.parallelFor(shape.batch, cost, work);
+    }
+    OP_REQUIRES(context, valid, InvalidIndex(invalid_index, shape));
+
+    Tensor state_t, grad_t;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DataTypeToEnum<T>::value,
+                       TensorShape({shape.input_units, shape.batch}),
+                       &state_t));
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DataTypeToEnum<T>::value,
+                       TensorShape({shape.output_units, shape.batch}),
+                       &grad_t));
+    Transpose<T>(device, state.matrix<T>(), state_t.matrix<T>());
+    Transpose<T>(device, grad.matrix<T>(), grad_t.matrix<T>());
+    const T *x = state_t.flat<T>().data();
+    const T *dy = grad_t.flat<T>().data();
+    T *dvalues = values_grad->flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 j = start; j < end; ++j) {
+        const ConstVectorMap<T> dy_row(dy + j * shape.batch, shape.batch);
+        for (int64 k = j * shape.row_size; k < (j + 1) * shape.row_size; ++k) {
+          const int64 i = static_cast<int64>(index_data[k]);
+          dvalues[k] =
+              dy_row.dot(ConstVectorMap<T>(x + i * shape.batch, shape.batch));
+        }
+      }
+    };
+    const double row_cost = static_cast<double>(shape.row_size * shape.batch);
+    const Eigen::TensorOpCost cost(sizeof(T) * row_cost,
+                                   sizeof(T) * shape.row_size, 2 * row_cost);
+    device.parallelFor(shape.output_units, cost, work);
+  }
+};
+
+// Estimates the spectral radius of a square sparse reservoir with restarted
+// Arnoldi iterations. Every cycle builds an orthonormal basis of the Krylov
+// space of the current vector with `krylov_size` products by the reservoir,
+// each sharded over its rows, and takes the largest magnitude among the
+// eigenvalues of the small Hessenberg matrix. The next cycle restarts from
+// the corresponding Ritz vector, until the estimate changes by less than
+// `tolerance` relatively or `max_restarts` cycles were run. The reservoir is
+// transposed by its storage, which leaves its eigenvalues unchanged.
+template <typename T, typename Tindices>
+class ReservoirSpectralRadiusOp : public OpKernel {
+ public:
+  explicit ReservoirSpectralRadiusOp(OpKernelConstruction *context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("krylov_size", &krylov_size_));
+    OP_REQUIRES_OK(context, context->GetAttr("max_restarts", &max_restarts_));
+    OP_REQUIRES_OK(context, context->GetAttr("tolerance", &tolerance_));
+    OP_REQUIRES_OK(context, context->GetAttr("seed", &seed_));
+  }
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &indices = context->input(0);
+    const Tensor &values = context->input(1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsMatrix(indices.shape()) &&
+                    indices.shape() == values.shape(),
+                errors::InvalidArgument(
+                    "indices and values must be matrices of the same shape, "
+                    "got ",
+                    indices.shape().DebugString(), " and ",
+                    values.shape().DebugString()));
+    ReservoirShape shape;
+    shape.batch = 1;
+    shape.input_units = indices.dim_size(0);
+    shape.output_units = indices.dim_size(0);
+    shape.row_size = indices.dim_size(1);
+    const auto index_vec = indices.flat<Tindices>();
+    for (int64 k = 0; k < index_vec.size(); ++k) {
+      const int64 i = static_cast<int64>(index_vec(k));
+      OP_REQUIRES(context, i >= 0 && i < shape.input_units,
+                  InvalidIndex(i, shape));
+    }
+    Tensor *output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({}), &output));
+    output->scalar<T>()() = static_cast<T>(SpectralRadius(context, shape));
+  }
+
+ private:
+  typedef Eigen::MatrixXd Matrix;
+
+  double SpectralRadius(OpKernelContext *context,
+                        const ReservoirShape &shape) const {
+    const int64 units = shape.output_units;
+    if (units == 0 || shape.row_size == 0) {
+      return 0.0;
+    }
+    const Tindices *index_data = context->input(0).flat<Tindices>().data();
+    const T *value_data = context->input(1).flat<T>().data();
+    const CPUDevice &device = context->eigen_device<CPUDevice>();
+    const Eigen::TensorOpCost cost(
+        (sizeof(T) + sizeof(Tindices) + sizeof(double)) * shape.row_size,
+        sizeof(double), 2 * shape.row_size);
+    const auto matvec = [&](const double *x, double *y) {
+      device.parallelFor(units, cost, [&](int64 start, int64 end) {
+        for (int64 j = start; j < end; ++j) {
+          double total = 0.0;
+          for (int64 k = j * shape.row_size; k < (j + 1) * shape.row_size;
+               ++k) {
+            total += static_cast<double>(value_data[k]) * x[index_data[k]];
+          }
+          y[j] = total;
+        }
+      });
+    };
+
+    const int64 size = std::min<int64>(krylov_size_, units);
+    Matrix basis(units, size + 1);
+    Matrix hessenberg(size + 1, size);
+    Eigen::VectorXd start = StartVector(units);
+    double estimate = 0.0;
+    for (int restart = 0; restart < std::max(max_restarts_, 1); ++restart) {
+      basis.col(0) = start.normalized();
+      hessenberg.setZero();
+      int64 steps = size;
+      for (int64 k = 0; k < size; ++k) {
+        auto w = basis.col(k + 1);
+        matvec(basis.col(k).data(), w.data());
+        const double norm = w.norm();
+        // Gram-Schmidt twice keeps the basis orthogonal to working precision.
+        for (int pass = 0; pass < 2; ++pass) {
+          const Eigen::VectorXd h = basis.leftCols(k + 1).transpose() * w;
+          w -= basis.leftCols(k + 1) * h;
+          hessenberg.col(k).head(k + 1) += h;
+        }
+        hessenberg(k + 1, k) = w.norm();
+        if (hessenberg(k + 1, k) <=
+            std::numeric_limits<double>::epsilon() * 100 * norm) {
+          // The Krylov space is invariant, so its eigenvalues are exact.
+          steps = k + 1;
+          break;
+        }
+        w /= hessenberg(k + 1, k);
+      }
+
+      Eigen::EigenSolver<Matrix> solver(
+          hessenberg.topLeftCorner(steps, steps));
+      if (solver.info() != Eigen::Success) {
+        // Without a first estimate from the Hessenberg matrix, the growth
+        // rate of the power iteration is used instead.
+        if (restart == 0) {
+          estimate = PowerIterationRadius(
+              matvec, start, std::max(max_restarts_, 1) * size);
+        }
+        break;
+      }
+      Eigen::Index largest;
+      const double previous = estimate;
+      estimate = solver.eigenvalues().cwiseAbs().maxCoeff(&largest);
+      if (steps < size ||
+          std::abs(estimate - previous) <= tolerance_ * estimate) {
+        break;
+      }
+      // A complex Ritz vector stands for the real invariant plane spanned by
+      // its real and imaginary parts, so both are kept.
+      const Eigen::VectorXcd ritz =
+          basis.leftCols(steps) * solver.eigenvectors().col(largest);
+      start = ritz.real() + ritz.imag();
+    }
+    return estimate;
+  }
+
+  // Estimates the spectral radius as the mean growth rate of the norm of the
+  // iterates over the second half of `steps` power iterations. Unlike the
+  // iterates themselves, the growth rate also converges when the dominant
+  // eigenvalues are a complex pair.
+  template <typename Matvec>
+  double PowerIterationRadius(const Matvec &matvec, Eigen::VectorXd x,
+                              int64 steps) const {
+    Eigen::VectorXd y(x.size());
+    x.normalize();
+    double log_growth = 0.0;
+    for (int64 step = 0; step < steps; ++step) {
+      matvec(x.data(), y.data());
+      const double norm = y.norm();
+      if (norm == 0.0) {
+        // The reservoir is nilpotent on the Krylov space of the start vector.
+        return 0.0;
+      }
+      if (2 * step >= steps) {
+        log_growth += std::log(norm);
+      }
+      x = y / norm;
+    }
+    return std::exp(log_growth / (steps - steps / 2));
+  }
+
+  // A pseudorandom vector, so that it has a component along the dominant
+  // eigenvectors of any reservoir.
+  Eigen::VectorXd StartVector(int64 units) const {
+    Eigen::VectorXd start(units);
+    random::PhiloxRandom generator(seed_, 0);
+    random::PhiloxRandom::ResultType bits;
+    for (int64 i = 0; i < units; ++i) {
+      if (i % 4 == 0) {
+        bits = generator();
+      }
+      start(i) = static_cast<double>(bits[i % 4]) / 4294967296.0 - 0.5;
+    }
+    return start;
+  }
+
+  int32 krylov_size_;
+  int32 max_restarts_;
+  float tolerance_;
+  int64 seed_;
+};
+
+#define REGISTER_CPU_KERNEL(T, Tindices)                                  \
+  REGISTER_KERNEL_BUILDER(Name("Addons>SparseReservoirMatMul")            \
+                              .Device(DEVICE_CPU)                         \
+                              .TypeConstraint<T>("T")                     \
+                              .TypeConstraint<Tindices>("Tindices"),      \
+                          SparseReservoirMatMulOp<T, Tindices>);          \
+  REGISTER_KERNEL_BUILDER(Name("Addons>SparseReservoirMatMulGrad")        \
+                              .Device(DEVICE_CPU)                         \
+                              .TypeConstraint<T>("T")                     \
+                              .TypeConstraint<Tindices>("Tindices"),      \
+                          SparseReservoirMatMulGradOp<T, Tindices>);        \
+  REGISTER_KERNEL_BUILDER(Name("Addons>ReservoirSpectralRadius")          \
+                              .Device(DEVICE_CPU)                         \
+                              .TypeConstraint<T>("T")                     \
+                              .TypeConstraint<Tindices>("Tindices"),      \
+                          ReservoirSpectralRadiusOp<T, Tindices>);
+
+#define REGISTER_CPU_KERNELS(T) \
+  REGISTER_CPU_KERNEL(T, int32); \
+  REGISTER_CPU_KERNEL(T, int64);
+
+REGISTER_CPU_KERNELS(float);
+REGISTER_CPU_KERNELS(double);
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,196 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using ::tensorflow::shape_inference::DimensionHandle;
+using ::tensorflow::shape_inference::InferenceContext;
+using ::tensorflow::shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>LayerNormLSTMBlockCell")
+    .Input("x: T")
+    .Input("h_prev: T")
+    .Input("c_prev: T")
+    .Input("kernel: T")
+    .Input("recurrent_kernel: T")
+    .Input("bias: T")
+    .Input("kernel_gamma: T")
+    .Input("kernel_beta: T")
+    .Input("recurrent_gamma: T")
+    .Input("recurrent_beta: T")
+    .Input("state_gamma: T")
+    .Input("state_beta: T")
+    .Output("h: T")
+    .Output("c: T")
+    .Output("kernel_projection: T")
+    .Output("recurrent_projection: T")
+    .Attr("epsilon: float = 0.001")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x, h_prev, kernel, recurrent_kernel;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &x));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &h_prev));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 2, &kernel));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 2, &recurrent_kernel));
+      DimensionHandle batch_size, units;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(x, 0), c->Dim(h_prev, 0),
+                                  &batch_size));
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(h_prev, 1),
+                                  c->Dim(recurrent_kernel, 0), &units));
+      const ShapeHandle state = c->MakeShape({batch_size, units});
+      const ShapeHandle projection =
+          c->MakeShape({batch_size, c->Dim(kernel, 1)});
+      c->set_output(0, state);
+      c->set_output(1, state);
+      c->set_output(2, projection);
+      c->set_output(3, projection);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+One step of an LSTM with layer normalization.
+
+Computes `z = LN_k(x . kernel) + LN_r(h_prev . recurrent_kernel) + bias`,
+split into the input, forget, candidate and output gates `i, f, g, o`, then
+`c = LN_s(sigmoid(f) * c_prev + sigmoid(i) * tanh(g))` and
+`h = sigmoid(o) * tanh(c)`, where each `LN` normalizes over the last axis
+with its own gain and offset and `epsilon`. Everything after the two
+projections is fused into one pass over every example.
+
+x: `[batch, input_size]`.
+h_prev: `[batch, units]`.
+c_prev: `[batch, units]`.
+kernel: `[input_size, 4 * units]`.
+recurrent_kernel: `[units, 4 * units]`.
+kernel_projection: `x . kernel`, kept for the gradient.
+recurrent_projection: `h_prev . recurrent_kernel`, kept for the gradient.
+)doc");
+
+REGISTER_OP("Addons>LayerNormLSTMBlockCellGrad")
+    .Input("x: T")
+    .Input("h_prev: T")
+    .Input("c_prev: T")
+    .Input("kernel: T")
+    .Input("recurrent_kernel: T")
+    .Input("bias: T")
+    .Input("kernel_gamma: T")
+    .Input("kernel_beta: T")
+    .Input("recurrent_gamma: T")
+    .Input("recurrent_beta: T")
+    .Input("state_gamma: T")
+    .Input("state_beta: T")
+    .Input("kernel_projection: T")
+    .Input("recurrent_projection: T")
+    .Input("h_grad: T")
+    .Input("c_grad: T")
+    .Output("x_grad: T")
+    .Output("h_prev_grad: T")
+    .Output("c_prev_grad: T")
+    .Output("kernel_grad: T")
+    .Output("recurrent_kernel_grad: T")
+    .Output("bias_grad: T")
+    .Output("kernel_gamma_grad: T")
+    .Output("kernel_beta_grad: T")
+    .Output("recurrent_gamma_grad: T")
+    .Output("recurrent_beta_grad: T")
+    .Output("state_gamma_grad: T")
+    .Output("state_beta_grad: T")
+    .Attr("epsilon: float = 0.001")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      for (int i = 0; i < 12; ++i) {
+        c->set_output(i, c->input(i));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of LayerNormLSTMBlockCell with respect to all of its inputs.
+)doc");
+
+REGISTER_OP("Addons>SparseReservoirMatMul")
+    .Input("state: T")
+    .Input("indices: Tindices")
+    .Input("values: T")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle state, indices;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &state));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &indices));
+      TF_RETURN_IF_ERROR(c->Merge(indices, c->input(2), &indices));
+      c->set_output(0, c->MakeShape({c->Dim(state, 0), c->Dim(indices, 0)}));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Multiplies a dense state by a sparse reservoir.
+
+The reservoir is stored row by row like a CSR matrix whose rows all have the
+same number of entries, so that the row offsets are implicit: for a
+`[batch, input_units]` state and `[output_units, row_size]` indices and
+values, `output[b, j] = sum_k values[j, k] * state[b, indices[j, k]]`.
+Duplicate indices in a row are summed.
+)doc");
+
+REGISTER_OP("Addons>SparseReservoirMatMulGrad")
+    .Input("state: T")
+    .Input("indices: Tindices")
+    .Input("values: T")
+    .Input("grad: T")
+    .Output("state_grad: T")
+    .Output("values_grad: T")
+    .Attr("T: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of SparseReservoirMatMul with respect to its state and values.
+)doc");
+
+REGISTER_OP("Addons>ReservoirSpectralRadius")
+    .Input("indices: Tindices")
+    .Input("values: T")
+    .Output("spectral_radius: T")
+    .Attr("krylov_size: int >= 1 = 32")
+    .Attr("max_restarts: int >= 1 = 30")
+    .Attr("tolerance: float = 1e-4")
+    .Attr("seed: int = 0")
+    .Attr("T: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle indices;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &indices));
+      TF_RETURN_IF_ERROR(c->Merge(indices, c->input(1), &indices));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Estimates the spectral radius of a square sparse reservoir.
+
+The reservoir is stored like the one of SparseReservoirMatMul, with
+`[units, row_size]` indices and values. The largest eigenvalue magnitude is
+estimated with restarted Arnoldi iterations of `krylov_size` products by the
+reservoir each, until the estimate changes by less than `tolerance`
+relatively or after `max_restarts` restarts. `seed` seeds the start vector.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
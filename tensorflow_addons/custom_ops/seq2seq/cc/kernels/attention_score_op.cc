@@ -0,0 +1,421 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+template <typename T>
+using Array = Eigen::Array<T, Eigen::Dynamic, 1>;
+
+template <typename T>
+using ConstArrayMap = Eigen::Map<const Array<T>>;
+
+template <typename T>
+using ArrayMap = Eigen::Map<Array<T>>;
+
+// The inputs shared by the op and its gradient, in order.
+enum Input {
+  kQuery,
+  kKeys,
+  kValues,
+  kMask,
+  kAttentionV,
+  kAttentionB,
+  kScale,
+  kNumInputs
+};
+
+// The inputs of one attention step: `[batch, units]` processed queries,
+// `[batch, memory_time, units]` keys and `[batch, memory_time, depth]`
+// values. The score of a query and a key is `scale * query . key` for Luong
+// attention, and `scale * sum(v * tanh(key + query + b))` for Bahdanau
+// attention.
+template <typename T>
+class ScoreInputs {
+ public:
+  ScoreInputs(OpKernelContext *context, bool bahdanau)
+      : context_(context), bahdanau_(bahdanau) {}
+
+  Status Check() {
+    const Tensor &query = context_->input(kQuery);
+    const Tensor &keys = context_->input(kKeys);
+    const Tensor &values = context_->input(kValues);
+    const Tensor &mask = context_->input(kMask);
+    const Tensor &attention_v = context_->input(kAttentionV);
+    const Tensor &attention_b = context_->input(kAttentionB);
+    if (!TensorShapeUtils::IsMatrix(query.shape()) || keys.dims() != 3 ||
+        values.dims() != 3) {
+      return errors::InvalidArgument(
+          "query must have rank 2 and keys and values rank 3, got ",
+          query.shape().DebugString(), ", ", keys.shape().DebugString(),
+          " and ", values.shape().DebugString());
+    }
+    batch_ = query.dim_size(0);
+    units_ = query.dim_size(1);
+    memory_time_ = keys.dim_size(1);
+    depth_ = values.dim_size(2);
+    if (keys.shape() != TensorShape({batch_, memory_time_, units_}) ||
+        values.dim_size(0) != batch_ || values.dim_size(1) != memory_time_) {
+      return errors::InvalidArgument(
+          "keys should be [batch, memory_time, units] and values "
+          "[batch, memory_time, depth] for a query of shape ",
+          query.shape().DebugString(), ", got ", keys.shape().DebugString(),
+          " and ", values.shape().DebugString());
+    }
+    if (mask.NumElements() > 0 &&
+        mask.shape() != TensorShape({batch_, memory_time_})) {
+      return errors::InvalidArgument(
+          "mask should be empty or have shape [", batch_, ", ", memory_time_,
+          "], got ", mask.shape().DebugString());
+    }
+    if (bahdanau_) {
+      if (attention_v.shape() != TensorShape({units_})) {
+        return errors::InvalidArgument("attention_v should have shape [",
+                                       units_, "], got ",
+                                       attention_v.shape().DebugString());
+      }
+      if (attention_b.NumElements() > 0 &&
+          attention_b.shape() != TensorShape({units_})) {
+        return errors::InvalidArgument(
+            "attention_b should be empty or have shape [", units_, "], got ",
+            attention_b.shape().DebugString());
+      }
+    }
+    if (!TensorShapeUtils::IsScalar(context_->input(kScale).shape())) {
+      return errors::InvalidArgument(
+          "scale must be a scalar, got ",
+          context_->input(kScale).shape().DebugString());
+    }
+    masked_ = mask.NumElements() > 0;
+    biased_ = bahdanau_ && attention_b.NumElements() > 0;
+    return Status::OK();
+  }
+
+  int64 batch() const { return batch_; }
+  int64 units() const { return units_; }
+  int64 memory_time() const { return memory_time_; }
+  int64 depth() const { return depth_; }
+  bool biased() const { return biased_; }
+  T scale() const { return context_->input(kScale).scalar<T>()(); }
+
+  ConstArrayMap<T> Query(int64 b) const {
+    return ConstArrayMap<T>(
+        context_->input(kQuery).flat<T>().data() + b * units_, units_);
+  }
+  ConstArrayMap<T> Key(int64 b, int64 t) const {
+    return ConstArrayMap<T>(context_->input(kKeys).flat<T>().data() +
+                                (b * memory_time_ + t) * units_,
+                            units_);
+  }
+  ConstArrayMap<T> Value(int64 b, int64 t) const {
+    return ConstArrayMap<T>(context_->input(kValues).flat<T>().data() +
+                                (b * memory_time_ + t) * depth_,
+                            depth_);
+  }
+  ConstArrayMap<T> AttentionV() const {
+    return ConstArrayMap<T>(context_->input(kAttentionV).flat<T>().data(),
+                            units_);
+  }
+  ConstArrayMap<T> AttentionB() const {
+    return ConstArrayMap<T>(context_->input(kAttentionB).flat<T>().data(),
+                            units_);
+  }
+  bool Masked(int64 b, int64 t) const {
+    return masked_ &&
+           !context_->input(kMask).flat<bool>()(b * memory_time_ + t);
+  }
+
+  // Returns the score before `scale` of query `b` and key `t`. For Bahdanau
+  // attention, `hidden` receives `tanh(key + query + b)`.
+  T Score(int64 b, int64 t, Array<T> *hidden) const {
+    if (!bahdanau_) {
+      return (Query(b) * Key(b, t)).sum();
+    }
+    if (biased_) {
+      *hidden = (Key(b, t) + Query(b) + AttentionB()).tanh();
+    } else {
+      *hidden = (Key(b, t) + Query(b)).tanh();
+    }
+    return (AttentionV() * *hidden).sum();
+  }
+
+  // Computes the masked softmax of the scores of query `b` into
+  // `alignments`, like `softmax` after replacing the masked scores by the
+  // lowest value.
+  void Alignments(int64 b, Array<T> *hidden, T *alignments) const {
+    const T scale = this->scale();
+    T max_score = std::numeric_limits<T>::lowest();
+    for (int64 t = 0; t < memory_time_; ++t) {
+      const T score = Masked(b, t) ? std::numeric_limits<T>::lowest()
+                                   : scale * Score(b, t, hidden);
+      alignments[t] = score;
+      max_score = std::max(max_score, score);
+    }
+    T total(0);
+    for (int64 t = 0; t < memory_time_; ++t) {
+      alignments[t] = std::exp(alignments[t] - max_score);
+      total += alignments[t];
+    }
+    for (int64 t = 0; t < memory_time_; ++t) {
+      alignments[t] /= total;
+    }
+  }
+
+  // The cost of `passes` passes over the memory of an example.
+  Eigen::TensorOpCost ExampleCost(int passes) const {
+    const double size =
+        static_cast<double>(passes * memory_time_ * (units_ + depth_));
+    return Eigen::TensorOpCost(sizeof(T) * size, sizeof(T) * memory_time_,
+                               (bahdanau_ ? 20 : 2) * size);
+  }
+
+ private:
+  OpKernelContext *context_;
+  bool bahdanau_;
+  bool masked_ = false;
+  bool biased_ = false;
+  int64 batch_ = 0;
+  int64 units_ = 0;
+  int64 memory_time_ = 0;
+  int64 depth_ = 0;
+};
+
+class AttentionScoreBase : public OpKernel {
+ public:
+  explicit AttentionScoreBase(OpKernelConstruction *context)
+      : OpKernel(context) {
+    std::string score_fn;
+    OP_REQUIRES_OK(context, context->GetAttr("score_fn", &score_fn));
+    bahdanau_ = score_fn == "bahdanau";
+  }
+
+ protected:
+  bool bahdanau_;
+};
+
+}  // namespace
+
+// Computes the scores of every query against its memory, their masked
+// softmax and the context vector in one pass per example, sharded over the
+// batch.
+template <typename T>
+class AttentionScoreContextOp : public AttentionScoreBase {
+ public:
+  explicit AttentionScoreContextOp(OpKernelConstruction *context)
+      : AttentionScoreBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    ScoreInputs<T> inputs(context, bahdanau_);
+    OP_REQUIRES_OK(context, inputs.Check());
+    Tensor *alignments = nullptr;
+    Tensor *attention = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({inputs.batch(), inputs.memory_time()}),
+                       &alignments));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       1, TensorShape({inputs.batch(), inputs.depth()}),
+                       &attention));
+    const int64 memory_time = inputs.memory_time();
+    const int64 depth = inputs.depth();
+    T *alignment_data = alignments->flat<T>().data();
+    T *attention_data = attention->flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      Array<T> hidden;
+      for (int64 b = start; b < end; ++b) {
+        T *p = alignment_data + b * memory_time;
+        inputs.Alignments(b, &hidden, p);
+        ArrayMap<T> context_row(attention_data + b * depth, depth);
+        context_row.setZero();
+        for (int64 t = 0; t < memory_time; ++t) {
+          context_row += p[t] * inputs.Value(b, t);
+        }
+      }
+    };
+    context->eigen_device<CPUDevice>().parallelFor(
+        inputs.batch(), inputs.ExampleCost(1), work);
+  }
+};
+
+// Backpropagates the gradients of the alignments and the context through an
+// attention step. The gradients of the queries, keys and values are computed
+// per example; the ones of `attention_v`, `attention_b` and `scale` are
+// summed over the examples in order.
+template <typename T>
+class AttentionScoreContextGradOp : public AttentionScoreBase {
+ public:
+  explicit AttentionScoreContextGradOp(OpKernelConstruction *context)
+      : AttentionScoreBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    ScoreInputs<T> inputs(context, bahdanau_);
+    OP_REQUIRES_OK(context, inputs.Check());
+    const int64 batch = inputs.batch();
+    const int64 units = inputs.units();
+    const int64 memory_time = inputs.memory_time();
+    const int64 depth = inputs.depth();
+    const Tensor &alignments = context->input(kNumInputs);
+    const Tensor &alignments_grad = context->input(kNumInputs + 1);
+    const Tensor &attention_grad = context->input(kNumInputs + 2);
+    const TensorShape alignments_shape({batch, memory_time});
+    OP_REQUIRES(context,
+                alignments.shape() == alignments_shape &&
+                    alignments_grad.shape() == alignments_shape,
+                errors::InvalidArgument(
+                    "alignments and their gradient should have shape ",
+                    alignments_shape.DebugString()));
+    OP_REQUIRES(context,
+                attention_grad.shape() == TensorShape({batch, depth}),
+                errors::InvalidArgument(
+                    "attention_grad should have shape [", batch, ", ", depth,
+                    "], got ", attention_grad.shape().DebugString()));
+
+    Tensor *query_grad = nullptr;
+    Tensor *keys_grad = nullptr;
+    Tensor *values_grad = nullptr;
+    Tensor *attention_v_grad = nullptr;
+    Tensor *attention_b_grad = nullptr;
+    Tensor *scale_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, context->input(kQuery).shape(),
+                                &query_grad));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, context->input(kKeys).shape(), &keys_grad));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                2, context->input(kValues).shape(),
+                                &values_grad));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                3, context->input(kAttentionV).shape(),
+                                &attention_v_grad));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                4, context->input(kAttentionB).shape(),
+                                &attention_b_grad));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(5, TensorShape({}), &scale_grad));
+    // For every example, its terms of the gradients of `scale`,
+    // `attention_v` and `attention_b`.
+    const int64 partial_size = 1 + (bahdanau_ ? 2 * units : 0);
+    Tensor partials;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({batch, partial_size}),
+                                &partials));
+
+    const T scale = inputs.scale();
+    const T *p_data = alignments.flat<T>().data();
+    const T *dp_data = alignments_grad.flat<T>().data();
+    const T *dcontext_data = attention_grad.flat<T>().data();
+    T *dquery_data = query_grad->flat<T>().data();
+    T *dkeys_data = keys_grad->flat<T>().data();
+    T *dvalues_data = values_grad->flat<T>().data();
+    T *partial_data = partials.flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      Array<T> hidden, dscores(memory_time);
+      for (int64 b = start; b < end; ++b) {
+        const T *p = p_data + b * memory_time;
+        const T *dp = dp_data + b * memory_time;
+        const ConstArrayMap<T> dcontext(dcontext_data + b * depth, depth);
+        // The gradient of the alignments, including through the context.
+        T weighted_total(0);
+        for (int64 t = 0; t < memory_time; ++t) {
+          ArrayMap<T>(dvalues_data + (b * memory_time + t) * depth, depth) =
+              p[t] * dcontext;
+          dscores(t) = dp[t] + (dcontext * inputs.Value(b, t)).sum();
+          weighted_total += p[t] * dscores(t);
+        }
+        ArrayMap<T> dquery(dquery_data + b * units, units);
+        ArrayMap<T> partial(partial_data + b * partial_size, partial_size);
+        dquery.setZero();
+        partial.setZero();
+        for (int64 t = 0; t < memory_time; ++t) {
+          ArrayMap<T> dkey(dkeys_data + (b * memory_time + t) * units, units);
+          if (inputs.Masked(b, t)) {
+            dkey.setZero();
+            continue;
+          }
+          const T dscore = p[t] * (dscores(t) - weighted_total);
+          const T score = inputs.Score(b, t, &hidden);
+          partial(0) += dscore * score;
+          const T dbase = scale * dscore;
+          if (bahdanau_) {
+            partial.segment(1, units) += dbase * hidden;
+            dkey = dbase * inputs.AttentionV() * (T(1) - hidden.square());
+            partial.segment(1 + units, units) += dkey;
+            dquery += dkey;
+          } else {
+            dkey = dbase * inputs.Query(b);
+            dquery += dbase * inputs.Key(b, t);
+          }
+        }
+      }
+    };
+    context->eigen_device<CPUDevice>().parallelFor(
+        batch, inputs.ExampleCost(2), work);
+
+    const auto partial_sums = partials.matrix<T>();
+    const auto sum = [&](int64 offset, int64 size, T *out) {
+      for (int64 j = 0; j < size; ++j) {
+        T total(0);
+        for (int64 b = 0; b < batch; ++b) {
+          total += partial_sums(b, offset + j);
+        }
+        out[j] = total;
+      }
+    };
+    sum(0, 1, scale_grad->flat<T>().data());
+    attention_v_grad->flat<T>().setZero();
+    attention_b_grad->flat<T>().setZero();
+    if (bahdanau_) {
+      sum(1, units, attention_v_grad->flat<T>().data());
+      if (inputs.biased()) {
+        sum(1 + units, units, attention_b_grad->flat<T>().data());
+      }
+    }
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                          \
+  REGISTER_KERNEL_BUILDER(Name("Addons>AttentionScoreContext")          \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          AttentionScoreContextOp<T>);                  \
+  REGISTER_KERNEL_BUILDER(Name("Addons>AttentionScoreContextGrad")      \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          AttentionScoreContextGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,259 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// The lower bound of the exclusive cumulative product of `1 - p_choose_i`
+// before dividing by it in the parallel mode.
+constexpr double kMinCumprod = 1e-10;
+
+// The running values of the parallel mode at memory position `i`:
+// `cumprod = exp(sum_{k < i} log(clip(1 - p_k, tiny, 1)))` and
+// `cumsum = sum_{k <= i} previous_k / clip(cumprod_k, kMinCumprod, 1)`.
+template <typename T>
+struct ParallelState {
+  T log_cumprod = T(0);
+  T cumsum = T(0);
+};
+
+template <typename T>
+T ClipCumprod(T cumprod) {
+  return std::max(cumprod, static_cast<T>(kMinCumprod));
+}
+
+// Like `safe_cumprod`, clips `1 - p` to `[tiny, 1]` before its logarithm.
+template <typename T>
+T ClipComplement(T p) {
+  return std::min(std::max(T(1) - p, std::numeric_limits<T>::min()), T(1));
+}
+
+class MonotonicAttentionBase : public OpKernel {
+ public:
+  explicit MonotonicAttentionBase(OpKernelConstruction *context)
+      : OpKernel(context) {
+    std::string mode;
+    OP_REQUIRES_OK(context, context->GetAttr("mode", &mode));
+    OP_REQUIRES(context, mode == "recursive" || mode == "parallel",
+                errors::InvalidArgument(
+                    "mode must be 'recursive' or 'parallel', got ", mode));
+    parallel_ = mode == "parallel";
+  }
+
+ protected:
+  Status CheckInputs(const Tensor &p_choose_i,
+                     const Tensor &previous_attention) const {
+    if (!TensorShapeUtils::IsMatrix(p_choose_i.shape())) {
+      return errors::InvalidArgument("p_choose_i must be a matrix, got ",
+                                     p_choose_i.shape().DebugString());
+    }
+    if (p_choose_i.shape() != previous_attention.shape()) {
+      return errors::InvalidArgument(
+          "p_choose_i and previous_attention should have the same shape, got ",
+          p_choose_i.shape().DebugString(), " and ",
+          previous_attention.shape().DebugString());
+    }
+    return Status::OK();
+  }
+
+  bool parallel_;
+};
+
+}  // namespace
+
+// Computes the expected monotonic attention of every example in one pass over
+// its memory, sharded over the batch. The recursive mode evaluates
+// `q_i = (1 - p_{i-1}) * q_{i-1} + previous_i` and `attention_i = p_i * q_i`
+// exactly; the parallel mode evaluates the closed form of `safe_cumprod` and
+// `cumsum`, with the same clipping, without any temporary.
+template <typename T>
+class MonotonicAttentionOp : public MonotonicAttentionBase {
+ public:
+  explicit MonotonicAttentionOp(OpKernelConstruction *context)
+      : MonotonicAttentionBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &p_choose_i = context->input(0);
+    const Tensor &previous_attention = context->input(1);
+    OP_REQUIRES_OK(context, CheckInputs(p_choose_i, previous_attention));
+    Tensor *attention = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, p_choose_i.shape(),
+                                                     &attention));
+    const int64 memory_time = p_choose_i.dim_size(1);
+    if (attention->NumElements() == 0) {
+      return;
+    }
+
+    const T *p = p_choose_i.flat<T>().data();
+    const T *previous = previous_attention.flat<T>().data();
+    T *a = attention->flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 b = start; b < end; ++b) {
+        const int64 offset = b * memory_time;
+        if (parallel_) {
+          ParallelState<T> state;
+          for (int64 i = 0; i < memory_time; ++i) {
+            const T cumprod = std::exp(state.log_cumprod);
+            state.cumsum += previous[offset + i] / ClipCumprod(cumprod);
+            a[offset + i] = p[offset + i] * cumprod * state.cumsum;
+            state.log_cumprod += std::log(ClipComplement(p[offset + i]));
+          }
+        } else {
+          T q(0);
+          for (int64 i = 0; i < memory_time; ++i) {
+            q = (i > 0 ? (T(1) - p[offset + i - 1]) * q : T(0)) +
+                previous[offset + i];
+            a[offset + i] = p[offset + i] * q;
+          }
+        }
+      }
+    };
+    const Eigen::TensorOpCost cost(2 * sizeof(T) * memory_time,
+                                   sizeof(T) * memory_time,
+                                   (parallel_ ? 40 : 4) * memory_time);
+    context->eigen_device<CPUDevice>().parallelFor(p_choose_i.dim_size(0),
+                                                   cost, work);
+  }
+};
+
+// Backpropagates through the recurrence of every example with a forward pass
+// that recomputes its running values and a reverse pass over its memory.
+template <typename T>
+class MonotonicAttentionGradOp : public MonotonicAttentionBase {
+ public:
+  explicit MonotonicAttentionGradOp(OpKernelConstruction *context)
+      : MonotonicAttentionBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &p_choose_i = context->input(0);
+    const Tensor &previous_attention = context->input(1);
+    const Tensor &grad = context->input(2);
+    OP_REQUIRES_OK(context, CheckInputs(p_choose_i, previous_attention));
+    OP_REQUIRES(context, grad.shape() == p_choose_i.shape(),
+                errors::InvalidArgument("grad should have shape ",
+                                        p_choose_i.shape().DebugString(),
+                                        ", got ", grad.shape().DebugString()));
+    Tensor *p_choose_i_grad = nullptr;
+    Tensor *previous_attention_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, p_choose_i.shape(),
+                                                     &p_choose_i_grad));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, previous_attention.shape(),
+                                            &previous_attention_grad));
+    const int64 memory_time = p_choose_i.dim_size(1);
+    if (grad.NumElements() == 0) {
+      return;
+    }
+
+    const T *p = p_choose_i.flat<T>().data();
+    const T *previous = previous_attention.flat<T>().data();
+    const T *da = grad.flat<T>().data();
+    T *dp = p_choose_i_grad->flat<T>().data();
+    T *dprevious = previous_attention_grad->flat<T>().data();
+    const auto work = [&](int64 start, int64 end) {
+      // The running values of the forward pass of one example.
+      std::vector<T> cumprods(memory_time), cumsums(memory_time);
+      for (int64 b = start; b < end; ++b) {
+        const int64 offset = b * memory_time;
+        if (parallel_) {
+          ParallelState<T> state;
+          for (int64 i = 0; i < memory_time; ++i) {
+            cumprods[i] = std::exp(state.log_cumprod);
+            state.cumsum += previous[offset + i] / ClipCumprod(cumprods[i]);
+            cumsums[i] = state.cumsum;
+            state.log_cumprod += std::log(ClipComplement(p[offset + i]));
+          }
+          // `weighted` is the gradient of `cumsum_i`, summed from the end;
+          // `log_cumprod_grad` the one of `log_cumprod_{i+1}`, summed from
+          // the end.
+          T weighted(0);
+          T log_cumprod_grad(0);
+          for (int64 i = memory_time - 1; i >= 0; --i) {
+            const int64 k = offset + i;
+            const T cumprod = cumprods[i];
+            const T clipped = ClipCumprod(cumprod);
+            weighted += da[k] * p[k] * cumprod;
+            dprevious[k] = weighted / clipped;
+            T cumprod_grad = da[k] * p[k] * cumsums[i];
+            if (cumprod >= static_cast<T>(kMinCumprod)) {
+              cumprod_grad -= weighted * previous[k] / (clipped * clipped);
+            }
+            const T complement = T(1) - p[k];
+            const bool clipped_complement =
+                complement < std::numeric_limits<T>::min() ||
+                complement > T(1);
+            dp[k] = da[k] * cumprod * cumsums[i] -
+                    (clipped_complement ? T(0)
+                                        : log_cumprod_grad / complement);
+            log_cumprod_grad += cumprod_grad * cumprod;
+          }
+        } else {
+          T q(0);
+          for (int64 i = 0; i < memory_time; ++i) {
+            q = (i > 0 ? (T(1) - p[offset + i - 1]) * q : T(0)) +
+                previous[offset + i];
+            cumsums[i] = q;
+          }
+          // The gradient of `q_{i+1}`.
+          T q_grad(0);
+          for (int64 i = memory_time - 1; i >= 0; --i) {
+            const int64 k = offset + i;
+            dp[k] = (da[k] - q_grad) * cumsums[i];
+            q_grad = da[k] * p[k] + q_grad * (T(1) - p[k]);
+            dprevious[k] = q_grad;
+          }
+        }
+      }
+    };
+    const Eigen::TensorOpCost cost(3 * sizeof(T) * memory_time,
+                                   2 * sizeof(T) * memory_time,
+                                   (parallel_ ? 60 : 8) * memory_time);
+    context->eigen_device<CPUDevice>().parallelFor(p_choose_i.dim_size(0),
+                                                   cost, work);
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T)                                          \
+  REGISTER_KERNEL_BUILDER(Name("Addons>MonotonicAttention")             \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          MonotonicAttentionOp<T>);                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>MonotonicAttentionGrad")         \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          MonotonicAttentionGradOp<T>);
+
+REGISTER_CPU_KERNEL(float);
+REGISTER_CPU_KERNEL(double);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,358 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+namespace addons {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// The dimensions the weighted cross-entropy is reduced over.
+enum class Reduction { kNone, kTimesteps, kBatch, kAll };
+
+// Returns `log(sum(exp(row)))` of a non-empty row in a single pass, rescaling
+// the running sum whenever a new maximum is found. The maximum starts at
+// `-inf` and elements equal to it add 1 without calling `exp`, so masked
+// `-inf` logits contribute nothing instead of `exp(-inf - -inf) = NaN`.
+template <typename T>
+T LogSumExp(const T *row, int64 size) {
+  T max = -std::numeric_limits<T>::infinity();
+  T sum(0);
+  for (int64 i = 0; i < size; ++i) {
+    if (row[i] > max) {
+      sum = sum * std::exp(max - row[i]) + T(1);
+      max = row[i];
+    } else if (row[i] == max) {
+      sum += T(1);
+    } else {
+      sum += std::exp(row[i] - max);
+    }
+  }
+  return max + std::log(sum);
+}
+
+class SequenceLossBase : public OpKernel {
+ public:
+  explicit SequenceLossBase(OpKernelConstruction *context)
+      : OpKernel(context) {
+    std::string reduction;
+    OP_REQUIRES_OK(context, context->GetAttr("reduction", &reduction));
+    if (reduction == "none") {
+      reduction_ = Reduction::kNone;
+    } else if (reduction == "timesteps") {
+      reduction_ = Reduction::kTimesteps;
+    } else if (reduction == "batch") {
+      reduction_ = Reduction::kBatch;
+    } else if (reduction == "all") {
+      reduction_ = Reduction::kAll;
+    } else {
+      context->CtxFailure(errors::InvalidArgument(
+          "reduction must be 'none', 'timesteps', 'batch' or 'all', got ",
+          reduction));
+      return;
+    }
+    std::string normalizer;
+    OP_REQUIRES_OK(context, context->GetAttr("normalizer", &normalizer));
+    OP_REQUIRES(context, normalizer == "weights" || normalizer == "count",
+                errors::InvalidArgument(
+                    "normalizer must be 'weights' or 'count', got ",
+                    normalizer));
+    count_ = normalizer == "count";
+  }
+
+ protected:
+  Status CheckInputs(const Tensor &logits, const Tensor &targets,
+                     const Tensor &weights) const {
+    if (logits.dims() != 3) {
+      return errors::InvalidArgument(
+          "logits must be a [batch_size, sequence_length, num_classes] "
+          "tensor, got ",
+          logits.shape().DebugString());
+    }
+    const TensorShape shape({logits.dim_size(0), logits.dim_size(1)});
+    if (targets.shape() != shape || weights.shape() != shape) {
+      return errors::InvalidArgument(
+          "targets and weights should have shape ", shape.DebugString(),
+          ", got ", targets.shape().DebugString(), " and ",
+          weights.shape().DebugString());
+    }
+    return Status::OK();
+  }
+
+  TensorShape LossShape(int64 batch, int64 time) const {
+    switch (reduction_) {
+      case Reduction::kNone:
+        return TensorShape({batch, time});
+      case Reduction::kTimesteps:
+        return TensorShape({batch});
+      case Reduction::kBatch:
+        return TensorShape({time});
+      default:
+        return TensorShape({});
+    }
+  }
+
+  // Returns the index of the loss that position `(b, t)` is reduced into.
+  int64 Group(int64 b, int64 t, int64 time) const {
+    switch (reduction_) {
+      case Reduction::kNone:
+        return b * time + t;
+      case Reduction::kTimesteps:
+        return b;
+      case Reduction::kBatch:
+        return t;
+      default:
+        return 0;
+    }
+  }
+
+  // Sums the weights, or counts the non-zero weights, of every group, in
+  // order.
+  template <typename T>
+  std::vector<T> Normalizers(const T *weights, int64 batch, int64 time,
+                             int64 num_groups) const {
+    std::vector<T> normalizers(num_groups, T(0));
+    for (int64 b = 0; b < batch; ++b) {
+      for (int64 t = 0; t < time; ++t) {
+        const T weight = weights[b * time + t];
+        normalizers[Group(b, t, time)] +=
+            count_ ? T(weight != T(0)) : weight;
+      }
+    }
+    return normalizers;
+  }
+
+  Reduction reduction_;
+  bool count_;
+};
+
+Status InvalidTarget(int64 target, int64 num_classes) {
+  return errors::InvalidArgument("target ", target, " is not in [0, ",
+                                 num_classes, ")");
+}
+
+}  // namespace
+
+// Computes the softmax cross-entropy of every position with a non-zero
+// weight in one pass over its logits, sharded over the positions, and
+// reduces the weighted cross-entropies in order. Also outputs the
+// unweighted cross-entropies, which are zero at the skipped positions.
+template <typename T, typename Tidx>
+class SequenceLossOp : public SequenceLossBase {
+ public:
+  explicit SequenceLossOp(OpKernelConstruction *context)
+      : SequenceLossBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &logits = context->input(0);
+    const Tensor &targets = context->input(1);
+    const Tensor &weights = context->input(2);
+    OP_REQUIRES_OK(context, CheckInputs(logits, targets, weights));
+    const int64 batch = logits.dim_size(0);
+    const int64 time = logits.dim_size(1);
+    const int64 num_classes = logits.dim_size(2);
+    Tensor *loss = nullptr;
+    Tensor *crossent = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, LossShape(batch, time), &loss));
+    OP_REQUIRES_OK(context, context->allocate_output(1, targets.shape(),
+                                                     &crossent));
+
+    const T *x = logits.flat<T>().data();
+    const Tidx *y = targets.flat<Tidx>().data();
+    const T *w = weights.flat<T>().data();
+    T *c = crossent->flat<T>().data();
+    std::atomic<bool> valid(true);
+    std::atomic<int64> invalid_target(0);
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 i = start; i < end; ++i) {
+        const Tidx target = y[i];
+        if (target < 0 || target >= num_classes) {
+          invalid_target = target;
+          valid = false;
+          c[i] = T(0);
+          continue;
+        }
+        const T *row = x + i * num_classes;
+        c[i] = w[i] == T(0) ? T(0)
+                            : LogSumExp(row, num_classes) - row[target];
+      }
+    };
+    const Eigen::TensorOpCost cost(sizeof(T) * num_classes, sizeof(T),
+                                   20 * num_classes);
+    context->eigen_device<CPUDevice>().parallelFor(batch * time, cost, work);
+    OP_REQUIRES(context, valid, InvalidTarget(invalid_target, num_classes));
+
+    T *l = loss->flat<T>().data();
+    if (reduction_ == Reduction::kNone) {
+      for (int64 i = 0; i < batch * time; ++i) {
+        l[i] = w[i] * c[i];
+      }
+      return;
+    }
+    const int64 num_groups = loss->NumElements();
+    const std::vector<T> normalizers =
+        Normalizers(w, batch, time, num_groups);
+    std::fill(l, l + num_groups, T(0));
+    for (int64 b = 0; b < batch; ++b) {
+      for (int64 t = 0; t < time; ++t) {
+        const int64 i = b * time + t;
+        l[Group(b, t, time)] += w[i] * c[i];
+      }
+    }
+    for (int64 g = 0; g < num_groups; ++g) {
+      l[g] = normalizers[g] == T(0) ? T(0) : l[g] / normalizers[g];
+    }
+  }
+};
+
+// Writes the gradient of every position straight into a logits shaped
+// buffer from the cross-entropies of the forward pass. The rows of the
+// positions with a zero weight are zero; their cross-entropy is only
+// recomputed for the gradient of their weight.
+template <typename T, typename Tidx>
+class SequenceLossGradOp : public SequenceLossBase {
+ public:
+  explicit SequenceLossGradOp(OpKernelConstruction *context)
+      : SequenceLossBase(context) {}
+
+  void Compute(OpKernelContext *context) override {
+    const Tensor &logits = context->input(0);
+    const Tensor &targets = context->input(1);
+    const Tensor &weights = context->input(2);
+    const Tensor &crossent = context->input(3);
+    const Tensor &loss = context->input(4);
+    const Tensor &loss_grad = context->input(5);
+    OP_REQUIRES_OK(context, CheckInputs(logits, targets, weights));
+    const int64 batch = logits.dim_size(0);
+    const int64 time = logits.dim_size(1);
+    const int64 num_classes = logits.dim_size(2);
+    const TensorShape loss_shape = LossShape(batch, time);
+    OP_REQUIRES(context, crossent.shape() == targets.shape(),
+                errors::InvalidArgument("crossent should have shape ",
+                                        targets.shape().DebugString(),
+                                        ", got ",
+                                        crossent.shape().DebugString()));
+    OP_REQUIRES(context,
+                loss.shape() == loss_shape && loss_grad.shape() == loss_shape,
+                errors::InvalidArgument(
+                    "loss and loss_grad should have shape ",
+                    loss_shape.DebugString(), ", got ",
+                    loss.shape().DebugString(), " and ",
+                    loss_grad.shape().DebugString()));
+    Tensor *logits_grad = nullptr;
+    Tensor *weights_grad = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, logits.shape(),
+                                                     &logits_grad));
+    OP_REQUIRES_OK(context, context->allocate_output(1, weights.shape(),
+                                                     &weights_grad));
+
+    const T *x = logits.flat<T>().data();
+    const Tidx *y = targets.flat<Tidx>().data();
+    const T *w = weights.flat<T>().data();
+    const T *c = crossent.flat<T>().data();
+    const T *l = loss.flat<T>().data();
+    const T *dl = loss_grad.flat<T>().data();
+    T *dx = logits_grad->flat<T>().data();
+    T *dw = weights_grad->flat<T>().data();
+    const std::vector<T> normalizers =
+        reduction_ == Reduction::kNone
+            ? std::vector<T>()
+            : Normalizers(w, batch, time, loss_shape.num_elements());
+    std::atomic<bool> valid(true);
+    std::atomic<int64> invalid_target(0);
+    const auto work = [&](int64 start, int64 end) {
+      for (int64 i = start; i < end; ++i) {
+        const int64 g = Group(i / time, i % time, time);
+        const Tidx target = y[i];
+        const T *row = x + i * num_classes;
+        T *grad_row = dx + i * num_classes;
+        std::fill(grad_row, grad_row + num_classes, T(0));
+        if (target < 0 || target >= num_classes) {
+          invalid_target = target;
+          valid = false;
+          dw[i] = T(0);
+          continue;
+        }
+        // The gradient of the weighted cross-entropy of the position.
+        T grad = dl[g];
+        if (reduction_ != Reduction::kNone) {
+          if (normalizers[g] == T(0)) {
+            dw[i] = T(0);
+            continue;
+          }
+          grad /= normalizers[g];
+        }
+        T cross_entropy = c[i];
+        if (w[i] == T(0)) {
+          cross_entropy = LogSumExp(row, num_classes) - row[target];
+        } else {
+          const T log_normalizer = c[i] + row[target];
+          const T scale = grad * w[i];
+          for (int64 k = 0; k < num_classes; ++k) {
+            grad_row[k] = scale * std::exp(row[k] - log_normalizer);
+          }
+          grad_row[target] -= scale;
+        }
+        const bool average =
+            reduction_ != Reduction::kNone && !count_;
+        dw[i] = grad * (average ? cross_entropy - l[g] : cross_entropy);
+      }
+    };
+    const Eigen::TensorOpCost cost(sizeof(T) * num_classes,
+                                   sizeof(T) * num_classes,
+                                   20 * num_classes);
+    context->eigen_device<CPUDevice>().parallelFor(batch * time, cost, work);
+    OP_REQUIRES(context, valid, InvalidTarget(invalid_target, num_classes));
+  }
+};
+
+#define REGISTER_CPU_KERNEL(T, Tidx)                                    \
+  REGISTER_KERNEL_BUILDER(Name("Addons>SequenceLoss")                   \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T")                   \
+                              .TypeConstraint<Tidx>("Tidx"),            \
+                          SequenceLossOp<T, Tidx>);                     \
+  REGISTER_KERNEL_BUILDER(Name("Addons>SequenceLossGrad")               \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T")                   \
+                              .TypeConstraint<Tidx>("Tidx"),            \
+                          SequenceLossGradOp<T, Tidx>);
+
+#define REGISTER_CPU_KERNELS(T) \
+  REGISTER_CPU_KERNEL(T, int32); \
+  REGISTER_CPU_KERNEL(T, int64);
+
+REGISTER_CPU_KERNELS(float);
+REGISTER_CPU_KERNELS(double);
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using shape_inference::DimensionHandle;
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>AttentionScoreContext")
+    .Input("query: T")
+    .Input("keys: T")
+    .Input("values: T")
+    .Input("mask: bool")
+    .Input("attention_v: T")
+    .Input("attention_b: T")
+    .Input("scale: T")
+    .Output("alignments: T")
+    .Output("attention: T")
+    .Attr("score_fn: {'luong', 'bahdanau'}")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle query, keys, values, scale;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &query));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 3, &keys));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 3, &values));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(6), 0, &scale));
+      DimensionHandle batch, memory_time;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(query, 0), c->Dim(keys, 0), &batch));
+      TF_RETURN_IF_ERROR(c->Merge(batch, c->Dim(values, 0), &batch));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(keys, 1), c->Dim(values, 1), &memory_time));
+      c->set_output(0, c->Matrix(batch, memory_time));
+      c->set_output(1, c->Matrix(batch, c->Dim(values, 2)));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the masked softmax alignments and the context of an attention step.
+
+The score of a `[batch, units]` query against its `[batch, memory_time, units]`
+keys is `scale * query . key` for `luong` and
+`scale * sum(attention_v * tanh(key + query + attention_b))` for `bahdanau`,
+where an empty `attention_b` is no bias. Scores where the `[batch,
+memory_time]` mask is false are set to the lowest value of `T` before the
+softmax, and an empty mask masks nothing. The attention is the alignments
+weighted sum of the `[batch, memory_time, depth]` values.
+)doc");
+
+REGISTER_OP("Addons>AttentionScoreContextGrad")
+    .Input("query: T")
+    .Input("keys: T")
+    .Input("values: T")
+    .Input("mask: bool")
+    .Input("attention_v: T")
+    .Input("attention_b: T")
+    .Input("scale: T")
+    .Input("alignments: T")
+    .Input("alignments_grad: T")
+    .Input("attention_grad: T")
+    .Output("query_grad: T")
+    .Output("keys_grad: T")
+    .Output("values_grad: T")
+    .Output("attention_v_grad: T")
+    .Output("attention_b_grad: T")
+    .Output("scale_grad: T")
+    .Attr("score_fn: {'luong', 'bahdanau'}")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(1));
+      c->set_output(2, c->input(2));
+      c->set_output(3, c->input(4));
+      c->set_output(4, c->input(5));
+      c->set_output(5, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of AttentionScoreContext with respect to its inputs.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
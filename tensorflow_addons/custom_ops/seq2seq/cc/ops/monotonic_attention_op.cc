@@ -0,0 +1,66 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>MonotonicAttention")
+    .Input("p_choose_i: T")
+    .Input("previous_attention: T")
+    .Output("attention: T")
+    .Attr("mode: {'recursive', 'parallel'}")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &shape));
+      TF_RETURN_IF_ERROR(c->Merge(shape, c->input(1), &shape));
+      c->set_output(0, shape);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the expected monotonic attention from choosing probabilities.
+
+For `[batch, memory_time]` choosing probabilities `p` and previous attention,
+the `recursive` mode computes `attention_i = p_i * q_i` with
+`q_i = (1 - p_{i-1}) * q_{i-1} + previous_attention_i`, and the `parallel`
+mode computes its closed form like `monotonic_attention`, dividing by the
+exclusive cumulative product of `1 - p` clipped to at least 1e-10.
+)doc");
+
+REGISTER_OP("Addons>MonotonicAttentionGrad")
+    .Input("p_choose_i: T")
+    .Input("previous_attention: T")
+    .Input("grad: T")
+    .Output("p_choose_i_grad: T")
+    .Output("previous_attention_grad: T")
+    .Attr("mode: {'recursive', 'parallel'}")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(1));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of MonotonicAttention with respect to its inputs.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
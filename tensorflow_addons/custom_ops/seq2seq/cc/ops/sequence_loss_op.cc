@@ -0,0 +1,99 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+namespace addons {
+
+using shape_inference::DimensionHandle;
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+REGISTER_OP("Addons>SequenceLoss")
+    .Input("logits: T")
+    .Input("targets: Tidx")
+    .Input("weights: T")
+    .Output("loss: T")
+    .Output("crossent: T")
+    .Attr("reduction: {'none', 'timesteps', 'batch', 'all'}")
+    .Attr("normalizer: {'weights', 'count'}")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle logits, targets;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 3, &logits));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &targets));
+      TF_RETURN_IF_ERROR(c->Merge(targets, c->input(2), &targets));
+      DimensionHandle batch, time;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(logits, 0), c->Dim(targets, 0), &batch));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(logits, 1), c->Dim(targets, 1), &time));
+      std::string reduction;
+      TF_RETURN_IF_ERROR(c->GetAttr("reduction", &reduction));
+      if (reduction == "none") {
+        c->set_output(0, c->Matrix(batch, time));
+      } else if (reduction == "timesteps") {
+        c->set_output(0, c->Vector(batch));
+      } else if (reduction == "batch") {
+        c->set_output(0, c->Vector(time));
+      } else {
+        c->set_output(0, c->Scalar());
+      }
+      c->set_output(1, c->Matrix(batch, time));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the weighted softmax cross-entropy of a sequence of logits.
+
+For `[batch_size, sequence_length, num_classes]` logits and
+`[batch_size, sequence_length]` targets and weights, computes the
+cross-entropy of every position with a non-zero weight, multiplies it by its
+weight and sums it over the `timesteps`, the `batch` or `all` the dimensions,
+dividing each sum by the sum of its weights or by its count of non-zero
+weights depending on `normalizer`, or zero if that is zero. The `none`
+reduction outputs the weighted cross-entropies without any normalization.
+
+crossent: The unweighted cross-entropies, zero where the weight is zero.
+)doc");
+
+REGISTER_OP("Addons>SequenceLossGrad")
+    .Input("logits: T")
+    .Input("targets: Tidx")
+    .Input("weights: T")
+    .Input("crossent: T")
+    .Input("loss: T")
+    .Input("loss_grad: T")
+    .Output("logits_grad: T")
+    .Output("weights_grad: T")
+    .Attr("reduction: {'none', 'timesteps', 'batch', 'all'}")
+    .Attr("normalizer: {'weights', 'count'}")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64}")
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gradients of SequenceLoss with respect to its logits and weights.
+)doc");
+
+}  // namespace addons
+}  // namespace tensorflow
@@ -15,8 +15,26 @@
 """Cutout op"""
 
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import TensorLike, Number
 
+_image_so = LazySO("custom_ops/image/_image_ops.so")
+
+_CUTOUT_DTYPES = (
+    tf.int64,
+    tf.int32,
+    tf.uint16,
+    tf.int16,
+    tf.uint8,
+    tf.int8,
+    tf.float16,
+    tf.bfloat16,
+    tf.float32,
+    tf.float64,
+    tf.bool,
+)
+
 
 @tf.function
 def _norm_params(mask_size, offset=None):
@@ -92,6 +110,36 @@ def random_cutout(
     return cutout(images, mask_size, offset, constant_values)
 
 
+def _cutout_custom_op(images, mask_size, offset, constant_values):
+    """Applies cutout with the custom kernel.
+
+    Returns:
+      The images, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or images.dtype not in _CUTOUT_DTYPES:
+        return None
+    try:
+        return _image_so.ops.addons_cutout(
+            images,
+            tf.cast(mask_size, tf.int32),
+            tf.cast(offset, tf.int32),
+            tf.cast(constant_values, images.dtype),
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("cutout")
+        return None
+
+
+@tf.RegisterGradient("Addons>Cutout")
+def _cutout_grad(op, grad):
+    _, mask_size, offset, _ = op.inputs
+    images_grad = _image_so.ops.addons_cutout(
+        grad, mask_size, offset, tf.zeros([], grad.dtype)
+    )
+    constant_values_grad = tf.reduce_sum(grad) - tf.reduce_sum(images_grad)
+    return [images_grad, None, None, constant_values_grad]
+
+
 def cutout(
     images: TensorLike,
     mask_size: TensorLike,
@@ -133,6 +181,10 @@ def cutout(
         )
 
         mask_size, offset = _norm_params(mask_size, offset)
+        output = _cutout_custom_op(images, mask_size, offset, constant_values)
+        if output is not None:
+            output.set_shape(image_static_shape)
+            return output
         mask_size = mask_size // 2
 
         cutout_center_heights = offset[:, 0]
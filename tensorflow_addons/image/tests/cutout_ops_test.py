@@ -32,6 +32,24 @@ def test_different_dtypes(dtype):
     assert result_image.dtype == dtype
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_per_image_offsets():
+    images = tf.constant(np.random.uniform(1, 2, size=(3, 9, 7, 2)))
+    offset = tf.constant([[0, 0], [4, 3], [8, 6]])
+    expected = images.numpy()
+    expected[0, :2, :3] = -1
+    expected[1, 2:6, :6] = -1
+    expected[2, 6:, 3:] = -1
+
+    with tf.GradientTape() as tape:
+        tape.watch(images)
+        result = cutout(images, [4, 6], offset, constant_values=-1)
+    np.testing.assert_equal(result.numpy(), expected)
+    np.testing.assert_equal(
+        tape.gradient(result, images).numpy(), (expected != -1).astype(np.float64)
+    )
+
+
 def test_different_channels():
     for channel in [0, 1, 3, 4]:
         test_image = tf.ones([1, 40, 40, channel], dtype=np.uint8)
@@ -20,11 +20,119 @@ import tensorflow_addons.utils.keras_utils as conv_utils
 from typeguard import typechecked
 from typing import Union, Callable, Iterable
 
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
+
+_adaptive_pool_so = LazySO("custom_ops/layers/_adaptive_pool_ops.so")
+
+_POOLING_TYPES = {tf.reduce_max: "max", tf.reduce_mean: "avg"}
+
+
+def _adaptive_pool_custom_op(
+    inputs, output_sizes, reduce_function, data_format, drop_remainder=False
+):
+    """Pools `inputs` into every level of `output_sizes` with the custom kernel.
+
+    With `drop_remainder`, every level pools the input cropped to a multiple of
+    its size instead of overlapping its bins.
+
+    Returns:
+      The bins of all levels, flattened to `[batch, num_bins, channels]` for
+      `channels_last` inputs and to `[batch, channels, num_bins]` otherwise,
+      or `None` if the custom kernel can't be used.
+    """
+    pooling_type = _POOLING_TYPES.get(reduce_function)
+    if (
+        options.is_custom_kernel_disabled()
+        or pooling_type is None
+        or inputs.dtype not in (tf.float32, tf.float64)
+    ):
+        return None
+
+    try:
+        return _adaptive_pool_so.ops.addons_adaptive_pool(
+            inputs,
+            output_sizes=[size for level in output_sizes for size in level],
+            pooling_type=pooling_type,
+            data_format=data_format,
+            drop_remainder=drop_remainder,
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("AdaptivePool")
+        return None
+
+
+def _adaptive_pool(inputs, output_size, reduce_function, data_format):
+    """Pools `inputs` to `output_size` with the custom kernel.
+
+    Returns:
+      The pooled tensor, or `None` if the custom kernel can't be used.
+    """
+    outputs = _adaptive_pool_custom_op(
+        inputs, [output_size], reduce_function, data_format
+    )
+    if outputs is None:
+        return None
+    shape = tf.shape(inputs)
+    if data_format == "channels_last":
+        output_shape = tf.concat([shape[:1], output_size, shape[-1:]], axis=0)
+    else:
+        output_shape = tf.concat([shape[:2], output_size], axis=0)
+    return tf.reshape(outputs, output_shape)
+
+
+@tf.RegisterGradient("Addons>AdaptivePool")
+def _adaptive_pool_grad(op, grad):
+    return _adaptive_pool_so.ops.addons_adaptive_pool_grad(
+        op.inputs[0],
+        grad,
+        output_sizes=op.get_attr("output_sizes"),
+        pooling_type=op.get_attr("pooling_type"),
+        data_format=op.get_attr("data_format"),
+        drop_remainder=op.get_attr("drop_remainder"),
+    )
+
+
+def _output_size_divides_input(inputs, output_size, data_format):
+    """Whether `output_size` is known to divide the spatial sizes of `inputs`."""
+    first_axis = 1 if data_format == "channels_last" else 2
+    spatial_shape = inputs.shape[first_axis : first_axis + len(output_size)]
+    return all(
+        size is not None and size % bins == 0
+        for size, bins in zip(spatial_shape, output_size)
+    )
+
+
+def _adaptive_pool_by_axis(inputs, output_size, reduce_function, data_format):
+    """Pools `inputs` to `output_size` with the bins of the custom kernel.
+
+    Bin `i` of `n` over an axis of size `s` spans the positions from
+    `floor(i * s / n)` up to `ceil((i + 1) * s / n)`. The spatial axes are
+    reduced one at a time, which gives the same result as a joint reduction
+    for max and average pooling.
+    """
+    first_axis = 1 if data_format == "channels_last" else 2
+    for i, bins in enumerate(output_size):
+        axis = first_axis + i
+        size = tf.shape(inputs)[axis]
+        outputs = []
+        for j in range(bins):
+            start = j * size // bins
+            end = -(-(j + 1) * size // bins)
+            window = tf.gather(inputs, tf.range(start, end), axis=axis)
+            outputs.append(reduce_function(window, axis=axis))
+        inputs = tf.stack(outputs, axis=axis)
+    return inputs
+
 
 class AdaptivePooling1D(tf.keras.layers.Layer):
     """Parent class for 1D pooling layers with adaptive kernel size.
 
     This class only exists for code reuse. It will never be an exposed API.
+    `output_size` need not divide the input size: bins then overlap by at
+    most one position along each axis. Max and average pooling of `float32`
+    and `float64` inputs use a custom kernel that computes the bin boundaries
+    on the fly.
 
     Args:
       reduce_function: The reduction method to apply, e.g. `tf.reduce_max`.
@@ -53,6 +161,15 @@ class AdaptivePooling1D(tf.keras.layers.Layer):
         super().__init__(**kwargs)
 
     def call(self, inputs, *args):
+        outputs = _adaptive_pool(
+            inputs, self.output_size, self.reduce_function, self.data_format
+        )
+        if outputs is not None:
+            return outputs
+        if not _output_size_divides_input(inputs, self.output_size, self.data_format):
+            return _adaptive_pool_by_axis(
+                inputs, self.output_size, self.reduce_function, self.data_format
+            )
         bins = self.output_size[0]
         if self.data_format == "channels_last":
             splits = tf.split(inputs, bins, axis=1)
@@ -158,6 +275,10 @@ class AdaptivePooling2D(tf.keras.layers.Layer):
     """Parent class for 2D pooling layers with adaptive kernel size.
 
     This class only exists for code reuse. It will never be an exposed API.
+    `output_size` need not divide the input size: bins then overlap by at
+    most one position along each axis. Max and average pooling of `float32`
+    and `float64` inputs use a custom kernel that computes the bin boundaries
+    on the fly.
 
     Args:
       reduce_function: The reduction method to apply, e.g. `tf.reduce_max`.
@@ -186,6 +307,15 @@ class AdaptivePooling2D(tf.keras.layers.Layer):
         super().__init__(**kwargs)
 
     def call(self, inputs, *args):
+        outputs = _adaptive_pool(
+            inputs, self.output_size, self.reduce_function, self.data_format
+        )
+        if outputs is not None:
+            return outputs
+        if not _output_size_divides_input(inputs, self.output_size, self.data_format):
+            return _adaptive_pool_by_axis(
+                inputs, self.output_size, self.reduce_function, self.data_format
+            )
         h_bins = self.output_size[0]
         w_bins = self.output_size[1]
         if self.data_format == "channels_last":
@@ -306,6 +436,10 @@ class AdaptivePooling3D(tf.keras.layers.Layer):
     """Parent class for 3D pooling layers with adaptive kernel size.
 
     This class only exists for code reuse. It will never be an exposed API.
+    `output_size` need not divide the input size: bins then overlap by at
+    most one position along each axis. Max and average pooling of `float32`
+    and `float64` inputs use a custom kernel that computes the bin boundaries
+    on the fly.
 
     Args:
       reduce_function: The reduction method to apply, e.g. `tf.reduce_max`.
@@ -334,6 +468,15 @@ class AdaptivePooling3D(tf.keras.layers.Layer):
         super().__init__(**kwargs)
 
     def call(self, inputs, *args):
+        outputs = _adaptive_pool(
+            inputs, self.output_size, self.reduce_function, self.data_format
+        )
+        if outputs is not None:
+            return outputs
+        if not _output_size_divides_input(inputs, self.output_size, self.data_format):
+            return _adaptive_pool_by_axis(
+                inputs, self.output_size, self.reduce_function, self.data_format
+            )
         h_bins = self.output_size[0]
         w_bins = self.output_size[1]
         d_bins = self.output_size[2]
@@ -19,7 +19,11 @@ import tensorflow as tf
 from typeguard import typechecked
 from typing import Union, Iterable
 
+from tensorflow_addons import options
 from tensorflow_addons.utils.keras_utils import normalize_tuple
+from tensorflow_addons.utils.resource_loader import LazySO
+
+_max_unpooling_so = LazySO("custom_ops/layers/_max_unpooling_ops.so")
 
 
 def _calculate_output_shape(input_shape, pool_size, strides, padding):
@@ -43,6 +47,44 @@ def _calculate_output_shape(input_shape, pool_size, strides, padding):
     return output_shape
 
 
+def _max_unpooling_2d_custom_op(updates, mask, pool_size, strides, padding):
+    """Unpools `updates` with the custom kernel.
+
+    Returns:
+      The unpooled tensor, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or updates.dtype not in (
+        tf.float16,
+        tf.float32,
+        tf.float64,
+    ):
+        return None
+    if mask.dtype not in (tf.int32, tf.int64):
+        mask = tf.cast(mask, tf.int32)
+
+    try:
+        return _max_unpooling_so.ops.addons_max_unpooling2d(
+            updates, mask, pool_size=pool_size, strides=strides, padding=padding
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("MaxUnpooling2D")
+        return None
+
+
+@tf.RegisterGradient("Addons>MaxUnpooling2D")
+def _max_unpooling_2d_grad(op, grad):
+    updates, mask = op.inputs
+    updates_grad = _max_unpooling_so.ops.addons_max_unpooling2d_grad(
+        updates,
+        mask,
+        grad,
+        pool_size=op.get_attr("pool_size"),
+        strides=op.get_attr("strides"),
+        padding=op.get_attr("padding"),
+    )
+    return [updates_grad, None]
+
+
 def _max_unpooling_2d(updates, mask, pool_size=(2, 2), strides=(2, 2), padding="SAME"):
     """Unpool the outputs of a maximum pooling operation."""
     pool_size_attr = " ".join(["i: %d" % v for v in pool_size])
@@ -57,6 +99,10 @@ def _max_unpooling_2d(updates, mask, pool_size=(2, 2), strides=(2, 2), padding="
 
     @tf.function(experimental_implements=experimental_implements)
     def func(updates, mask):
+        ret = _max_unpooling_2d_custom_op(updates, mask, pool_size, strides, padding)
+        if ret is not None:
+            return ret
+
         mask = tf.cast(mask, "int32")
         input_shape = tf.shape(updates, out_type="int32")
         input_shape = [updates.shape[i] or input_shape[i] for i in range(4)]
@@ -18,6 +18,93 @@ import warnings
 
 import tensorflow as tf
 
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
+
+_attention_so = LazySO("custom_ops/layers/_attention_ops.so")
+
+
+def _dot_product_attention_custom_op(query, key, value, mask, dropout_rate, training):
+    """Computes the attention of all heads with the fused custom kernel.
+
+    `query`, `key` and `value` are `[..., elements, heads, depth]` tensors,
+    and `query` is already scaled.
+
+    Returns:
+      The `[..., query_elements, heads, value_depth]` attention, or `None` if
+      the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or query.dtype not in (
+        tf.float32,
+        tf.float64,
+    ):
+        return None
+    if training is None:
+        training = tf.keras.backend.learning_phase()
+    training = tf.get_static_value(training)
+    if training is None:
+        return None
+    dropout_rate = dropout_rate if training else 0.0
+
+    batch_shape = tf.shape(query)[:-3]
+    query_shape = query.shape
+
+    def flatten(x):
+        return tf.reshape(x, tf.concat([[-1], tf.shape(x)[-3:]], axis=0))
+
+    if mask is None:
+        mask = tf.zeros([0, 0, 0, 0], query.dtype)
+    else:
+        mask = tf.cast(mask, query.dtype)
+        # possibly expand on the head dimension, like the logits
+        if len(mask.shape) != len(query_shape):
+            mask = tf.expand_dims(mask, -3)
+        if mask.shape[:-3].num_elements() != 1:
+            mask = tf.broadcast_to(
+                mask, tf.concat([batch_shape, tf.shape(mask)[-3:]], axis=0)
+            )
+        mask = flatten(mask)
+    if dropout_rate > 0.0:
+        seed = tf.random.uniform([2], maxval=tf.int64.max, dtype=tf.int64)
+    else:
+        seed = tf.zeros([2], tf.int64)
+
+    try:
+        output, _ = _attention_so.ops.addons_dot_product_attention(
+            flatten(query),
+            flatten(key),
+            flatten(value),
+            mask,
+            seed,
+            dropout_rate=dropout_rate,
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("MultiHeadAttention")
+        return None
+    output = tf.reshape(
+        output, tf.concat([batch_shape, tf.shape(output)[1:]], axis=0)
+    )
+    output.set_shape(query_shape[:-1].concatenate(value.shape[-1:]))
+    return output
+
+
+@tf.RegisterGradient("Addons>DotProductAttention")
+def _dot_product_attention_grad(op, grad, unused_logsumexp_grad):
+    query, key, value, mask, seed = op.inputs
+    output, logsumexp = op.outputs
+    grads = _attention_so.ops.addons_dot_product_attention_grad(
+        query,
+        key,
+        value,
+        mask,
+        seed,
+        output,
+        logsumexp,
+        grad,
+        dropout_rate=op.get_attr("dropout_rate"),
+    )
+    return list(grads) + [None, None]
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class MultiHeadAttention(tf.keras.layers.Layer):
@@ -45,6 +132,11 @@ class MultiHeadAttention(tf.keras.layers.Layer):
     >>> attention.shape
     TensorShape([3, 5, 10])
 
+    Unless `return_attn_coef` is set, the attention of `float32` and `float64`
+    inputs is computed by a custom kernel that visits the keys in blocks and
+    never materializes the `(batch_size, num_heads, query_elements,
+    key_elements)` attention coefficients.
+
     Args:
         head_size: int, dimensionality of the `query`, `key` and `value` tensors
             after the linear transformation.
@@ -219,26 +311,35 @@ class MultiHeadAttention(tf.keras.layers.Layer):
         depth = tf.constant(self.head_size, dtype=query.dtype)
         query /= tf.sqrt(depth)
 
-        # Calculate dot product attention
-        logits = tf.einsum("...NHO,...MHO->...HNM", query, key)
+        multihead_output = None
+        if not self.return_attn_coef:
+            multihead_output = _dot_product_attention_custom_op(
+                query, key, value, mask, self._droput_rate, training
+            )
 
-        # apply mask
-        if mask is not None:
-            mask = tf.cast(mask, tf.float32)
+        if multihead_output is None:
+            # Calculate dot product attention
+            logits = tf.einsum("...NHO,...MHO->...HNM", query, key)
+
+            # apply mask
+            if mask is not None:
+                mask = tf.cast(mask, logits.dtype)
 
-            # possibly expand on the head dimension so broadcasting works
-            if len(mask.shape) != len(logits.shape):
-                mask = tf.expand_dims(mask, -3)
+                # possibly expand on the head dimension so broadcasting works
+                if len(mask.shape) != len(logits.shape):
+                    mask = tf.expand_dims(mask, -3)
 
-            logits += -10e9 * (1.0 - mask)
+                logits += -10e9 * (1.0 - mask)
 
-        attn_coef = tf.nn.softmax(logits)
+            attn_coef = tf.nn.softmax(logits)
 
-        # attention dropout
-        attn_coef_dropout = self.dropout(attn_coef, training=training)
+            # attention dropout
+            attn_coef_dropout = self.dropout(attn_coef, training=training)
 
-        # attention * value
-        multihead_output = tf.einsum("...HNM,...MHI->...NHI", attn_coef_dropout, value)
+            # attention * value
+            multihead_output = tf.einsum(
+                "...HNM,...MHI->...NHI", attn_coef_dropout, value
+            )
 
         # Run the outputs through another linear projection layer. Recombining heads
         # is automatically done.
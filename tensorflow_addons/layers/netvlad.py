@@ -18,6 +18,39 @@ import math
 import tensorflow as tf
 from typeguard import typechecked
 
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
+
+_netvlad_so = LazySO("custom_ops/layers/_netvlad_ops.so")
+
+
+def _netvlad_custom_op(frames, assignments, cluster_centers):
+    """Aggregates the frames with the fused custom kernel.
+
+    Returns:
+      The NetVLAD descriptors, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or frames.dtype not in (
+        tf.float32,
+        tf.float64,
+    ):
+        return None
+
+    try:
+        return _netvlad_so.ops.addons_net_vlad_aggregate(
+            frames,
+            tf.cast(assignments, frames.dtype),
+            tf.cast(cluster_centers[0], frames.dtype),
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("NetVLAD")
+        return None
+
+
+@tf.RegisterGradient("Addons>NetVLADAggregate")
+def _netvlad_aggregate_grad(op, grad):
+    return _netvlad_so.ops.addons_net_vlad_aggregate_grad(*op.inputs, grad)
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class NetVLAD(tf.keras.layers.Layer):
@@ -88,6 +121,14 @@ class NetVLAD(tf.keras.layers.Layer):
         activation = self.fc(frames)
         activation = tf.reshape(activation, (-1, max_frames, self.num_clusters))
 
+        vlad = _netvlad_custom_op(
+            tf.reshape(frames, (-1, max_frames, feature_dim)),
+            activation,
+            self.cluster_centers,
+        )
+        if vlad is not None:
+            return vlad
+
         # Soft-count of number of frames assigned to each cluster.
         # Output shape: [batch_size, 1, num_clusters]
         a_sum = tf.math.reduce_sum(activation, axis=-2, keepdims=True)
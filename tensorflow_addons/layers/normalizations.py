@@ -19,7 +19,61 @@ import logging
 import tensorflow as tf
 from typeguard import typechecked
 
+from tensorflow_addons import options
 from tensorflow_addons.utils import types
+from tensorflow_addons.utils.resource_loader import LazySO
+
+_normalization_so = LazySO("custom_ops/layers/_normalization_ops.so")
+
+
+def _group_norm_custom_op(inputs, gamma, beta, groups, axis, epsilon):
+    """Applies group normalization with the fused custom kernel.
+
+    Returns:
+      The normalized inputs, or `None` if the custom kernel can't be used.
+    """
+    rank = inputs.shape.rank
+    if (
+        options.is_custom_kernel_disabled()
+        or inputs.dtype not in (tf.float32, tf.float64)
+        or rank is None
+    ):
+        return None
+    if axis % rank == rank - 1:
+        data_format = "NHWC"
+    elif axis % rank == 1:
+        data_format = "NCHW"
+    else:
+        return None
+
+    try:
+        outputs, _, _ = _normalization_so.ops.addons_group_norm(
+            inputs,
+            tf.cast(gamma, inputs.dtype),
+            tf.cast(beta, inputs.dtype),
+            groups=groups,
+            epsilon=epsilon,
+            data_format=data_format,
+        )
+        return outputs
+    except tf.errors.NotFoundError:
+        options.warn_fallback("GroupNormalization")
+        return None
+
+
+@tf.RegisterGradient("Addons>GroupNorm")
+def _group_norm_grad(op, grad, *unused_grads):
+    x, gamma, _ = op.inputs
+    _, mean, inv_std = op.outputs
+    return _normalization_so.ops.addons_group_norm_grad(
+        grad,
+        x,
+        gamma,
+        mean,
+        inv_std,
+        groups=op.get_attr("groups"),
+        data_format=op.get_attr("data_format"),
+    )
 
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
@@ -118,6 +172,18 @@ class GroupNormalization(tf.keras.layers.Layer):
     def call(self, inputs):
 
         input_shape = tf.keras.backend.int_shape(inputs)
+        dim = input_shape[self.axis]
+        outputs = _group_norm_custom_op(
+            inputs,
+            self.gamma if self.scale else tf.ones([dim], inputs.dtype),
+            self.beta if self.center else tf.zeros([dim], inputs.dtype),
+            self.groups,
+            self.axis,
+            self.epsilon,
+        )
+        if outputs is not None:
+            return outputs
+
         tensor_input_shape = tf.shape(inputs)
 
         reshaped_inputs, group_shape = self._reshape_into_groups(
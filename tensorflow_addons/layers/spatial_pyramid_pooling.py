@@ -15,7 +15,10 @@
 """Spatial Pyramid Pooling layers"""
 
 import tensorflow as tf
-from tensorflow_addons.layers.adaptive_pooling import AdaptiveAveragePooling2D
+from tensorflow_addons.layers.adaptive_pooling import (
+    AdaptiveAveragePooling2D,
+    _adaptive_pool_custom_op,
+)
 import tensorflow_addons.utils.keras_utils as conv_utils
 
 from typeguard import typechecked
@@ -32,6 +35,9 @@ class SpatialPyramidPooling2D(tf.keras.layers.Layer):
     regardless of input size/scale. It is typically used before a layer
     that requires a constant input shape, for example before a Dense Layer.
 
+    Every level drops the trailing rows and columns that do not fill a bin.
+    With the custom kernel, all levels are pooled in one pass over the input.
+
     Args:
       bins: Either a collection of integers or a collection of collections of 2 integers.
         Each element in the inner collection must contain 2 integers, (pooled_rows, pooled_cols)
@@ -76,6 +82,12 @@ class SpatialPyramidPooling2D(tf.keras.layers.Layer):
         super().__init__(*args, **kwargs)
 
     def call(self, inputs, **kwargs):
+        outputs = _adaptive_pool_custom_op(
+            inputs, self.bins, tf.reduce_mean, self.data_format, drop_remainder=True
+        )
+        if outputs is not None:
+            return outputs
+
         dynamic_input_shape = tf.shape(inputs)
         outputs = []
         index = 0
@@ -16,6 +16,34 @@
 import tensorflow as tf
 from typeguard import typechecked
 
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
+
+_normalization_so = LazySO("custom_ops/layers/_normalization_ops.so")
+
+
+def _spectral_normalize_custom_op(w, u, power_iterations):
+    """Normalizes `w` and updates `u` in place with the fused custom kernel.
+
+    Returns:
+      Whether the custom kernel was used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or w.dtype not in (tf.float32, tf.float64)
+        or tf.DeviceSpec.from_string(w.device).device_type != "CPU"
+        or tf.DeviceSpec.from_string(u.device).device_type != "CPU"
+    ):
+        return False
+    try:
+        _normalization_so.ops.addons_resource_spectral_normalize(
+            w.handle, u.handle, T=w.dtype, power_iterations=power_iterations
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("SpectralNormalization")
+        return False
+    return True
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class SpectralNormalization(tf.keras.layers.Wrapper):
@@ -111,6 +139,9 @@ class SpectralNormalization(tf.keras.layers.Wrapper):
         spectral normalized value, so that the layer is ready for `call()`.
         """
 
+        if _spectral_normalize_custom_op(self.w, self.u, self.power_iterations):
+            return
+
         w = tf.reshape(self.w, [-1, self.w_shape[-1]])
         u = self.u
 
@@ -16,6 +16,7 @@
 
 import pytest
 import numpy as np
+import tensorflow as tf
 from tensorflow_addons.layers.adaptive_pooling import (
     AdaptiveAveragePooling1D,
     AdaptiveMaxPooling1D,
@@ -184,3 +185,39 @@ def test_max_3d():
         input_data=valid_input,
         expected_output=output,
     )
+
+
+def _adaptive_pool_2d(inputs, output_size, reduce_function):
+    height, width = inputs.shape[1:3]
+    rows = []
+    for i in range(output_size[0]):
+        h0, h1 = i * height // output_size[0], -(-(i + 1) * height // output_size[0])
+        row = []
+        for j in range(output_size[1]):
+            w0, w1 = j * width // output_size[1], -(-(j + 1) * width // output_size[1])
+            row.append(reduce_function(inputs[:, h0:h1, w0:w1], axis=(1, 2)))
+        rows.append(np.stack(row, axis=1))
+    return np.stack(rows, axis=1)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize(
+    "layer_class,reduce_function",
+    [(AdaptiveAveragePooling2D, np.mean), (AdaptiveMaxPooling2D, np.max)],
+)
+def test_non_divisible_2d(layer_class, reduce_function):
+    np.random.seed(0)
+    inputs = tf.constant(np.random.normal(size=(2, 7, 10, 3)))
+    layer = layer_class((3, 4), dtype=tf.float64)
+    expected = _adaptive_pool_2d(inputs.numpy(), (3, 4), reduce_function)
+    np.testing.assert_allclose(layer(inputs), expected, rtol=1e-6, atol=1e-6)
+
+    layer = layer_class((3, 4), data_format="channels_first", dtype=tf.float64)
+    inputs = tf.transpose(inputs, [0, 3, 1, 2])
+    outputs = layer(inputs)
+    np.testing.assert_allclose(
+        outputs, np.transpose(expected, [0, 3, 1, 2]), rtol=1e-6, atol=1e-6
+    )
+
+    theoretical, numerical = tf.test.compute_gradient(layer, [inputs])
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-5, atol=1e-5)
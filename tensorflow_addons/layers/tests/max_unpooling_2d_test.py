@@ -250,3 +250,21 @@ def test_symbolic_tensor_shape():
         updates, indices
     )
     np.testing.assert_array_equal(valid_input.shape.as_list(), output.shape.as_list())
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_against_pooling_input():
+    np.random.seed(0)
+    inputs = tf.constant(np.random.normal(size=(2, 6, 8, 3)))
+    updates, indices = tf.nn.max_pool_with_argmax(
+        inputs, ksize=[2, 2], strides=[2, 2], padding="SAME"
+    )
+    layer = MaxUnpooling2D(dtype=tf.float64)
+    pooled = tf.nn.max_pool2d(inputs, ksize=2, strides=2, padding="SAME")
+    is_max = inputs.numpy() == np.repeat(np.repeat(pooled, 2, axis=1), 2, axis=2)
+    np.testing.assert_array_equal(layer(updates, indices), inputs * is_max)
+
+    theoretical, numerical = tf.test.compute_gradient(
+        lambda x: layer(x, indices), [updates]
+    )
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-6, atol=1e-6)
@@ -343,3 +343,72 @@ def test_mask():
     assert output.shape[2] == v.shape[2]
 
     np.testing.assert_array_equal((attn_coef != 0), mask)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_against_attention_coefficients():
+    np.random.seed(0)
+    q = tf.constant(np.random.normal(size=(2, 40, 9)))
+    k = tf.constant(np.random.normal(size=(2, 70, 11)))
+    v = tf.constant(np.random.normal(size=(2, 70, 13)))
+    mask = tf.constant(np.random.uniform(size=(2, 40, 70)) > 0.2)
+
+    mha = MultiHeadAttention(head_size=6, num_heads=3, dtype=tf.float64)
+    mha_coef = MultiHeadAttention(
+        head_size=6, num_heads=3, return_attn_coef=True, dtype=tf.float64
+    )
+    output = mha([q, k, v], mask=mask)
+    mha_coef([q, k, v], mask=mask)
+    mha_coef.set_weights(mha.get_weights())
+    expected, _ = mha_coef([q, k, v], mask=mask)
+    np.testing.assert_allclose(output, expected, rtol=1e-6, atol=1e-6)
+
+    theoretical, numerical = tf.test.compute_gradient(
+        lambda q, k, v: mha([q, k, v], mask=mask[:1, :5, :7]),
+        [q[:1, :5], k[:1, :7], v[:1, :7]],
+    )
+    for t, n in zip(theoretical, numerical):
+        np.testing.assert_allclose(t, n, rtol=1e-5, atol=1e-5)
+
+
+def _multi_block_inputs():
+    # More than one block of 32 queries and of 64 keys in the kernel.
+    np.random.seed(0)
+    q = tf.constant(np.random.normal(size=(1, 40, 5)))
+    k = tf.constant(np.random.normal(size=(1, 70, 4)))
+    v = tf.constant(np.random.normal(size=(1, 70, 3)))
+    return q, k, v
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_gradients_across_blocks():
+    q, k, v = _multi_block_inputs()
+    mask = tf.constant(np.random.uniform(size=(1, 40, 70)) > 0.2)
+    mha = MultiHeadAttention(head_size=4, num_heads=2, dtype=tf.float64)
+
+    theoretical, numerical = tf.test.compute_gradient(
+        lambda q, k, v: mha([q, k, v], mask=mask), [q, k, v]
+    )
+    for t, n in zip(theoretical, numerical):
+        np.testing.assert_allclose(t, n, rtol=1e-5, atol=1e-5)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_dropout_gradients():
+    q, k, v = _multi_block_inputs()
+    mha = MultiHeadAttention(head_size=4, num_heads=2, dropout=0.5, dtype=tf.float64)
+    expected = mha([q, k, v], training=False)
+
+    def attention(q, k, v):
+        # Resetting the seed draws the same dropout mask in every call, so the
+        # gradients only match if the backward drops what the forward dropped.
+        tf.random.set_seed(1)
+        return mha([q, k, v], training=True)
+
+    output = attention(q, k, v)
+    np.testing.assert_allclose(attention(q, k, v), output)
+    assert not np.allclose(output, expected)
+
+    theoretical, numerical = tf.test.compute_gradient(attention, [q, k, v])
+    for t, n in zip(theoretical, numerical):
+        np.testing.assert_allclose(t, n, rtol=1e-5, atol=1e-5)
@@ -17,6 +17,7 @@
 
 import pytest
 import numpy as np
+import tensorflow as tf
 from tensorflow_addons.layers.netvlad import NetVLAD
 from tensorflow_addons.utils import test_utils
 
@@ -57,3 +58,23 @@ def test_invalid_shape():
             NetVLAD, kwargs={"num_clusters": 2}, input_shape=(5, 4, 4, 20)
         )
     assert "must have rank 3" in str(exception_info.value)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_against_numpy():
+    np.random.seed(0)
+    frames = tf.constant(np.random.normal(size=(3, 7, 5)))
+    layer = NetVLAD(num_clusters=4, dtype=tf.float64)
+    vlad = layer(frames)
+
+    assignments = layer.fc(tf.reshape(frames, (-1, 5))).numpy().reshape(3, 7, 4)
+    centers = layer.cluster_centers.numpy()[0]
+    residuals = np.einsum("btk,btd->bdk", assignments, frames.numpy())
+    residuals -= assignments.sum(axis=1)[:, None, :] * centers
+    residuals /= np.linalg.norm(residuals, axis=1, keepdims=True)
+    expected = residuals.reshape(3, 20)
+    expected /= np.linalg.norm(expected, axis=1, keepdims=True)
+    np.testing.assert_allclose(vlad, expected, rtol=1e-6, atol=1e-6)
+
+    theoretical, numerical = tf.test.compute_gradient(layer, [frames])
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-5, atol=1e-5)
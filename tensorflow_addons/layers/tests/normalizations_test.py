@@ -346,6 +346,65 @@ def test_groupnorm_convnet_no_center_no_scale():
     )
 
 
+def _group_norm_reference(x, gamma, beta, groups, axis, epsilon):
+    x = np.moveaxis(x, axis, -1)
+    grouped = x.reshape(x.shape[0], -1, groups, x.shape[-1] // groups)
+    mean = grouped.mean(axis=(1, 3), keepdims=True)
+    variance = grouped.var(axis=(1, 3), keepdims=True)
+    normalized = ((grouped - mean) / np.sqrt(variance + epsilon)).reshape(x.shape)
+    return np.moveaxis(normalized * gamma + beta, -1, axis)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("axis", [-1, 1])
+@pytest.mark.parametrize("groups", [1, 2, 6])
+def test_groupnorm_against_numpy(axis, groups):
+    np.random.seed(0x2020)
+    x = np.random.normal(loc=2.0, scale=3.0, size=(3, 6, 5, 6))
+    layer = GroupNormalization(
+        groups=groups,
+        axis=axis,
+        epsilon=1e-3,
+        gamma_initializer="random_normal",
+        beta_initializer="random_normal",
+        dtype=tf.float64,
+    )
+    x = tf.constant(x)
+    with tf.GradientTape() as tape:
+        tape.watch(x)
+        y = layer(x)
+        loss = tf.reduce_sum(y * tf.sin(tf.range(tf.size(y), dtype=tf.float64)))
+
+    expected = _group_norm_reference(
+        x.numpy(), layer.gamma.numpy(), layer.beta.numpy(), groups, axis, 1e-3
+    )
+    np.testing.assert_allclose(y, expected, rtol=1e-6, atol=1e-6)
+
+    grads = tape.gradient(loss, [x, layer.gamma, layer.beta])
+    # Permutations moving the channels last and back.
+    to_last, from_last = [0, 1, 2, 3], [0, 1, 2, 3]
+    if axis == 1:
+        to_last, from_last = [0, 2, 3, 1], [0, 3, 1, 2]
+    with tf.GradientTape() as reference_tape:
+        reference_tape.watch(x)
+        x_grouped = tf.transpose(x, to_last)
+        shape = tf.shape(x_grouped)
+        x_grouped = tf.reshape(x_grouped, [3, -1, groups, 6 // groups])
+        mean, variance = tf.nn.moments(x_grouped, [1, 3], keepdims=True)
+        normalized = tf.reshape(
+            (x_grouped - mean) * tf.math.rsqrt(variance + 1e-3), shape
+        )
+        y_reference = tf.transpose(normalized * layer.gamma + layer.beta, from_last)
+        reference_loss = tf.reduce_sum(
+            y_reference * tf.sin(tf.range(tf.size(y), dtype=tf.float64))
+        )
+    expected_grads = reference_tape.gradient(
+        reference_loss, [x, layer.gamma, layer.beta]
+    )
+    for grad, expected_grad in zip(grads, expected_grads):
+        np.testing.assert_allclose(grad, expected_grad, rtol=1e-6, atol=1e-6)
+
+
 def calculate_frn(
     x, beta=0.2, gamma=1, eps=1e-6, learned_epsilon=False, dtype=np.float32
 ):
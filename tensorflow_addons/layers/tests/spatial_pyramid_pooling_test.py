@@ -56,6 +56,30 @@ def test_spp_output_2d():
     )
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_spp_non_divisible_2d():
+    np.random.seed(0)
+    inputs = np.random.normal(size=(2, 7, 10, 3))
+    expected = []
+    for rows, cols in [(1, 1), (2, 3), (3, 4)]:
+        # The trailing rows and columns that do not fill a bin are dropped.
+        height, width = 7 // rows * rows, 10 // cols * cols
+        cropped = inputs[:, :height, :width].reshape(
+            [2, rows, height // rows, cols, width // cols, 3]
+        )
+        expected.append(cropped.mean(axis=(2, 4)).reshape([2, rows * cols, 3]))
+    expected = np.concatenate(expected, axis=1)
+
+    spp = SpatialPyramidPooling2D([[1, 1], [2, 3], [3, 4]], dtype=tf.float64)
+    np.testing.assert_allclose(spp(tf.constant(inputs)), expected, rtol=1e-6)
+
+    spp = SpatialPyramidPooling2D(
+        [[1, 1], [2, 3], [3, 4]], data_format="channels_first", dtype=tf.float64
+    )
+    outputs = spp(tf.constant(np.transpose(inputs, [0, 3, 1, 2])))
+    np.testing.assert_allclose(outputs, np.transpose(expected, [0, 2, 1]), rtol=1e-6)
+
+
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 def test_serialization():
     layer = SpatialPyramidPooling2D([[1, 1], [3, 3]])
@@ -108,6 +108,7 @@ def test_model_build(base_layer_fn, input_shape):
     assert hasattr(model.layers[0], "u")
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 def test_normalization():
     inputs = tf.keras.layers.Input(shape=[2, 2, 1])
@@ -134,6 +135,7 @@ def test_normalization():
         np.testing.assert_allclose(w, np.squeeze(model.layers[0].w.numpy()))
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 def test_apply_layer():
     images = tf.ones((1, 2, 2, 1))
@@ -154,6 +156,31 @@ def test_apply_layer():
     assert hasattr(sn_wrapper, "u")
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("power_iterations", [1, 3])
+def test_power_iterations(dtype, power_iterations):
+    sn_layer = spectral_normalization.SpectralNormalization(
+        tf.keras.layers.Conv2D(4, (3, 3), dtype=dtype),
+        power_iterations=power_iterations,
+    )
+    sn_layer.build((None, 5, 5, 2))
+    w = sn_layer.w.numpy()
+    u = sn_layer.u.numpy()
+
+    w_matrix = w.reshape([-1, 4])
+    for _ in range(power_iterations):
+        v = u @ w_matrix.T
+        v /= np.linalg.norm(v)
+        u = v @ w_matrix
+        u /= np.linalg.norm(u)
+    sigma = (v @ w_matrix) @ u.T
+
+    sn_layer.normalize_weights()
+    np.testing.assert_allclose(sn_layer.u.numpy(), u, rtol=1e-5, atol=1e-6)
+    np.testing.assert_allclose(sn_layer.w.numpy(), w / sigma, rtol=1e-5, atol=1e-6)
+
+
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 def test_no_layer():
     images = tf.random.uniform((2, 4, 43))
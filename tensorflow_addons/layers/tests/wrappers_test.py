@@ -155,6 +155,7 @@ def test_save_file_h5(base_layer, input_shape):
         model.save_weights(os.path.join(tmp_dir, "wrapper_test_model.h5"))
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 @pytest.mark.parametrize(
     "base_layer, input_shape",
@@ -174,6 +175,36 @@ def test_forward_pass(base_layer, input_shape):
     np.testing.assert_allclose(base_output, wn_output, rtol=1e-6, atol=1e-6)
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize(
+    "base_layer, input_shape",
+    [
+        (lambda: tf.keras.layers.Dense(3), [5]),
+        (lambda: tf.keras.layers.Conv2D(4, 2), [4, 4, 2]),
+    ],
+)
+def test_normalized_kernel(base_layer, input_shape):
+    sample_data = np.random.rand(*([2] + input_shape)).astype(np.float32)
+    wn_layer = wrappers.WeightNormalization(base_layer(), False)
+    wn_layer(sample_data)
+    wn_layer.g.assign(np.random.uniform(0.5, 2, size=wn_layer.g.shape))
+    variables = [wn_layer.v, wn_layer.g]
+    weights = tf.constant(np.random.rand(*wn_layer.v.shape), wn_layer.v.dtype)
+
+    with tf.GradientTape(persistent=True) as tape:
+        kernel = wn_layer._normalized_kernel(wn_layer.g)
+        axis = wn_layer.kernel_norm_axes
+        expected_kernel = tf.nn.l2_normalize(wn_layer.v, axis=axis) * wn_layer.g
+        loss = tf.reduce_sum(kernel * weights)
+        expected_loss = tf.reduce_sum(expected_kernel * weights)
+
+    np.testing.assert_allclose(kernel, expected_kernel, rtol=1e-6, atol=1e-6)
+    for grad, expected_grad in zip(
+        tape.gradient(loss, variables), tape.gradient(expected_loss, variables)
+    ):
+        np.testing.assert_allclose(grad, expected_grad, rtol=1e-5, atol=1e-6)
+
+
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 @pytest.mark.parametrize("data_init", [True, False])
 @pytest.mark.parametrize(
@@ -18,6 +18,32 @@ import logging
 import tensorflow as tf
 from typeguard import typechecked
 
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
+
+_normalization_so = LazySO("custom_ops/layers/_normalization_ops.so")
+
+
+def _weight_norm_custom_op(v, g):
+    """Computes `g * v / ||v||` with the fused custom kernel.
+
+    Returns:
+      The normalized kernel, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or v.dtype not in (tf.float32, tf.float64):
+        return None
+    try:
+        return _normalization_so.ops.addons_weight_norm(v, g)
+    except tf.errors.NotFoundError:
+        options.warn_fallback("WeightNormalization")
+        return None
+
+
+@tf.RegisterGradient("Addons>WeightNorm")
+def _weight_norm_grad(op, grad):
+    v, g = op.inputs
+    return _normalization_so.ops.addons_weight_norm_grad(grad, v, g)
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class WeightNormalization(tf.keras.layers.Wrapper):
@@ -138,7 +164,7 @@ class WeightNormalization(tf.keras.layers.Wrapper):
 
         with tf.name_scope("compute_weights"):
             # Replace kernel by normalized weight variable.
-            kernel = tf.nn.l2_normalize(self.v, axis=self.kernel_norm_axes) * g
+            kernel = self._normalized_kernel(g)
 
             if self.is_rnn:
                 self.layer.cell.recurrent_kernel = kernel
@@ -155,6 +181,13 @@ class WeightNormalization(tf.keras.layers.Wrapper):
     def compute_output_shape(self, input_shape):
         return tf.TensorShape(self.layer.compute_output_shape(input_shape).as_list())
 
+    def _normalized_kernel(self, g):
+        """Computes `g * v / ||v||`, fused into one op when possible."""
+        kernel = _weight_norm_custom_op(self.v, g)
+        if kernel is None:
+            kernel = tf.nn.l2_normalize(self.v, axis=self.kernel_norm_axes) * g
+        return kernel
+
     def _initialize_weights(self, inputs):
         """Initialize weight g.
 
@@ -215,7 +248,7 @@ class WeightNormalization(tf.keras.layers.Wrapper):
 
     def remove(self):
         kernel = tf.Variable(
-            tf.nn.l2_normalize(self.v, axis=self.kernel_norm_axes) * self.g,
+            self._normalized_kernel(self.g),
             name="recurrent_kernel" if self.is_rnn else "kernel",
         )
 
@@ -14,14 +14,21 @@
 # ==============================================================================
 """Implements GIoU loss."""
 
+import math
 from typing import Optional
 
 import tensorflow as tf
 from typeguard import typechecked
 
+from tensorflow_addons import options
 from tensorflow_addons.utils.keras_utils import LossFunctionWrapper
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import TensorLike
 
+_box_iou_loss_so = LazySO("custom_ops/losses/_box_iou_loss_ops.so")
+
+_MODES = ["giou", "iou", "diou", "ciou"]
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class GIoULoss(LossFunctionWrapper):
@@ -48,7 +55,8 @@ class GIoULoss(LossFunctionWrapper):
     >>> model.compile('sgd', loss=tfa.losses.GIoULoss())
 
     Args:
-      mode: one of ['giou', 'iou'], decided to calculate GIoU or IoU loss.
+      mode: one of ['giou', 'iou', 'diou', 'ciou'], decided to calculate GIoU,
+        IoU, DIoU or CIoU loss.
     """
 
     @typechecked
@@ -71,27 +79,65 @@ def giou_loss(y_true: TensorLike, y_pred: TensorLike, mode: str = "giou") -> tf.
     (https://giou.stanford.edu/GIoU.pdf).
     GIoU is an enhancement for models which use IoU in object detection.
 
+    DIoU and CIoU were introduced in
+    [Distance-IoU Loss: Faster and Better Learning for Bounding Box
+    Regression](https://arxiv.org/abs/1911.08287). DIoU also penalizes the
+    distance between the box centers, and CIoU also the difference of their
+    aspect ratios.
+
     Args:
         y_true: true targets tensor. The coordinates of the each bounding
             box in boxes are encoded as [y_min, x_min, y_max, x_max].
         y_pred: predictions tensor. The coordinates of the each bounding
             box in boxes are encoded as [y_min, x_min, y_max, x_max].
-        mode: one of ['giou', 'iou'], decided to calculate GIoU or IoU loss.
+        mode: one of ['giou', 'iou', 'diou', 'ciou'], decided to calculate
+            GIoU, IoU, DIoU or CIoU loss.
 
     Returns:
         GIoU loss float `Tensor`.
     """
-    if mode not in ["giou", "iou"]:
-        raise ValueError("Value of mode should be 'iou' or 'giou'")
+    if mode not in _MODES:
+        raise ValueError("Value of mode should be 'iou', 'giou', 'diou' or 'ciou'")
     y_pred = tf.convert_to_tensor(y_pred)
     if not y_pred.dtype.is_floating:
         y_pred = tf.cast(y_pred, tf.float32)
     y_true = tf.cast(y_true, y_pred.dtype)
+    loss = _box_iou_loss_custom_op(y_pred, y_true, mode)
+    if loss is not None:
+        return tf.squeeze(loss)
     giou = tf.squeeze(_calculate_giou(y_pred, y_true, mode))
 
     return 1 - giou
 
 
+def _box_iou_loss_custom_op(b1, b2, mode):
+    """Computes the box IoU loss with the custom kernel.
+
+    Returns:
+      The loss, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or b1.dtype not in (tf.float32, tf.float64):
+        return None
+    if not b1.shape.is_fully_defined() or b1.shape != b2.shape:
+        # The kernel reads pairs of boxes of the same shape, broadcasting
+        # is a no-op when they already are.
+        shape = tf.broadcast_dynamic_shape(tf.shape(b1), tf.shape(b2))
+        b1 = tf.broadcast_to(b1, shape)
+        b2 = tf.broadcast_to(b2, shape)
+    try:
+        return _box_iou_loss_so.ops.addons_box_iou_loss(b1, b2, mode=mode)
+    except tf.errors.NotFoundError:
+        options.warn_fallback("giou_loss")
+        return None
+
+
+@tf.RegisterGradient("Addons>BoxIoULoss")
+def _box_iou_loss_grad(op, grad):
+    return _box_iou_loss_so.ops.addons_box_iou_loss_grad(
+        *op.inputs, grad, mode=op.get_attr("mode")
+    )
+
+
 def _calculate_giou(b1: TensorLike, b2: TensorLike, mode: str = "giou") -> tf.Tensor:
     """
     Args:
@@ -99,7 +145,8 @@ def _calculate_giou(b1: TensorLike, b2: TensorLike, mode: str = "giou") -> tf.Te
             encoded as [y_min, x_min, y_max, x_max].
         b2: the other bounding box. The coordinates of the each bounding box
             in boxes are encoded as [y_min, x_min, y_max, x_max].
-        mode: one of ['giou', 'iou'], decided to calculate GIoU or IoU loss.
+        mode: one of ['giou', 'iou', 'diou', 'ciou'], decided to calculate
+            GIoU, IoU, DIoU or CIoU loss.
 
     Returns:
         GIoU loss float `Tensor`.
@@ -133,6 +180,23 @@ def _calculate_giou(b1: TensorLike, b2: TensorLike, mode: str = "giou") -> tf.Te
     enclose_xmax = tf.maximum(b1_xmax, b2_xmax)
     enclose_width = tf.maximum(zero, enclose_xmax - enclose_xmin)
     enclose_height = tf.maximum(zero, enclose_ymax - enclose_ymin)
-    enclose_area = enclose_width * enclose_height
-    giou = iou - tf.math.divide_no_nan((enclose_area - union_area), enclose_area)
-    return giou
+    if mode == "giou":
+        enclose_area = enclose_width * enclose_height
+        giou = iou - tf.math.divide_no_nan((enclose_area - union_area), enclose_area)
+        return giou
+
+    center_dy = (b1_ymin + b1_ymax - b2_ymin - b2_ymax) / 2
+    center_dx = (b1_xmin + b1_xmax - b2_xmin - b2_xmax) / 2
+    center_distance = tf.square(center_dy) + tf.square(center_dx)
+    diagonal = tf.square(enclose_width) + tf.square(enclose_height)
+    diou = iou - tf.math.divide_no_nan(center_distance, diagonal)
+    if mode == "diou":
+        return diou
+
+    aspect_ratio = (4 / math.pi ** 2) * tf.square(
+        tf.math.atan2(b2_width, b2_height) - tf.math.atan2(b1_width, b1_height)
+    )
+    alpha = tf.stop_gradient(
+        tf.math.divide_no_nan(aspect_ratio, 1 - iou + aspect_ratio)
+    )
+    return diou - alpha * aspect_ratio
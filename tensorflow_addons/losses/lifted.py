@@ -15,6 +15,7 @@
 """Implements lifted_struct_loss."""
 
 import tensorflow as tf
+from tensorflow_addons import options
 from tensorflow_addons.losses import metric_learning
 
 from tensorflow_addons.utils.keras_utils import LossFunctionWrapper
@@ -23,6 +24,38 @@ from typeguard import typechecked
 from typing import Optional
 
 
+def _lifted_struct_loss_custom_op(labels, embeddings, margin):
+    """Computes the lifted structured loss with the custom kernel.
+
+    Returns:
+      The loss, or `None` if the custom kernel can't be used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or labels.dtype not in (tf.int32, tf.int64)
+        or embeddings.dtype not in (tf.float32, tf.float64)
+    ):
+        return None
+
+    try:
+        return metric_learning._metric_learning_so.ops.addons_lifted_struct_loss(
+            tf.reshape(labels, [-1]), embeddings, tf.cast(margin, embeddings.dtype)
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("lifted_struct_loss")
+        return None
+
+
+@tf.RegisterGradient("Addons>LiftedStructLoss")
+def _lifted_struct_loss_grad(op, grad):
+    labels, embeddings, margin = op.inputs
+    ops = metric_learning._metric_learning_so.ops
+    embeddings_grads = ops.addons_lifted_struct_loss_grad(
+        labels, embeddings, margin, grad
+    )
+    return [None, embeddings_grads, None]
+
+
 @tf.keras.utils.register_keras_serializable(package="Addons")
 @tf.function
 def lifted_struct_loss(
@@ -47,6 +80,10 @@ def lifted_struct_loss(
         tf.cast(embeddings, tf.dtypes.float32) if convert_to_float32 else embeddings
     )
 
+    lifted_loss = _lifted_struct_loss_custom_op(labels, precise_embeddings, margin)
+    if lifted_loss is not None:
+        return tf.cast(lifted_loss, embeddings.dtype)
+
     # Reshape [batch_size] label tensor to a [batch_size, 1] label tensor.
     lshape = tf.shape(labels)
     labels = tf.reshape(labels, [lshape[0], 1])
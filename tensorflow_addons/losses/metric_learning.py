@@ -15,10 +15,22 @@
 """Functions of metric learning."""
 
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import TensorLike
 
+_metric_learning_so = LazySO("custom_ops/losses/_metric_learning_ops.so")
+
+tf.no_gradient("Addons>PairwiseDistanceReduce")
+
+
+def _use_custom_kernel(feature):
+    return not options.is_custom_kernel_disabled() and feature.dtype in (
+        tf.float32,
+        tf.float64,
+    )
+
 
-@tf.function
 def pairwise_distance(feature: TensorLike, squared: bool = False):
     """Computes the pairwise distance matrix with numerical stability.
 
@@ -31,6 +43,20 @@ def pairwise_distance(feature: TensorLike, squared: bool = False):
     Returns:
       pairwise_distances: 2-D Tensor of size `[number of data, number of data]`.
     """
+    feature = tf.convert_to_tensor(feature, name="feature")
+    if _use_custom_kernel(feature):
+        try:
+            return _metric_learning_so.ops.addons_pairwise_distance(
+                feature, metric="squared-L2" if squared else "L2"
+            )
+        except tf.errors.NotFoundError:
+            options.warn_fallback("pairwise_distance")
+
+    return _pairwise_distance(feature, squared)
+
+
+@tf.function
+def _pairwise_distance(feature, squared):
     pairwise_distances_squared = (
         tf.math.add(
             tf.math.reduce_sum(tf.math.square(feature), axis=[1], keepdims=True),
@@ -70,7 +96,6 @@ def pairwise_distance(feature: TensorLike, squared: bool = False):
     return pairwise_distances
 
 
-@tf.function
 def angular_distance(feature: TensorLike):
     """Computes the angular distance matrix.
 
@@ -82,6 +107,20 @@ def angular_distance(feature: TensorLike):
     Returns:
       angular_distances: 2-D Tensor of size `[number of data, number of data]`.
     """
+    feature = tf.convert_to_tensor(feature, name="feature")
+    if _use_custom_kernel(feature):
+        try:
+            return _metric_learning_so.ops.addons_pairwise_distance(
+                feature, metric="angular"
+            )
+        except tf.errors.NotFoundError:
+            options.warn_fallback("angular_distance")
+
+    return _angular_distance(feature)
+
+
+@tf.function
+def _angular_distance(feature):
     # normalize input
     feature = tf.math.l2_normalize(feature, axis=1)
 
@@ -92,3 +131,89 @@ def angular_distance(feature: TensorLike):
     angular_distances = tf.maximum(angular_distances, 0.0)
 
     return angular_distances
+
+
+def pairwise_distance_reduce(
+    feature: TensorLike, reduction: str = "min", distance_metric: str = "L2"
+):
+    """Computes the nearest or farthest other row of every row of `feature`.
+
+    output[i] = reduction_{j != i} distance(feature[i, :], feature[j, :])
+
+    The custom kernel reduces the distance matrix tile by tile and never
+    materializes it, so the memory used is linear in the batch size.
+
+    Args:
+      feature: 2-D Tensor of size `[number of data, feature dimension]`.
+      reduction: `"min"` or `"max"`.
+      distance_metric: `"L2"`, `"squared-L2"` or `"angular"`.
+
+    Returns:
+      values: 1-D Tensor of size `[number of data]` with the reduced distances.
+      indices: 1-D int32 Tensor of size `[number of data]` with the row the
+        reduced distance was found at. A batch of a single row is reduced
+        against itself.
+    """
+    if reduction not in ("min", "max"):
+        raise ValueError("`reduction` must be either `min` or `max`.")
+    if distance_metric not in ("L2", "squared-L2", "angular"):
+        raise ValueError(
+            "`distance_metric` must be one of `L2`, `squared-L2` or `angular`."
+        )
+
+    feature = tf.convert_to_tensor(feature, name="feature")
+    indices = None
+    if _use_custom_kernel(feature):
+        try:
+            _, indices = _metric_learning_so.ops.addons_pairwise_distance_reduce(
+                feature, metric=distance_metric, reduction=reduction
+            )
+        except tf.errors.NotFoundError:
+            options.warn_fallback("pairwise_distance_reduce")
+
+    if indices is None:
+        if distance_metric == "angular":
+            pdist_matrix = _angular_distance(feature)
+        else:
+            pdist_matrix = _pairwise_distance(feature, distance_metric == "squared-L2")
+        num_data = tf.shape(feature)[0]
+        fill = float("inf") if reduction == "min" else float("-inf")
+        diagonal = tf.math.logical_and(
+            tf.cast(tf.eye(num_data), tf.bool), tf.math.greater(num_data, 1)
+        )
+        pdist_matrix = tf.where(
+            diagonal, tf.cast(fill, pdist_matrix.dtype), pdist_matrix
+        )
+        arg_reduce = tf.math.argmin if reduction == "min" else tf.math.argmax
+        indices = arg_reduce(pdist_matrix, axis=1, output_type=tf.int32)
+
+    # The distances of the selected pairs are recomputed from the gathered rows
+    # so that they are differentiable at O(batch) cost.
+    values = _paired_distance(feature, tf.gather(feature, indices), distance_metric)
+    return values, indices
+
+
+def _paired_distance(feature_a, feature_b, distance_metric):
+    if distance_metric == "angular":
+        cosine_similarity = tf.math.reduce_sum(
+            tf.math.l2_normalize(feature_a, axis=1)
+            * tf.math.l2_normalize(feature_b, axis=1),
+            axis=1,
+        )
+        return tf.maximum(1 - cosine_similarity, 0.0)
+
+    distances_squared = tf.math.reduce_sum(tf.math.square(feature_a - feature_b), 1)
+    if distance_metric == "squared-L2":
+        return distances_squared
+    error_mask = tf.math.less_equal(distances_squared, 0.0)
+    distances = tf.math.sqrt(
+        distances_squared + tf.cast(error_mask, distances_squared.dtype) * 1e-16
+    )
+    return distances * tf.cast(tf.math.logical_not(error_mask), distances.dtype)
+
+
+@tf.RegisterGradient("Addons>PairwiseDistance")
+def _pairwise_distance_grad(op, grad):
+    return _metric_learning_so.ops.addons_pairwise_distance_grad(
+        op.inputs[0], grad, metric=op.get_attr("metric")
+    )
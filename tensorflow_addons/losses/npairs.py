@@ -17,9 +17,42 @@
 import tensorflow as tf
 from typeguard import typechecked
 
+from tensorflow_addons import options
+from tensorflow_addons.losses import metric_learning
 from tensorflow_addons.utils.types import TensorLike
 
 
+def _npairs_loss_custom_op(y_true, y_pred):
+    """Computes the npairs loss with the custom kernel.
+
+    Returns:
+      The loss, or `None` if the custom kernel can't be used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or y_true.dtype not in (tf.int32, tf.int64)
+        or y_pred.dtype not in (tf.float32, tf.float64)
+    ):
+        return None
+
+    try:
+        return metric_learning._metric_learning_so.ops.addons_npairs_loss(
+            y_true, y_pred
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("npairs_loss")
+        return None
+
+
+@tf.RegisterGradient("Addons>NpairsLoss")
+def _npairs_loss_grad(op, grad):
+    labels, logits = op.inputs
+    logits_grads = metric_learning._metric_learning_so.ops.addons_npairs_loss_grad(
+        labels, logits, grad
+    )
+    return [None, logits_grads]
+
+
 @tf.keras.utils.register_keras_serializable(package="Addons")
 @tf.function
 def npairs_loss(y_true: TensorLike, y_pred: TensorLike) -> tf.Tensor:
@@ -61,6 +94,10 @@ def npairs_loss(y_true: TensorLike, y_pred: TensorLike) -> tf.Tensor:
       npairs_loss: float scalar.
     """
     y_pred = tf.convert_to_tensor(y_pred)
+    loss = _npairs_loss_custom_op(tf.convert_to_tensor(y_true), y_pred)
+    if loss is not None:
+        return loss
+
     y_true = tf.cast(y_true, y_pred.dtype)
 
     # Expand to [batch_size, 1]
@@ -21,6 +21,7 @@ import numpy as np
 import tensorflow as tf
 from tensorflow_addons.utils import test_utils
 from tensorflow_addons.losses import giou_loss, GIoULoss
+from tensorflow_addons.losses.giou_loss import _calculate_giou
 
 
 def test_config():
@@ -49,6 +50,43 @@ def test_giou_loss(dtype):
     test_utils.assert_allclose_according_to_type(loss, expected_result)
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize(
+    "mode,expected",
+    [
+        ("diou", [0.9969512195121951, 1.6243093922651934]),
+        ("ciou", [0.999313052496148, 1.641531433948796]),
+    ],
+)
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+def test_distance_modes(mode, expected, dtype):
+    boxes1 = tf.constant([[4.0, 3.0, 7.0, 5.0], [5.0, 6.0, 10.0, 7.0]], dtype=dtype)
+    boxes2 = tf.constant([[3.0, 4.0, 6.0, 8.0], [14.0, 14.0, 15.0, 15.0]], dtype=dtype)
+    loss = giou_loss(boxes1, boxes2, mode=mode)
+    test_utils.assert_allclose_according_to_type(loss, tf.constant(expected, dtype))
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("mode", ["iou", "giou", "diou", "ciou"])
+def test_gradients(mode):
+    np.random.seed(0)
+    mins = np.random.uniform(0, 4, size=(2, 16, 2))
+    sizes = np.random.uniform(0.1, 3, size=(2, 16, 2))
+    boxes1, boxes2 = tf.unstack(tf.constant(np.concatenate([mins, mins + sizes], -1)))
+
+    with tf.GradientTape(persistent=True) as tape:
+        tape.watch([boxes1, boxes2])
+        loss = giou_loss(boxes2, boxes1, mode=mode)
+        expected_loss = 1 - _calculate_giou(boxes1, boxes2, mode)
+
+    np.testing.assert_allclose(loss, expected_loss, rtol=1e-6)
+    for grad, expected_grad in zip(
+        tape.gradient(loss, [boxes1, boxes2]),
+        tape.gradient(expected_loss, [boxes1, boxes2]),
+    ):
+        np.testing.assert_allclose(grad, expected_grad, rtol=1e-6, atol=1e-9)
+
+
 @pytest.mark.parametrize("dtype", [np.float16, np.float32, np.float64])
 def test_different_shapes(dtype):
     boxes1 = tf.constant([[4.0, 3.0, 7.0, 5.0], [5.0, 6.0, 10.0, 7.0]], dtype=dtype)
@@ -120,3 +120,20 @@ def test_keras_model_compile():
 def test_serialization():
     loss = lifted.LiftedStructLoss()
     tf.keras.losses.deserialize(tf.keras.losses.serialize(loss))
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_lifted_struct_gradients():
+    np.random.seed(0)
+    embedding = np.random.rand(20, 6)
+    labels = np.random.randint(0, 4, size=20)
+
+    def loss_fn(embedding):
+        return lifted.lifted_struct_loss.python_function(tf.constant(labels), embedding)
+
+    loss = loss_fn(tf.constant(embedding))
+    loss_np = lifted_struct_loss_np(labels, embedding, 1.0)
+    np.testing.assert_allclose(loss, loss_np, rtol=1e-6, atol=1e-6)
+
+    theoretical, numerical = tf.test.compute_gradient(loss_fn, [tf.constant(embedding)])
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-5, atol=1e-5)
@@ -18,6 +18,7 @@
 import pytest
 import numpy as np
 import tensorflow as tf
+from tensorflow_addons.losses import metric_learning
 from tensorflow_addons.losses.metric_learning import pairwise_distance
 
 
@@ -58,3 +59,54 @@ def test_correct_distance_squared():
 
     distances = pairwise_distance(tf_embeddings, squared=True)
     np.testing.assert_allclose(expected_distance, distances, 1e-6, 1e-6)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("distance_metric", ["L2", "squared-L2", "angular"])
+def test_distance_gradients(distance_metric):
+    """Compare gradients against the pure python implementation."""
+    embeddings = tf.constant(np.random.rand(300, 7), dtype=tf.float32)
+    weights = tf.constant(np.random.rand(300, 300), dtype=tf.float32)
+
+    def loss(fn, *args):
+        with tf.GradientTape() as tape:
+            tape.watch(embeddings)
+            distances = fn(embeddings, *args)
+            value = tf.math.reduce_sum(weights * distances)
+        return distances, tape.gradient(value, embeddings)
+
+    if distance_metric == "angular":
+        distances, grads = loss(metric_learning.angular_distance)
+        expected_distances, expected_grads = loss(metric_learning._angular_distance)
+    else:
+        squared = distance_metric == "squared-L2"
+        distances, grads = loss(pairwise_distance, squared)
+        expected_distances, expected_grads = loss(
+            metric_learning._pairwise_distance, squared
+        )
+    np.testing.assert_allclose(distances, expected_distances, 1e-4, 1e-4)
+    np.testing.assert_allclose(grads, expected_grads, 1e-3, 1e-3)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("reduction", ["min", "max"])
+@pytest.mark.parametrize("distance_metric", ["L2", "squared-L2", "angular"])
+def test_pairwise_distance_reduce(reduction, distance_metric):
+    """Compare against a reduction of the full distance matrix."""
+    embeddings = np.random.rand(200, 5).astype(np.float32)
+    values, indices = metric_learning.pairwise_distance_reduce(
+        embeddings, reduction=reduction, distance_metric=distance_metric
+    )
+
+    if distance_metric == "angular":
+        distances = metric_learning._angular_distance(embeddings).numpy()
+    else:
+        distances = metric_learning._pairwise_distance(
+            embeddings, distance_metric == "squared-L2"
+        ).numpy()
+    np.fill_diagonal(distances, np.inf if reduction == "min" else -np.inf)
+    reduce_fn = np.min if reduction == "min" else np.max
+    np.testing.assert_allclose(values, reduce_fn(distances, axis=1), 1e-4, 1e-4)
+    np.testing.assert_allclose(
+        distances[np.arange(200), indices], reduce_fn(distances, axis=1), 1e-4, 1e-4
+    )
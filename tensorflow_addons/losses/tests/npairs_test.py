@@ -14,6 +14,7 @@
 # ==============================================================================
 """Tests for npairs loss."""
 
+import pytest
 import numpy as np
 import tensorflow as tf
 from tensorflow_addons.losses import npairs
@@ -133,3 +134,26 @@ def test_multilabel():
     y_true = tf.sparse.from_dense(y_true)
     loss = nml_obj(y_true, y_pred)
     np.testing.assert_allclose(loss, 1.420522, rtol=1e-06, atol=1e-06)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_npairs_gradients():
+    np.random.seed(0)
+    y_true = np.random.randint(0, 4, size=30)
+    y_pred = np.random.randn(30, 30)
+
+    def loss_fn(y_pred):
+        return npairs.npairs_loss.python_function(tf.constant(y_true), y_pred)
+
+    soft_labels = np.equal(y_true[:, None], y_true[None, :]).astype(np.float64)
+    soft_labels /= np.sum(soft_labels, axis=1, keepdims=True)
+    row_max = np.max(y_pred, axis=1, keepdims=True)
+    log_softmax = y_pred - row_max
+    log_softmax -= np.log(np.sum(np.exp(log_softmax), axis=1, keepdims=True))
+    expected_loss = -np.mean(np.sum(soft_labels * log_softmax, axis=1))
+    np.testing.assert_allclose(
+        loss_fn(tf.constant(y_pred)), expected_loss, rtol=1e-6, atol=1e-6
+    )
+
+    theoretical, numerical = tf.test.compute_gradient(loss_fn, [tf.constant(y_pred)])
+    np.testing.assert_allclose(theoretical[0], numerical[0], rtol=1e-5, atol=1e-5)
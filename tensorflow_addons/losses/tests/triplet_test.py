@@ -18,7 +18,7 @@ import pytest
 import numpy as np
 import tensorflow as tf
 
-from tensorflow_addons.losses import triplet
+from tensorflow_addons.losses import metric_learning, triplet
 from tensorflow_addons.utils import test_utils
 
 
@@ -233,3 +233,41 @@ def test_keras_model_compile_hard():
 def test_serialization_hard():
     loss = triplet.TripletHardLoss()
     tf.keras.losses.deserialize(tf.keras.losses.serialize(loss))
+
+
+# Callable distance metrics always use the Python implementation.
+CALLABLE_METRICS = {
+    "angular": metric_learning.angular_distance,
+    "squared-L2": lambda x: metric_learning.pairwise_distance(x, squared=True),
+    "L2": lambda x: metric_learning.pairwise_distance(x, squared=False),
+}
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize(
+    "mining, soft", [("semihard", False), ("hard", False), ("hard", True)]
+)
+@pytest.mark.parametrize("dist_metric", ["angular", "squared-L2", "L2"])
+@pytest.mark.parametrize("num_data", [16, 45])
+def test_triplet_loss_gradients(mining, soft, dist_metric, num_data):
+    np.random.seed(0)
+    embedding = tf.constant(np.random.rand(num_data, 6).astype(np.float32))
+    labels = tf.constant(np.random.randint(0, 4, size=num_data))
+
+    def loss_and_grads(distance_metric):
+        with tf.GradientTape() as tape:
+            tape.watch(embedding)
+            if mining == "semihard":
+                loss = triplet.triplet_semihard_loss.python_function(
+                    labels, embedding, distance_metric=distance_metric
+                )
+            else:
+                loss = triplet.triplet_hard_loss.python_function(
+                    labels, embedding, soft=soft, distance_metric=distance_metric
+                )
+        return loss, tape.gradient(loss, embedding)
+
+    loss, grads = loss_and_grads(dist_metric)
+    expected_loss, expected_grads = loss_and_grads(CALLABLE_METRICS[dist_metric])
+    np.testing.assert_allclose(loss, expected_loss, rtol=1e-5, atol=1e-6)
+    np.testing.assert_allclose(grads, expected_grads, rtol=1e-4, atol=1e-5)
@@ -15,6 +15,7 @@
 """Implements triplet loss."""
 
 import tensorflow as tf
+from tensorflow_addons import options
 from tensorflow_addons.losses import metric_learning
 from tensorflow_addons.utils.keras_utils import LossFunctionWrapper
 from tensorflow_addons.utils.types import FloatTensorLike, TensorLike
@@ -66,6 +67,56 @@ def _masked_minimum(data, mask, dim=1):
     return masked_minimums
 
 
+def _triplet_loss_custom_op(
+    labels, embeddings, margin, distance_metric, mining, soft=False
+):
+    """Computes the triplet loss with the custom kernel.
+
+    The kernel mines every anchor row against all candidates without building
+    the tiled `[batch_size ** 2, batch_size]` masks, so it uses O(batch_size)
+    memory per thread.
+
+    Returns:
+      The loss, or `None` if the custom kernel can't be used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or distance_metric not in ("L2", "squared-L2", "angular")
+        or labels.dtype not in (tf.int32, tf.int64)
+        or embeddings.dtype not in (tf.float32, tf.float64)
+    ):
+        return None
+
+    try:
+        return metric_learning._metric_learning_so.ops.addons_triplet_loss(
+            tf.reshape(labels, [-1]),
+            embeddings,
+            tf.cast(margin, embeddings.dtype),
+            metric=distance_metric,
+            mining=mining,
+            soft=soft,
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("triplet_loss")
+        return None
+
+
+@tf.RegisterGradient("Addons>TripletLoss")
+def _triplet_loss_grad(op, grad):
+    labels, embeddings, margin = op.inputs
+    ops = metric_learning._metric_learning_so.ops
+    embeddings_grads = ops.addons_triplet_loss_grad(
+        labels,
+        embeddings,
+        margin,
+        grad,
+        metric=op.get_attr("metric"),
+        mining=op.get_attr("mining"),
+        soft=op.get_attr("soft"),
+    )
+    return [None, embeddings_grads, None]
+
+
 @tf.keras.utils.register_keras_serializable(package="Addons")
 @tf.function
 def triplet_semihard_loss(
@@ -115,6 +166,12 @@ def triplet_semihard_loss(
         tf.cast(embeddings, tf.dtypes.float32) if convert_to_float32 else embeddings
     )
 
+    triplet_loss = _triplet_loss_custom_op(
+        labels, precise_embeddings, margin, distance_metric, "semihard"
+    )
+    if triplet_loss is not None:
+        return tf.cast(triplet_loss, embeddings.dtype)
+
     # Reshape label tensor to [batch_size, 1].
     lshape = tf.shape(labels)
     labels = tf.reshape(labels, [lshape[0], 1])
@@ -252,6 +309,12 @@ def triplet_hard_loss(
         tf.cast(embeddings, tf.dtypes.float32) if convert_to_float32 else embeddings
     )
 
+    triplet_loss = _triplet_loss_custom_op(
+        labels, precise_embeddings, margin, distance_metric, "hard", soft
+    )
+    if triplet_loss is not None:
+        return tf.cast(triplet_loss, embeddings.dtype)
+
     # Reshape label tensor to [batch_size, 1].
     lshape = tf.shape(labels)
     labels = tf.reshape(labels, [lshape[0], 1])
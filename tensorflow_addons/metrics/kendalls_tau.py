@@ -16,10 +16,14 @@
 
 import tensorflow as tf
 from tensorflow.keras.metrics import Metric
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import AcceptableDTypes
 
 from typeguard import typechecked
 
+_metric_so = LazySO("custom_ops/metrics/_metric_ops.so")
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class KendallsTau(Metric):
@@ -29,6 +33,8 @@ class KendallsTau(Metric):
     of values, with allowances for ties.
 
     Based on the algorithm of Wei Xiao https://arxiv.org/abs/1712.01521.
+    Values are binned with the cut points, and the metric keeps a dense
+    `[actual_cutpoints, preds_cutpoints]` matrix of joint bin counts.
 
     Usage:
 
@@ -76,7 +82,22 @@ class KendallsTau(Metric):
         self.preds_max = preds_max
         self.actual_cutpoints = actual_cutpoints
         self.preds_cutpoints = preds_cutpoints
-        self.reset_states()
+        self.actual_cuts = tf.linspace(
+            tf.cast(self.actual_min, tf.float32),
+            tf.cast(self.actual_max, tf.float32),
+            self.actual_cutpoints - 1,
+        )
+        self.preds_cuts = tf.linspace(
+            tf.cast(self.preds_min, tf.float32),
+            tf.cast(self.preds_max, tf.float32),
+            self.preds_cutpoints - 1,
+        )
+        self.m = self.add_weight(
+            "m",
+            shape=[self.actual_cutpoints, self.preds_cutpoints],
+            initializer="zeros",
+            dtype=tf.int64,
+        )
 
     def update_state(self, y_true, y_pred, sample_weight=None):
         """Accumulates ranks.
@@ -89,53 +110,34 @@ class KendallsTau(Metric):
         Returns:
           Update op.
         """
-        if y_true.shape and y_true.shape[0]:
-            i = tf.searchsorted(
-                self.actual_cuts,
-                tf.cast(tf.reshape(y_true, -1), self.actual_cuts.dtype),
-            )
-            j = tf.searchsorted(
-                self.preds_cuts, tf.cast(tf.reshape(y_pred, -1), self.preds_cuts.dtype)
-            )
-
-            def body(k, n, m, nrow, ncol):
-                return (
-                    k + 1,
-                    n + 1,
-                    tf.sparse.add(
-                        m,
-                        tf.SparseTensor(
-                            [[i[k], j[k]]],
-                            tf.cast([1], dtype=self.m.dtype),
-                            self.m.shape,
-                        ),
-                    ),
-                    tf.sparse.add(
-                        nrow,
-                        tf.SparseTensor(
-                            [[i[k]]],
-                            tf.cast([1], dtype=self.nrow.dtype),
-                            self.nrow.shape,
-                        ),
-                    ),
-                    tf.sparse.add(
-                        ncol,
-                        tf.SparseTensor(
-                            [[j[k]]],
-                            tf.cast([1], dtype=self.ncol.dtype),
-                            self.ncol.shape,
-                        ),
-                    ),
+        y_true = tf.cast(tf.reshape(y_true, [-1]), tf.float32)
+        y_pred = tf.cast(tf.reshape(y_pred, [-1]), tf.float32)
+        if self._use_custom_kernel():
+            try:
+                return _metric_so.ops.addons_kendalls_tau_update(
+                    self.m.handle, y_true, y_pred, self.actual_cuts, self.preds_cuts
                 )
-
-            _, self.n, self.m, self.nrow, self.ncol = tf.while_loop(
-                lambda k, n, m, nrow, ncol: k < i.shape[0],
-                body=body,
-                loop_vars=(0, self.n, self.m, self.nrow, self.ncol),
-            )
+            except tf.errors.NotFoundError:
+                options.warn_fallback("KendallsTau")
+
+        i = tf.searchsorted(self.actual_cuts, y_true)
+        j = tf.searchsorted(self.preds_cuts, y_pred)
+        indices = tf.cast(tf.stack([i, j], axis=1), tf.int64)
+        counts = tf.scatter_nd(
+            indices, tf.ones_like(i, dtype=tf.int64), tf.shape(self.m, tf.int64)
+        )
+        return self.m.assign_add(counts)
 
     def result(self):
-        m_dense = tf.sparse.to_dense(tf.cast(self.m, tf.float32))
+        if self._use_custom_kernel():
+            try:
+                return _metric_so.ops.addons_kendalls_tau(
+                    self.m.read_value(), T=tf.float32
+                )
+            except tf.errors.NotFoundError:
+                options.warn_fallback("KendallsTau")
+
+        m_dense = tf.cast(self.m, tf.float32)
         n_cap = tf.cumsum(
             tf.cumsum(
                 tf.slice(tf.pad(m_dense, [[1, 0], [1, 0]]), [0, 0], self.m.shape),
@@ -148,21 +150,27 @@ class KendallsTau(Metric):
         sum_m_squard = tf.math.reduce_sum(tf.math.square(m_dense))
         # Ties in x.
         t = (
-            tf.math.reduce_sum(tf.math.square(tf.sparse.to_dense(self.nrow)))
+            tf.math.reduce_sum(tf.math.square(tf.math.reduce_sum(m_dense, axis=1)))
             - sum_m_squard
         ) / 2.0
         # Ties in y.
         u = (
-            tf.math.reduce_sum(tf.math.square(tf.sparse.to_dense(self.ncol)))
+            tf.math.reduce_sum(tf.math.square(tf.math.reduce_sum(m_dense, axis=0)))
             - sum_m_squard
         ) / 2.0
         # Ties in both.
         b = tf.math.reduce_sum(tf.multiply(m_dense, (m_dense - 1.0))) / 2.0
         # Number of discordant pairs.
-        n = tf.cast(self.n, tf.float32)
+        n = tf.math.reduce_sum(m_dense)
         q = (n - 1.0) * n / 2.0 - p - t - u - b
         return (p - q) / tf.math.sqrt((p + q + t) * (p + q + u))
 
+    def _use_custom_kernel(self):
+        return (
+            not options.is_custom_kernel_disabled()
+            and tf.DeviceSpec.from_string(self.m.device).device_type == "CPU"
+        )
+
     def get_config(self):
         """Returns the serializable config of the metric."""
 
@@ -179,25 +187,4 @@ class KendallsTau(Metric):
 
     def reset_states(self):
         """Resets all of the metric state variables."""
-        self.actual_cuts = tf.linspace(
-            tf.cast(self.actual_min, tf.float32),
-            tf.cast(self.actual_max, tf.float32),
-            self.actual_cutpoints - 1,
-        )
-        self.preds_cuts = tf.linspace(
-            tf.cast(self.preds_min, tf.float32),
-            tf.cast(self.preds_max, tf.float32),
-            self.preds_cutpoints - 1,
-        )
-        self.m = tf.SparseTensor(
-            tf.zeros((0, 2), tf.int64),
-            [],
-            [self.actual_cutpoints, self.preds_cutpoints],
-        )
-        self.nrow = tf.SparseTensor(
-            tf.zeros((0, 1), dtype=tf.int64), [], [self.actual_cutpoints]
-        )
-        self.ncol = tf.SparseTensor(
-            tf.zeros((0, 1), dtype=tf.int64), [], [self.preds_cutpoints]
-        )
-        self.n = 0
+        self.m.assign(tf.zeros_like(self.m))
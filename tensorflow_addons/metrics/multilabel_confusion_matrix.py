@@ -14,16 +14,18 @@
 # ==============================================================================
 """Implements Multi-label confusion matrix scores."""
 
-import warnings
-
 import tensorflow as tf
 from tensorflow.keras import backend as K
 from tensorflow.keras.metrics import Metric
 import numpy as np
 
 from typeguard import typechecked
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import AcceptableDTypes, FloatTensorLike
 
+_metric_so = LazySO("custom_ops/metrics/_metric_ops.so")
+
 
 class MultiLabelConfusionMatrix(Metric):
     """Computes Multi-label confusion matrix.
@@ -46,6 +48,12 @@ class MultiLabelConfusionMatrix(Metric):
     - false negatives for class `i` in `M(1,0)`
     - true positives for class `i` in `M(1,1)`
 
+    Labels and predictions are cast to `int32`, which truncates
+    probabilities, and are expected to be 0 or 1 after the cast. If
+    `sample_weight` is given to `update_state`, it can be a scalar, a
+    `[batch_size]` vector or a `[batch_size, num_classes]` matrix, and every
+    entry adds its weight instead of one to the counts.
+
     Args:
         num_classes: `int`, the number of labels the prediction task can have.
         name: (Optional) string name of the metric instance.
@@ -122,12 +130,16 @@ class MultiLabelConfusionMatrix(Metric):
         )
 
     def update_state(self, y_true, y_pred, sample_weight=None):
+        if not options.is_custom_kernel_disabled():
+            try:
+                used, update = self._custom_update(y_true, y_pred, sample_weight)
+                if used:
+                    return update
+            except tf.errors.NotFoundError:
+                options.warn_fallback("MultiLabelConfusionMatrix")
+
         if sample_weight is not None:
-            warnings.warn(
-                "`sample_weight` is not None. Be aware that MultiLabelConfusionMatrix "
-                "does not take `sample_weight` into account when computing the metric "
-                "value."
-            )
+            return self._weighted_update(y_true, y_pred, sample_weight)
 
         y_true = tf.cast(y_true, tf.int32)
         y_pred = tf.cast(y_pred, tf.int32)
@@ -154,6 +166,85 @@ class MultiLabelConfusionMatrix(Metric):
         # true negative state update
         self.true_negatives.assign_add(tf.cast(true_negative, self.dtype))
 
+    def _custom_update(self, y_true, y_pred, sample_weight):
+        """Updates the four counts with `Addons>MultiLabelConfusionMatrixUpdate`,
+        which reads the labels once and accumulates in place. Returns whether
+        the op could be used for these inputs, and the op. The op is `None` in
+        eager mode since it has no outputs."""
+        if self.dtype not in ("float32", "float64", "int32", "int64") or any(
+            tf.DeviceSpec.from_string(v.device).device_type != "CPU"
+            for v in self.variables
+        ):
+            return False, None
+        y_true = tf.convert_to_tensor(y_true)
+        y_pred = tf.convert_to_tensor(y_pred)
+        if y_true.shape.rank != 2 or y_pred.shape.rank != 2:
+            return False, None
+        labels_dtype = y_true.dtype
+        if labels_dtype != y_pred.dtype or labels_dtype not in (
+            tf.bool,
+            tf.int8,
+            tf.int16,
+            tf.int32,
+            tf.int64,
+            tf.uint8,
+        ):
+            # Truncated like in the Python path.
+            labels_dtype = tf.int32
+        if sample_weight is None:
+            sample_weight = tf.ones([], self.dtype)
+        return True, _metric_so.ops.addons_multi_label_confusion_matrix_update(
+            true_positives=self.true_positives.handle,
+            false_positives=self.false_positives.handle,
+            false_negatives=self.false_negatives.handle,
+            true_negatives=self.true_negatives.handle,
+            y_true=tf.cast(y_true, labels_dtype),
+            y_pred=tf.cast(y_pred, labels_dtype),
+            sample_weight=self._flatten_sample_weight(sample_weight),
+        )
+
+    def _flatten_sample_weight(self, sample_weight):
+        # [batch_size, 1] weights are the same as [batch_size] ones.
+        sample_weight = tf.cast(sample_weight, self.dtype)
+        if sample_weight.shape.rank == 2 and sample_weight.shape[-1] == 1:
+            sample_weight = tf.squeeze(sample_weight, axis=-1)
+        return sample_weight
+
+    def _weighted_update(self, y_true, y_pred, sample_weight):
+        # The same counts as the unweighted update, where the true negatives
+        # are the entries where neither the label nor the prediction is 1.
+        y_true = tf.cast(y_true, tf.int32)
+        y_pred = tf.cast(y_pred, tf.int32)
+        sample_weight = self._flatten_sample_weight(sample_weight)
+        if sample_weight.shape.rank == 1:
+            sample_weight = tf.expand_dims(sample_weight, -1)
+        sample_weight = tf.broadcast_to(sample_weight, tf.shape(y_true))
+        zeros = tf.zeros_like(sample_weight)
+
+        def weighted_count(mask):
+            return tf.reduce_sum(tf.where(mask, sample_weight, zeros), axis=0)
+
+        true_nonzero = tf.math.not_equal(y_true, 0)
+        pred_nonzero = tf.math.not_equal(y_pred, 0)
+        true_zero = tf.math.logical_not(true_nonzero)
+        pred_zero = tf.math.logical_not(pred_nonzero)
+        self.true_positives.assign_add(
+            weighted_count(tf.math.logical_and(true_nonzero, pred_nonzero))
+        )
+        self.false_positives.assign_add(
+            weighted_count(tf.math.logical_and(true_zero, pred_nonzero))
+        )
+        self.false_negatives.assign_add(
+            weighted_count(tf.math.logical_and(true_nonzero, pred_zero))
+        )
+        self.true_negatives.assign_add(
+            weighted_count(
+                tf.math.logical_and(
+                    tf.math.not_equal(y_true, 1), tf.math.not_equal(y_pred, 1)
+                )
+            )
+        )
+
     def result(self):
         flat_confusion_matrix = tf.convert_to_tensor(
             [
@@ -79,6 +79,26 @@ def test_scoring_iterative():
     np.testing.assert_almost_equal(metric.result(), stats.kendalltau(actuals, preds)[0])
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_scoring_large_batches():
+    rng = np.random.RandomState(0)
+    actuals = rng.randint(0, 10, size=5000)
+    preds = np.clip(actuals + rng.randint(-3, 4, size=5000), 0, 9)
+
+    # One bin per integer value, so that the binned result is exact.
+    metric = KendallsTau(0.5, 9.5, 0.5, 9.5, 11, 11)
+    metric.update_state(tf.constant(actuals[:3000]), tf.constant(preds[:3000]))
+    metric.update_state(tf.constant(actuals[3000:]), tf.constant(preds[3000:]))
+    np.testing.assert_allclose(
+        metric.result(), stats.kendalltau(actuals, preds)[0], rtol=1e-5
+    )
+    metric.reset_states()
+    metric.update_state(tf.constant(actuals[:10]), tf.constant(preds[:10]))
+    np.testing.assert_allclose(
+        metric.result(), stats.kendalltau(actuals[:10], preds[:10])[0], rtol=1e-5
+    )
+
+
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 def test_keras_binary_classification_model():
     kp = KendallsTau()
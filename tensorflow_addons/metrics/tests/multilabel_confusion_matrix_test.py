@@ -129,3 +129,48 @@ def test_multiclass(dtype):
         mcm_obj,
         [[[5, 2], [0, 3]], [[7, 1], [2, 0]], [[7, 0], [1, 2]], [[8, 0], [0, 2]]],
     )
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("labels_dtype", [tf.bool, tf.int8, tf.int64])
+def test_sample_weight(labels_dtype):
+    rng = np.random.RandomState(0)
+    actuals = rng.randint(0, 2, size=(50, 6))
+    preds = rng.randint(0, 2, size=(50, 6))
+    row_weights = rng.uniform(size=50).astype(np.float32)
+    element_weights = rng.uniform(size=(50, 6)).astype(np.float32)
+
+    def expected(weights):
+        weights = np.broadcast_to(weights, actuals.shape)
+        counts = [
+            np.sum(weights * ((actuals == t) & (preds == p)), axis=0)
+            for t in (0, 1)
+            for p in (0, 1)
+        ]
+        return np.stack(counts, axis=-1).reshape([-1, 2, 2])
+
+    for weights, expected_weights in [
+        (None, 1.0),
+        (row_weights, row_weights[:, None]),
+        (row_weights[:, None], row_weights[:, None]),
+        (element_weights, element_weights),
+    ]:
+        mcm_obj = MultiLabelConfusionMatrix(num_classes=6)
+        mcm_obj.update_state(
+            tf.cast(actuals, labels_dtype), tf.cast(preds, labels_dtype), weights
+        )
+        mcm_obj.update_state(
+            tf.cast(actuals, labels_dtype), tf.cast(preds, labels_dtype), weights
+        )
+        check_results(mcm_obj, 2 * expected(expected_weights))
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("weights", [None, 1.0])
+def test_float_labels(weights):
+    # Probabilities are truncated to integers, weighted or not.
+    actuals = tf.constant([[0.3, 0.0], [0.0, 1.0]])
+    preds = tf.constant([[1.0, 0.0], [0.7, 0.0]])
+    mcm_obj = MultiLabelConfusionMatrix(num_classes=2)
+    mcm_obj.update_state(actuals, preds, weights)
+    check_results(mcm_obj, [[[1, 1], [0, 0]], [[1, 0], [1, 0]]])
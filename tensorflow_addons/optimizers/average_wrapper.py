@@ -17,10 +17,14 @@ import abc
 import warnings
 
 import tensorflow as tf
+from tensorflow_addons import options
 from tensorflow_addons.utils import types
+from tensorflow_addons.utils.resource_loader import LazySO
 
 from typeguard import typechecked
 
+_optimizer_so = LazySO("custom_ops/optimizers/_optimizer_ops.so")
+
 
 class AveragedOptimizerWrapper(tf.keras.optimizers.Optimizer, metaclass=abc.ABCMeta):
     @typechecked
@@ -39,6 +43,8 @@ class AveragedOptimizerWrapper(tf.keras.optimizers.Optimizer, metaclass=abc.ABCM
 
         self._optimizer = optimizer
         self._track_trackable(self._optimizer, "awg_optimizer")
+        # Set while the fused kernel updates the averages after the step.
+        self._defer_average = False
 
     def _create_slots(self, var_list):
         self._optimizer._create_slots(var_list=var_list)
@@ -59,7 +65,87 @@ class AveragedOptimizerWrapper(tf.keras.optimizers.Optimizer, metaclass=abc.ABCM
     def average_op(self, var, average_var, local_apply_state):
         raise NotImplementedError
 
+    def _average_decay(self, local_apply_state):
+        """Returns the scalar `decay` for which `average_op` is
+        `average = decay * average + (1 - decay) * var`, or `None` if it can't
+        be written that way.
+
+        When a decay is returned, the averages of all variables are updated by
+        one `Addons>MultiTensorAverage` call per device and dtype instead of
+        one `average_op` per variable.
+        """
+        return None
+
+    def _distributed_apply(self, distribution, grads_and_vars, name, apply_state):
+        decays = self._fused_average_decays(grads_and_vars, apply_state)
+        if decays is None:
+            return super()._distributed_apply(
+                distribution, grads_and_vars, name, apply_state
+            )
+
+        self._defer_average = True
+        try:
+            train_op = super()._distributed_apply(
+                distribution, grads_and_vars, name, apply_state
+            )
+        finally:
+            self._defer_average = False
+
+        groups = {}
+        for _, var in grads_and_vars:
+            groups.setdefault((var.device, var.dtype.base_dtype), []).append(var)
+        average_ops = []
+        with tf.control_dependencies([train_op]):
+            for (var_device, var_dtype), var_list in groups.items():
+                with tf.device(var_device):
+                    average_ops.append(
+                        _optimizer_so.ops.addons_multi_tensor_average(
+                            var=[var.handle for var in var_list],
+                            average=[
+                                self.get_slot(var, "average").handle
+                                for var in var_list
+                            ],
+                            decay=decays[(var_device, var_dtype)],
+                            use_locking=self._use_locking,
+                        )
+                    )
+        return tf.group(train_op, *average_ops)
+
+    def _fused_average_decays(self, grads_and_vars, apply_state):
+        """Returns the decay of every (device, dtype) group of variables, or
+        `None` if their averages can't be updated by the fused kernel.
+
+        The decays are computed before the step, so they see the same
+        iteration count as `average_op` would.
+        """
+        if options.is_custom_kernel_disabled() or tf.distribute.has_strategy():
+            return None
+        decays = {}
+        for _, var in grads_and_vars:
+            key = (var.device, var.dtype.base_dtype)
+            if (
+                var.dtype.base_dtype not in (tf.float32, tf.float64)
+                or tf.DeviceSpec.from_string(var.device).device_type != "CPU"
+            ):
+                return None
+            if key not in decays:
+                local_apply_state = (apply_state or {}).get(
+                    key
+                ) or self._fallback_apply_state(*key)
+                decay = self._average_decay(local_apply_state)
+                if decay is None:
+                    return None
+                decays[key] = tf.cast(decay, key[1])
+        try:
+            _optimizer_so.ops
+        except tf.errors.NotFoundError:
+            options.warn_fallback("MultiTensorAverage")
+            return None
+        return decays
+
     def _apply_average_op(self, train_op, var, apply_state):
+        if self._defer_average:
+            return tf.no_op()
         apply_state = apply_state or {}
         local_apply_state = apply_state.get((var.device, var.dtype.base_dtype))
         if local_apply_state is None:
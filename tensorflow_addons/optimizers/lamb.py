@@ -23,8 +23,12 @@ from typing import Optional, Union, Callable, List
 from typeguard import typechecked
 
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import FloatTensorLike
 
+_optimizer_so = LazySO("custom_ops/optimizers/_optimizer_ops.so")
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class LAMB(tf.keras.optimizers.Optimizer):
@@ -213,6 +217,75 @@ class LAMB(tf.keras.optimizers.Optimizer):
         )
         return tf.group(*[var_update, m_t, v_t])
 
+    def _distributed_apply(self, distribution, grads_and_vars, name, apply_state):
+        if self._use_fused_kernel(grads_and_vars):
+            try:
+                with tf.name_scope(name or self._name):
+                    update_ops = self._fused_apply_dense(grads_and_vars, apply_state)
+                    with tf.control_dependencies(update_ops):
+                        return self.iterations.assign_add(1)
+            except tf.errors.NotFoundError:
+                options.warn_fallback("LAMB")
+        return super()._distributed_apply(
+            distribution, grads_and_vars, name, apply_state
+        )
+
+    def _use_fused_kernel(self, grads_and_vars):
+        """Whether all variables can be updated by one fused kernel call per
+        device and dtype."""
+        if options.is_custom_kernel_disabled() or tf.distribute.has_strategy():
+            return False
+        for grad, var in grads_and_vars:
+            if (
+                not isinstance(grad, tf.Tensor)
+                or var.constraint is not None
+                or var.dtype.base_dtype not in (tf.float32, tf.float64)
+                or tf.DeviceSpec.from_string(var.device).device_type != "CPU"
+            ):
+                return False
+        return True
+
+    def _fused_apply_dense(self, grads_and_vars, apply_state):
+        """Applies the dense updates with `Addons>ResourceApplyLambMulti`, which
+        does the slot updates, both norms and the trust ratio of every
+        variable in two passes over it."""
+        groups = {}
+        for grad, var in grads_and_vars:
+            key = (var.device, var.dtype.base_dtype)
+            groups.setdefault(key, []).append((grad, var))
+
+        update_ops = []
+        for (var_device, var_dtype), group in groups.items():
+            coefficients = (apply_state or {}).get(
+                (var_device, var_dtype)
+            ) or self._fallback_apply_state(var_device, var_dtype)
+            grads, var_list = zip(*group)
+            var_names = [self._get_variable_name(var.name) for var in var_list]
+            with tf.device(var_device):
+                update_ops.append(
+                    _optimizer_so.ops.addons_resource_apply_lamb_multi(
+                        var=[var.handle for var in var_list],
+                        m=[self.get_slot(var, "m").handle for var in var_list],
+                        v=[self.get_slot(var, "v").handle for var in var_list],
+                        grad=list(grads),
+                        lr=coefficients["lr_t"],
+                        beta_1=coefficients["beta_1_t"],
+                        beta_2=coefficients["beta_2_t"],
+                        epsilon=coefficients["epsilon"],
+                        weight_decay_rate=coefficients["weight_decay_rate"],
+                        beta_1_power=coefficients["beta_1_power"],
+                        beta_2_power=coefficients["beta_2_power"],
+                        use_weight_decay=[
+                            self._do_use_weight_decay(n) for n in var_names
+                        ],
+                        use_layer_adaptation=[
+                            self._do_layer_adaptation(n) for n in var_names
+                        ],
+                        use_locking=self._use_locking,
+                    )
+                )
+        return update_ops
+
     def get_config(self):
         config = super().get_config()
         config.update(
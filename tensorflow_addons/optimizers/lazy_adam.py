@@ -21,11 +21,15 @@ original Adam algorithm, and may lead to different empirical results.
 """
 
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import FloatTensorLike
 
 from typeguard import typechecked
 from typing import Union, Callable
 
+_optimizer_so = LazySO("custom_ops/optimizers/_optimizer_ops.so")
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class LazyAdam(tf.keras.optimizers.Adam):
@@ -95,15 +99,62 @@ class LazyAdam(tf.keras.optimizers.Adam):
             **kwargs,
         )
 
-    def _resource_apply_sparse(self, grad, var, indices):
-        var_dtype = var.dtype.base_dtype
-        lr_t = self._decayed_lr(var_dtype)
+    def _sparse_coefficients(self, var_dtype):
         beta_1_t = self._get_hyper("beta_1", var_dtype)
         beta_2_t = self._get_hyper("beta_2", var_dtype)
         local_step = tf.cast(self.iterations + 1, var_dtype)
-        beta_1_power = tf.math.pow(beta_1_t, local_step)
-        beta_2_power = tf.math.pow(beta_2_t, local_step)
-        epsilon_t = tf.convert_to_tensor(self.epsilon, var_dtype)
+        return dict(
+            lr_t=self._decayed_lr(var_dtype),
+            beta_1_t=beta_1_t,
+            beta_2_t=beta_2_t,
+            beta_1_power=tf.math.pow(beta_1_t, local_step),
+            beta_2_power=tf.math.pow(beta_2_t, local_step),
+            epsilon_t=tf.convert_to_tensor(self.epsilon, var_dtype),
+        )
+
+    def _resource_apply_sparse_duplicate_indices(self, grad, var, indices, **kwargs):
+        if (
+            not options.is_custom_kernel_disabled()
+            and var.dtype.base_dtype in (tf.float32, tf.float64)
+            and tf.DeviceSpec.from_string(var.device).device_type == "CPU"
+        ):
+            try:
+                return self._fused_apply_sparse(grad, var, indices)
+            except tf.errors.NotFoundError:
+                options.warn_fallback("LazyAdam")
+        return super()._resource_apply_sparse_duplicate_indices(
+            grad, var, indices, **kwargs
+        )
+
+    def _fused_apply_sparse(self, grad, var, indices):
+        """Applies the update with `Addons>ResourceSparseApplyLazyAdam`, which
+        sums the gradients of repeated indices itself and updates every row of
+        `var`, `m` and `v` in place, instead of two gathers and three
+        scatters."""
+        coefficients = self._sparse_coefficients(var.dtype.base_dtype)
+        return _optimizer_so.ops.addons_resource_sparse_apply_lazy_adam(
+            var=var.handle,
+            m=self.get_slot(var, "m").handle,
+            v=self.get_slot(var, "v").handle,
+            beta_1_power=coefficients["beta_1_power"],
+            beta_2_power=coefficients["beta_2_power"],
+            lr=coefficients["lr_t"],
+            beta_1=coefficients["beta_1_t"],
+            beta_2=coefficients["beta_2_t"],
+            epsilon=coefficients["epsilon_t"],
+            grad=grad,
+            indices=indices,
+            use_locking=self._use_locking,
+        )
+
+    def _resource_apply_sparse(self, grad, var, indices):
+        coefficients = self._sparse_coefficients(var.dtype.base_dtype)
+        lr_t = coefficients["lr_t"]
+        beta_1_t = coefficients["beta_1_t"]
+        beta_2_t = coefficients["beta_2_t"]
+        beta_1_power = coefficients["beta_1_power"]
+        beta_2_power = coefficients["beta_2_power"]
+        epsilon_t = coefficients["epsilon_t"]
         lr = lr_t * tf.math.sqrt(1 - beta_2_power) / (1 - beta_1_power)
 
         # \\(m := beta1 * m + (1 - beta1) * g_t\\)
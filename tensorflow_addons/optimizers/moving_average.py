@@ -15,12 +15,16 @@
 
 import tensorflow as tf
 
+from tensorflow_addons import options
 from tensorflow_addons.optimizers import AveragedOptimizerWrapper
 from tensorflow_addons.utils import types
+from tensorflow_addons.utils.resource_loader import LazySO
 
 from typing import Union
 from typeguard import typechecked
 
+_optimizer_so = LazySO("custom_ops/optimizers/_optimizer_ops.so")
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class MovingAverage(AveragedOptimizerWrapper):
@@ -118,6 +122,9 @@ class MovingAverage(AveragedOptimizerWrapper):
             average_var, var, local_apply_state["tfa_ma_decay"]
         )
 
+    def _average_decay(self, local_apply_state):
+        return local_apply_state["tfa_ma_decay"]
+
     def get_config(self):
         config = {
             "average_decay": self._serialize_hyperparameter("average_decay"),
@@ -164,6 +171,44 @@ class MovingAverage(AveragedOptimizerWrapper):
                 "Swapping weights must occur under a " "tf.distribute.Strategy"
             )
 
+    def _use_fused_swap(self, strategy):
+        if options.is_custom_kernel_disabled() or not self._model_weights:
+            return False
+        return all(
+            var.dtype.base_dtype in (tf.float32, tf.float64)
+            and tf.DeviceSpec.from_string(component.device).device_type == "CPU"
+            for var in self._model_weights
+            for component in strategy.experimental_local_results(var)
+        )
+
+    def _fused_swap(self, strategy):
+        """Swaps the weights in place with one `Addons>MultiTensorSwap` call per
+        device and dtype, instead of three assigns per variable.
+
+        Every copy of a variable is swapped with the copy of its average on the
+        same device, so mirrored variables stay in sync.
+        """
+        groups = {}
+        for average, var in zip(self._average_weights, self._model_weights):
+            for average_component, var_component in zip(
+                strategy.experimental_local_results(average),
+                strategy.experimental_local_results(var),
+            ):
+                key = (var_component.device, var.dtype.base_dtype)
+                groups.setdefault(key, []).append((average_component, var_component))
+        swap_ops = []
+        for (var_device, var_dtype), pairs in groups.items():
+            with tf.device(var_device):
+                swap_ops.append(
+                    _optimizer_so.ops.addons_multi_tensor_swap(
+                        a=[average.handle for average, _ in pairs],
+                        b=[var.handle for _, var in pairs],
+                        dtype=var_dtype,
+                        use_locking=self._use_locking,
+                    )
+                )
+        return tf.group(swap_ops)
+
     @tf.function
     def _swap_weights(self):
         def fn_0(a, b):
@@ -177,6 +222,11 @@ class MovingAverage(AveragedOptimizerWrapper):
 
         def swap(strategy, a, b):
             """Swap `a` and `b` and mirror to all devices."""
+            if self._use_fused_swap(strategy):
+                try:
+                    return self._fused_swap(strategy)
+                except tf.errors.NotFoundError:
+                    options.warn_fallback("MultiTensorSwap")
             for a_element, b_element in zip(a, b):
                 strategy.extended.update(
                     a_element, fn_0, args=(b_element,)
@@ -15,11 +15,15 @@
 """NovoGrad for TensorFlow."""
 
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import FloatTensorLike
 
 from typing import Union, Callable
 from typeguard import typechecked
 
+_optimizer_so = LazySO("custom_ops/optimizers/_optimizer_ops.so")
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class NovoGrad(tf.keras.optimizers.Optimizer):
@@ -150,11 +154,50 @@ class NovoGrad(tf.keras.optimizers.Optimizer):
             weights = weights[: len(params)]
         super().set_weights(weights)
 
+    def _use_fused_kernel(self, var):
+        return (
+            not options.is_custom_kernel_disabled()
+            and var.dtype.base_dtype in (tf.float32, tf.float64)
+            and tf.DeviceSpec.from_string(var.device).device_type == "CPU"
+        )
+
+    def _fused_apply(self, grad, var, coefficients, indices=None):
+        """Applies the update with `Addons>ResourceApplyNovoGrad`, or
+        `Addons>ResourceSparseApplyNovoGrad` when `indices` is given, which
+        reduce the squared norm of `grad` and then update `m` and `var` in a
+        single pass, instead of materializing every intermediate gradient."""
+        var_dtype = var.dtype.base_dtype
+        inputs = dict(
+            var=var.handle,
+            m=self.get_slot(var, "m").handle,
+            v=self.get_slot(var, "v").handle,
+            vhat=[self.get_slot(var, "vhat").handle] if self.amsgrad else [],
+            step=self.iterations,
+            lr=coefficients["lr_t"],
+            beta_1=coefficients["beta_1_t"],
+            beta_2=coefficients["beta_2_t"],
+            epsilon=coefficients["epsilon"],
+            weight_decay=self._get_hyper("weight_decay", var_dtype),
+            grad_averaging=tf.cast(self._get_hyper("grad_averaging"), tf.bool),
+            grad=grad,
+            use_locking=self._use_locking,
+        )
+        if indices is None:
+            return _optimizer_so.ops.addons_resource_apply_novo_grad(**inputs)
+        return _optimizer_so.ops.addons_resource_sparse_apply_novo_grad(
+            indices=indices, **inputs
+        )
+
     def _resource_apply_dense(self, grad, var, apply_state=None):
         var_device, var_dtype = var.device, var.dtype.base_dtype
         coefficients = (apply_state or {}).get(
             (var_device, var_dtype)
         ) or self._fallback_apply_state(var_device, var_dtype)
+        if self._use_fused_kernel(var):
+            try:
+                return self._fused_apply(grad, var, coefficients)
+            except tf.errors.NotFoundError:
+                options.warn_fallback("NovoGrad")
         weight_decay = self._get_hyper("weight_decay", var_dtype)
         grad_averaging = self._get_hyper("grad_averaging")
 
@@ -198,6 +241,11 @@ class NovoGrad(tf.keras.optimizers.Optimizer):
         coefficients = (apply_state or {}).get(
             (var_device, var_dtype)
         ) or self._fallback_apply_state(var_device, var_dtype)
+        if self._use_fused_kernel(var):
+            try:
+                return self._fused_apply(grad, var, coefficients, indices)
+            except tf.errors.NotFoundError:
+                options.warn_fallback("NovoGrad")
         weight_decay = self._get_hyper("weight_decay", var_dtype)
         grad_averaging = self._get_hyper("grad_averaging")
 
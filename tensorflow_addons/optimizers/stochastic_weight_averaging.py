@@ -112,8 +112,9 @@ class SWA(AveragedOptimizerWrapper):
         self._set_hyper("average_period", average_period)
         self._set_hyper("start_averaging", start_averaging)
 
-    @tf.function
-    def average_op(self, var, average_var, local_apply_state):
+    def _snapshot(self):
+        """Returns whether this iteration takes a snapshot, and the number of
+        snapshots averaged before it."""
         average_period = self._get_hyper("average_period", tf.dtypes.int64)
         start_averaging = self._get_hyper("start_averaging", tf.dtypes.int64)
         # number of times snapshots of weights have been taken (using max to
@@ -127,13 +128,27 @@ class SWA(AveragedOptimizerWrapper):
         # 1. A min number of iterations (start_averaging) have taken place.
         # 2. Iteration is one in which snapshot should be taken.
         checkpoint = start_averaging + num_snapshots * average_period
-        if self.iterations >= start_averaging and self.iterations == checkpoint:
-            num_snapshots = tf.cast(num_snapshots, tf.float32)
+        take_snapshot = tf.math.logical_and(
+            self.iterations >= start_averaging,
+            tf.math.equal(self.iterations, checkpoint),
+        )
+        return take_snapshot, tf.cast(num_snapshots, tf.float32)
+
+    @tf.function
+    def average_op(self, var, average_var, local_apply_state):
+        take_snapshot, num_snapshots = self._snapshot()
+        if take_snapshot:
             average_value = (average_var * num_snapshots + var) / (num_snapshots + 1.0)
             return average_var.assign(average_value, use_locking=self._use_locking)
 
         return average_var
 
+    def _average_decay(self, local_apply_state):
+        # A running mean over n snapshots is a moving average with decay
+        # n / (n + 1); a decay of 1 leaves the averages untouched.
+        take_snapshot, num_snapshots = self._snapshot()
+        return tf.where(take_snapshot, num_snapshots / (num_snapshots + 1.0), 1.0)
+
     def get_config(self):
         config = {
             "average_period": self._serialize_hyperparameter("average_period"),
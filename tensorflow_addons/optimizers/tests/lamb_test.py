@@ -327,6 +327,47 @@ def test_resource():
             test_utils.assert_allclose_according_to_type(var1_np, var1.numpy())
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("dtype", [tf.float32, tf.float64])
+def test_multiple_variables_with_exclusions(dtype):
+    var_nps = [
+        np.random.rand(*shape).astype(dtype.as_numpy_dtype)
+        for shape in [(300, 200), (7,), (3, 4)]
+    ]
+    grad_nps = [np.random.randn(*x.shape).astype(x.dtype) for x in var_nps]
+    slots = [(0.0, 0.0) for _ in var_nps]
+    var_list = [
+        tf.Variable(x, name=name) for x, name in zip(var_nps, ["w", "bias", "w1"])
+    ]
+
+    opt = lamb.LAMB(
+        learning_rate=0.01,
+        weight_decay_rate=0.01,
+        exclude_from_weight_decay=["bias"],
+        exclude_from_layer_adaptation=["w1"],
+    )
+    for t in range(3):
+        opt.apply_gradients(zip([tf.constant(g) for g in grad_nps], var_list))
+        for i, (var_np, grad_np) in enumerate(zip(var_nps, grad_nps)):
+            m, v = slots[i]
+            lamb_wd = 0.0 if i == 1 else 0.01
+            if i == 2:
+                # No layer adaptation: the update is not rescaled.
+                _, m, v = lamb_update_numpy(var_np, grad_np, t, m, v, 0.01, lamb_wd)
+                m_hat = m / (1 - 0.9 ** (t + 1))
+                v_hat = v / (1 - 0.999 ** (t + 1))
+                update = m_hat / (np.sqrt(v_hat) + 1e-6) + lamb_wd * var_np
+                var_nps[i] = var_np - 0.01 * update
+            else:
+                var_nps[i], m, v = lamb_update_numpy(
+                    var_np, grad_np, t, m, v, 0.01, lamb_wd
+                )
+            slots[i] = (m, v)
+
+        for var_np, var in zip(var_nps, var_list):
+            test_utils.assert_allclose_according_to_type(var_np, var.numpy())
+
+
 def test_get_config():
     opt = lamb.LAMB(1e-4)
     config = opt.get_config()
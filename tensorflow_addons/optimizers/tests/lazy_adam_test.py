@@ -142,6 +142,33 @@ def test_sparse_repeated_indices(dtype):
             )
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("dtype", [tf.float32, tf.float64])
+def test_sparse_rows_with_repeated_indices(dtype):
+    with tf.device("CPU:0"):
+        var_np = np.random.rand(50, 4).astype(dtype.as_numpy_dtype)
+        m_np = np.zeros_like(var_np)
+        v_np = np.zeros_like(var_np)
+        var = tf.Variable(var_np)
+        indices_np = np.array([3, 7, 3, 49, 0, 7, 3])
+        grads_np = np.random.randn(len(indices_np), 4).astype(var_np.dtype)
+        grads = tf.IndexedSlices(
+            tf.constant(grads_np), tf.constant(indices_np), tf.constant([50, 4])
+        )
+
+        opt = lazy_adam.LazyAdam(0.01)
+        for t in range(3):
+            opt.apply_gradients([(grads, var)])
+
+            summed = np.zeros_like(var_np)
+            np.add.at(summed, indices_np, grads_np)
+            rows = np.unique(indices_np)
+            var_np[rows], m_np[rows], v_np[rows] = adam_update_numpy(
+                var_np[rows], summed[rows], t, m_np[rows], v_np[rows], lr=0.01
+            )
+            test_utils.assert_allclose_according_to_type(var_np, var.numpy())
+
+
 @pytest.mark.parametrize("use_callable_params", [True, False])
 @pytest.mark.parametrize("dtype", [tf.half, tf.float32, tf.float64])
 def test_basic(use_callable_params, dtype):
@@ -293,6 +293,53 @@ def test_swap_weights(device):
     np.testing.assert_allclose(ema_var.read_value(), [0.9, 1.9])
 
 
+def _check_multiple_variables_average_and_swap(strategy):
+    var_nps = [
+        np.random.rand(200, 100).astype(np.float32),
+        np.random.rand(5).astype(np.float32),
+    ]
+    grad_nps = [np.random.randn(*x.shape).astype(np.float32) for x in var_nps]
+    average_nps = [x.copy() for x in var_nps]
+    with strategy.scope():
+        var_list = [tf.Variable(x) for x in var_nps]
+        opt = MovingAverage(tf.keras.optimizers.SGD(lr=0.5), average_decay=0.9)
+
+    @tf.function
+    def apply_gradients():
+        opt.apply_gradients(zip([tf.constant(g) for g in grad_nps], var_list))
+
+    for _ in range(3):
+        strategy.run(apply_gradients)
+        for i, grad_np in enumerate(grad_nps):
+            var_nps[i] = var_nps[i] - 0.5 * grad_np
+            average_nps[i] = 0.9 * average_nps[i] + 0.1 * var_nps[i]
+
+    for var, var_np, average_np in zip(var_list, var_nps, average_nps):
+        np.testing.assert_allclose(var.numpy(), var_np, rtol=1e-5, atol=1e-6)
+        average = opt.get_slot(var, "average")
+        np.testing.assert_allclose(average.numpy(), average_np, rtol=1e-5, atol=1e-6)
+
+    with strategy.scope():
+        opt.swap_weights()
+    for var, var_np, average_np in zip(var_list, var_nps, average_nps):
+        np.testing.assert_allclose(var.numpy(), average_np, rtol=1e-5, atol=1e-6)
+        average = opt.get_slot(var, "average")
+        np.testing.assert_allclose(average.numpy(), var_np, rtol=1e-5, atol=1e-6)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_multiple_variables_average_and_swap():
+    strategy = tf.distribute.OneDeviceStrategy("cpu:0")
+    _check_multiple_variables_average_and_swap(strategy)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_multiple_variables_swap_without_strategy():
+    strategy = tf.distribute.get_strategy()
+    with pytest.raises(ValueError, match="must occur under a"):
+        _check_multiple_variables_average_and_swap(strategy)
+
+
 @pytest.mark.usefixtures("run_with_mixed_precision_policy")
 def test_model_mixed_precision():
     x = np.random.standard_normal((10000, 3))
@@ -123,6 +123,50 @@ def test_sparse_sample_with_grad_averaging(dtype):
     )
 
 
+def novograd_update_numpy(
+    var, grad, t, m, v, vhat, lr, weight_decay, grad_averaging, amsgrad
+):
+    beta_1, beta_2, epsilon = 0.9, 0.999, 1e-8
+    g_2 = np.sum(grad * grad)
+    v = g_2 if t == 0 else beta_2 * v + (1 - beta_2) * g_2
+    if amsgrad:
+        vhat = np.maximum(vhat, v)
+        grad = grad / (np.sqrt(vhat) + epsilon)
+    else:
+        grad = grad / (np.sqrt(v) + epsilon)
+    grad = grad + weight_decay * var
+    if grad_averaging and t > 0:
+        grad = grad * (1 - beta_1)
+    m = beta_1 * m - lr * grad
+    return var + m, m, v, vhat
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("amsgrad", [False, True])
+@pytest.mark.parametrize("dtype", [tf.float32, tf.float64])
+def test_dense_update_against_numpy(amsgrad, dtype):
+    with tf.device("CPU:0"):
+        var_np = np.random.rand(64, 5).astype(dtype.as_numpy_dtype)
+        m_np, v_np, vhat_np = np.zeros_like(var_np), 0.0, np.zeros_like(var_np)
+        var = tf.Variable(var_np)
+
+        opt = NovoGrad(
+            lr=0.1,
+            weight_decay=0.01,
+            grad_averaging=True,
+            amsgrad=amsgrad,
+            epsilon=1e-8,
+        )
+        for t in range(3):
+            # Shrinking gradients make vhat differ from v.
+            grad_np = (np.random.randn(64, 5) / (t + 1)).astype(var_np.dtype)
+            opt.apply_gradients([(tf.constant(grad_np), var)])
+            var_np, m_np, v_np, vhat_np = novograd_update_numpy(
+                var_np, grad_np, t, m_np, v_np, vhat_np, 0.1, 0.01, True, amsgrad
+            )
+            np.testing.assert_allclose(var.numpy(), var_np, rtol=1e-5, atol=1e-5)
+
+
 def test_fit_simple_linear_model():
     np.random.seed(0x2020)
     tf.random.set_seed(0x2020)
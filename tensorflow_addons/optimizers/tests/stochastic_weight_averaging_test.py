@@ -55,6 +55,34 @@ def test_averaging():
     np.testing.assert_allclose(var_1.read_value(), [1.8, 1.8])
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_running_mean_of_snapshots():
+    var_nps = [
+        np.random.rand(300, 70).astype(np.float32),
+        np.random.rand(3).astype(np.float32),
+    ]
+    grad_nps = [np.random.randn(*x.shape).astype(np.float32) for x in var_nps]
+    average_nps = [np.zeros_like(x) for x in var_nps]
+    var_list = [tf.Variable(x) for x in var_nps]
+
+    sgd = tf.keras.optimizers.SGD(lr=0.1)
+    optimizer = SWA(sgd, start_averaging=1, average_period=2)
+    num_snapshots = 0
+    for step in range(6):
+        optimizer.apply_gradients(zip([tf.constant(g) for g in grad_nps], var_list))
+        var_nps = [x - 0.1 * g for x, g in zip(var_nps, grad_nps)]
+        if step >= 1 and (step - 1) % 2 == 0:
+            average_nps = [
+                (a * num_snapshots + x) / (num_snapshots + 1)
+                for a, x in zip(average_nps, var_nps)
+            ]
+            num_snapshots += 1
+
+    for var, average_np in zip(var_list, average_nps):
+        average = optimizer.get_slot(var, "average")
+        np.testing.assert_allclose(average.numpy(), average_np, rtol=1e-5, atol=1e-6)
+
+
 def test_optimizer_failure():
     with pytest.raises(TypeError):
         _ = SWA(None, average_period=10)
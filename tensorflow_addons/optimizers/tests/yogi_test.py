@@ -261,6 +261,52 @@ def test_basic_momentum_regularization():
     do_test_basic(beta1=0.9, l1reg=0.1, l2reg=0.2)
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("beta1", [0.0, 0.9])
+@pytest.mark.parametrize("dtype", [tf.float32, tf.float64])
+def test_dense_and_sparse_rows(beta1, dtype):
+    with tf.device("CPU:0"):
+        var_np = np.random.rand(40, 3).astype(dtype.as_numpy_dtype)
+        grad_np = np.random.randn(40, 3).astype(var_np.dtype)
+        m_np, v_np = np.zeros_like(var_np), np.ones_like(var_np)
+        sparse_np, sparse_m_np, sparse_v_np = var_np.copy(), m_np.copy(), v_np.copy()
+        indices_np = np.array([5, 0, 39, 17])
+
+        var = tf.Variable(var_np)
+        sparse_var = tf.Variable(var_np)
+        grads = tf.IndexedSlices(
+            tf.constant(grad_np[indices_np]),
+            tf.constant(indices_np),
+            tf.constant([40, 3]),
+        )
+        opt = yogi.Yogi(
+            beta1=beta1, l2_regularization_strength=0.2, initial_accumulator_value=1.0
+        )
+        for t in range(1, 4):
+            opt.apply_gradients([(tf.constant(grad_np), var), (grads, sparse_var)])
+
+            var_np, m_np, v_np = yogi_update_numpy(
+                var_np, grad_np, t, m_np, v_np, beta1=beta1, l2reg=0.2
+            )
+            rows, sparse_m_rows, sparse_v_rows = yogi_update_numpy(
+                sparse_np[indices_np],
+                grad_np[indices_np],
+                t,
+                sparse_m_np[indices_np],
+                sparse_v_np[indices_np],
+                beta1=beta1,
+                l2reg=0.2,
+            )
+            # m decays everywhere, not only in the updated rows.
+            sparse_m_np = sparse_m_np * beta1
+            sparse_np[indices_np] = rows
+            sparse_m_np[indices_np] = sparse_m_rows
+            sparse_v_np[indices_np] = sparse_v_rows
+
+            test_utils.assert_allclose_according_to_type(var_np, var.numpy())
+            test_utils.assert_allclose_according_to_type(sparse_np, sparse_var.numpy())
+
+
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 def test_tensor_learning_rate():
     for dtype in _dtypes_to_test(use_gpu=test_utils.is_gpu_available()):
@@ -23,11 +23,15 @@ https://papers.nips.cc/paper/8186-adaptive-methods-for-nonconvex-optimization.pd
 """
 
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import FloatTensorLike
 
 from typeguard import typechecked
 from typing import Union, Callable
 
+_optimizer_so = LazySO("custom_ops/optimizers/_optimizer_ops.so")
+
 
 def _solve(a, b, c):
     """Return solution of a quadratic minimization.
@@ -121,8 +125,53 @@ class Yogi(tf.keras.optimizers.Optimizer):
             if self._beta1 > 0.0:
                 self.add_slot(var, "m")
 
+    def _use_fused_kernel(self, var):
+        return (
+            not options.is_custom_kernel_disabled()
+            and self._activation in ("sign", "tanh")
+            and var.dtype.base_dtype in (tf.float32, tf.float64)
+            and tf.DeviceSpec.from_string(var.device).device_type == "CPU"
+        )
+
+    def _fused_apply(self, grad, var, indices=None):
+        """Applies the update with `Addons>ResourceApplyYogi`, or
+        `Addons>ResourceSparseApplyYogi` when `indices` is given, which
+        update the slots and `var` and apply the regularization in a single
+        pass over the variable."""
+        var_dtype = var.dtype.base_dtype
+        beta1_t = self._get_hyper("beta_1", var_dtype)
+        beta2_t = self._get_hyper("beta_2", var_dtype)
+        local_step = tf.cast(self.iterations + 1, var_dtype)
+        inputs = dict(
+            var=var.handle,
+            m=[self.get_slot(var, "m").handle] if self._beta1 > 0.0 else [],
+            v=self.get_slot(var, "v").handle,
+            beta_1_power=tf.pow(beta1_t, local_step),
+            beta_2_power=tf.pow(beta2_t, local_step),
+            lr=self._decayed_lr(var_dtype),
+            beta_1=beta1_t,
+            beta_2=beta2_t,
+            epsilon=self._get_hyper("epsilon", var_dtype),
+            l1=self._get_hyper("l1_regularization_strength", var_dtype),
+            l2=self._get_hyper("l2_regularization_strength", var_dtype),
+            grad=grad,
+            activation=self._activation,
+            use_locking=self._use_locking,
+        )
+        if indices is None:
+            return _optimizer_so.ops.addons_resource_apply_yogi(**inputs)
+        return _optimizer_so.ops.addons_resource_sparse_apply_yogi(
+            indices=indices, **inputs
+        )
+
     def _resource_apply_dense(self, grad, var):
         """See `tf.train.Optimizer._apply_dense()`."""
+        if self._use_fused_kernel(var):
+            try:
+                return self._fused_apply(grad, var)
+            except tf.errors.NotFoundError:
+                options.warn_fallback("Yogi")
+
         var_dtype = var.dtype.base_dtype
         lr_t = self._decayed_lr(var_dtype)
         beta1_t = self._get_hyper("beta_1", var_dtype)
@@ -220,6 +269,11 @@ class Yogi(tf.keras.optimizers.Optimizer):
         Returns:
           An op which updates `var` with `grad` and `indices`.
         """
+        if self._use_fused_kernel(var):
+            try:
+                return self._fused_apply(grad, var, indices)
+            except tf.errors.NotFoundError:
+                options.warn_fallback("Yogi")
 
         var_dtype = var.dtype.base_dtype
         lr_t = self._decayed_lr(var_dtype)
@@ -18,11 +18,80 @@ import tensorflow as tf
 import tensorflow.keras as keras
 from typeguard import typechecked
 
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import (
     Activation,
     Initializer,
 )
 
+_rnn_so = LazySO("custom_ops/rnn/_rnn_ops.so")
+
+
+def _sparse_reservoir_matmul_custom_op(state, indices, values):
+    """Multiplies `state` by a sparse reservoir with the custom kernel.
+
+    Returns:
+      The `[batch, units]` product, or `None` if the custom kernel can't be
+      used.
+    """
+    if options.is_custom_kernel_disabled() or state.dtype not in (
+        tf.float32,
+        tf.float64,
+    ):
+        return None
+    try:
+        return _rnn_so.ops.addons_sparse_reservoir_mat_mul(state, indices, values)
+    except tf.errors.NotFoundError:
+        options.warn_fallback("ESNCell")
+        return None
+
+
+@tf.RegisterGradient("Addons>SparseReservoirMatMul")
+def _sparse_reservoir_matmul_grad(op, grad):
+    state, indices, values = op.inputs
+    state_grad, values_grad = _rnn_so.ops.addons_sparse_reservoir_mat_mul_grad(
+        state, indices, values, grad
+    )
+    return [state_grad, None, values_grad]
+
+
+def _reservoir_spectral_radius_custom_op(sparse_reservoir, dtype):
+    """Estimates the spectral radius of a reservoir with the custom kernel.
+
+    `sparse_reservoir` returns the `(indices, values)` of the reservoir, and
+    is only called when the custom kernel can be used.
+
+    Returns:
+      The spectral radius, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled() or dtype not in (tf.float32, tf.float64):
+        return None
+    try:
+        return _rnn_so.ops.addons_reservoir_spectral_radius(*sparse_reservoir())
+    except tf.errors.NotFoundError:
+        options.warn_fallback("ESNCell")
+        return None
+
+
+def _dense_to_sparse_reservoir(recurrent_weights):
+    """Stores a dense reservoir like a sparse one, padding every unit with
+    zero weights to the largest number of connections of a unit."""
+    transposed = tf.transpose(recurrent_weights)
+    is_connected = tf.cast(tf.math.not_equal(transposed, 0), tf.int32)
+    row_size = tf.reduce_max(tf.reduce_sum(is_connected, axis=1))
+    # `top_k` keeps the first of equal values, so the connected units come
+    # first in order.
+    indices = tf.math.top_k(is_connected, k=row_size).indices
+    return indices, tf.gather(transposed, indices, batch_dims=1)
+
+
+def _sparse_reservoir_matmul(state, indices, values):
+    output = _sparse_reservoir_matmul_custom_op(state, indices, values)
+    if output is None:
+        output = tf.math.reduce_sum(values * tf.gather(state, indices, axis=1), -1)
+    return output
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class ESNCell(keras.layers.AbstractRNNCell):
@@ -60,6 +129,8 @@ class ESNCell(keras.layers.AbstractRNNCell):
         use_norm2: Boolean, whether to use the p-norm function (with p=2) as an upper
             bound of the spectral radius so that the echo state property is satisfied.
             It  avoids to compute the eigenvalues which has an exponential complexity.
+            Otherwise, the spectral radius is estimated with Arnoldi iterations
+            by a custom kernel when available.
             Default: False.
         use_bias: Boolean, whether the layer uses a bias vector.
             Default: True.
@@ -73,6 +144,15 @@ class ESNCell(keras.layers.AbstractRNNCell):
             Default: `glorot_uniform`.
         bias_initializer: Initializer for the bias vector.
             Default: `zeros`.
+        sparse_reservoir: Boolean, whether to store the reservoir as a sparse
+            matrix. Every unit then receives exactly
+            `round(connectivity * units)` connections, drawn from evenly
+            spaced ranges of units, and the recurrent step is computed by a
+            sparse custom kernel. The reservoir is stored in the non-trainable
+            `recurrent_kernel_indices` and `recurrent_kernel_values` weights,
+            of shape `[units, round(connectivity * units)]`, in place of
+            `recurrent_kernel`.
+            Default: False.
     Call arguments:
         inputs: A 2D tensor (batch x num_units).
         states: List of state tensors corresponding to the previous timestep.
@@ -91,6 +171,7 @@ class ESNCell(keras.layers.AbstractRNNCell):
         kernel_initializer: Initializer = "glorot_uniform",
         recurrent_initializer: Initializer = "glorot_uniform",
         bias_initializer: Initializer = "zeros",
+        sparse_reservoir: bool = False,
         **kwargs,
     ):
         super().__init__(**kwargs)
@@ -104,6 +185,7 @@ class ESNCell(keras.layers.AbstractRNNCell):
         self.kernel_initializer = tf.keras.initializers.get(kernel_initializer)
         self.recurrent_initializer = tf.keras.initializers.get(recurrent_initializer)
         self.bias_initializer = tf.keras.initializers.get(bias_initializer)
+        self.sparse_reservoir = sparse_reservoir
 
         self._state_size = units
         self._output_size = units
@@ -124,17 +206,9 @@ class ESNCell(keras.layers.AbstractRNNCell):
                 % inputs_shape
             )
 
-        def _esn_recurrent_initializer(shape, dtype, partition_info=None):
-            recurrent_weights = tf.keras.initializers.get(self.recurrent_initializer)(
-                shape, dtype
-            )
-
-            connectivity_mask = tf.cast(
-                tf.math.less_equal(tf.random.uniform(shape), self.connectivity),
-                dtype,
-            )
-            recurrent_weights = tf.math.multiply(recurrent_weights, connectivity_mask)
-
+        def _esn_scaling_factor(
+            recurrent_weights, sparse_recurrent_weights, dense_recurrent_weights, dtype
+        ):
             # Satisfy the necessary condition for the echo state property `max(eig(W)) < 1`
             if self.use_norm2:
                 # This condition is approximated scaling the norm 2 of the reservoir matrix
@@ -147,22 +221,103 @@ class ESNCell(keras.layers.AbstractRNNCell):
                     recurrent_norm2 + 1 * is_norm2_0
                 )
             else:
-                abs_eig_values = tf.abs(tf.linalg.eig(recurrent_weights)[0])
+                # Estimated with Arnoldi iterations by the custom kernel, which
+                # only needs products by the reservoir.
+                spectral_radius = _reservoir_spectral_radius_custom_op(
+                    sparse_recurrent_weights, dtype
+                )
+                if spectral_radius is None:
+                    abs_eig_values = tf.abs(
+                        tf.linalg.eig(dense_recurrent_weights())[0]
+                    )
+                    spectral_radius = tf.reduce_max(abs_eig_values)
                 scaling_factor = tf.math.divide_no_nan(
-                    self.spectral_radius, tf.reduce_max(abs_eig_values)
+                    self.spectral_radius, spectral_radius
                 )
+            return scaling_factor
+
+        def _esn_recurrent_initializer(shape, dtype, partition_info=None):
+            recurrent_weights = tf.keras.initializers.get(self.recurrent_initializer)(
+                shape, dtype
+            )
+
+            connectivity_mask = tf.cast(
+                tf.math.less_equal(tf.random.uniform(shape), self.connectivity),
+                dtype,
+            )
+            recurrent_weights = tf.math.multiply(recurrent_weights, connectivity_mask)
 
+            scaling_factor = _esn_scaling_factor(
+                recurrent_weights,
+                lambda: _dense_to_sparse_reservoir(recurrent_weights),
+                lambda: recurrent_weights,
+                dtype,
+            )
             recurrent_weights = tf.multiply(recurrent_weights, scaling_factor)
 
             return recurrent_weights
 
-        self.recurrent_kernel = self.add_weight(
-            name="recurrent_kernel",
-            shape=[self.units, self.units],
-            initializer=_esn_recurrent_initializer,
-            trainable=False,
-            dtype=self.dtype,
-        )
+        def _esn_reservoir_indices_initializer(shape, dtype, partition_info=None):
+            # Row `j` lists the units connected to unit `j`, one drawn from each
+            # of `row_size` evenly spaced ranges, so that they are distinct and
+            # sorted.
+            units, row_size = shape
+            bounds = tf.range(row_size + 1, dtype=tf.int64) * units // max(row_size, 1)
+            lower, widths = bounds[:-1], bounds[1:] - bounds[:-1]
+            offsets = tf.cast(
+                tf.random.uniform(shape) * tf.cast(widths, tf.float32), tf.int64
+            )
+            return tf.cast(lower + tf.minimum(offsets, widths - 1), dtype)
+
+        def _esn_reservoir_values_initializer(shape, dtype, partition_info=None):
+            recurrent_weights = tf.keras.initializers.get(self.recurrent_initializer)(
+                shape, dtype
+            )
+            indices = tf.convert_to_tensor(self.recurrent_kernel_indices)
+
+            def dense_recurrent_weights():
+                # `recurrent_weights[j, k]` connects unit `indices[j, k]` to `j`
+                columns = tf.broadcast_to(
+                    tf.range(shape[0], dtype=indices.dtype)[:, tf.newaxis], shape
+                )
+                return tf.scatter_nd(
+                    tf.stack([indices, columns], axis=-1),
+                    recurrent_weights,
+                    [shape[0], shape[0]],
+                )
+
+            scaling_factor = _esn_scaling_factor(
+                recurrent_weights,
+                lambda: (indices, recurrent_weights),
+                dense_recurrent_weights,
+                dtype,
+            )
+            return tf.multiply(recurrent_weights, scaling_factor)
+
+        if self.sparse_reservoir:
+            row_size = int(round(self.connectivity * self.units))
+            self.recurrent_kernel_indices = self.add_weight(
+                name="recurrent_kernel_indices",
+                shape=[self.units, row_size],
+                initializer=_esn_reservoir_indices_initializer,
+                trainable=False,
+                dtype=tf.int32,
+            )
+            self.recurrent_kernel_values = self.add_weight(
+                name="recurrent_kernel_values",
+                shape=[self.units, row_size],
+                initializer=_esn_reservoir_values_initializer,
+                trainable=False,
+                dtype=self.dtype,
+            )
+        else:
+            self.recurrent_kernel = self.add_weight(
+                name="recurrent_kernel",
+                shape=[self.units, self.units],
+                initializer=_esn_recurrent_initializer,
+                trainable=False,
+                dtype=self.dtype,
+            )
         self.kernel = self.add_weight(
             name="kernel",
             shape=[input_size, self.units],
@@ -183,10 +338,12 @@ class ESNCell(keras.layers.AbstractRNNCell):
         self.built = True
 
     def call(self, inputs, state):
-        in_matrix = tf.concat([inputs, state[0]], axis=1)
-        weights_matrix = tf.concat([self.kernel, self.recurrent_kernel], axis=0)
-
-        output = tf.linalg.matmul(in_matrix, weights_matrix)
+        if self.sparse_reservoir:
+            output = tf.linalg.matmul(inputs, self.kernel) + _sparse_reservoir_matmul(
+                state[0], self.recurrent_kernel_indices, self.recurrent_kernel_values
+            )
+        else:
+            output = self._dense_step(inputs, state)
         if self.use_bias:
             output = output + self.bias
         output = self.activation(output)
@@ -194,6 +351,12 @@ class ESNCell(keras.layers.AbstractRNNCell):
 
         return output, output
 
+    def _dense_step(self, inputs, state):
+        in_matrix = tf.concat([inputs, state[0]], axis=1)
+        weights_matrix = tf.concat([self.kernel, self.recurrent_kernel], axis=0)
+
+        return tf.linalg.matmul(in_matrix, weights_matrix)
+
     def get_config(self):
         config = {
             "units": self.units,
@@ -210,6 +373,7 @@ class ESNCell(keras.layers.AbstractRNNCell):
                 self.recurrent_initializer
             ),
             "bias_initializer": tf.keras.initializers.serialize(self.bias_initializer),
+            "sparse_reservoir": self.sparse_reservoir,
         }
         base_config = super().get_config()
         return {**base_config, **config}
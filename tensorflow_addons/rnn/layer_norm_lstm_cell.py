@@ -18,6 +18,8 @@ import tensorflow as tf
 import tensorflow.keras as keras
 from typeguard import typechecked
 
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import (
     Activation,
     FloatTensorLike,
@@ -27,6 +29,62 @@ from tensorflow_addons.utils.types import (
     Regularizer,
 )
 
+_rnn_so = LazySO("custom_ops/rnn/_rnn_ops.so")
+
+
+def _layer_norm_lstm_custom_op(cell, inputs, h_tm1, c_tm1):
+    """Runs one step of `cell` with the fused custom kernel.
+
+    Returns:
+      The new `(h, c)`, or `None` if the custom kernel can't be used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or inputs.dtype not in (tf.float32, tf.float64)
+        or cell.activation is not keras.activations.get("tanh")
+        or cell.recurrent_activation is not keras.activations.get("sigmoid")
+    ):
+        return None
+    if cell.use_bias:
+        bias = cell.bias
+    else:
+        bias = tf.zeros([4 * cell.units], inputs.dtype)
+    try:
+        h, c, _, _ = _rnn_so.ops.addons_layer_norm_lstm_block_cell(
+            inputs,
+            h_tm1,
+            c_tm1,
+            cell.kernel,
+            cell.recurrent_kernel,
+            bias,
+            cell.kernel_norm.gamma,
+            cell.kernel_norm.beta,
+            cell.recurrent_norm.gamma,
+            cell.recurrent_norm.beta,
+            cell.state_norm.gamma,
+            cell.state_norm.beta,
+            epsilon=cell.norm_epsilon,
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("LayerNormLSTMCell")
+        return None
+    return h, c
+
+
+@tf.RegisterGradient("Addons>LayerNormLSTMBlockCell")
+def _layer_norm_lstm_block_cell_grad(
+    op, h_grad, c_grad, unused_kernel_projection_grad, unused_recurrent_grad
+):
+    _, _, kernel_projection, recurrent_projection = op.outputs
+    return _rnn_so.ops.addons_layer_norm_lstm_block_cell_grad(
+        *op.inputs,
+        kernel_projection,
+        recurrent_projection,
+        h_grad,
+        c_grad,
+        epsilon=op.get_attr("epsilon"),
+    )
+
 
 @tf.keras.utils.register_keras_serializable(package="Addons")
 class LayerNormLSTMCell(keras.layers.LSTMCell):
@@ -39,7 +97,9 @@ class LayerNormLSTMCell(keras.layers.LSTMCell):
 
     "Layer Normalization" Jimmy Lei Ba, Jamie Ryan Kiros, Geoffrey E. Hinton
 
-    and is applied before the internal nonlinearities.
+    and is applied before the internal nonlinearities. With the default
+    activations, the step after the input and recurrent projections is
+    computed by a fused custom kernel.
     Recurrent dropout is based on:
 
       https://arxiv.org/abs/1603.05118
@@ -173,10 +233,15 @@ class LayerNormLSTMCell(keras.layers.LSTMCell):
         rec_dp_mask = self.get_recurrent_dropout_mask_for_cell(h_tm1, training, count=4)
         if 0.0 < self.dropout < 1.0:
             inputs *= dp_mask[0]
-        z = self.kernel_norm(keras.backend.dot(inputs, self.kernel))
-
         if 0.0 < self.recurrent_dropout < 1.0:
             h_tm1 *= rec_dp_mask[0]
+
+        fused = _layer_norm_lstm_custom_op(self, inputs, h_tm1, c_tm1)
+        if fused is not None:
+            h, c = fused
+            return h, [h, c]
+
+        z = self.kernel_norm(keras.backend.dot(inputs, self.kernel))
         z += self.recurrent_norm(keras.backend.dot(h_tm1, self.recurrent_kernel))
         if self.use_bias:
             z = keras.backend.bias_add(z, self.bias)
@@ -15,6 +15,7 @@
 """Tests for ESN Cell."""
 
 import numpy as np
+import pytest
 import tensorflow as tf
 import tensorflow.keras as keras
 
@@ -73,6 +74,15 @@ def test_esn_echo_state_property_eig():
     assert max_eig < 1, "max(eig(W)) < 1"
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_esn_spectral_radius():
+    cell = ESNCell(units=200, connectivity=0.1, spectral_radius=0.9)
+    cell.build((3, 3))
+    recurrent_weights = cell.get_weights()[0]
+    max_eig = np.max(np.abs(np.linalg.eigvals(recurrent_weights)))
+    np.testing.assert_allclose(max_eig, 0.9, rtol=1e-2)
+
+
 def test_esn_echo_state_property_norm2():
     use_norm2 = True
     units = 3
@@ -103,6 +113,45 @@ def test_esn_connectivity():
     )
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("use_norm2", [False, True])
+def test_esn_sparse_reservoir(use_norm2):
+    units = 50
+    cell = ESNCell(
+        units=units,
+        connectivity=0.2,
+        use_norm2=use_norm2,
+        sparse_reservoir=True,
+        dtype=tf.float64,
+    )
+    cell.build((3, 4))
+    indices, values, kernel, bias = cell.get_weights()
+    assert indices.shape == (units, 10)
+    assert values.shape == (units, 10)
+    # the connections of every unit are distinct
+    assert (np.diff(indices, axis=1) > 0).all()
+
+    recurrent_kernel = np.zeros((units, units))
+    recurrent_kernel[indices, np.arange(units)[:, np.newaxis]] = values
+    max_eig = np.max(np.abs(np.linalg.eigvals(recurrent_kernel)))
+    assert max_eig < 1, "max(eig(W)) < 1"
+
+    dense_cell = ESNCell(units=units, dtype=tf.float64)
+    dense_cell.build((3, 4))
+    dense_cell.set_weights([recurrent_kernel, kernel, bias])
+    inputs = tf.constant(np.random.normal(size=(3, 4)))
+    state = tf.constant(np.random.normal(size=(3, units)))
+    output, _ = cell(inputs, [state])
+    expected, _ = dense_cell(inputs, [state])
+    np.testing.assert_allclose(output, expected, rtol=1e-6, atol=1e-6)
+
+    theoretical, numerical = tf.test.compute_gradient(
+        lambda inputs, state: cell(inputs, [state])[0], [inputs, state]
+    )
+    for t, n in zip(theoretical, numerical):
+        np.testing.assert_allclose(t, n, rtol=1e-5, atol=1e-5)
+
+
 def test_esn_keras_rnn():
     cell = ESNCell(10)
     seq_input = tf.convert_to_tensor(
@@ -160,6 +209,7 @@ def test_esn_config():
         "bias_initializer": tf.keras.initializers.serialize(
             tf.keras.initializers.get("glorot_uniform")
         ),
+        "sparse_reservoir": False,
     }
     config = cell.get_config()
     assert config == expected_config
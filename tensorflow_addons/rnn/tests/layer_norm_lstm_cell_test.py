@@ -15,6 +15,7 @@
 """Tests for LayerNormLSTM Cell."""
 
 import numpy as np
+import pytest
 import tensorflow as tf
 import tensorflow.keras as keras
 
@@ -81,6 +82,42 @@ def test_cell_output():
     np.testing.assert_allclose(output_states_v[1], expected_c, 1e-5)
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_against_python_step():
+    np.random.seed(0)
+    x = tf.constant(np.random.normal(size=(3, 5)))
+    h = tf.constant(np.random.normal(size=(3, 4)))
+    c = tf.constant(np.random.normal(size=(3, 4)))
+    cell = LayerNormLSTMCell(4, dtype=tf.float64)
+    # a wrapped activation isn't fused, so this cell takes the python path
+    python_cell = LayerNormLSTMCell(
+        4, activation=lambda x: tf.tanh(x), dtype=tf.float64
+    )
+    cell(x, [h, c])
+    python_cell(x, [h, c])
+    cell.set_weights([np.random.normal(size=w.shape) for w in cell.get_weights()])
+    python_cell.set_weights(cell.get_weights())
+
+    def step(cell, x, h, c):
+        output, (_, new_c) = cell(x, [h, c])
+        return tf.concat([output, new_c], axis=-1)
+
+    with tf.GradientTape(persistent=True) as tape:
+        output = step(cell, x, h, c)
+        expected = step(python_cell, x, h, c)
+    np.testing.assert_allclose(output, expected, rtol=1e-6, atol=1e-6)
+    grads = tape.gradient(output, cell.trainable_weights)
+    expected_grads = tape.gradient(expected, python_cell.trainable_weights)
+    for grad, expected_grad in zip(grads, expected_grads):
+        np.testing.assert_allclose(grad, expected_grad, rtol=1e-6, atol=1e-6)
+
+    theoretical, numerical = tf.test.compute_gradient(
+        lambda x, h, c: step(cell, x, h, c), [x, h, c]
+    )
+    for t, n in zip(theoretical, numerical):
+        np.testing.assert_allclose(t, n, rtol=1e-5, atol=1e-5)
+
+
 def test_config_layer_norm():
     cell = LayerNormLSTMCell(10, name="layer_norm_lstm_cell_3")
 
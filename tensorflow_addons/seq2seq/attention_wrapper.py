@@ -22,7 +22,9 @@ import numpy as np
 
 import tensorflow as tf
 
+from tensorflow_addons import options
 from tensorflow_addons.utils import keras_utils
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import (
     AcceptableDTypes,
     FloatTensorLike,
@@ -37,6 +39,9 @@ from typing import Optional, Callable, Union, List
 # TODO: Find public API alternatives to these
 from tensorflow.python.keras.engine import base_layer_utils
 
+_attention_score_so = LazySO("custom_ops/seq2seq/_attention_score_ops.so")
+_monotonic_attention_so = LazySO("custom_ops/seq2seq/_monotonic_attention_ops.so")
+
 
 class AttentionMechanism(tf.keras.layers.Layer):
     """Base class for attention mechanisms.
@@ -107,6 +112,7 @@ class AttentionMechanism(tf.keras.layers.Layer):
         self.keys = None
         self.values = None
         self.batch_size = None
+        self._score_mask = None
         self._memory_initialized = False
         self._check_inner_dims_defined = True
         self.supports_masking = True
@@ -180,7 +186,9 @@ class AttentionMechanism(tf.keras.layers.Layer):
 
         return super().__call__(inputs, **kwargs)
 
-    def call(self, inputs, mask=None, setup_memory=False, **kwargs):
+    def call(
+        self, inputs, mask=None, setup_memory=False, compute_context=False, **kwargs
+    ):
         """Setup the memory or query the attention.
 
         There are two case here, one for setup memory, and the second is query
@@ -205,9 +213,13 @@ class AttentionMechanism(tf.keras.layers.Layer):
             memory should be filtered out during calculation.
           setup_memory: boolean, whether the input is for setting up memory, or
             query attention.
+          compute_context: boolean, whether to also return the context, the
+            alignments weighted sum of the memory, when querying the attention.
           **kwargs: Dict, other keyword arguments for the call method.
         Returns:
           Either processed memory or attention score, based on `setup_memory`.
+          With `compute_context`, the attention score is followed by the
+          context.
         """
         if setup_memory:
             if isinstance(inputs, list):
@@ -242,6 +254,8 @@ class AttentionMechanism(tf.keras.layers.Layer):
             # Ignore the rest of the inputs and only care about the query and
             # state
             query, state = inputs[0], inputs[1]
+            if compute_context:
+                return self._calculate_attention_with_context(query, state)
             return self._calculate_attention(query, state)
 
     def setup_memory(self, memory, memory_sequence_length=None, memory_mask=None):
@@ -282,6 +296,9 @@ class AttentionMechanism(tf.keras.layers.Layer):
                 self.keys = self.values
             self.batch_size = self.keys.shape[0] or tf.shape(self.keys)[0]
             self._alignments_size = self.keys.shape[1] or tf.shape(self.keys)[1]
+            self._score_mask = _score_mask(
+                memory_sequence_length, memory_mask, self._alignments_size
+            )
             if memory_mask is not None or memory_sequence_length is not None:
                 unwrapped_probability_fn = self.default_probability_fn
 
@@ -304,6 +321,41 @@ class AttentionMechanism(tf.keras.layers.Layer):
             "_calculate_attention need to be implemented by subclasses."
         )
 
+    def _calculate_attention_with_context(self, query, state):
+        """Score the query and compute the context of the values.
+
+        Subclasses can override this to compute both in a single pass.
+
+        Args:
+          query: Tensor of dtype matching `self.values` and shape
+            `[batch_size, query_depth]`.
+          state: Tensor of dtype matching `self.values` and shape
+            `[batch_size, alignments_size]`
+            (`alignments_size` is memory's `max_time`).
+
+        Returns:
+          alignments: Tensor of dtype matching `self.values` and shape
+            `[batch_size, alignments_size]`.
+          next_state: The next state of the mechanism.
+          context: Tensor of dtype matching `self.values` and shape
+            `[batch_size, memory_depth]`.
+        """
+        alignments, next_state = self._calculate_attention(query, state)
+        # Reshape from [batch_size, memory_time] to [batch_size, 1, memory_time]
+        expanded_alignments = tf.expand_dims(alignments, 1)
+        # Context is the inner product of alignments and values along the
+        # memory time dimension.
+        # alignments shape is
+        #   [batch_size, 1, memory_time]
+        # self.values shape is
+        #   [batch_size, memory_time, memory_size]
+        # the batched matmul is over memory_time, so the output shape is
+        #   [batch_size, 1, memory_size].
+        # we then squeeze out the singleton dim.
+        context = tf.matmul(expanded_alignments, self.values)
+        context = tf.squeeze(context, [1])
+        return alignments, next_state, context
+
     def compute_mask(self, inputs, mask=None):
         # There real input of the attention is query and state, and the memory
         # layer mask shouldn't be pass down. Returning None for all output mask
@@ -487,6 +539,71 @@ def _luong_score(query, keys, scale):
     return score
 
 
+def _attention_score_context_custom_op(
+    score_fn,
+    query,
+    keys,
+    values,
+    score_mask,
+    attention_v=None,
+    attention_b=None,
+    scale=None,
+):
+    """Computes the softmax alignments and the context with the custom kernel.
+
+    Returns:
+      The alignments and the context, or `None` if the custom kernel can't be
+      used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or keys.dtype not in (tf.float32, tf.float64)
+        or query.dtype != keys.dtype
+        or values.dtype != keys.dtype
+        or query.shape.rank != 2
+        or keys.shape.rank != 3
+        or values.shape.rank != 3
+        or query.shape[-1] != keys.shape[-1]
+    ):
+        return None
+    dtype = keys.dtype
+    if score_mask is None:
+        score_mask = tf.zeros([0, 0], tf.bool)
+    if attention_v is None:
+        attention_v = tf.zeros([0], dtype)
+    if attention_b is None:
+        attention_b = tf.zeros([0], dtype)
+    if scale is None:
+        scale = tf.ones([], dtype)
+    try:
+        return _attention_score_so.ops.addons_attention_score_context(
+            query,
+            keys,
+            values,
+            score_mask,
+            attention_v,
+            attention_b,
+            scale,
+            score_fn=score_fn,
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("attention_score_context")
+        return None
+
+
+@tf.RegisterGradient("Addons>AttentionScoreContext")
+def _attention_score_context_grad(op, alignments_grad, attention_grad):
+    grads = _attention_score_so.ops.addons_attention_score_context_grad(
+        *op.inputs,
+        op.outputs[0],
+        alignments_grad,
+        attention_grad,
+        score_fn=op.get_attr("score_fn"),
+    )
+    # The mask has no gradient.
+    return [*grads[:3], None, *grads[3:]]
+
+
 class LuongAttention(AttentionMechanism):
     """Implements Luong-style (multiplicative) attention scoring.
 
@@ -592,6 +709,26 @@ class LuongAttention(AttentionMechanism):
         next_state = alignments
         return alignments, next_state
 
+    def _calculate_attention_with_context(self, query, state):
+        # The fused kernel computes the score of this class, so it is skipped
+        # for subclasses that override `_calculate_attention()`.
+        if (
+            self.probability_fn_name == "softmax"
+            and type(self)._calculate_attention is LuongAttention._calculate_attention
+        ):
+            outputs = _attention_score_context_custom_op(
+                "luong",
+                query,
+                self.keys,
+                self.values,
+                self._score_mask,
+                scale=self.scale_weight,
+            )
+            if outputs is not None:
+                alignments, context = outputs
+                return alignments, alignments, context
+        return super()._calculate_attention_with_context(query, state)
+
     def get_config(self):
         config = {
             "units": self.units,
@@ -796,6 +933,38 @@ class BahdanauAttention(AttentionMechanism):
         next_state = alignments
         return alignments, next_state
 
+    def _calculate_attention_with_context(self, query, state):
+        # The fused kernel computes the score of this class, so it is skipped
+        # for subclasses that override `_calculate_attention()`.
+        if (
+            self.probability_fn_name == "softmax"
+            and type(self)._calculate_attention
+            is BahdanauAttention._calculate_attention
+        ):
+            processed_query = self.query_layer(query) if self.query_layer else query
+            scale, attention_b = None, None
+            if self.attention_g is not None and self.attention_b is not None:
+                # The normalized `attention_v` is folded into the scale of the
+                # score.
+                scale = self.attention_g * tf.math.rsqrt(
+                    tf.reduce_sum(tf.square(self.attention_v))
+                )
+                attention_b = self.attention_b
+            outputs = _attention_score_context_custom_op(
+                "bahdanau",
+                processed_query,
+                self.keys,
+                self.values,
+                self._score_mask,
+                attention_v=self.attention_v,
+                attention_b=attention_b,
+                scale=scale,
+            )
+            if outputs is not None:
+                alignments, context = outputs
+                return alignments, alignments, context
+        return super()._calculate_attention_with_context(query, state)
+
     def get_config(self):
         # yapf: disable
         config = {
@@ -842,6 +1011,35 @@ def safe_cumprod(x: TensorLike, *args, **kwargs) -> tf.Tensor:
         )
 
 
+def _monotonic_attention_custom_op(p_choose_i, previous_attention, mode):
+    """Computes the monotonic attention with the custom kernel.
+
+    Returns:
+      The attention, or `None` if the custom kernel can't be used.
+    """
+    if (
+        options.is_custom_kernel_disabled()
+        or mode not in ("recursive", "parallel")
+        or p_choose_i.dtype not in (tf.float32, tf.float64)
+        or p_choose_i.shape.rank != 2
+    ):
+        return None
+    try:
+        return _monotonic_attention_so.ops.addons_monotonic_attention(
+            p_choose_i, previous_attention, mode=mode
+        )
+    except tf.errors.NotFoundError:
+        options.warn_fallback("monotonic_attention")
+        return None
+
+
+@tf.RegisterGradient("Addons>MonotonicAttention")
+def _monotonic_attention_grad(op, grad):
+    return _monotonic_attention_so.ops.addons_monotonic_attention_grad(
+        *op.inputs, grad, mode=op.get_attr("mode")
+    )
+
+
 def monotonic_attention(
     p_choose_i: FloatTensorLike, previous_attention: FloatTensorLike, mode: str
 ) -> tf.Tensor:
@@ -877,6 +1075,8 @@ def monotonic_attention(
             entries very close to 0 or 1.
           * 'hard' requires that the probabilities in p_choose_i are all either
             0 or 1, and subsequently uses a more efficient and exact solution.
+        The 'recursive' and 'parallel' modes are computed by a custom kernel
+        in one pass over the memory when available.
 
     Returns:
       A tensor of shape (batch_size, input_sequence_length) representing the
@@ -890,13 +1090,16 @@ def monotonic_attention(
     previous_attention = tf.convert_to_tensor(
         previous_attention, name="previous_attention"
     )
+    attention = _monotonic_attention_custom_op(p_choose_i, previous_attention, mode)
+    if attention is not None:
+        return attention
     if mode == "recursive":
         # Use .shape[0] when it's not None, or fall back on symbolic shape
         batch_size = p_choose_i.shape[0] or tf.shape(p_choose_i)[0]
         # Compute [1, 1 - p_choose_i[0], 1 - p_choose_i[1], ..., 1 - p_choose_
         # i[-2]]
         shifted_1mp_choose_i = tf.concat(
-            [tf.ones((batch_size, 1)), 1 - p_choose_i[:, :-1]], 1
+            [tf.ones((batch_size, 1), p_choose_i.dtype), 1 - p_choose_i[:, :-1]], 1
         )
         # Compute attention distribution recursively as
         # q[i] = (1 - p_choose_i[i - 1])*q[i - 1] + previous_attention[i]
@@ -909,7 +1112,7 @@ def monotonic_attention(
                 # Loop variables yz[0] and yz[1]
                 [tf.transpose(shifted_1mp_choose_i), tf.transpose(previous_attention)],
                 # Initial value of x is just zeros
-                tf.zeros((batch_size,)),
+                tf.zeros((batch_size,), p_choose_i.dtype),
             )
         )
     elif mode == "parallel":
@@ -1487,12 +1690,10 @@ def _prepare_memory(
     return tf.nest.map_structure(lambda m: _maybe_mask(m, seq_len_mask), memory)
 
 
-def _maybe_mask_score(
-    score, memory_sequence_length=None, memory_mask=None, score_mask_value=None
-):
-    """Mask the attention score based on the masks."""
+def _score_mask(memory_sequence_length, memory_mask, maxlen):
+    """Returns the boolean mask of the attention score, or `None`."""
     if memory_sequence_length is None and memory_mask is None:
-        return score
+        return None
     if memory_sequence_length is not None and memory_mask is not None:
         raise ValueError(
             "memory_sequence_length and memory_mask can't be provided at same time."
@@ -1506,9 +1707,17 @@ def _maybe_mask_score(
                 )
             ]
         ):
-            memory_mask = tf.sequence_mask(
-                memory_sequence_length, maxlen=tf.shape(score)[1]
-            )
+            memory_mask = tf.sequence_mask(memory_sequence_length, maxlen=maxlen)
+    return memory_mask
+
+
+def _maybe_mask_score(
+    score, memory_sequence_length=None, memory_mask=None, score_mask_value=None
+):
+    """Mask the attention score based on the masks."""
+    memory_mask = _score_mask(memory_sequence_length, memory_mask, tf.shape(score)[1])
+    if memory_mask is None:
+        return score
     score_mask_values = score_mask_value * tf.ones_like(score)
     return tf.where(memory_mask, score, score_mask_values)
 
@@ -1535,23 +1744,20 @@ def _compute_attention(
 ):
     """Computes the attention and alignments for a given
     attention_mechanism."""
-    alignments, next_attention_state = attention_mechanism(
-        [cell_output, attention_state]
-    )
-
-    # Reshape from [batch_size, memory_time] to [batch_size, 1, memory_time]
-    expanded_alignments = tf.expand_dims(alignments, 1)
-    # Context is the inner product of alignments and values along the
-    # memory time dimension.
-    # alignments shape is
-    #   [batch_size, 1, memory_time]
-    # attention_mechanism.values shape is
-    #   [batch_size, memory_time, memory_size]
-    # the batched matmul is over memory_time, so the output shape is
-    #   [batch_size, 1, memory_size].
-    # we then squeeze out the singleton dim.
-    context_ = tf.matmul(expanded_alignments, attention_mechanism.values)
-    context_ = tf.squeeze(context_, [1])
+    if type(attention_mechanism).call is AttentionMechanism.call:
+        alignments, next_attention_state, context_ = attention_mechanism(
+            [cell_output, attention_state], compute_context=True
+        )
+    else:
+        # A mechanism that overrides `call()` may not accept `compute_context`,
+        # so compute the context from its alignments.
+        alignments, next_attention_state = attention_mechanism(
+            [cell_output, attention_state]
+        )
+        # Reshape from [batch_size, memory_time] to [batch_size, 1, memory_time]
+        expanded_alignments = tf.expand_dims(alignments, 1)
+        context_ = tf.matmul(expanded_alignments, attention_mechanism.values)
+        context_ = tf.squeeze(context_, [1])
 
     if attention_layer is not None:
         attention = attention_layer(tf.concat([cell_output, context_], 1))
@@ -15,11 +15,79 @@
 """Loss functions for sequence models."""
 
 import tensorflow as tf
+from tensorflow_addons import options
+from tensorflow_addons.utils.resource_loader import LazySO
 from tensorflow_addons.utils.types import TensorLike
 
 from typeguard import typechecked
 from typing import Callable, Optional
 
+_sequence_loss_so = LazySO("custom_ops/seq2seq/_sequence_loss_ops.so")
+
+
+def _sequence_loss_custom_op(
+    logits,
+    targets,
+    weights,
+    average_across_timesteps,
+    average_across_batch,
+    sum_over_timesteps,
+    sum_over_batch,
+):
+    """Computes the sequence loss with the custom kernel.
+
+    Returns:
+      The loss, or `None` if the custom kernel can't be used.
+    """
+    if options.is_custom_kernel_disabled():
+        return None
+    logits = tf.convert_to_tensor(logits)
+    targets = tf.convert_to_tensor(targets)
+    weights = tf.convert_to_tensor(weights)
+    if (
+        logits.dtype not in (tf.float32, tf.float64)
+        or weights.dtype != logits.dtype
+        or targets.dtype not in (tf.int32, tf.int64)
+    ):
+        return None
+    if average_across_timesteps and average_across_batch:
+        reduction, normalizer = "all", "weights"
+    elif sum_over_timesteps and sum_over_batch:
+        reduction, normalizer = "all", "count"
+    elif average_across_timesteps or average_across_batch:
+        reduction = "timesteps" if average_across_timesteps else "batch"
+        normalizer = "weights"
+    elif sum_over_timesteps or sum_over_batch:
+        reduction = "timesteps" if sum_over_timesteps else "batch"
+        normalizer = "count"
+    else:
+        reduction, normalizer = "none", "weights"
+    try:
+        crossent, _ = _sequence_loss_so.ops.addons_sequence_loss(
+            logits, targets, weights, reduction=reduction, normalizer=normalizer
+        )
+        return crossent
+    except tf.errors.NotFoundError:
+        options.warn_fallback("sequence_loss")
+        return None
+
+
+@tf.RegisterGradient("Addons>SequenceLoss")
+def _sequence_loss_grad(op, loss_grad, _):
+    logits, targets, weights = op.inputs
+    loss, crossent = op.outputs
+    logits_grad, weights_grad = _sequence_loss_so.ops.addons_sequence_loss_grad(
+        logits,
+        targets,
+        weights,
+        crossent,
+        loss,
+        loss_grad,
+        reduction=op.get_attr("reduction"),
+        normalizer=op.get_attr("normalizer"),
+    )
+    return [logits_grad, None, weights_grad]
+
 
 def sequence_loss(
     logits: TensorLike,
@@ -49,6 +117,10 @@ def sequence_loss(
     instead of weighted average. User are recommend to use `sum_over_timesteps`
     and `sum_over_batch` for reduction.
 
+    Without `softmax_loss_function` and with class index `targets`, the
+    cross-entropy is computed by a fused kernel that skips the positions with
+    a zero weight.
+
     Args:
       logits: A Tensor of shape
         `[batch_size, sequence_length, num_decoder_symbols]` and dtype float.
@@ -126,6 +198,18 @@ def sequence_loss(
             "to True at same time because of ambiguous order."
         )
     with tf.name_scope(name or "sequence_loss"):
+        if softmax_loss_function is None and targets_rank == 2:
+            crossent = _sequence_loss_custom_op(
+                logits,
+                targets,
+                weights,
+                average_across_timesteps,
+                average_across_batch,
+                sum_over_timesteps,
+                sum_over_batch,
+            )
+            if crossent is not None:
+                return crossent
         num_classes = tf.shape(input=logits)[2]
         logits_flat = tf.reshape(logits, [-1, num_classes])
         if softmax_loss_function is None:
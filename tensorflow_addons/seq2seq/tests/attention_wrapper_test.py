@@ -720,6 +720,123 @@ def test_not_use_attention_layer():
     )
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize("mode", ["recursive", "parallel"])
+def test_monotonic_attention(mode):
+    np.random.seed(0)
+    p_choose_i = np.random.uniform(0.05, 0.95, size=(3, 11))
+    previous_attention = np.random.uniform(size=(3, 11))
+    previous_attention /= previous_attention.sum(axis=1, keepdims=True)
+
+    expected = np.zeros_like(p_choose_i)
+    q = np.zeros(3)
+    for i in range(11):
+        if i > 0:
+            q *= 1 - p_choose_i[:, i - 1]
+        q += previous_attention[:, i]
+        expected[:, i] = p_choose_i[:, i] * q
+
+    def attention(p_choose_i, previous_attention):
+        return wrapper.monotonic_attention(p_choose_i, previous_attention, mode)
+
+    p_choose_i = tf.constant(p_choose_i)
+    previous_attention = tf.constant(previous_attention)
+    np.testing.assert_allclose(
+        attention(p_choose_i, previous_attention), expected, rtol=1e-6, atol=1e-6
+    )
+    theoretical, numerical = tf.test.compute_gradient(
+        attention, [p_choose_i, previous_attention]
+    )
+    for t, n in zip(theoretical, numerical):
+        np.testing.assert_allclose(t, n, rtol=1e-5, atol=1e-5)
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize(
+    "attention_cls,kwargs",
+    [
+        (wrapper.LuongAttention, {}),
+        (wrapper.LuongAttention, {"scale": True}),
+        (wrapper.BahdanauAttention, {}),
+        (wrapper.BahdanauAttention, {"normalize": True}),
+    ],
+)
+def test_attention_score_context(attention_cls, kwargs):
+    np.random.seed(0)
+    memory = np.random.randn(4, 7, 6)
+    memory_length = np.array([7, 3, 1, 5])
+    query = tf.constant(np.random.randn(4, 8))
+    state = tf.constant(np.random.uniform(size=(4, 7)))
+    attention = attention_cls(
+        8,
+        memory,
+        memory_sequence_length=memory_length,
+        dtype=tf.float64,
+        **kwargs,
+    )
+
+    with tf.GradientTape(persistent=True) as tape:
+        tape.watch(query)
+        alignments, _, context = attention([query, state], compute_context=True)
+        expected_alignments, _ = attention([query, state])
+        expected_context = tf.einsum(
+            "bt,btd->bd", expected_alignments, attention.values
+        )
+        loss = tf.reduce_sum(alignments * state) + tf.reduce_sum(context ** 2)
+        expected_loss = tf.reduce_sum(expected_alignments * state) + tf.reduce_sum(
+            expected_context ** 2
+        )
+
+    np.testing.assert_allclose(alignments, expected_alignments, rtol=1e-6)
+    np.testing.assert_allclose(context, expected_context, rtol=1e-6)
+    np.testing.assert_array_equal(alignments.numpy()[2, 1:], 0)
+    sources = [query] + attention.trainable_variables
+    for grad, expected_grad in zip(
+        tape.gradient(loss, sources), tape.gradient(expected_loss, sources)
+    ):
+        np.testing.assert_allclose(grad, expected_grad, rtol=1e-6, atol=1e-9)
+
+
+def test_attention_wrapper_with_custom_call():
+    class UniformAttention(wrapper.LuongAttention):
+        def call(self, inputs, mask=None, setup_memory=False, **kwargs):
+            if setup_memory:
+                return super().call(inputs, mask=mask, setup_memory=True)
+            alignments = tf.ones_like(inputs[1]) / self._alignments_size
+            return alignments, alignments
+
+    mechanism = UniformAttention(units=3)
+    cell = wrapper.AttentionWrapper(tf.keras.layers.GRUCell(3), mechanism)
+    memory = tf.random.uniform([2, 5, 3])
+    inputs = tf.ones([2, 3])
+    mechanism.setup_memory(memory)
+    initial_state = cell.get_initial_state(inputs=inputs)
+    _, state = cell(inputs, initial_state)
+    np.testing.assert_allclose(state.alignments, np.full([2, 5], 0.2), rtol=1e-6)
+    np.testing.assert_allclose(
+        state.attention, tf.reduce_mean(memory, axis=1), rtol=1e-6
+    )
+
+
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+def test_custom_attention_score_with_context():
+    class NegatedLuongAttention(wrapper.LuongAttention):
+        def _calculate_attention(self, query, state):
+            return super()._calculate_attention(-query, state)
+
+    np.random.seed(0)
+    memory = np.random.randn(2, 5, 3)
+    query = tf.constant(np.random.randn(2, 3))
+    state = tf.constant(np.random.uniform(size=(2, 5)))
+    attention = NegatedLuongAttention(3, memory, dtype=tf.float64)
+    alignments, _, context = attention([query, state], compute_context=True)
+    expected_alignments, _ = attention([query, state])
+    np.testing.assert_allclose(alignments, expected_alignments, rtol=1e-6)
+    np.testing.assert_allclose(
+        context, tf.einsum("bt,btd->bd", expected_alignments, memory), rtol=1e-6
+    )
+
+
 def test_bahdanau_monotonic_not_normalized():
     set_random_state_for_tf_and_np()
     create_attention_mechanism = wrapper.BahdanauMonotonicAttention
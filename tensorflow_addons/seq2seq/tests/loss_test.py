@@ -252,6 +252,69 @@ def test_weighted_sum_reduction():
     np.testing.assert_allclose(compare_total, res, rtol=1e-6, atol=1e-6)
 
 
+@pytest.mark.usefixtures("run_custom_and_py_ops")
+@pytest.mark.parametrize(
+    "reduction",
+    [
+        {},
+        {"average_across_timesteps": True, "average_across_batch": True},
+        {"average_across_timesteps": True},
+        {"average_across_batch": True},
+        {"sum_over_timesteps": True, "sum_over_batch": True},
+        {"sum_over_timesteps": True},
+        {"sum_over_batch": True},
+    ],
+)
+def test_sequence_loss_reductions(reduction):
+    np.random.seed(0)
+    logits = np.random.randn(3, 4, 7) * 3
+    targets = np.random.randint(7, size=(3, 4))
+    weights = np.random.uniform(0.5, 1.5, size=(3, 4))
+    weights[0, 1] = 0
+    weights[:, 3] = 0
+    # Masked special tokens at the front of the vocabulary.
+    logits[0, :, :2] = -np.inf
+    logits[2, 1, :3] = -np.inf
+    targets[0, :] = np.maximum(targets[0, :], 2)
+    targets[2, 1] = np.maximum(targets[2, 1], 3)
+    kwargs = {
+        "average_across_timesteps": False,
+        "average_across_batch": False,
+        **reduction,
+    }
+
+    log_softmax = logits - np.log(np.exp(logits).sum(axis=-1, keepdims=True))
+    crossent = -np.take_along_axis(log_softmax, targets[..., None], -1)[..., 0]
+    weighted = crossent * weights
+    count = kwargs.get("sum_over_timesteps") or kwargs.get("sum_over_batch")
+    normalizer = (weights != 0) if count else weights
+    axis = []
+    if kwargs.get("average_across_batch") or kwargs.get("sum_over_batch"):
+        axis.append(0)
+    if kwargs.get("average_across_timesteps") or kwargs.get("sum_over_timesteps"):
+        axis.append(1)
+    if axis:
+        total = normalizer.sum(axis=tuple(axis))
+        expected = np.where(
+            total == 0, 0, weighted.sum(axis=tuple(axis)) / np.maximum(total, 1e-12)
+        )
+    else:
+        expected = weighted
+
+    def sequence_loss(logits, weights):
+        return loss.sequence_loss(logits, tf.constant(targets), weights, **kwargs)
+
+    np.testing.assert_allclose(
+        sequence_loss(tf.constant(logits), tf.constant(weights)), expected, rtol=1e-6
+    )
+    theoretical, numerical = tf.test.compute_gradient(
+        sequence_loss,
+        [tf.constant(logits), tf.constant(np.random.uniform(0.5, 1.5, size=(3, 4)))],
+    )
+    for t, n in zip(theoretical, numerical):
+        np.testing.assert_allclose(t, n, rtol=1e-5, atol=1e-5)
+
+
 @pytest.mark.usefixtures("maybe_run_functions_eagerly")
 def test_ambiguous_order():
     with pytest.raises(ValueError, match="because of ambiguous order"):